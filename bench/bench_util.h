@@ -0,0 +1,51 @@
+#ifndef  __XRTCSERVER_BENCH_BENCH_UTIL_H_
+#define  __XRTCSERVER_BENCH_BENCH_UTIL_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <random>
+
+namespace xrtc {
+namespace bench {
+
+inline int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Gilbert-Elliott两状态丢包模型，坏状态下的包全部丢失，
+// 平均丢包率为loss_rate，连续丢包的平均长度为mean_burst_length。
+// mean_burst_length为1时退化成随机丢包
+class BurstLossModel {
+public:
+    BurstLossModel(double loss_rate, double mean_burst_length, uint32_t seed) :
+        rng_(seed)
+    {
+        bad_to_good_ = 1.0 / mean_burst_length;
+        good_to_bad_ = loss_rate < 1.0 ?
+            loss_rate * bad_to_good_ / (1.0 - loss_rate) : 1.0;
+    }
+
+    bool NextLost() {
+        double r = dist_(rng_);
+        if (bad_) {
+            bad_ = r >= bad_to_good_;
+        } else {
+            bad_ = r < good_to_bad_;
+        }
+        return bad_;
+    }
+
+private:
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> dist_{0.0, 1.0};
+    double good_to_bad_;
+    double bad_to_good_;
+    bool bad_ = false;
+};
+
+} // namespace bench
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_BENCH_BENCH_UTIL_H_
@@ -0,0 +1,462 @@
+// 丢包时帧的恢复延迟，只用NACK和NACK+FEC对比。
+// 发送端每一帧的媒体包经过UlpfecGenerator，保护比例由FecController按照丢包率和rtt给出；
+// 接收端用FEC包恢复丢失的媒体包(恢复出来的包和原始包逐字节比较)，
+// 恢复不了的由NackRequester请求重传，重传包一个rtt之后到达，同样可能丢失。
+// 帧的恢复延迟 = 帧的所有媒体包都到齐的时间 - 不丢包时最后一个包的到达时间
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <rtc_base/byte_io.h>
+#include <rtc_base/copy_on_write_buffer.h>
+#include <rtc_base/third_party/sigslot/sigslot.h>
+#include <system_wrappers/include/clock.h>
+
+#include "base/event_loop.h"
+#include "modules/fec/fec_controller.h"
+#include "modules/fec/fec_xor.h"
+#include "modules/fec/ulpfec_generator.h"
+#include "modules/video_coding/nack_requester.h"
+#include "bench_util.h"
+
+namespace xrtc {
+namespace bench {
+namespace {
+
+const int kNumFrames = 9000;
+const int64_t kFrameIntervalMs = 33;
+const int64_t kRttMs = 100;
+const int64_t kProcessIntervalMs = 20;
+const int kKeyFrameInterval = 90;
+const int kKeyFramePackets = 30;
+const int kDeltaFramePackets = 6;
+const size_t kMinPayloadSize = 800;
+const size_t kMaxPayloadSize = 1150;
+// 超过这个时间还没有到齐的帧认为丢失
+const int64_t kFrameTimeoutMs = 2000;
+// 发送端保留的历史包个数，用于重传和校验恢复结果
+const size_t kHistorySize = 4096;
+
+const size_t kRtpHeaderSize = 12;
+const size_t kFecHeaderSize = 10;
+const uint32_t kSsrc = 0x11223344;
+const uint8_t kPayloadType = 107;
+
+struct LossPattern {
+    const char* name;
+    double loss_rate;
+    double mean_burst_length;
+};
+
+struct SentPacket {
+    int frame_id;
+    bool is_fec;
+    // 关键帧的第一个包
+    bool keyframe_start;
+    rtc::CopyOnWriteBuffer data;
+};
+
+struct Frame {
+    int num_media_packets;
+    int received = 0;
+    // 不丢包时最后一个媒体包的到达时间
+    int64_t expected_ms;
+    bool used_fec = false;
+    std::vector<rtc::CopyOnWriteBuffer> fec_packets;
+};
+
+struct Result {
+    int frames = 0;
+    int delayed_frames = 0;
+    int fec_recovered_frames = 0;
+    int lost_frames = 0;
+    int fec_recovered_packets = 0;
+    int recover_mismatches = 0;
+    int64_t media_bytes = 0;
+    int64_t fec_bytes = 0;
+    int64_t rtx_bytes = 0;
+    std::vector<int64_t> latencies_ms;
+};
+
+uint16_t SequenceNumber(const rtc::CopyOnWriteBuffer& packet) {
+    return rtc::ByteReader<uint16_t>::ReadBigEndian(packet.data() + 2);
+}
+
+class FecSimulation : public sigslot::has_slots<> {
+public:
+    FecSimulation(const LossPattern& pattern, uint8_t protection_factor) :
+        clock_(1000000),
+        el_(nullptr),
+        nack_(&clock_, &el_, nullptr),
+        loss_(pattern.loss_rate, pattern.mean_burst_length, 1),
+        payload_rng_(2)
+    {
+        fec_generator_.SetProtectionFactor(protection_factor);
+        nack_.UpdateRtt(kRttMs);
+        nack_.SignalNackSend.connect(this, &FecSimulation::OnNackSend);
+    }
+
+    Result Run() {
+        int64_t start_ms = clock_.TimeInMilliseconds();
+        int64_t end_ms = start_ms + kNumFrames * kFrameIntervalMs + kFrameTimeoutMs;
+        int64_t next_frame_ms = start_ms;
+        int64_t next_process_ms = start_ms + kProcessIntervalMs;
+        int frame_id = 0;
+
+        while (clock_.TimeInMilliseconds() < end_ms) {
+            int64_t now_ms = clock_.TimeInMilliseconds();
+            if (frame_id < kNumFrames && now_ms >= next_frame_ms) {
+                SendFrame(frame_id++, now_ms);
+                next_frame_ms += kFrameIntervalMs;
+            }
+
+            DeliverPackets(now_ms);
+
+            if (now_ms >= next_process_ms) {
+                next_process_ms += kProcessIntervalMs;
+                nack_.ProcessNacks();
+            }
+
+            ExpireFrames(now_ms);
+            clock_.AdvanceTimeMilliseconds(1);
+        }
+
+        result_.lost_frames += frames_.size();
+        return std::move(result_);
+    }
+
+private:
+    // 发送端: 生成一帧的媒体包和FEC包，所有包在同一毫秒发出
+    void SendFrame(int frame_id, int64_t now_ms) {
+        bool is_keyframe = 0 == frame_id % kKeyFrameInterval;
+        int num_packets = is_keyframe ? kKeyFramePackets : kDeltaFramePackets;
+        uint32_t timestamp = frame_id * 3000;
+
+        Frame& frame = frames_[frame_id];
+        frame.num_media_packets = num_packets;
+        frame.expected_ms = now_ms + kRttMs / 2;
+        ++result_.frames;
+
+        for (int i = 0; i < num_packets; ++i) {
+            bool marker = i == num_packets - 1;
+            rtc::CopyOnWriteBuffer packet = BuildMediaPacket(next_seq_num_++,
+                    timestamp, marker);
+            result_.media_bytes += packet.size();
+            fec_generator_.AddMediaPacket(packet, marker);
+            Send(SentPacket{frame_id, false, is_keyframe && 0 == i, packet}, now_ms);
+        }
+
+        for (rtc::CopyOnWriteBuffer& fec : fec_generator_.GetFecPackets()) {
+            // FEC包和媒体包使用同一个序列号空间
+            uint16_t seq_num = next_seq_num_++;
+            rtc::CopyOnWriteBuffer packet(kRtpHeaderSize + fec.size());
+            uint8_t* data = packet.MutableData();
+            memset(data, 0, kRtpHeaderSize);
+            rtc::ByteWriter<uint16_t>::WriteBigEndian(data + 2, seq_num);
+            memcpy(data + kRtpHeaderSize, fec.data(), fec.size());
+            result_.fec_bytes += packet.size();
+            Send(SentPacket{frame_id, true, false, packet}, now_ms);
+        }
+    }
+
+    rtc::CopyOnWriteBuffer BuildMediaPacket(uint16_t seq_num, uint32_t timestamp,
+            bool marker)
+    {
+        size_t payload_size = kMinPayloadSize +
+            payload_rng_() % (kMaxPayloadSize - kMinPayloadSize + 1);
+        rtc::CopyOnWriteBuffer packet(kRtpHeaderSize + payload_size);
+        uint8_t* data = packet.MutableData();
+        data[0] = 0x80;
+        data[1] = (marker ? 0x80 : 0) | kPayloadType;
+        rtc::ByteWriter<uint16_t>::WriteBigEndian(data + 2, seq_num);
+        rtc::ByteWriter<uint32_t>::WriteBigEndian(data + 4, timestamp);
+        rtc::ByteWriter<uint32_t>::WriteBigEndian(data + 8, kSsrc);
+        for (size_t i = 0; i < payload_size; ++i) {
+            data[kRtpHeaderSize + i] = payload_rng_();
+        }
+        return packet;
+    }
+
+    void Send(const SentPacket& packet, int64_t now_ms) {
+        uint16_t seq_num = SequenceNumber(packet.data);
+        if (!history_.count(seq_num)) {
+            history_order_.push_back(seq_num);
+            if (history_order_.size() > kHistorySize) {
+                history_.erase(history_order_.front());
+                history_order_.pop_front();
+            }
+        }
+        history_[seq_num] = packet;
+
+        if (!loss_.NextLost()) {
+            in_flight_.emplace(now_ms + kRttMs / 2, packet);
+        }
+    }
+
+    void OnNackSend(const std::vector<uint16_t>& nack_list) {
+        // NACK到达发送端需要半个rtt，重传包回来再需要半个rtt
+        int64_t now_ms = clock_.TimeInMilliseconds();
+        for (uint16_t seq_num : nack_list) {
+            auto iter = history_.find(seq_num);
+            if (iter == history_.end()) {
+                continue;
+            }
+
+            result_.rtx_bytes += iter->second.data.size();
+            if (!loss_.NextLost()) {
+                in_flight_.emplace(now_ms + kRttMs, iter->second);
+            }
+        }
+    }
+
+    // 接收端
+    void DeliverPackets(int64_t now_ms) {
+        while (!in_flight_.empty() && in_flight_.begin()->first <= now_ms) {
+            SentPacket packet = in_flight_.begin()->second;
+            in_flight_.erase(in_flight_.begin());
+            OnPacketReceived(packet, now_ms);
+        }
+    }
+
+    void OnPacketReceived(const SentPacket& packet, int64_t now_ms) {
+        uint16_t seq_num = SequenceNumber(packet.data);
+        bool duplicate = received_.count(seq_num) > 0;
+        nack_.OnReceivedPacket(seq_num, packet.keyframe_start, false);
+        if (duplicate) {
+            return;
+        }
+
+        AddReceived(seq_num, packet.data);
+        auto iter = frames_.find(packet.frame_id);
+        if (iter == frames_.end()) {
+            return;
+        }
+
+        Frame& frame = iter->second;
+        if (packet.is_fec) {
+            frame.fec_packets.push_back(packet.data);
+        } else {
+            ++frame.received;
+        }
+
+        RecoverWithFec(&frame, now_ms);
+        if (frame.received == frame.num_media_packets) {
+            OnFrameComplete(iter, now_ms);
+        }
+    }
+
+    void AddReceived(uint16_t seq_num, const rtc::CopyOnWriteBuffer& data) {
+        received_order_.push_back(seq_num);
+        if (received_order_.size() > kHistorySize) {
+            received_.erase(received_order_.front());
+            received_order_.pop_front();
+        }
+        received_[seq_num] = data;
+    }
+
+    // 一个FEC包保护的媒体包中只丢了一个时可以恢复，恢复之后可能让其他FEC包也可以恢复
+    void RecoverWithFec(Frame* frame, int64_t now_ms) {
+        bool progress = true;
+        while (progress && frame->received < frame->num_media_packets) {
+            progress = false;
+            for (const rtc::CopyOnWriteBuffer& fec : frame->fec_packets) {
+                if (TryRecover(fec, now_ms)) {
+                    ++frame->received;
+                    frame->used_fec = true;
+                    progress = true;
+                }
+            }
+        }
+    }
+
+    bool TryRecover(const rtc::CopyOnWriteBuffer& packet, int64_t /*now_ms*/) {
+        const uint8_t* fec = packet.data() + kRtpHeaderSize;
+        size_t fec_size = packet.size() - kRtpHeaderSize;
+        bool l_bit = fec[0] & 0x40;
+        size_t mask_size = l_bit ? 6 : 2;
+        size_t header_size = kFecHeaderSize + 2 + mask_size;
+        uint16_t seq_num_base = rtc::ByteReader<uint16_t>::ReadBigEndian(fec + 2);
+        const uint8_t* mask = fec + kFecHeaderSize + 2;
+
+        int missing = 0;
+        uint16_t missing_seq_num = 0;
+        for (size_t k = 0; k < mask_size * 8; ++k) {
+            if (!(mask[k / 8] & (0x80 >> (k % 8)))) {
+                continue;
+            }
+
+            uint16_t seq_num = seq_num_base + k;
+            if (!received_.count(seq_num)) {
+                ++missing;
+                missing_seq_num = seq_num;
+            }
+        }
+
+        if (missing != 1) {
+            return false;
+        }
+
+        uint8_t b0 = fec[0];
+        uint8_t b1 = fec[1];
+        uint8_t timestamp[4];
+        memcpy(timestamp, fec + 4, 4);
+        uint16_t length = rtc::ByteReader<uint16_t>::ReadBigEndian(fec + 8);
+        std::vector<uint8_t> payload(fec + header_size, fec + fec_size);
+
+        for (size_t k = 0; k < mask_size * 8; ++k) {
+            uint16_t seq_num = seq_num_base + k;
+            if (!(mask[k / 8] & (0x80 >> (k % 8))) || seq_num == missing_seq_num) {
+                continue;
+            }
+
+            const rtc::CopyOnWriteBuffer& media = received_[seq_num];
+            b0 ^= media.data()[0];
+            b1 ^= media.data()[1];
+            FecXor(timestamp, media.data() + 4, 4);
+            size_t media_payload_size = media.size() - kRtpHeaderSize;
+            length ^= (uint16_t)media_payload_size;
+            FecXor(payload.data(), media.data() + kRtpHeaderSize, media_payload_size);
+        }
+
+        if (length > payload.size()) {
+            ++result_.recover_mismatches;
+            return false;
+        }
+
+        rtc::CopyOnWriteBuffer recovered(kRtpHeaderSize + length);
+        uint8_t* data = recovered.MutableData();
+        data[0] = 0x80 | (b0 & 0x3f);
+        data[1] = b1;
+        rtc::ByteWriter<uint16_t>::WriteBigEndian(data + 2, missing_seq_num);
+        memcpy(data + 4, timestamp, 4);
+        rtc::ByteWriter<uint32_t>::WriteBigEndian(data + 8, kSsrc);
+        memcpy(data + kRtpHeaderSize, payload.data(), length);
+
+        auto iter = history_.find(missing_seq_num);
+        if (iter == history_.end() || iter->second.data.size() != recovered.size() ||
+                memcmp(iter->second.data.data(), recovered.data(), recovered.size()))
+        {
+            ++result_.recover_mismatches;
+        }
+
+        ++result_.fec_recovered_packets;
+        AddReceived(missing_seq_num, recovered);
+        nack_.OnReceivedPacket(missing_seq_num, false, true);
+        return true;
+    }
+
+    void OnFrameComplete(std::map<int, Frame>::iterator iter, int64_t now_ms) {
+        int64_t latency_ms = now_ms - iter->second.expected_ms;
+        result_.latencies_ms.push_back(latency_ms);
+        if (latency_ms > 0) {
+            ++result_.delayed_frames;
+        } else if (iter->second.used_fec) {
+            ++result_.fec_recovered_frames;
+        }
+        frames_.erase(iter);
+    }
+
+    void ExpireFrames(int64_t now_ms) {
+        while (!frames_.empty() &&
+                now_ms - frames_.begin()->second.expected_ms > kFrameTimeoutMs)
+        {
+            ++result_.lost_frames;
+            frames_.erase(frames_.begin());
+        }
+    }
+
+private:
+    webrtc::SimulatedClock clock_;
+    EventLoop el_;
+    NackRequester nack_;
+    UlpfecGenerator fec_generator_;
+    BurstLossModel loss_;
+    std::mt19937 payload_rng_;
+    uint16_t next_seq_num_ = 65000;
+    Result result_;
+
+    std::unordered_map<uint16_t, SentPacket> history_;
+    std::deque<uint16_t> history_order_;
+    // 到达时间 -> 包，同一时间的包保持发送顺序
+    std::multimap<int64_t, SentPacket> in_flight_;
+    std::unordered_map<uint16_t, rtc::CopyOnWriteBuffer> received_;
+    std::deque<uint16_t> received_order_;
+    // 还没有到齐的帧
+    std::map<int, Frame> frames_;
+};
+
+int64_t Percentile(std::vector<int64_t>* values, double p) {
+    if (values->empty()) {
+        return 0;
+    }
+
+    size_t index = std::min(values->size() - 1, (size_t)(values->size() * p));
+    std::nth_element(values->begin(), values->begin() + index, values->end());
+    return (*values)[index];
+}
+
+void Report(const LossPattern& pattern, const char* mode, uint8_t protection_factor) {
+    FecSimulation simulation(pattern, protection_factor);
+    Result r = simulation.Run();
+
+    double avg_ms = 0;
+    for (int64_t latency_ms : r.latencies_ms) {
+        avg_ms += latency_ms;
+    }
+    if (!r.latencies_ms.empty()) {
+        avg_ms /= r.latencies_ms.size();
+    }
+
+    printf("%-10s %-9s %4d %7.1f%% %7.1f%% %8.2f%% %8.2f%% %7.1f %6lld %6lld %6d %8d\n",
+            pattern.name, mode, protection_factor,
+            100.0 * r.fec_bytes / r.media_bytes,
+            100.0 * r.rtx_bytes / r.media_bytes,
+            100.0 * r.delayed_frames / r.frames,
+            100.0 * r.fec_recovered_frames / r.frames,
+            avg_ms,
+            (long long)Percentile(&r.latencies_ms, 0.95),
+            (long long)Percentile(&r.latencies_ms, 0.99),
+            r.lost_frames,
+            r.recover_mismatches);
+}
+
+} // namespace
+} // namespace bench
+} // namespace xrtc
+
+int main() {
+    using namespace xrtc;
+    using namespace xrtc::bench;
+
+    const LossPattern patterns[] = {
+        {"burst 3%", 0.03, 2.0},
+        {"burst 5%", 0.05, 3.0},
+        {"burst 10%", 0.1, 3.0},
+        {"burst 20%", 0.2, 5.0},
+    };
+
+    printf("rtt: %lld ms, frames: %d, FecXor: %s\n", (long long)kRttMs, kNumFrames,
+            FecXorImplementation());
+    printf("%-10s %-9s %4s %8s %8s %9s %9s %7s %6s %6s %6s %8s\n",
+            "pattern", "mode", "pf", "fec", "rtx", "delayed", "fec_only",
+            "avg_ms", "p95", "p99", "lost", "mismatch");
+    for (const LossPattern& pattern : patterns) {
+        Report(pattern, "nack", 0);
+
+        FecController controller{FecControllerConfig()};
+        for (int i = 0; i < 20; ++i) {
+            controller.Update(pattern.loss_rate, kRttMs);
+        }
+        Report(pattern, ProtectionModeToString(controller.mode()),
+                controller.protection_factor());
+    }
+
+    return 0;
+}
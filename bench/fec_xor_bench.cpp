@@ -0,0 +1,73 @@
+// FecXor的吞吐，和逐字节异或对比。
+// 包大小覆盖音频小包、一般的视频包(1200左右)和大块数据
+
+#include <stdio.h>
+
+#include <random>
+#include <vector>
+
+#include "modules/fec/fec_xor.h"
+#include "bench_util.h"
+
+namespace xrtc {
+namespace bench {
+namespace {
+
+// 每种大小至少处理这么多数据
+const size_t kBytesPerRun = 1 << 30;
+
+void ByteXor(uint8_t* dst, const uint8_t* src, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+typedef void (*XorFunc)(uint8_t* dst, const uint8_t* src, size_t size);
+
+// 返回GB/s，按照src的字节数计算
+double Measure(XorFunc func, size_t size, size_t offset) {
+    std::mt19937 rng(size);
+    std::vector<uint8_t> dst(size + offset);
+    std::vector<uint8_t> src(size + offset);
+    for (size_t i = 0; i < src.size(); ++i) {
+        dst[i] = rng();
+        src[i] = rng();
+    }
+
+    size_t iterations = kBytesPerRun / size + 1;
+    int64_t start = NowNs();
+    for (size_t i = 0; i < iterations; ++i) {
+        func(dst.data() + offset, src.data() + offset, size);
+    }
+    int64_t elapsed_ns = NowNs() - start;
+
+    // 防止结果被优化掉
+    volatile uint8_t sink = dst[size / 2];
+    (void)sink;
+    return (double)size * iterations / elapsed_ns;
+}
+
+} // namespace
+} // namespace bench
+} // namespace xrtc
+
+int main() {
+    using namespace xrtc::bench;
+
+    const size_t sizes[] = {64, 160, 1200, 1500, 8192, 65536};
+
+    printf("FecXor implementation: %s\n", xrtc::FecXorImplementation());
+    printf("%8s %8s %14s %14s %8s\n", "size", "offset", "byte GB/s", "FecXor GB/s",
+            "speedup");
+    for (size_t size : sizes) {
+        // rtp负载在包中的偏移一般不对齐
+        for (size_t offset : {0, 3}) {
+            double byte_rate = Measure(ByteXor, size, offset);
+            double fec_rate = Measure(xrtc::FecXor, size, offset);
+            printf("%8zu %8zu %14.2f %14.2f %8.2f\n", size, offset,
+                    byte_rate, fec_rate, fec_rate / byte_rate);
+        }
+    }
+
+    return 0;
+}
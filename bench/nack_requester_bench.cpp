@@ -0,0 +1,172 @@
+// NackRequester在不同丢包模式下的开销和重传效果。
+// 推流端以固定间隔发包，丢失的包在NACK发出一个RTT之后以rtx的形式到达，
+// 重传包同样按照丢包模型丢失。统计每个包在NackRequester中的耗时、
+// 发出的NACK个数、无效的NACK(请求了已经收到的包)以及丢包恢复的延迟
+
+#include <stdio.h>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include <rtc_base/third_party/sigslot/sigslot.h>
+#include <system_wrappers/include/clock.h>
+
+#include "base/event_loop.h"
+#include "modules/video_coding/nack_requester.h"
+#include "bench_util.h"
+
+namespace xrtc {
+namespace bench {
+namespace {
+
+const int kNumPackets = 200000;
+const int64_t kPacketIntervalMs = 2;
+const int64_t kProcessIntervalMs = 20;
+const int64_t kRttMs = 50;
+// 每2秒一个关键帧
+const int kKeyFrameInterval = 1000;
+const uint16_t kStartSeqNum = 65000;
+
+struct LossPattern {
+    const char* name;
+    double loss_rate;
+    double mean_burst_length;
+};
+
+struct Retransmission {
+    int64_t arrival_ms;
+    uint16_t seq_num;
+};
+
+struct Result {
+    int64_t nack_ns = 0;
+    int lost = 0;
+    int nacks = 0;
+    int spurious_nacks = 0;
+    int recovered = 0;
+    int64_t total_recovery_ms = 0;
+    int64_t max_recovery_ms = 0;
+};
+
+class NackSimulation : public sigslot::has_slots<> {
+public:
+    explicit NackSimulation(const LossPattern& pattern) :
+        clock_(1000000),
+        el_(nullptr),
+        nack_(&clock_, &el_, nullptr),
+        media_loss_(pattern.loss_rate, pattern.mean_burst_length, 1),
+        rtx_loss_(pattern.loss_rate, pattern.mean_burst_length, 2)
+    {
+        nack_.UpdateRtt(kRttMs);
+        nack_.SignalNackSend.connect(this, &NackSimulation::OnNackSend);
+    }
+
+    Result Run() {
+        uint16_t seq_num = kStartSeqNum;
+        int64_t next_process_ms = clock_.TimeInMilliseconds() + kProcessIntervalMs;
+        for (int i = 0; i < kNumPackets; ++i, ++seq_num) {
+            clock_.AdvanceTimeMilliseconds(kPacketIntervalMs);
+            int64_t now_ms = clock_.TimeInMilliseconds();
+            DeliverRetransmissions(now_ms);
+
+            if (media_loss_.NextLost()) {
+                ++result_.lost;
+                missing_[seq_num] = now_ms;
+            } else {
+                int64_t start = NowNs();
+                nack_.OnReceivedPacket(seq_num, 0 == i % kKeyFrameInterval, false);
+                result_.nack_ns += NowNs() - start;
+            }
+
+            if (now_ms >= next_process_ms) {
+                next_process_ms += kProcessIntervalMs;
+                int64_t start = NowNs();
+                nack_.ProcessNacks();
+                result_.nack_ns += NowNs() - start;
+            }
+        }
+
+        return result_;
+    }
+
+private:
+    void OnNackSend(const std::vector<uint16_t>& nack_list) {
+        int64_t now_ms = clock_.TimeInMilliseconds();
+        for (uint16_t seq_num : nack_list) {
+            ++result_.nacks;
+            if (!missing_.count(seq_num)) {
+                ++result_.spurious_nacks;
+                continue;
+            }
+
+            in_flight_.push_back(Retransmission{now_ms + kRttMs, seq_num});
+        }
+    }
+
+    void DeliverRetransmissions(int64_t now_ms) {
+        while (!in_flight_.empty() && in_flight_.front().arrival_ms <= now_ms) {
+            Retransmission rtx = in_flight_.front();
+            in_flight_.pop_front();
+            auto iter = missing_.find(rtx.seq_num);
+            if (iter == missing_.end() || rtx_loss_.NextLost()) {
+                continue;
+            }
+
+            int64_t recovery_ms = now_ms - iter->second;
+            ++result_.recovered;
+            result_.total_recovery_ms += recovery_ms;
+            if (recovery_ms > result_.max_recovery_ms) {
+                result_.max_recovery_ms = recovery_ms;
+            }
+            missing_.erase(iter);
+
+            int64_t start = NowNs();
+            nack_.OnReceivedPacket(rtx.seq_num, false, true);
+            result_.nack_ns += NowNs() - start;
+        }
+    }
+
+private:
+    webrtc::SimulatedClock clock_;
+    EventLoop el_;
+    NackRequester nack_;
+    BurstLossModel media_loss_;
+    BurstLossModel rtx_loss_;
+    Result result_;
+    // 丢失且还没有恢复的包 -> 原始包的发送时间
+    std::unordered_map<uint16_t, int64_t> missing_;
+    // 按到达时间排序的重传包
+    std::deque<Retransmission> in_flight_;
+};
+
+} // namespace
+} // namespace bench
+} // namespace xrtc
+
+int main() {
+    using namespace xrtc::bench;
+
+    const LossPattern patterns[] = {
+        {"random 0.1%", 0.001, 1.0},
+        {"burst 5%", 0.05, 3.0},
+        {"burst 30%", 0.3, 5.0},
+    };
+
+    printf("%-12s %10s %8s %8s %9s %10s %12s %12s %10s\n",
+            "pattern", "ns/packet", "lost", "nacks", "spurious", "recovered",
+            "unrecovered", "avg_rec_ms", "max_rec_ms");
+    for (const LossPattern& pattern : patterns) {
+        NackSimulation simulation(pattern);
+        Result r = simulation.Run();
+        printf("%-12s %10.1f %8d %8d %9d %10d %12d %12.1f %10lld\n",
+                pattern.name,
+                (double)r.nack_ns / kNumPackets,
+                r.lost, r.nacks, r.spurious_nacks, r.recovered,
+                r.lost - r.recovered,
+                r.recovered > 0 ? (double)r.total_recovery_ms / r.recovered : 0.0,
+                (long long)r.max_recovery_ms);
+    }
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+// sdp的解析和生成，和原来基于rtc::split/std::stringstream的实现对比。
+// 解析使用test/data中Chrome和Firefox的answer，
+// 生成覆盖answer解析出的描述和服务器生成的推拉流offer，
+// offer再加上模板缓存命中时的Render
+
+#include <stdio.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "pc/offer_template.h"
+#include "pc/remote_description.h"
+#include "legacy_sdp.h"
+#include "bench_util.h"
+
+namespace xrtc {
+namespace bench {
+namespace {
+
+// 每一项至少运行这么长时间
+const int64_t kRunNs = 1000000000;
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// 返回每秒执行的次数，func返回false表示出错
+template <typename Func>
+double Measure(Func func) {
+    int64_t count = 0;
+    int64_t start = NowNs();
+    int64_t elapsed_ns = 0;
+    do {
+        for (int i = 0; i < 100; ++i) {
+            if (!func()) {
+                return 0;
+            }
+        }
+        count += 100;
+        elapsed_ns = NowNs() - start;
+    } while (elapsed_ns < kRunNs);
+
+    return count * 1e9 / elapsed_ns;
+}
+
+void PrintResult(const char* name, size_t bytes, double legacy_rate, double rate) {
+    printf("%-24s %8zu %14.0f %14.0f %8.2f\n", name, bytes, legacy_rate, rate,
+            legacy_rate > 0 ? rate / legacy_rate : 0.0);
+}
+
+Candidate MakeCandidate() {
+    Candidate c;
+    c.component = IceCandidateComponent::RTP;
+    c.protocol = "udp";
+    c.address = rtc::SocketAddress("192.168.1.10", 8000);
+    c.port = 8000;
+    c.priority = 2130706431;
+    c.type = "host";
+    c.foundation = "4208434592";
+    return c;
+}
+
+// 和PeerConnection::CreateOffer生成的结构一致
+std::unique_ptr<SessionDescription> MakeOffer(bool push) {
+    auto desc = std::make_unique<SessionDescription>(SdpType::kOffer);
+    std::vector<Candidate> candidates = {MakeCandidate()};
+
+    auto audio = std::make_shared<AudioContentDescription>();
+    auto video = std::make_shared<VideoContentDescription>();
+    audio->set_direction(push ? RtpDirection::kRecvOnly : RtpDirection::kSendOnly);
+    video->set_direction(push ? RtpDirection::kRecvOnly : RtpDirection::kSendOnly);
+
+    if (!push) {
+        StreamParams audio_stream;
+        audio_stream.id = "audio-track";
+        audio_stream.stream_id = "xrtc-stream";
+        audio_stream.cname = "xrtc";
+        audio_stream.ssrcs = {1001};
+        audio->add_stream(audio_stream);
+
+        StreamParams video_stream;
+        video_stream.id = "video-track";
+        video_stream.stream_id = "xrtc-stream";
+        video_stream.cname = "xrtc";
+        video_stream.ssrcs = {2001, 2002};
+        video_stream.ssrc_groups.push_back(SsrcGroup(kFidSsrcGroupSemantics, {2001, 2002}));
+        video->add_stream(video_stream);
+        video->AddFecCodecs();
+    }
+
+    ContentGroup bundle("BUNDLE");
+    for (std::shared_ptr<MediaContentDescription> content :
+            std::vector<std::shared_ptr<MediaContentDescription>>{audio, video})
+    {
+        content->add_candidates(candidates);
+        desc->AddContent(content);
+        bundle.AddContentName(content->mid());
+
+        auto td = std::make_shared<TransportDescription>();
+        td->mid = content->mid();
+        td->ice_ufrag = "aB3d";
+        td->ice_pwd = "q2W3e4R5t6Y7u8I9o0P1a2S3";
+        td->connection_role = ConnectionRole::ACTPASS;
+        td->identity_fingerprint = rtc::SSLFingerprint::CreateUniqueFromRfc4572(
+                "sha-256", "22:B0:D3:38:A5:19:16:8D:4F:E8:17:70:92:BE:CC:0F:"
+                "7F:46:31:D8:C0:A7:B7:89:CC:1A:D3:69:21:82:A3:45");
+        desc->AddTransportInfo(td);
+    }
+    desc->AddGroup(bundle);
+
+    return desc;
+}
+
+} // namespace
+} // namespace bench
+} // namespace xrtc
+
+int main() {
+    using namespace xrtc;
+    using namespace xrtc::bench;
+
+    const char* answers[] = {"chrome_answer.sdp", "firefox_answer.sdp"};
+    std::vector<std::shared_ptr<RemoteDescription>> remotes;
+
+    printf("%-24s %8s %14s %14s %8s\n", "case", "bytes", "legacy ops/s",
+            "new ops/s", "speedup");
+    for (const char* file : answers) {
+        std::string sdp = ReadFile(std::string(XRTC_TEST_DATA_DIR "/") + file);
+        auto remote = ParseRemoteDescription(sdp);
+        if (!remote) {
+            fprintf(stderr, "parse %s failed\n", file);
+            return 1;
+        }
+        remotes.push_back(remote);
+
+        double legacy_rate = Measure([&sdp]() {
+            return legacy::ParseRemoteDescription(sdp) != nullptr;
+        });
+        double rate = Measure([&sdp]() {
+            return ParseRemoteDescription(sdp) != nullptr;
+        });
+        PrintResult((std::string("parse ") + file).c_str(), sdp.size(), legacy_rate, rate);
+    }
+
+    for (size_t i = 0; i < remotes.size(); ++i) {
+        SessionDescription* desc = remotes[i]->desc.get();
+        double legacy_rate = Measure([desc]() {
+            return !legacy::ToString(desc).empty();
+        });
+        double rate = Measure([desc]() {
+            return !desc->ToString().empty();
+        });
+        PrintResult((std::string("write ") + answers[i]).c_str(), desc->ToString().size(),
+                legacy_rate, rate);
+    }
+
+    for (bool push : {true, false}) {
+        auto offer = MakeOffer(push);
+        SessionDescription* desc = offer.get();
+        uint32_t key = push ? 1 : 2;
+        double legacy_rate = Measure([desc]() {
+            return !legacy::ToString(desc).empty();
+        });
+        double rate = Measure([desc]() {
+            return !desc->ToString().empty();
+        });
+        double render_rate = Measure([desc, key]() {
+            return !OfferTemplateCache::ThreadInstance()->Render(key, desc).empty();
+        });
+        size_t bytes = desc->ToString().size();
+        PrintResult(push ? "write push offer" : "write pull offer", bytes, legacy_rate, rate);
+        PrintResult(push ? "render push offer" : "render pull offer", bytes, legacy_rate,
+                render_rate);
+    }
+
+    return 0;
+}
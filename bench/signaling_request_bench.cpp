@@ -0,0 +1,154 @@
+// 信令请求解析的吞吐，ParseSignalingRequest和原来的jsoncpp解析对比。
+// 请求覆盖推流、拉流和带answer sdp的请求，answer是最大的一种
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include "server/signaling_request.h"
+#include "bench_util.h"
+
+namespace xrtc {
+namespace bench {
+namespace {
+
+// 每种请求至少处理这么长时间
+const int64_t kRunNs = 1000000000;
+
+// 和原来的signaling worker一样，每个请求构造reader和Json::Value，
+// 再从json对象中取出字段
+int ParseWithJsonCpp(const std::string& body, SignalingRequest* req) {
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    Json::Value root;
+    JSONCPP_STRING err;
+    reader->parse(body.data(), body.data() + body.size(), &root, &err);
+    if (!err.empty()) {
+        return -1;
+    }
+
+    try {
+        req->cmdno = root["cmdno"].asInt();
+        req->uid = root["uid"].asUInt64();
+        req->stream_name = root["stream_name"].asString();
+        req->audio = root["audio"].asInt();
+        req->video = root["video"].asInt();
+        req->is_dtls = root["is_dtls"].asInt();
+        req->skip_silent_audio = root.get("skip_silent_audio", 0).asInt();
+        req->answer = root["answer"].asString();
+        req->type = root["type"].asString();
+    } catch (const Json::Exception&) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int ParseWithScanner(const std::string& body, SignalingRequest* req) {
+    std::string err;
+    return ParseSignalingRequest(body.data(), body.size(), req, &err);
+}
+
+typedef int (*ParseFunc)(const std::string& body, SignalingRequest* req);
+
+// 浏览器answer的大致内容，音视频各一个m line，json中换行为转义字符
+std::string MakeAnswerSdp() {
+    std::string sdp =
+        "v=0\\r\\n"
+        "o=- 4611731400430051336 2 IN IP4 127.0.0.1\\r\\n"
+        "s=-\\r\\n"
+        "t=0 0\\r\\n"
+        "a=group:BUNDLE 0 1\\r\\n"
+        "a=extmap-allow-mixed\\r\\n"
+        "a=msid-semantic: WMS\\r\\n";
+
+    const char* media[] = {"audio", "video"};
+    for (int m = 0; m < 2; ++m) {
+        sdp += std::string("m=") + media[m]
+            + " 9 UDP/TLS/RTP/SAVPF 111 96 97 98 99 100 101\\r\\n"
+            "c=IN IP4 0.0.0.0\\r\\n"
+            "a=rtcp:9 IN IP4 0.0.0.0\\r\\n"
+            "a=ice-ufrag:Xo4h\\r\\n"
+            "a=ice-pwd:qzLbJwhuWrbBGrDVqJ8IAhC1\\r\\n"
+            "a=ice-options:trickle\\r\\n"
+            "a=fingerprint:sha-256 6B:8B:F0:65:5F:78:E2:51:3B:AC:6F:F3:3F:46:1B:35:"
+            "DC:B8:5F:64:1A:24:C2:43:F0:A1:58:D0:A1:2C:19:08\\r\\n"
+            "a=setup:active\\r\\n"
+            "a=mid:" + std::to_string(m) + "\\r\\n"
+            "a=extmap:1 urn:ietf:params:rtp-hdrext:toffset\\r\\n"
+            "a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\\r\\n"
+            "a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\\r\\n"
+            "a=recvonly\\r\\n"
+            "a=rtcp-mux\\r\\n"
+            "a=rtcp-rsize\\r\\n";
+        for (int pt = 96; pt <= 101; ++pt) {
+            std::string p = std::to_string(pt);
+            sdp += "a=rtpmap:" + p + " VP8/90000\\r\\n"
+                "a=rtcp-fb:" + p + " goog-remb\\r\\n"
+                "a=rtcp-fb:" + p + " transport-cc\\r\\n"
+                "a=rtcp-fb:" + p + " ccm fir\\r\\n"
+                "a=rtcp-fb:" + p + " nack\\r\\n"
+                "a=rtcp-fb:" + p + " nack pli\\r\\n";
+        }
+    }
+
+    return sdp;
+}
+
+struct Request {
+    const char* name;
+    std::string body;
+};
+
+// 返回每秒处理的请求数
+double Measure(ParseFunc func, const std::string& body) {
+    SignalingRequest req;
+    int64_t count = 0;
+    int64_t start = NowNs();
+    int64_t elapsed_ns = 0;
+    do {
+        // 每批之后检查一次时间，避免时钟的开销
+        for (int i = 0; i < 1000; ++i) {
+            if (func(body, &req) != 0) {
+                fprintf(stderr, "parse failed: %s\n", body.c_str());
+                return 0;
+            }
+        }
+        count += 1000;
+        elapsed_ns = NowNs() - start;
+    } while (elapsed_ns < kRunNs);
+
+    return count * 1e9 / elapsed_ns;
+}
+
+} // namespace
+} // namespace bench
+} // namespace xrtc
+
+int main() {
+    using namespace xrtc::bench;
+
+    const Request requests[] = {
+        {"push", R"({"cmdno":1,"uid":123456789,"stream_name":"xrtc1234",)"
+            R"("audio":1,"video":1,"is_dtls":1})"},
+        {"pull", R"({"cmdno":2,"uid":123456789,"stream_name":"xrtc1234",)"
+            R"("audio":1,"video":1,"is_dtls":1,"skip_silent_audio":1})"},
+        {"answer", R"({"cmdno":3,"uid":123456789,"stream_name":"xrtc1234",)"
+            R"("type":"push","answer":")" + MakeAnswerSdp() + R"("})"},
+    };
+
+    printf("%-8s %8s %14s %14s %8s\n", "request", "bytes", "jsoncpp req/s",
+            "scanner req/s", "speedup");
+    for (const Request& request : requests) {
+        double json_rate = Measure(ParseWithJsonCpp, request.body);
+        double scanner_rate = Measure(ParseWithScanner, request.body);
+        printf("%-8s %8zu %14.0f %14.0f %8.2f\n", request.name, request.body.size(),
+                json_rate, scanner_rate, json_rate > 0 ? scanner_rate / json_rate : 0.0);
+    }
+
+    return 0;
+}
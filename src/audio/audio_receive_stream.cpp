@@ -0,0 +1,85 @@
+#include "audio/audio_receive_stream.h"
+
+#include <modules/rtp_rtcp/source/rtp_header_extensions.h>
+
+namespace xrtc {
+
+namespace {
+
+const uint8_t kMaxAudioLevel = 127;
+// 指数加权平均的系数，大约对应最近10个包(200ms)的音量
+const double kAudioLevelSmoothingFactor = 0.1;
+
+std::unique_ptr<RtpRtcpImpl> CreateRtpRtcpModule(
+        const AudioReceiveStreamConfig& aconf,
+        ReceiveStat* receive_stat)
+{
+    RtpRtcpConfig config;
+    config.el = aconf.el;
+    config.clock = aconf.clock;
+    config.feedback_scheduler = aconf.feedback_scheduler;
+    config.audio = true;
+    config.local_media_ssrc = aconf.rtp.local_ssrc;
+    config.receive_stat = receive_stat;
+    config.rtp_rtcp_module_observer = aconf.rtp_rtcp_module_observer;
+
+    auto rtp_rtcp = std::make_unique<RtpRtcpImpl>(config);
+    rtp_rtcp->SetRTCPStatus(webrtc::RtcpMode::kCompound);
+    rtp_rtcp->SetRemoteSsrc(aconf.rtp.remote_ssrc);
+    return rtp_rtcp;
+}
+
+} // namespace
+
+AudioReceiveStream::AudioReceiveStream(const AudioReceiveStreamConfig& config) :
+    config_(config),
+    rtp_receive_stat_(ReceiveStat::Create(config.clock)),
+    rtp_rtcp_(CreateRtpRtcpModule(config, rtp_receive_stat_.get())),
+    smoothed_audio_level_(kMaxAudioLevel)
+{
+}
+
+AudioReceiveStream::~AudioReceiveStream() {
+}
+
+void AudioReceiveStream::OnRtpPacket(const webrtc::RtpPacketReceived& packet) {
+    UpdateAudioLevel(packet);
+
+    if (!packet.recovered()) {
+        rtp_receive_stat_->OnRtpPacket(packet);
+    }
+}
+
+void AudioReceiveStream::DeliverRtcp(const uint8_t* data, size_t len) {
+    rtp_rtcp_->IncomingRtcpPacket(data, len);
+}
+
+void AudioReceiveStream::UpdateAudioLevel(const webrtc::RtpPacketReceived& packet) {
+    bool voice_activity = false;
+    uint8_t audio_level = 0;
+    if (!packet.GetExtension<webrtc::AudioLevel>(&voice_activity, &audio_level)) {
+        return;
+    }
+
+    ++audio_level_packets_;
+    if (voice_activity) {
+        ++voice_activity_packets_;
+    }
+
+    smoothed_audio_level_ += kAudioLevelSmoothingFactor *
+        (audio_level - smoothed_audio_level_);
+}
+
+uint8_t AudioReceiveStream::audio_level() const {
+    return static_cast<uint8_t>(smoothed_audio_level_ + 0.5);
+}
+
+double AudioReceiveStream::voice_activity_ratio() const {
+    if (0 == audio_level_packets_) {
+        return 0.0;
+    }
+
+    return static_cast<double>(voice_activity_packets_) / audio_level_packets_;
+}
+
+} // namespace xrtc
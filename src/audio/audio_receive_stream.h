@@ -0,0 +1,44 @@
+#ifndef  XRTCSERVER_AUDIO_AUDIO_RECEIVE_STREAM_H_
+#define  XRTCSERVER_AUDIO_AUDIO_RECEIVE_STREAM_H_
+
+#include <modules/rtp_rtcp/source/rtp_packet_received.h>
+
+#include "audio/audio_receive_stream_config.h"
+#include "modules/rtp_rtcp/receive_stat.h"
+#include "modules/rtp_rtcp/rtp_rtcp_impl.h"
+
+namespace xrtc {
+
+// 推流端的音频接收流，只做统计和rtcp反馈，不解码opus
+class AudioReceiveStream {
+public:
+    AudioReceiveStream(const AudioReceiveStreamConfig& config);
+    ~AudioReceiveStream();
+
+    void OnRtpPacket(const webrtc::RtpPacketReceived& packet);
+    void DeliverRtcp(const uint8_t* data, size_t len);
+    bool SendTransportFeedback(const webrtc::rtcp::TransportFeedback& packet) {
+        return rtp_rtcp_->SendTransportFeedback(packet);
+    }
+
+    // 平滑后的音量，单位-dBov，取值范围[0, 127]，0表示最大音量
+    uint8_t audio_level() const;
+    // 携带语音活动标志的包所占的比例
+    double voice_activity_ratio() const;
+
+private:
+    void UpdateAudioLevel(const webrtc::RtpPacketReceived& packet);
+
+private:
+    AudioReceiveStreamConfig config_;
+    std::unique_ptr<ReceiveStat> rtp_receive_stat_;
+    std::unique_ptr<RtpRtcpImpl> rtp_rtcp_;
+
+    double smoothed_audio_level_;
+    uint64_t audio_level_packets_ = 0;
+    uint64_t voice_activity_packets_ = 0;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_AUDIO_AUDIO_RECEIVE_STREAM_H_
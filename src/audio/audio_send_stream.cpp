@@ -0,0 +1,75 @@
+#include "audio/audio_send_stream.h"
+
+namespace xrtc {
+
+namespace {
+
+const uint8_t kSilentAudioLevel = 127;
+// opus在DTX状态下发送的包，负载不超过3个字节
+const size_t kMaxDtxPayloadSize = 3;
+
+std::unique_ptr<RtpRtcpImpl> CreateRtpRtcpModule(
+        const AudioSendStreamConfig& aconf)
+{
+    RtpRtcpConfig config;
+    config.el = aconf.el;
+    config.clock = aconf.clock;
+    config.feedback_scheduler = aconf.feedback_scheduler;
+    config.audio = true;
+    config.local_media_ssrc = aconf.rtp.ssrc;
+    config.rtp_rtcp_module_observer = aconf.rtp_rtcp_module_observer;
+
+    auto rtp_rtcp = std::make_unique<RtpRtcpImpl>(config);
+    rtp_rtcp->SetRTCPStatus(webrtc::RtcpMode::kCompound);
+    rtp_rtcp->SetSendingStatus(true);
+    rtp_rtcp->SetRemoteSsrc(aconf.rtp.remote_ssrc);
+    return rtp_rtcp;
+}
+
+} // namespace
+
+AudioSendStream::AudioSendStream(const AudioSendStreamConfig& config) :
+    config_(config),
+    rtp_rtcp_(CreateRtpRtcpModule(config))
+{
+}
+
+AudioSendStream::~AudioSendStream() {
+}
+
+bool AudioSendStream::OnSendingRtpPacket(const RtpPacketView& packet,
+        uint16_t* seq_num)
+{
+    if (config_.skip_silence && IsSilentPacket(packet)) {
+        ++skipped_packets_;
+        ++seq_num_offset_;
+        return false;
+    }
+
+    *seq_num = packet.SequenceNumber() - seq_num_offset_;
+    rtp_rtcp_->OnSendingRtpPacket(packet.Timestamp(), packet.payload_size());
+    return true;
+}
+
+void AudioSendStream::DeliverRtcp(const uint8_t* data, size_t len) {
+    rtp_rtcp_->IncomingRtcpPacket(data, len);
+}
+
+bool AudioSendStream::IsSilentPacket(const RtpPacketView& packet) {
+    rtc::ArrayView<const uint8_t> data =
+        packet.FindExtension(config_.rtp.audio_level_extension_id);
+    if (data.empty()) {
+        return false;
+    }
+
+    bool voice_activity = (data[0] & 0x80) != 0;
+    uint8_t audio_level = data[0] & 0x7F;
+    if (voice_activity) {
+        return false;
+    }
+
+    return audio_level >= kSilentAudioLevel ||
+        packet.payload_size() <= kMaxDtxPayloadSize;
+}
+
+} // namespace xrtc
@@ -0,0 +1,36 @@
+#ifndef  XRTCSERVER_AUDIO_AUDIO_SEND_STREAM_H_
+#define  XRTCSERVER_AUDIO_AUDIO_SEND_STREAM_H_
+
+#include "audio/audio_send_stream_config.h"
+#include "modules/rtp_rtcp/rtp_rtcp_impl.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+
+namespace xrtc {
+
+// 拉流端的音频发送流，负责生成SR，以及按需过滤静音包
+class AudioSendStream {
+public:
+    AudioSendStream(const AudioSendStreamConfig& config);
+    ~AudioSendStream();
+
+    uint32_t ssrc() const { return config_.rtp.ssrc; }
+    uint64_t skipped_packets() const { return skipped_packets_; }
+
+    // 返回false表示该包是静音包，不需要发送；
+    // 跳过静音包之后，后续包的序列号需要改写为seq_num，保证拉流端看到的序列号连续
+    bool OnSendingRtpPacket(const RtpPacketView& packet, uint16_t* seq_num);
+    void DeliverRtcp(const uint8_t* data, size_t len);
+
+private:
+    bool IsSilentPacket(const RtpPacketView& packet);
+
+private:
+    AudioSendStreamConfig config_;
+    std::unique_ptr<RtpRtcpImpl> rtp_rtcp_;
+    uint16_t seq_num_offset_ = 0;
+    uint64_t skipped_packets_ = 0;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_AUDIO_AUDIO_SEND_STREAM_H_
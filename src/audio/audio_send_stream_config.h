@@ -0,0 +1,33 @@
+#ifndef  XRTCSERVER_AUDIO_AUDIO_SEND_STREAM_CONFIG_H_
+#define  XRTCSERVER_AUDIO_AUDIO_SEND_STREAM_CONFIG_H_
+
+#include <system_wrappers/include/clock.h>
+
+#include "base/event_loop.h"
+
+namespace xrtc {
+
+class RtpRtcpModuleObserver;
+class FeedbackScheduler;
+
+class AudioSendStreamConfig {
+public:
+    EventLoop* el = nullptr;
+    webrtc::Clock* clock = nullptr;
+    FeedbackScheduler* feedback_scheduler = nullptr;
+
+    struct Rtp {
+        uint32_t ssrc = 0;
+        uint32_t remote_ssrc = 0;
+        int audio_level_extension_id = 0;
+    } rtp;
+
+    // 不转发静音(DTX)包，由拉流端在信令中选择开启
+    bool skip_silence = false;
+
+    RtpRtcpModuleObserver* rtp_rtcp_module_observer = nullptr;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_AUDIO_AUDIO_SEND_STREAM_CONFIG_H_
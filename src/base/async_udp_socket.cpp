@@ -1,12 +1,29 @@
 #include "base/async_udp_socket.h"
 
+#include <algorithm>
+
 #include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
 
+#include "base/metrics.h"
 #include "base/socket.h"
 
 namespace xrtc {
 
 const size_t MAX_BUF_SIZE = 1500;
+// 一次sendmmsg最多发送的包的个数
+const size_t kMaxBatchSize = 64;
+// 同一个端口上所有会话共用发送缓存，超过上限时丢弃最旧的包，
+// 避免一个慢速的拉流端拖累其它会话的延迟和内存
+const size_t kMaxPendingBytes = 4 * 1024 * 1024;
+
+namespace {
+
+// 当前线程批量发送的嵌套深度，以及有缓存数据的socket
+thread_local int t_send_batch_depth = 0;
+thread_local std::vector<AsyncUdpSocket*> t_batch_sockets;
+
+} // namespace
 
 void AsyncUdpSocketIOCb(EventLoop* /*el*/, IOWatcher* /*w*/, 
         int /*fd*/, int events, void* data) 
@@ -41,18 +58,38 @@ AsyncUdpSocket::~AsyncUdpSocket() {
         delete []buf_;
         buf_ = nullptr;
     }
+
+    for (auto packet : udp_packet_list_) {
+        delete packet;
+    }
+    udp_packet_list_.clear();
+
+    t_batch_sockets.erase(std::remove(t_batch_sockets.begin(),
+                t_batch_sockets.end(), this), t_batch_sockets.end());
+    for (auto packet : batch_packet_list_) {
+        delete packet;
+    }
+    batch_packet_list_.clear();
 }
 
 void AsyncUdpSocket::RecvData() {
     while (true) {
         struct sockaddr_in addr;
         socklen_t addr_len = sizeof(addr);
-        int len = SockRecvFrom(socket_, buf_, size_, (struct sockaddr*)&addr, addr_len);
+        int64_t ts = -1;
+        int len = SockRecvFrom(socket_, buf_, size_, (struct sockaddr*)&addr, addr_len,
+                &ts);
         if (len <= 0) {
             return;
         }
         
-        int64_t ts = SockGetRecvTimestamp(socket_);
+        if (ts > 0) {
+            // 内核时间戳是系统时间，转换成和webrtc::Clock一致的单调时间，
+            // 保留包在内核队列中等待的时长
+            int64_t now_us = rtc::TimeMicros();
+            ts = std::min(now_us, now_us - (rtc::TimeUTCMicros() - ts));
+        }
+
         int port = ntohs(addr.sin_port);
         char ip[64] = {0};
         inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
@@ -75,16 +112,14 @@ void AsyncUdpSocket::SendData() {
         if (sent < 0) {
             RTC_LOG(LS_WARNING) << "send udp packet error, remote_addr: " <<
                 packet->addr().ToString();
-            delete packet;
-            udp_packet_list_.pop_front();
+            PopUdpPacket();
             return;
         } else if (0 == sent) {
             RTC_LOG(LS_WARNING) << "send 0 bytes, try again, remote_addr: " <<
                 packet->addr().ToString();
             return;
         } else {
-            delete packet;
-            udp_packet_list_.pop_front();
+            PopUdpPacket();
         }
     }
 
@@ -94,9 +129,98 @@ void AsyncUdpSocket::SendData() {
 }
 
 int AsyncUdpSocket::SendTo(const char* data, size_t size, const rtc::SocketAddress& addr) {
+    // 发送缓冲区已满时，保持原来的顺序排队等待可写事件
+    if (t_send_batch_depth > 0 && udp_packet_list_.empty()) {
+        if (batch_packet_list_.empty()) {
+            t_batch_sockets.push_back(this);
+        }
+
+        batch_packet_list_.push_back(new UdpPacketData(data, size, addr));
+        if (batch_packet_list_.size() >= kMaxBatchSize) {
+            FlushBatch();
+        }
+
+        return size;
+    }
+
     return AddUdpPacket(data, size, addr);
 }
 
+void AsyncUdpSocket::FlushBatch() {
+    struct mmsghdr msgs[kMaxBatchSize];
+    struct iovec iovs[kMaxBatchSize];
+    sockaddr_storage saddrs[kMaxBatchSize];
+
+    size_t offset = 0;
+    while (offset < batch_packet_list_.size()) {
+        size_t count = std::min(kMaxBatchSize, batch_packet_list_.size() - offset);
+        memset(msgs, 0, sizeof(struct mmsghdr) * count);
+        for (size_t i = 0; i < count; ++i) {
+            UdpPacketData* packet = batch_packet_list_[offset + i];
+            iovs[i].iov_base = packet->data();
+            iovs[i].iov_len = packet->size();
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = &saddrs[i];
+            msgs[i].msg_hdr.msg_namelen = packet->addr().ToSockAddrStorage(&saddrs[i]);
+        }
+
+        int sent = SockSendMmsg(socket_, msgs, count, MSG_NOSIGNAL);
+        if (sent < 0) {
+            // 和单个发送一致，出错的包直接丢弃
+            RTC_LOG(LS_WARNING) << "send udp packet error, remote_addr: " <<
+                batch_packet_list_[offset]->addr().ToString();
+            delete batch_packet_list_[offset];
+            ++offset;
+        } else if (0 == sent) {
+            // 缓冲区已满，剩余的包等待可写事件再发送
+            for (; offset < batch_packet_list_.size(); ++offset) {
+                PushUdpPacket(batch_packet_list_[offset]);
+            }
+            el_->StartIOEvent(socket_watcher_, socket_, EventLoop::WRITE);
+        } else {
+            for (int i = 0; i < sent; ++i) {
+                delete batch_packet_list_[offset + i];
+            }
+            offset += sent;
+        }
+    }
+
+    batch_packet_list_.clear();
+}
+
+ScopedUdpSendBatch::ScopedUdpSendBatch() {
+    ++t_send_batch_depth;
+}
+
+ScopedUdpSendBatch::~ScopedUdpSendBatch() {
+    if (--t_send_batch_depth > 0) {
+        return;
+    }
+
+    std::vector<AsyncUdpSocket*> sockets;
+    sockets.swap(t_batch_sockets);
+    for (auto socket : sockets) {
+        socket->FlushBatch();
+    }
+}
+
+void AsyncUdpSocket::PushUdpPacket(UdpPacketData* packet) {
+    udp_packet_list_.push_back(packet);
+    udp_packet_list_bytes_ += packet->size();
+    while (udp_packet_list_bytes_ > kMaxPendingBytes && udp_packet_list_.size() > 1) {
+        PopUdpPacket();
+        Metrics::ThreadInstance()->Increment("udp_send_queue_dropped");
+    }
+}
+
+void AsyncUdpSocket::PopUdpPacket() {
+    UdpPacketData* packet = udp_packet_list_.front();
+    udp_packet_list_bytes_ -= packet->size();
+    udp_packet_list_.pop_front();
+    delete packet;
+}
+
 int AsyncUdpSocket::AddUdpPacket(const char* data, size_t size,
         const rtc::SocketAddress& addr)
 {
@@ -113,16 +237,14 @@ int AsyncUdpSocket::AddUdpPacket(const char* data, size_t size,
         if (sent < 0) {
             RTC_LOG(LS_WARNING) << "send udp packet error, remote_addr: " <<
                 packet->addr().ToString();
-            delete packet;
-            udp_packet_list_.pop_front();
+            PopUdpPacket();
             return -1;
         } else if (0 == sent) {
             RTC_LOG(LS_WARNING) << "send 0 bytes, try again, remote_addr: " <<
                 packet->addr().ToString();
             goto SEND_AGAIN;
         } else {
-            delete packet;
-            udp_packet_list_.pop_front();
+            PopUdpPacket();
         }
     }
 
@@ -142,7 +264,7 @@ int AsyncUdpSocket::AddUdpPacket(const char* data, size_t size,
 
 SEND_AGAIN: 
     UdpPacketData* packet_data = new UdpPacketData(data, size, addr);
-   udp_packet_list_.push_back(packet_data);
+   PushUdpPacket(packet_data);
    el_->StartIOEvent(socket_watcher_, socket_, EventLoop::WRITE);
 
     return size;
@@ -2,6 +2,7 @@
 #define  __XRTCSERVER_BASE_ASYNC_UDP_SOCKET_H_
 
 #include <list>
+#include <vector>
 
 #include <rtc_base/third_party/sigslot/sigslot.h>
 #include <rtc_base/socket_address.h>
@@ -46,12 +47,16 @@ public:
     void SendData();
 
     int SendTo(const char* data, size_t size, const rtc::SocketAddress& addr);
+    // 把批量发送期间缓存的包用sendmmsg发送出去
+    void FlushBatch();
 
     sigslot::signal5<AsyncUdpSocket*, char*, size_t, const rtc::SocketAddress&, int64_t>
         SignalReadPacket;
 
 private:
     int AddUdpPacket(const char* data, size_t size, const rtc::SocketAddress& addr);
+    void PushUdpPacket(UdpPacketData* packet);
+    void PopUdpPacket();
 
 private:
     EventLoop* el_;
@@ -61,6 +66,17 @@ private:
     size_t size_;
 
     std::list<UdpPacketData*> udp_packet_list_;
+    size_t udp_packet_list_bytes_ = 0;
+    std::vector<UdpPacketData*> batch_packet_list_;
+};
+
+// 作用域内通过AsyncUdpSocket发送的包先缓存在各自的socket中，
+// 作用域结束时每个socket用一次sendmmsg发送，减少系统调用的次数
+// 只能在事件循环所在的线程中使用，可以嵌套
+class ScopedUdpSendBatch {
+public:
+    ScopedUdpSendBatch();
+    ~ScopedUdpSendBatch();
 };
 
 } // namespace xrtc
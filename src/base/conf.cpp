@@ -7,6 +7,14 @@
 
 namespace xrtc {
 
+// 配置项不存在时保留原来的值，存在但是类型不对时抛出异常
+template <typename T>
+static void ReadOptional(const YAML::Node& node, T* value) {
+    if (node) {
+        *value = node.as<T>();
+    }
+}
+
 int LoadGeneralConf(const char* filename, GeneralConf* conf) {
     if (!filename || !conf) {
         fprintf(stderr, "filename or conf is nullptr\n");
@@ -29,12 +37,48 @@ int LoadGeneralConf(const char* filename, GeneralConf* conf) {
         conf->ice_max_port = config["ice"]["max_port"].as<int>();
         conf->rtcp_report_timer_interval = 
             config["rtp_rtcp"]["rtcp_report_timer_interval"].as<int>();
+        // 以下是后来增加的配置，缺少时使用GeneralConf中的默认值，原来的配置文件可以继续使用
+        ReadOptional(config["simulcast"]["subscriber_bitrate_kbps"],
+                &conf->subscriber_bitrate_kbps);
+        ReadOptional(config["bwe"]["min_bitrate_kbps"], &conf->bwe_min_bitrate_kbps);
+        ReadOptional(config["bwe"]["max_bitrate_kbps"], &conf->bwe_max_bitrate_kbps);
+        ReadOptional(config["bwe"]["remb_subscriber_cap"], &conf->remb_subscriber_cap);
+        ReadOptional(config["pacer"]["enable"], &conf->pacer_enabled);
+        ReadOptional(config["pacer"]["process_interval"], &conf->pacer_process_interval);
+        ReadOptional(config["pacer"]["pacing_factor"], &conf->pacing_factor);
+        ReadOptional(config["pacer"]["max_queue_bytes"], &conf->pacer_max_queue_bytes);
+        ReadOptional(config["pacer"]["max_queue_time_ms"], &conf->pacer_max_queue_time_ms);
+        ReadOptional(config["fec"]["enable"], &conf->fec_enabled);
+        ReadOptional(config["fec"]["min_loss_fraction"], &conf->fec_min_loss_fraction);
+        ReadOptional(config["fec"]["low_rtt_ms"], &conf->fec_low_rtt_ms);
+        ReadOptional(config["fec"]["high_rtt_ms"], &conf->fec_high_rtt_ms);
+        ReadOptional(config["video"]["relay_mode"], &conf->video_relay_mode);
+        ReadOptional(config["fanout"]["enable"], &conf->fanout_enabled);
+        ReadOptional(config["metrics"]["dump_interval"], &conf->metrics_dump_interval);
     } catch (const YAML::Exception& e) {
         fprintf(stderr, "catch a YAML::Exception, line: %d, column: %d"
                 ", error:%s\n", e.mark.line + 1, e.mark.column + 1, e.msg.c_str());
         return -1;
     }
 
+    if (conf->bwe_min_bitrate_kbps > conf->bwe_max_bitrate_kbps) {
+        fprintf(stderr, "bwe.min_bitrate_kbps(%d) is greater than bwe.max_bitrate_kbps(%d)\n",
+                conf->bwe_min_bitrate_kbps, conf->bwe_max_bitrate_kbps);
+        return -1;
+    }
+
+    if (conf->pacer_process_interval <= 0) {
+        fprintf(stderr, "pacer.process_interval(%d) must be positive\n",
+                conf->pacer_process_interval);
+        return -1;
+    }
+
+    if (conf->fec_low_rtt_ms > conf->fec_high_rtt_ms) {
+        fprintf(stderr, "fec.low_rtt_ms(%d) is greater than fec.high_rtt_ms(%d)\n",
+                conf->fec_low_rtt_ms, conf->fec_high_rtt_ms);
+        return -1;
+    }
+
     return 0;
 }
 
@@ -13,6 +13,31 @@ struct GeneralConf {
     int ice_min_port = 0;
     int ice_max_port = 0;
     int rtcp_report_timer_interval = 100;
+    // 拉流端默认的带宽预算，用于选择simulcast层
+    int subscriber_bitrate_kbps = 2500;
+    // 拉流端发送带宽估计的范围，初始值使用subscriber_bitrate_kbps
+    int bwe_min_bitrate_kbps = 100;
+    int bwe_max_bitrate_kbps = 8000;
+    // 发给推流端的REMB不超过拉流端能够接收的码率
+    bool remb_subscriber_cap = true;
+    // 拉流端的发送节奏控制，发送码率 = 带宽估计值 * pacing_factor
+    bool pacer_enabled = true;
+    int pacer_process_interval = 5;
+    double pacing_factor = 2.5;
+    // 拉流端发送队列的上限，超过之后按照丢帧策略丢弃
+    int pacer_max_queue_bytes = 1048576;
+    int pacer_max_queue_time_ms = 1000;
+    // 拉流端的FEC，按照丢包率和rtt在NACK/FEC/NACK+FEC之间切换
+    bool fec_enabled = true;
+    double fec_min_loss_fraction = 0.02;
+    int fec_low_rtt_ms = 50;
+    int fec_high_rtt_ms = 300;
+    // 视频只做转发，不解包组帧，需要帧数据的功能(录制等)单独开启组帧
+    bool video_relay_mode = true;
+    // 推流的rtp包分发到其他worker，拉流可以放在任意worker上，分摊热门流的发送开销
+    bool fanout_enabled = false;
+    // 运行时统计输出到日志的间隔，单位毫秒
+    int metrics_dump_interval = 10000;
 };
 
 int LoadGeneralConf(const char* filename, GeneralConf* conf);
@@ -0,0 +1,89 @@
+#include "base/metrics.h"
+
+#include <time.h>
+
+#include <sstream>
+
+namespace xrtc {
+
+Metrics* Metrics::ThreadInstance() {
+    static thread_local Metrics metrics;
+    return &metrics;
+}
+
+void Metrics::Increment(const std::string& name, int64_t delta) {
+    counters_[name] += delta;
+}
+
+void Metrics::SetGauge(const std::string& name, int64_t value) {
+    gauges_[name] = value;
+}
+
+void Metrics::Observe(const std::string& name, int64_t value) {
+    Summary& summary = summaries_[name];
+    ++summary.count;
+    summary.sum += value;
+    if (value > summary.max) {
+        summary.max = value;
+    }
+}
+
+int64_t Metrics::counter(const std::string& name) const {
+    auto iter = counters_.find(name);
+    return iter != counters_.end() ? iter->second : 0;
+}
+
+std::string Metrics::ToString() const {
+    std::stringstream ss;
+    for (auto& counter : counters_) {
+        ss << counter.first << "=" << counter.second << " ";
+    }
+
+    for (auto& gauge : gauges_) {
+        ss << gauge.first << "=" << gauge.second << " ";
+    }
+
+    for (auto& summary : summaries_) {
+        const Summary& s = summary.second;
+        ss << summary.first << "{count=" << s.count
+            << ",avg=" << (s.count > 0 ? s.sum / s.count : 0)
+            << ",max=" << s.max << "} ";
+    }
+
+    return ss.str();
+}
+
+void Metrics::Reset() {
+    counters_.clear();
+    summaries_.clear();
+}
+
+int64_t ThreadCpuTimeNanos() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return -1;
+    }
+
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+ScopedCpuTimer::ScopedCpuTimer(const char* name, bool enabled) :
+    name_(name)
+{
+    if (enabled) {
+        start_ns_ = ThreadCpuTimeNanos();
+    }
+}
+
+ScopedCpuTimer::~ScopedCpuTimer() {
+    if (start_ns_ < 0) {
+        return;
+    }
+
+    int64_t end_ns = ThreadCpuTimeNanos();
+    if (end_ns >= start_ns_) {
+        Metrics::ThreadInstance()->Observe(name_, end_ns - start_ns_);
+    }
+}
+
+} // namespace xrtc
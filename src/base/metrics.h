@@ -0,0 +1,58 @@
+#ifndef  __XRTCSERVER_BASE_METRICS_H_
+#define  __XRTCSERVER_BASE_METRICS_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+namespace xrtc {
+
+// 运行时统计，每个线程一份，只在所属的线程中访问，不需要加锁
+// 由工作线程的定时器周期性地输出到日志，并清零
+class Metrics {
+public:
+    struct Summary {
+        int64_t count = 0;
+        int64_t sum = 0;
+        int64_t max = 0;
+    };
+
+    // 当前线程的统计实例
+    static Metrics* ThreadInstance();
+
+    void Increment(const std::string& name, int64_t delta = 1);
+    void SetGauge(const std::string& name, int64_t value);
+    void Observe(const std::string& name, int64_t value);
+
+    int64_t counter(const std::string& name) const;
+
+    std::string ToString() const;
+    // 清空计数器和统计值，gauge保留最近一次的设置
+    void Reset();
+
+private:
+    std::map<std::string, int64_t> counters_;
+    std::map<std::string, int64_t> gauges_;
+    std::map<std::string, Summary> summaries_;
+};
+
+// 当前线程消耗的cpu时间，单位纳秒
+int64_t ThreadCpuTimeNanos();
+
+// 统计一个作用域内当前线程消耗的cpu时间，enabled为false时不做任何事情，
+// 用于在热点路径上按比例采样
+class ScopedCpuTimer {
+public:
+    ScopedCpuTimer(const char* name, bool enabled);
+    ~ScopedCpuTimer();
+
+private:
+    const char* name_;
+    int64_t start_ns_ = -1;
+};
+
+} // namespace xrtc
+
+
+#endif  //__XRTCSERVER_BASE_METRICS_H_
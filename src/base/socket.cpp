@@ -10,7 +10,7 @@
 
 namespace xrtc {
 
-int CreateTcpServer(const char* addr, int port) {
+int CreateTcpServer(const char* addr, int port, bool reuse_port) {
     // 1. 创建socket
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if (-1 == sock) {
@@ -29,6 +29,17 @@ int CreateTcpServer(const char* addr, int port) {
         return -1;
     }
 
+    // 由内核在监听同一个端口的socket之间分配新连接
+    if (reuse_port) {
+        ret = setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+        if (-1 == ret) {
+            RTC_LOG(LS_WARNING) << "setsockopt SO_REUSEPORT error, errno: " << errno
+                << ", error: " << strerror(errno);
+            close(sock);
+            return -1;
+        }
+    }
+
     // 3. 创建addr
     struct sockaddr_in sa;
     sa.sin_family = AF_INET;
@@ -203,6 +214,21 @@ int SockWriteData(int sock, const char* buf, size_t len) {
     return nwritten;
 }
 
+int SockWritevData(int sock, const struct iovec* iov, int iovcnt) {
+    int nwritten = writev(sock, iov, iovcnt);
+    if (-1 == nwritten) {
+        if (EAGAIN == errno) {
+            nwritten = 0;
+        } else {
+            RTC_LOG(LS_WARNING) << "sock writev failed, error: " << strerror(errno)
+                << ", errno: " << errno << ", fd: " << sock;
+            return -1;
+        }
+    }
+
+    return nwritten;
+}
+
 int SockBind(int sock, struct sockaddr* addr, socklen_t len, int min_port, int max_port) {
     int ret = -1;
     if (0 == min_port && 0 == max_port) {
@@ -244,10 +270,41 @@ int SockGetAddress(int sock, char* ip, int* port) {
     return 0;
 }
 
+int SockSetRecvTimestamp(int sock) {
+    // 开启之后，每个收到的udp包都会携带内核的接收时间
+    int on = 1;
+    int ret = setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on));
+    if (-1 == ret) {
+        RTC_LOG(LS_WARNING) << "setsockopt SO_TIMESTAMP error: " << strerror(errno)
+            << ", errno: " << errno;
+        return -1;
+    }
+
+    return 0;
+}
+
 int SockRecvFrom(int sock, char* buf, size_t size, struct sockaddr* addr, 
-        socklen_t addr_len)
+        socklen_t addr_len, int64_t* recv_time_us)
 {
-    int received = recvfrom(sock, buf, size, 0, addr, &addr_len);
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = size;
+
+    char control[CMSG_SPACE(sizeof(struct timeval))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = addr;
+    msg.msg_namelen = addr_len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recv_time_us) {
+        *recv_time_us = -1;
+    }
+
+    int received = recvmsg(sock, &msg, 0);
     if (received < 0) {
         if (EAGAIN == errno) {
             received = 0;
@@ -262,17 +319,20 @@ int SockRecvFrom(int sock, char* buf, size_t size, struct sockaddr* addr,
         return -1;
     }
 
-    return received;
-}
-
-int64_t SockGetRecvTimestamp(int sock) {
-    struct timeval time;
-    int ret = ioctl(sock, SIOCGARP, &time);
-    if (ret != 0) {
-        return -1;
+    if (received > 0 && recv_time_us) {
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+                cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (SOL_SOCKET == cmsg->cmsg_level && SCM_TIMESTAMP == cmsg->cmsg_type) {
+                struct timeval time;
+                memcpy(&time, CMSG_DATA(cmsg), sizeof(time));
+                *recv_time_us = (int64_t)time.tv_sec * 1000000 + time.tv_usec;
+                break;
+            }
+        }
     }
 
-    return time.tv_sec * 1000000 + time.tv_usec;
+    return received;
 }
 
 int SockSendTo(int sock, const char* buf, size_t len, int flag,
@@ -294,6 +354,20 @@ int SockSendTo(int sock, const char* buf, size_t len, int flag,
     return sent;
 }
 
+int SockSendMmsg(int sock, struct mmsghdr* msgs, unsigned int count, int flag) {
+    int sent = sendmmsg(sock, msgs, count, flag);
+    if (sent < 0) {
+        if (EAGAIN == errno) {
+            sent = 0;
+        } else {
+            RTC_LOG(LS_WARNING) << "sendmmsg error: " << strerror(errno) << ", errno: " << errno;
+            return -1;
+        }
+    }
+
+    return sent;
+}
+
 } // namespace xrtc
 
 
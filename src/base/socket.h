@@ -2,10 +2,12 @@
 #define  __XRTCSERVER_BASE_SOCKET_H_
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 namespace xrtc {
 
-int CreateTcpServer(const char* addr, int port);
+// reuse_port为true时设置SO_REUSEPORT，多个线程可以各自监听同一个端口
+int CreateTcpServer(const char* addr, int port, bool reuse_port = false);
 int CreateUdpSocket(int family);
 int TcpAccept(int sock, char* host, int* port);
 int SockSetnonblock(int sock);
@@ -13,12 +15,17 @@ int SockSetnodelay(int sock);
 int SockPeerToStr(int sock, char* ip, int* port);
 int SockReadData(int sock, char* buf, size_t len);
 int SockWriteData(int sock, const char* buf, size_t len);
+// 一次系统调用写入多个缓冲区，返回写入的字节数，缓冲区满时返回0
+int SockWritevData(int sock, const struct iovec* iov, int iovcnt);
 int SockBind(int sock, struct sockaddr* addr, socklen_t len, int min_port, int max_port);
 int SockGetAddress(int sock, char* ip, int* port);
-int SockRecvFrom(int sock, char* buf, size_t len, struct sockaddr* addr, socklen_t addr_len);
-int64_t SockGetRecvTimestamp(int sock);
+int SockSetRecvTimestamp(int sock);
+int SockRecvFrom(int sock, char* buf, size_t len, struct sockaddr* addr, socklen_t addr_len,
+        int64_t* recv_time_us = nullptr);
 int SockSendTo(int sock, const char* buf, size_t len, int flag,
         struct sockaddr* addr, socklen_t addr_len);
+// 一次系统调用发送多个udp包，返回成功发送的包的个数，缓冲区满时返回0
+int SockSendMmsg(int sock, struct mmsghdr* msgs, unsigned int count, int flag);
 
 } // namespace xrtc
 
@@ -0,0 +1,62 @@
+#ifndef  __XRTCSERVER_BASE_SPSC_RING_H_
+#define  __XRTCSERVER_BASE_SPSC_RING_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace xrtc {
+
+// 固定容量的环形队列，一个生产者，一个消费者。
+// 和LockFreeQueue不同，入队不分配内存，队列满时入队失败，由生产者决定丢弃
+template <typename T>
+class SpscRing {
+public:
+    // capacity向上取整到2的幂
+    explicit SpscRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    bool TryPush(T&& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T* value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        // 移走之后槽位中不再持有引用
+        *value = std::move(slots_[head & mask_]);
+        slots_[head & mask_] = T();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+    // 生产者和消费者各自修改的位置放在不同的cache line
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_BASE_SPSC_RING_H_
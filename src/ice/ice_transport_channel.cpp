@@ -366,6 +366,10 @@ int IceTransportChannel::SendPacket(const char* data, size_t len) {
     return sent;
 }
 
+int IceTransportChannel::rtt() {
+    return selected_connection_ ? selected_connection_->rtt() : -1;
+}
+
 std::string IceTransportChannel::ToString() {
     std::stringstream ss;
     ss << "Channel[" << this << ":" << transport_name_ << ":" << component_
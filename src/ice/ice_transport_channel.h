@@ -41,6 +41,8 @@ public:
     bool writable() { return writable_; }
     bool receiving() { return receiving_; }
     IceTransportState state() { return state_; }
+    // 选中的连接上stun ping测量的rtt，还没有选中连接时返回-1
+    int rtt();
 
     void set_ice_params(const IceParameters& ice_params);
     void set_remote_ice_params(const IceParameters& ice_params);
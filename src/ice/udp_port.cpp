@@ -46,6 +46,9 @@ int UDPPort::CreateIceCandidate(Network* network, int min_port, int max_port,
     if (SockSetnonblock(socket_) != 0) {
         return -1;
     }
+
+    // 内核时间戳用于transport-cc的到达时间，失败时退化为应用层时间
+    SockSetRecvTimestamp(socket_);
     
     sockaddr_in addr_in;
     addr_in.sin_family = network->ip().family();
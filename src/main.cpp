@@ -57,7 +57,9 @@ int InitSignalingServer() {
 
 int InitRtcServer() {
     g_rtc_server = new xrtc::RtcServer();
-    int ret = g_rtc_server->Init("./conf/rtc_server.yaml");
+    // 每个signaling worker和每个rtc worker之间一个消息队列
+    int ret = g_rtc_server->Init("./conf/rtc_server.yaml",
+            g_signaling_server->worker_num());
     if (ret != 0) {
         return -1;
     }
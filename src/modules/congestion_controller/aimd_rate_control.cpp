@@ -0,0 +1,87 @@
+#include "modules/congestion_controller/aimd_rate_control.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace xrtc {
+
+namespace {
+
+// 过载时降到实际吞吐量的85%
+const double kBeta = 0.85;
+const int64_t kMinDecreaseIntervalMs = 200;
+// 正常状态下每秒乘性增长8%
+const double kIncreaseFactor = 1.08;
+const int64_t kMinIncreaseBps = 1000;
+// 估计值最多超过实际吞吐量的1.5倍，避免在没有足够数据时无限增长
+const double kMaxThroughputRatio = 1.5;
+const int64_t kThroughputHeadroomBps = 10000;
+
+} // namespace
+
+AimdRateControl::AimdRateControl(int64_t start_bitrate_bps,
+        int64_t min_bitrate_bps,
+        int64_t max_bitrate_bps) :
+    min_bitrate_bps_(min_bitrate_bps),
+    max_bitrate_bps_(std::max(min_bitrate_bps, max_bitrate_bps)),
+    current_bitrate_bps_(start_bitrate_bps)
+{
+    current_bitrate_bps_ = Clamp(current_bitrate_bps_);
+}
+
+AimdRateControl::~AimdRateControl() {
+}
+
+int64_t AimdRateControl::Update(BandwidthUsage usage,
+        absl::optional<int64_t> throughput_bps,
+        int64_t now_ms)
+{
+    switch (usage) {
+        case BandwidthUsage::kBwOverusing:
+            if (last_decrease_ms_ < 0 ||
+                now_ms - last_decrease_ms_ >= kMinDecreaseIntervalMs)
+            {
+                int64_t base_bitrate_bps = throughput_bps ?
+                    *throughput_bps : current_bitrate_bps_;
+                current_bitrate_bps_ = std::min(current_bitrate_bps_,
+                        static_cast<int64_t>(kBeta * base_bitrate_bps));
+                last_decrease_ms_ = now_ms;
+            }
+            last_increase_ms_ = now_ms;
+            break;
+        case BandwidthUsage::kBwUnderusing:
+            // 队列正在排空，保持当前的估计值
+            last_increase_ms_ = now_ms;
+            break;
+        case BandwidthUsage::kBwNormal: {
+            if (last_increase_ms_ < 0) {
+                last_increase_ms_ = now_ms;
+            }
+
+            if (throughput_bps && current_bitrate_bps_ >=
+                    kMaxThroughputRatio * (*throughput_bps) + kThroughputHeadroomBps)
+            {
+                last_increase_ms_ = now_ms;
+                break;
+            }
+
+            double elapsed_s = std::min<int64_t>(now_ms - last_increase_ms_,
+                    1000) / 1000.0;
+            int64_t increase_bps = std::max<int64_t>(kMinIncreaseBps,
+                    current_bitrate_bps_ * (pow(kIncreaseFactor, elapsed_s) - 1.0));
+            current_bitrate_bps_ += increase_bps;
+            last_increase_ms_ = now_ms;
+            break;
+        }
+    }
+
+    current_bitrate_bps_ = Clamp(current_bitrate_bps_);
+    return current_bitrate_bps_;
+}
+
+int64_t AimdRateControl::Clamp(int64_t bitrate_bps) const {
+    return std::max(min_bitrate_bps_, std::min(bitrate_bps, max_bitrate_bps_));
+}
+
+} // namespace xrtc
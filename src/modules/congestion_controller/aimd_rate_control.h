@@ -0,0 +1,37 @@
+#ifndef  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_AIMD_RATE_CONTROL_H_
+#define  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_AIMD_RATE_CONTROL_H_
+
+#include <absl/types/optional.h>
+
+#include "modules/congestion_controller/trendline_estimator.h"
+
+namespace xrtc {
+
+// 基于延迟检测结果的加性增/乘性减码率控制
+// 发送端带宽估计和接收端带宽估计共用，输入的码率分别是对端确认的码率和本端收到的码率
+class AimdRateControl {
+public:
+    AimdRateControl(int64_t start_bitrate_bps,
+            int64_t min_bitrate_bps,
+            int64_t max_bitrate_bps);
+    ~AimdRateControl();
+
+    int64_t Update(BandwidthUsage usage,
+            absl::optional<int64_t> throughput_bps,
+            int64_t now_ms);
+    int64_t LatestEstimate() const { return current_bitrate_bps_; }
+
+private:
+    int64_t Clamp(int64_t bitrate_bps) const;
+
+private:
+    int64_t min_bitrate_bps_;
+    int64_t max_bitrate_bps_;
+    int64_t current_bitrate_bps_;
+    int64_t last_increase_ms_ = -1;
+    int64_t last_decrease_ms_ = -1;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_CONGESTION_CONTROLLER_AIMD_RATE_CONTROL_H_
@@ -0,0 +1,75 @@
+#include "modules/congestion_controller/receive_side_bandwidth_estimation.h"
+
+namespace xrtc {
+
+namespace {
+
+const int64_t kIncomingRateWindowMs = 1000;
+const float kRateScaleBps = 8000.0f;
+// 没有检测到过载时，每隔这么长时间更新一次估计值
+const int64_t kUpdateIntervalMs = 100;
+const int kAbsSendTimeFraction = 18;
+const int64_t kAbsSendTimeWrap = 1 << 24;
+
+} // namespace
+
+ReceiveSideBandwidthEstimation::ReceiveSideBandwidthEstimation(
+        int64_t start_bitrate_bps,
+        int64_t min_bitrate_bps,
+        int64_t max_bitrate_bps) :
+    rate_control_(start_bitrate_bps, min_bitrate_bps, max_bitrate_bps),
+    incoming_bitrate_(kIncomingRateWindowMs, kRateScaleBps)
+{
+}
+
+ReceiveSideBandwidthEstimation::~ReceiveSideBandwidthEstimation() {
+}
+
+bool ReceiveSideBandwidthEstimation::OnPacketArrival(uint32_t abs_send_time,
+        int64_t arrival_time_ms, size_t size)
+{
+    incoming_bitrate_.Update(size, arrival_time_ms);
+
+    PacketResult packet;
+    packet.send_time_ms = UnwrapSendTimeMs(abs_send_time);
+    packet.receive_time_ms = arrival_time_ms;
+    packet.size = size;
+
+    BandwidthUsage prev_state = trendline_estimator_.State();
+    trendline_estimator_.OnPacketFeedback(packet);
+
+    // 刚进入过载状态时立即降低，其它情况下按照固定间隔更新
+    bool overusing = trendline_estimator_.State() == BandwidthUsage::kBwOverusing &&
+        prev_state != BandwidthUsage::kBwOverusing;
+    if (!overusing && last_update_ms_ >= 0 &&
+        arrival_time_ms - last_update_ms_ < kUpdateIntervalMs)
+    {
+        return false;
+    }
+
+    int64_t prev_bitrate_bps = rate_control_.LatestEstimate();
+    rate_control_.Update(trendline_estimator_.State(),
+            incoming_bitrate_.Rate(arrival_time_ms), arrival_time_ms);
+    last_update_ms_ = arrival_time_ms;
+    return rate_control_.LatestEstimate() != prev_bitrate_bps;
+}
+
+int64_t ReceiveSideBandwidthEstimation::UnwrapSendTimeMs(uint32_t abs_send_time) {
+    int64_t send_time = abs_send_time & (kAbsSendTimeWrap - 1);
+    if (last_abs_send_time_ >= 0) {
+        // 24位的时间戳大约64秒回绕一次，按照最小差值展开
+        int64_t delta = (send_time - last_abs_send_time_ + kAbsSendTimeWrap) %
+            kAbsSendTimeWrap;
+        if (delta >= kAbsSendTimeWrap / 2) {
+            delta -= kAbsSendTimeWrap;
+        }
+        unwrapped_send_time_ += delta;
+    } else {
+        unwrapped_send_time_ = send_time;
+    }
+
+    last_abs_send_time_ = send_time;
+    return (unwrapped_send_time_ * 1000) >> kAbsSendTimeFraction;
+}
+
+} // namespace xrtc
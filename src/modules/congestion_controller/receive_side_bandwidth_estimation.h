@@ -0,0 +1,42 @@
+#ifndef  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_RECEIVE_SIDE_BANDWIDTH_ESTIMATION_H_
+#define  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_RECEIVE_SIDE_BANDWIDTH_ESTIMATION_H_
+
+#include <rtc_base/rate_statistics.h>
+
+#include "modules/congestion_controller/trendline_estimator.h"
+#include "modules/congestion_controller/aimd_rate_control.h"
+
+namespace xrtc {
+
+// 推流端的接收端带宽估计，根据abs-send-time扩展中的发送时间和本端的到达时间
+// 检测上行链路的排队延迟，估计值通过REMB反馈给推流端
+// 和发送端带宽估计一样只依赖外部传入的时间
+class ReceiveSideBandwidthEstimation {
+public:
+    ReceiveSideBandwidthEstimation(int64_t start_bitrate_bps,
+            int64_t min_bitrate_bps,
+            int64_t max_bitrate_bps);
+    ~ReceiveSideBandwidthEstimation();
+
+    // abs_send_time是24位的6.18定点数，单位是秒
+    // 返回true表示估计值发生了变化
+    bool OnPacketArrival(uint32_t abs_send_time, int64_t arrival_time_ms, size_t size);
+
+    int64_t target_bitrate_bps() const { return rate_control_.LatestEstimate(); }
+
+private:
+    int64_t UnwrapSendTimeMs(uint32_t abs_send_time);
+
+private:
+    TrendlineEstimator trendline_estimator_;
+    AimdRateControl rate_control_;
+    webrtc::RateStatistics incoming_bitrate_;
+    int64_t last_update_ms_ = -1;
+
+    int64_t last_abs_send_time_ = -1;
+    int64_t unwrapped_send_time_ = 0;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_CONGESTION_CONTROLLER_RECEIVE_SIDE_BANDWIDTH_ESTIMATION_H_
@@ -0,0 +1,119 @@
+#include "modules/congestion_controller/send_side_bandwidth_estimation.h"
+
+#include <algorithm>
+
+namespace xrtc {
+
+namespace {
+
+const int64_t kAckedRateWindowMs = 1000;
+const float kRateScaleBps = 8000.0f;
+// 至少统计这么多个包之后才更新丢包率
+const int kLimitNumPackets = 20;
+const double kLossBasedIncreaseFactor = 1.08;
+const int64_t kLossBasedMinIncreaseBps = 1000;
+const double kLowLossThreshold = 0.02;
+const double kHighLossThreshold = 0.1;
+const int64_t kLossIncreaseIntervalMs = 1000;
+const int64_t kLossDecreaseIntervalMs = 300;
+
+} // namespace
+
+SendSideBandwidthEstimation::SendSideBandwidthEstimation(int64_t start_bitrate_bps,
+        int64_t min_bitrate_bps,
+        int64_t max_bitrate_bps) :
+    min_bitrate_bps_(min_bitrate_bps),
+    max_bitrate_bps_(std::max(min_bitrate_bps, max_bitrate_bps)),
+    loss_based_bitrate_bps_(start_bitrate_bps),
+    delay_based_rate_control_(start_bitrate_bps, min_bitrate_bps, max_bitrate_bps),
+    acked_bitrate_(kAckedRateWindowMs, kRateScaleBps)
+{
+    loss_based_bitrate_bps_ = Clamp(loss_based_bitrate_bps_);
+}
+
+SendSideBandwidthEstimation::~SendSideBandwidthEstimation() {
+}
+
+void SendSideBandwidthEstimation::OnSentPacket(uint16_t transport_seq, size_t size,
+        int64_t send_time_ms)
+{
+    feedback_adapter_.AddPacket(transport_seq, size, send_time_ms);
+}
+
+bool SendSideBandwidthEstimation::OnTransportFeedback(
+        const webrtc::rtcp::TransportFeedback& feedback,
+        int64_t now_ms)
+{
+    TransportPacketsFeedback report;
+    if (!feedback_adapter_.ProcessTransportFeedback(feedback, now_ms, &report)) {
+        return false;
+    }
+
+    int64_t prev_target_bitrate_bps = target_bitrate_bps();
+
+    for (const PacketResult& packet : report.packet_feedbacks) {
+        if (packet.received()) {
+            acked_bitrate_.Update(packet.size, now_ms);
+            trendline_estimator_.OnPacketFeedback(packet);
+        }
+    }
+
+    delay_based_rate_control_.Update(trendline_estimator_.State(),
+            acked_bitrate_.Rate(now_ms), now_ms);
+    UpdateLossBased(report, now_ms);
+
+    return target_bitrate_bps() != prev_target_bitrate_bps;
+}
+
+int64_t SendSideBandwidthEstimation::target_bitrate_bps() const {
+    return Clamp(std::min(delay_based_rate_control_.LatestEstimate(),
+                loss_based_bitrate_bps_));
+}
+
+void SendSideBandwidthEstimation::UpdateLossBased(
+        const TransportPacketsFeedback& feedback,
+        int64_t now_ms)
+{
+    for (const PacketResult& packet : feedback.packet_feedbacks) {
+        ++expected_packets_since_last_update_;
+        if (!packet.received()) {
+            ++lost_packets_since_last_update_;
+        }
+    }
+
+    if (expected_packets_since_last_update_ < kLimitNumPackets) {
+        return;
+    }
+
+    last_loss_fraction_ = static_cast<double>(lost_packets_since_last_update_) /
+        expected_packets_since_last_update_;
+    lost_packets_since_last_update_ = 0;
+    expected_packets_since_last_update_ = 0;
+
+    if (last_loss_fraction_ <= kLowLossThreshold) {
+        // 低丢包时，在当前的目标码率上增长，避免和基于延迟的估计值拉开太大
+        if (last_loss_increase_ms_ < 0 ||
+            now_ms - last_loss_increase_ms_ >= kLossIncreaseIntervalMs)
+        {
+            loss_based_bitrate_bps_ = static_cast<int64_t>(
+                    target_bitrate_bps() * kLossBasedIncreaseFactor) + kLossBasedMinIncreaseBps;
+            last_loss_increase_ms_ = now_ms;
+        }
+    } else if (last_loss_fraction_ > kHighLossThreshold) {
+        if (last_loss_decrease_ms_ < 0 ||
+            now_ms - last_loss_decrease_ms_ >= kLossDecreaseIntervalMs)
+        {
+            loss_based_bitrate_bps_ = static_cast<int64_t>(
+                    loss_based_bitrate_bps_ * (1.0 - 0.5 * last_loss_fraction_));
+            last_loss_decrease_ms_ = now_ms;
+        }
+    }
+
+    loss_based_bitrate_bps_ = Clamp(loss_based_bitrate_bps_);
+}
+
+int64_t SendSideBandwidthEstimation::Clamp(int64_t bitrate_bps) const {
+    return std::max(min_bitrate_bps_, std::min(bitrate_bps, max_bitrate_bps_));
+}
+
+} // namespace xrtc
@@ -0,0 +1,58 @@
+#ifndef  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_SEND_SIDE_BANDWIDTH_ESTIMATION_H_
+#define  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_SEND_SIDE_BANDWIDTH_ESTIMATION_H_
+
+#include <rtc_base/rate_statistics.h>
+
+#include "modules/congestion_controller/transport_feedback_adapter.h"
+#include "modules/congestion_controller/trendline_estimator.h"
+#include "modules/congestion_controller/aimd_rate_control.h"
+
+namespace xrtc {
+
+// 每个拉流端一个的发送端带宽估计，取基于延迟和基于丢包两个估计值中的较小值
+// 只依赖外部传入的时间，不依赖事件循环，可以直接用模拟链路驱动
+class SendSideBandwidthEstimation {
+public:
+    SendSideBandwidthEstimation(int64_t start_bitrate_bps,
+            int64_t min_bitrate_bps,
+            int64_t max_bitrate_bps);
+    ~SendSideBandwidthEstimation();
+
+    void OnSentPacket(uint16_t transport_seq, size_t size, int64_t send_time_ms);
+    // 返回true表示估计值发生了变化
+    bool OnTransportFeedback(const webrtc::rtcp::TransportFeedback& feedback,
+            int64_t now_ms);
+
+    int64_t target_bitrate_bps() const;
+    int64_t delay_based_bitrate_bps() const {
+        return delay_based_rate_control_.LatestEstimate();
+    }
+    int64_t loss_based_bitrate_bps() const { return loss_based_bitrate_bps_; }
+    double loss_fraction() const { return last_loss_fraction_; }
+    size_t outstanding_bytes() const { return feedback_adapter_.outstanding_bytes(); }
+
+private:
+    void UpdateLossBased(const TransportPacketsFeedback& feedback, int64_t now_ms);
+    int64_t Clamp(int64_t bitrate_bps) const;
+
+private:
+    int64_t min_bitrate_bps_;
+    int64_t max_bitrate_bps_;
+    int64_t loss_based_bitrate_bps_;
+
+    TransportFeedbackAdapter feedback_adapter_;
+    TrendlineEstimator trendline_estimator_;
+    AimdRateControl delay_based_rate_control_;
+    // 对端确认收到的码率
+    webrtc::RateStatistics acked_bitrate_;
+
+    int lost_packets_since_last_update_ = 0;
+    int expected_packets_since_last_update_ = 0;
+    double last_loss_fraction_ = 0;
+    int64_t last_loss_increase_ms_ = -1;
+    int64_t last_loss_decrease_ms_ = -1;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_CONGESTION_CONTROLLER_SEND_SIDE_BANDWIDTH_ESTIMATION_H_
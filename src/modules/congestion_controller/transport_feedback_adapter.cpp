@@ -0,0 +1,94 @@
+#include "modules/congestion_controller/transport_feedback_adapter.h"
+
+#include <rtc_base/logging.h>
+
+namespace xrtc {
+
+namespace {
+
+// 超过这个时间还没有收到反馈的包，认为反馈已经丢失
+const int64_t kSendTimeHistoryWindowMs = 60000;
+
+} // namespace
+
+TransportFeedbackAdapter::TransportFeedbackAdapter() {
+}
+
+TransportFeedbackAdapter::~TransportFeedbackAdapter() {
+}
+
+void TransportFeedbackAdapter::AddPacket(uint16_t transport_seq, size_t size,
+        int64_t send_time_ms)
+{
+    PruneHistory(send_time_ms);
+
+    int64_t seq = seq_unwrapper_.Unwrap(transport_seq);
+    SentPacket& packet = history_[seq];
+    packet.send_time_ms = send_time_ms;
+    packet.size = size;
+    packet.acked = false;
+    outstanding_bytes_ += size;
+}
+
+void TransportFeedbackAdapter::PruneHistory(int64_t now_ms) {
+    while (!history_.empty() &&
+           now_ms - history_.begin()->second.send_time_ms > kSendTimeHistoryWindowMs)
+    {
+        if (!history_.begin()->second.acked) {
+            outstanding_bytes_ -= history_.begin()->second.size;
+        }
+        history_.erase(history_.begin());
+    }
+}
+
+bool TransportFeedbackAdapter::ProcessTransportFeedback(
+        const webrtc::rtcp::TransportFeedback& feedback,
+        int64_t feedback_time_ms,
+        TransportPacketsFeedback* result)
+{
+    uint16_t status_count = feedback.GetPacketStatusCount();
+    if (0 == status_count) {
+        RTC_LOG(LS_WARNING) << "empty transport feedback packet received";
+        return false;
+    }
+
+    result->feedback_time_ms = feedback_time_ms;
+    result->packet_feedbacks.clear();
+
+    int64_t base_seq = seq_unwrapper_.Unwrap(feedback.GetBaseSequence());
+    const std::vector<webrtc::rtcp::TransportFeedback::ReceivedPacket>& received =
+        feedback.GetReceivedPackets();
+    int64_t receive_time_us = feedback.GetBaseTimeUs();
+    size_t received_index = 0;
+
+    for (uint16_t i = 0; i < status_count; ++i) {
+        int64_t seq = base_seq + i;
+        PacketResult packet_result;
+        if (received_index < received.size() &&
+            received[received_index].sequence_number() == static_cast<uint16_t>(seq))
+        {
+            receive_time_us += received[received_index].delta_us();
+            packet_result.receive_time_ms = receive_time_us / 1000;
+            ++received_index;
+        }
+
+        auto iter = history_.find(seq);
+        if (iter == history_.end()) {
+            continue;
+        }
+
+        SentPacket& sent_packet = iter->second;
+        if (!sent_packet.acked) {
+            sent_packet.acked = true;
+            outstanding_bytes_ -= sent_packet.size;
+        }
+
+        packet_result.send_time_ms = sent_packet.send_time_ms;
+        packet_result.size = sent_packet.size;
+        result->packet_feedbacks.push_back(packet_result);
+    }
+
+    return !result->packet_feedbacks.empty();
+}
+
+} // namespace xrtc
@@ -0,0 +1,58 @@
+#ifndef  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_TRANSPORT_FEEDBACK_ADAPTER_H_
+#define  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_TRANSPORT_FEEDBACK_ADAPTER_H_
+
+#include <map>
+#include <vector>
+
+#include <modules/include/module_common_types_public.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/transport_feedback.h>
+
+namespace xrtc {
+
+struct PacketResult {
+    bool received() const { return receive_time_ms >= 0; }
+
+    int64_t send_time_ms = -1;
+    // 对端时钟的到达时间，只有差值有意义，-1表示丢失
+    int64_t receive_time_ms = -1;
+    size_t size = 0;
+};
+
+struct TransportPacketsFeedback {
+    int64_t feedback_time_ms = -1;
+    // 按照transport-wide序列号排列，包含丢失的包
+    std::vector<PacketResult> packet_feedbacks;
+};
+
+// 记录本端每个transport-wide序列号的发送时间和大小，
+// 收到transport-cc反馈之后，组合成每个包的发送/到达时间
+class TransportFeedbackAdapter {
+public:
+    TransportFeedbackAdapter();
+    ~TransportFeedbackAdapter();
+
+    void AddPacket(uint16_t transport_seq, size_t size, int64_t send_time_ms);
+    bool ProcessTransportFeedback(const webrtc::rtcp::TransportFeedback& feedback,
+            int64_t feedback_time_ms, TransportPacketsFeedback* result);
+
+    // 已经发送但是还没有收到反馈的字节数
+    size_t outstanding_bytes() const { return outstanding_bytes_; }
+
+private:
+    struct SentPacket {
+        int64_t send_time_ms;
+        size_t size;
+        bool acked;
+    };
+
+    void PruneHistory(int64_t now_ms);
+
+private:
+    webrtc::SequenceNumberUnwrapper seq_unwrapper_;
+    std::map<int64_t, SentPacket> history_;
+    size_t outstanding_bytes_ = 0;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_CONGESTION_CONTROLLER_TRANSPORT_FEEDBACK_ADAPTER_H_
@@ -0,0 +1,192 @@
+#include "modules/congestion_controller/trendline_estimator.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace xrtc {
+
+namespace {
+
+// 5ms内发送的包认为是同一组
+const int64_t kBurstDeltaThresholdMs = 5;
+const size_t kWindowSize = 20;
+const double kSmoothingCoef = 0.9;
+const double kThresholdGain = 4.0;
+const int kMinNumDeltas = 60;
+const int kDeltaCounterMax = 1000;
+const double kOverUsingTimeThresholdMs = 10;
+const double kInitialThreshold = 12.5;
+const double kMinThreshold = 6.0;
+const double kMaxThreshold = 600.0;
+const double kMaxAdaptOffsetMs = 15.0;
+const double kUpThresholdCoef = 0.0087;
+const double kDownThresholdCoef = 0.039;
+const int64_t kMaxThresholdUpdateIntervalMs = 100;
+
+bool LinearFitSlope(const std::deque<std::pair<double, double>>& points,
+        double* slope)
+{
+    double sum_x = 0;
+    double sum_y = 0;
+    for (const auto& point : points) {
+        sum_x += point.first;
+        sum_y += point.second;
+    }
+
+    double x_avg = sum_x / points.size();
+    double y_avg = sum_y / points.size();
+    double numerator = 0;
+    double denominator = 0;
+    for (const auto& point : points) {
+        double x = point.first;
+        double y = point.second;
+        numerator += (x - x_avg) * (y - y_avg);
+        denominator += (x - x_avg) * (x - x_avg);
+    }
+
+    if (denominator == 0) {
+        return false;
+    }
+
+    *slope = numerator / denominator;
+    return true;
+}
+
+} // namespace
+
+TrendlineEstimator::TrendlineEstimator() :
+    threshold_(kInitialThreshold)
+{
+}
+
+TrendlineEstimator::~TrendlineEstimator() {
+}
+
+void TrendlineEstimator::OnPacketFeedback(const PacketResult& packet) {
+    if (!packet.received()) {
+        return;
+    }
+
+    if (current_group_.first_send_time_ms < 0) {
+        current_group_.first_send_time_ms = packet.send_time_ms;
+        current_group_.last_send_time_ms = packet.send_time_ms;
+        current_group_.last_receive_time_ms = packet.receive_time_ms;
+        return;
+    }
+
+    // 乱序的包不参与计算
+    if (packet.send_time_ms < current_group_.first_send_time_ms) {
+        return;
+    }
+
+    if (packet.send_time_ms - current_group_.first_send_time_ms <= kBurstDeltaThresholdMs) {
+        current_group_.last_send_time_ms = std::max(current_group_.last_send_time_ms,
+                packet.send_time_ms);
+        current_group_.last_receive_time_ms = std::max(
+                current_group_.last_receive_time_ms, packet.receive_time_ms);
+        return;
+    }
+
+    // 当前组已经完整，和上一组比较
+    if (prev_group_.first_send_time_ms >= 0) {
+        double send_delta_ms = current_group_.last_send_time_ms -
+            prev_group_.last_send_time_ms;
+        double recv_delta_ms = current_group_.last_receive_time_ms -
+            prev_group_.last_receive_time_ms;
+        UpdateTrendline(recv_delta_ms, send_delta_ms, current_group_.last_receive_time_ms);
+    }
+
+    prev_group_ = current_group_;
+    current_group_.first_send_time_ms = packet.send_time_ms;
+    current_group_.last_send_time_ms = packet.send_time_ms;
+    current_group_.last_receive_time_ms = packet.receive_time_ms;
+}
+
+void TrendlineEstimator::UpdateTrendline(double recv_delta_ms, double send_delta_ms,
+        int64_t arrival_time_ms)
+{
+    double delta_ms = recv_delta_ms - send_delta_ms;
+    num_of_deltas_ = std::min(num_of_deltas_ + 1, kDeltaCounterMax);
+    if (first_arrival_time_ms_ < 0) {
+        first_arrival_time_ms_ = arrival_time_ms;
+    }
+
+    // 累积的排队延迟做指数平滑
+    accumulated_delay_ += delta_ms;
+    smoothed_delay_ = kSmoothingCoef * smoothed_delay_ +
+        (1 - kSmoothingCoef) * accumulated_delay_;
+
+    delay_hist_.emplace_back(
+            static_cast<double>(arrival_time_ms - first_arrival_time_ms_),
+            smoothed_delay_);
+    if (delay_hist_.size() > kWindowSize) {
+        delay_hist_.pop_front();
+    }
+
+    double trend = prev_trend_;
+    if (delay_hist_.size() == kWindowSize) {
+        LinearFitSlope(delay_hist_, &trend);
+    }
+
+    Detect(trend, send_delta_ms, arrival_time_ms);
+}
+
+void TrendlineEstimator::Detect(double trend, double send_delta_ms, int64_t now_ms) {
+    if (num_of_deltas_ < 2) {
+        hypothesis_ = BandwidthUsage::kBwNormal;
+        return;
+    }
+
+    double modified_trend = std::min(num_of_deltas_, kMinNumDeltas) * trend *
+        kThresholdGain;
+    if (modified_trend > threshold_) {
+        if (time_over_using_ < 0) {
+            time_over_using_ = send_delta_ms / 2;
+        } else {
+            time_over_using_ += send_delta_ms;
+        }
+
+        ++overuse_counter_;
+        // 持续一段时间并且延迟还在增长，才认为是过载
+        if (time_over_using_ > kOverUsingTimeThresholdMs && overuse_counter_ > 1 &&
+            trend >= prev_trend_)
+        {
+            time_over_using_ = 0;
+            overuse_counter_ = 0;
+            hypothesis_ = BandwidthUsage::kBwOverusing;
+        }
+    } else if (modified_trend < -threshold_) {
+        time_over_using_ = -1;
+        overuse_counter_ = 0;
+        hypothesis_ = BandwidthUsage::kBwUnderusing;
+    } else {
+        time_over_using_ = -1;
+        overuse_counter_ = 0;
+        hypothesis_ = BandwidthUsage::kBwNormal;
+    }
+
+    prev_trend_ = trend;
+    UpdateThreshold(modified_trend, now_ms);
+}
+
+void TrendlineEstimator::UpdateThreshold(double modified_trend, int64_t now_ms) {
+    if (last_threshold_update_ms_ < 0) {
+        last_threshold_update_ms_ = now_ms;
+    }
+
+    // 突发的大延迟不用来调整阈值
+    if (fabs(modified_trend) > threshold_ + kMaxAdaptOffsetMs) {
+        last_threshold_update_ms_ = now_ms;
+        return;
+    }
+
+    double k = fabs(modified_trend) < threshold_ ? kDownThresholdCoef : kUpThresholdCoef;
+    int64_t time_delta_ms = std::min(now_ms - last_threshold_update_ms_,
+            kMaxThresholdUpdateIntervalMs);
+    threshold_ += k * (fabs(modified_trend) - threshold_) * time_delta_ms;
+    threshold_ = std::max(kMinThreshold, std::min(threshold_, kMaxThreshold));
+    last_threshold_update_ms_ = now_ms;
+}
+
+} // namespace xrtc
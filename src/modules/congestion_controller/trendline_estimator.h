@@ -0,0 +1,62 @@
+#ifndef  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_TRENDLINE_ESTIMATOR_H_
+#define  XRTCSERVER_MODULES_CONGESTION_CONTROLLER_TRENDLINE_ESTIMATOR_H_
+
+#include <deque>
+#include <utility>
+
+#include "modules/congestion_controller/transport_feedback_adapter.h"
+
+namespace xrtc {
+
+enum class BandwidthUsage {
+    kBwNormal,
+    kBwUnderusing,
+    kBwOverusing,
+};
+
+// 基于延迟梯度的拥塞检测：按照发送时间把包分组，计算相邻两组之间
+// 到达间隔与发送间隔的差值，对累积的排队延迟做线性拟合，
+// 斜率超过自适应阈值时认为链路过载
+class TrendlineEstimator {
+public:
+    TrendlineEstimator();
+    ~TrendlineEstimator();
+
+    // 按照序列号顺序输入每个已经到达的包
+    void OnPacketFeedback(const PacketResult& packet);
+    BandwidthUsage State() const { return hypothesis_; }
+
+private:
+    struct PacketGroup {
+        int64_t first_send_time_ms = -1;
+        int64_t last_send_time_ms = -1;
+        int64_t last_receive_time_ms = -1;
+    };
+
+    void UpdateTrendline(double recv_delta_ms, double send_delta_ms,
+            int64_t arrival_time_ms);
+    void Detect(double trend, double send_delta_ms, int64_t now_ms);
+    void UpdateThreshold(double modified_trend, int64_t now_ms);
+
+private:
+    PacketGroup current_group_;
+    PacketGroup prev_group_;
+
+    int num_of_deltas_ = 0;
+    int64_t first_arrival_time_ms_ = -1;
+    double accumulated_delay_ = 0;
+    double smoothed_delay_ = 0;
+    // (到达时间, 平滑后的累积延迟)
+    std::deque<std::pair<double, double>> delay_hist_;
+
+    double threshold_;
+    double prev_trend_ = 0;
+    double time_over_using_ = -1;
+    int overuse_counter_ = 0;
+    int64_t last_threshold_update_ms_ = -1;
+    BandwidthUsage hypothesis_ = BandwidthUsage::kBwNormal;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_CONGESTION_CONTROLLER_TRENDLINE_ESTIMATOR_H_
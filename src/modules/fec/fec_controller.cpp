@@ -0,0 +1,71 @@
+#include "modules/fec/fec_controller.h"
+
+#include <algorithm>
+
+namespace xrtc {
+
+namespace {
+
+const double kLossSmoothingCoef = 0.7;
+// 丢包率回落到阈值的一半以下才关闭FEC，避免在阈值附近来回切换
+const double kDisableLossRatio = 0.5;
+// 和NACK一起使用时FEC只需要覆盖重传来不及的部分，单独使用时需要更多的冗余
+const double kNackAndFecOverhead = 1.5;
+const double kFecOnlyOverhead = 2.5;
+const double kMinProtection = 0.05;
+const double kMaxProtection = 0.5;
+
+} // namespace
+
+FecController::FecController(const FecControllerConfig& config) :
+    config_(config)
+{
+}
+
+FecController::~FecController() {
+}
+
+void FecController::Update(double loss_fraction, int64_t rtt_ms) {
+    smoothed_loss_fraction_ = kLossSmoothingCoef * smoothed_loss_fraction_ +
+        (1 - kLossSmoothingCoef) * loss_fraction;
+
+    double enable_threshold = config_.min_loss_fraction;
+    if (mode_ != ProtectionMode::kNack) {
+        enable_threshold *= kDisableLossRatio;
+    }
+
+    if (smoothed_loss_fraction_ < enable_threshold ||
+        (rtt_ms > 0 && rtt_ms < config_.low_rtt_ms))
+    {
+        mode_ = ProtectionMode::kNack;
+        protection_factor_ = 0;
+        return;
+    }
+
+    // 还没有rtt时两种方式一起使用
+    double overhead = kNackAndFecOverhead;
+    mode_ = ProtectionMode::kNackAndFec;
+    if (rtt_ms >= config_.high_rtt_ms) {
+        mode_ = ProtectionMode::kFec;
+        overhead = kFecOnlyOverhead;
+    }
+
+    double protection = std::max(kMinProtection,
+            std::min(smoothed_loss_fraction_ * overhead, kMaxProtection));
+    protection_factor_ = (uint8_t)(protection * 255);
+}
+
+const char* ProtectionModeToString(ProtectionMode mode) {
+    switch (mode) {
+        case ProtectionMode::kNack:
+            return "nack";
+        case ProtectionMode::kFec:
+            return "fec";
+        case ProtectionMode::kNackAndFec:
+            return "nack+fec";
+        default:
+            return "unknown";
+    }
+}
+
+} // namespace xrtc
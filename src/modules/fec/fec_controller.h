@@ -0,0 +1,49 @@
+#ifndef  XRTCSERVER_MODULES_FEC_FEC_CONTROLLER_H_
+#define  XRTCSERVER_MODULES_FEC_FEC_CONTROLLER_H_
+
+#include <stdint.h>
+
+namespace xrtc {
+
+enum class ProtectionMode {
+    kNack,
+    kFec,
+    kNackAndFec,
+};
+
+struct FecControllerConfig {
+    // 丢包率低于这个值时只使用NACK
+    double min_loss_fraction = 0.02;
+    // rtt低于这个值时重传足够快，只使用NACK
+    int64_t low_rtt_ms = 50;
+    // rtt高于这个值时重传来不及，只使用FEC
+    int64_t high_rtt_ms = 300;
+};
+
+// 按照拉流端的丢包率和rtt选择抗丢包方式和FEC的保护比例
+// 只依赖外部传入的统计，不依赖事件循环
+class FecController {
+public:
+    explicit FecController(const FecControllerConfig& config);
+    ~FecController();
+
+    // loss_fraction: 0~1，rtt_ms <= 0表示还没有rtt
+    void Update(double loss_fraction, int64_t rtt_ms);
+
+    ProtectionMode mode() const { return mode_; }
+    // FEC包数相对媒体包数的比例 * 256，kNack时为0
+    uint8_t protection_factor() const { return protection_factor_; }
+    double smoothed_loss_fraction() const { return smoothed_loss_fraction_; }
+
+private:
+    FecControllerConfig config_;
+    double smoothed_loss_fraction_ = 0;
+    ProtectionMode mode_ = ProtectionMode::kNack;
+    uint8_t protection_factor_ = 0;
+};
+
+const char* ProtectionModeToString(ProtectionMode mode);
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_FEC_FEC_CONTROLLER_H_
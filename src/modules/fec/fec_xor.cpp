@@ -0,0 +1,113 @@
+#include "modules/fec/fec_xor.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define XRTC_FEC_XOR_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define XRTC_FEC_XOR_NEON 1
+#endif
+
+namespace xrtc {
+
+namespace {
+
+typedef void (*FecXorFunc)(uint8_t* dst, const uint8_t* src, size_t size);
+
+struct FecXorImpl {
+    FecXorFunc func;
+    const char* name;
+};
+
+void FecXorGeneric(uint8_t* dst, const uint8_t* src, size_t size) {
+    size_t i = 0;
+    // rtp负载没有对齐保证，用memcpy按字读写，编译器会优化成普通的load/store
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t a;
+        uint64_t b;
+        memcpy(&a, dst + i, sizeof(a));
+        memcpy(&b, src + i, sizeof(b));
+        a ^= b;
+        memcpy(dst + i, &a, sizeof(a));
+    }
+
+    for (; i < size; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+#if defined(XRTC_FEC_XOR_X86)
+
+__attribute__((target("sse2")))
+void FecXorSse2(uint8_t* dst, const uint8_t* src, size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(a, b));
+    }
+
+    FecXorGeneric(dst + i, src + i, size - i);
+}
+
+__attribute__((target("avx2")))
+void FecXorAvx2(uint8_t* dst, const uint8_t* src, size_t size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(a, b));
+    }
+
+    FecXorSse2(dst + i, src + i, size - i);
+}
+
+#elif defined(XRTC_FEC_XOR_NEON)
+
+void FecXorNeon(uint8_t* dst, const uint8_t* src, size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t a = vld1q_u8(dst + i);
+        uint8x16_t b = vld1q_u8(src + i);
+        vst1q_u8(dst + i, veorq_u8(a, b));
+    }
+
+    FecXorGeneric(dst + i, src + i, size - i);
+}
+
+#endif
+
+FecXorImpl SelectFecXorImpl() {
+#if defined(XRTC_FEC_XOR_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {FecXorAvx2, "avx2"};
+    }
+
+    if (__builtin_cpu_supports("sse2")) {
+        return {FecXorSse2, "sse2"};
+    }
+#elif defined(XRTC_FEC_XOR_NEON)
+    return {FecXorNeon, "neon"};
+#endif
+    return {FecXorGeneric, "generic"};
+}
+
+const FecXorImpl& GetFecXorImpl() {
+    static const FecXorImpl impl = SelectFecXorImpl();
+    return impl;
+}
+
+} // namespace
+
+void FecXor(uint8_t* dst, const uint8_t* src, size_t size) {
+    GetFecXorImpl().func(dst, src, size);
+}
+
+const char* FecXorImplementation() {
+    return GetFecXorImpl().name;
+}
+
+} // namespace xrtc
@@ -0,0 +1,18 @@
+#ifndef  XRTCSERVER_MODULES_FEC_FEC_XOR_H_
+#define  XRTCSERVER_MODULES_FEC_FEC_XOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace xrtc {
+
+// dst[i] ^= src[i]，FEC编码的热点
+// 启动时按照CPU支持的指令集选择实现(AVX2/SSE2/NEON)，其余平台使用按字处理的通用实现
+void FecXor(uint8_t* dst, const uint8_t* src, size_t size);
+
+// 当前使用的实现，用于日志
+const char* FecXorImplementation();
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_FEC_FEC_XOR_H_
@@ -0,0 +1,121 @@
+#include "modules/fec/ulpfec_generator.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <rtc_base/byte_io.h>
+
+#include "modules/fec/fec_xor.h"
+
+namespace xrtc {
+
+namespace {
+
+const size_t kRtpHeaderSize = 12;
+const size_t kFecHeaderSize = 10;
+// ULP level header: protection length(2字节) + mask(2字节或者6字节)
+const size_t kUlpHeaderSizeLBitClear = 2 + 2;
+const size_t kUlpHeaderSizeLBitSet = 2 + 6;
+const size_t kMaskBitsLBitClear = 16;
+
+uint16_t SequenceNumber(const rtc::CopyOnWriteBuffer& packet) {
+    return rtc::ByteReader<uint16_t>::ReadBigEndian(packet.data() + 2);
+}
+
+} // namespace
+
+UlpfecGenerator::UlpfecGenerator() {
+}
+
+UlpfecGenerator::~UlpfecGenerator() {
+}
+
+void UlpfecGenerator::SetProtectionFactor(uint8_t protection_factor) {
+    protection_factor_ = protection_factor;
+    if (0 == protection_factor_) {
+        media_packets_.clear();
+    }
+}
+
+void UlpfecGenerator::AddMediaPacket(const rtc::CopyOnWriteBuffer& packet, bool marker) {
+    if (0 == protection_factor_ || packet.size() <= kRtpHeaderSize) {
+        return;
+    }
+
+    // 掩码按照相对序列号标记，丢包后的序列号跳变不能放在同一组里
+    if (!media_packets_.empty() &&
+        SequenceNumber(packet) != (uint16_t)(SequenceNumber(media_packets_.back()) + 1))
+    {
+        media_packets_.clear();
+    }
+
+    // 只增加引用计数，不拷贝数据
+    media_packets_.push_back(packet);
+    if (marker || media_packets_.size() >= kMaxMediaPackets) {
+        Encode();
+        media_packets_.clear();
+    }
+}
+
+std::vector<rtc::CopyOnWriteBuffer> UlpfecGenerator::GetFecPackets() {
+    std::vector<rtc::CopyOnWriteBuffer> fec_packets;
+    fec_packets.swap(fec_packets_);
+    return fec_packets;
+}
+
+void UlpfecGenerator::Encode() {
+    size_t num_media_packets = media_packets_.size();
+    size_t num_fec_packets = (num_media_packets * protection_factor_ + 255) / 256;
+    num_fec_packets = std::min(num_fec_packets, num_media_packets);
+    if (0 == num_fec_packets) {
+        return;
+    }
+
+    bool l_bit = num_media_packets > kMaskBitsLBitClear;
+    size_t fec_header_size = kFecHeaderSize +
+        (l_bit ? kUlpHeaderSizeLBitSet : kUlpHeaderSizeLBitClear);
+    uint16_t seq_num_base = SequenceNumber(media_packets_.front());
+
+    for (size_t j = 0; j < num_fec_packets; ++j) {
+        size_t protection_length = 0;
+        for (size_t i = j; i < num_media_packets; i += num_fec_packets) {
+            protection_length = std::max(protection_length,
+                    media_packets_[i].size() - kRtpHeaderSize);
+        }
+
+        rtc::CopyOnWriteBuffer fec_packet(fec_header_size + protection_length);
+        uint8_t* fec_data = fec_packet.MutableData();
+        memset(fec_data, 0, fec_packet.size());
+
+        uint16_t length_recovery = 0;
+        uint8_t* mask = fec_data + kFecHeaderSize + 2;
+        for (size_t i = j; i < num_media_packets; i += num_fec_packets) {
+            const uint8_t* media_data = media_packets_[i].data();
+            size_t media_payload_length = media_packets_[i].size() - kRtpHeaderSize;
+
+            // P/X/CC和M/PT恢复字段
+            fec_data[0] ^= media_data[0];
+            fec_data[1] ^= media_data[1];
+            // TS恢复字段
+            FecXor(fec_data + 4, media_data + 4, 4);
+            length_recovery ^= (uint16_t)media_payload_length;
+            // rtp固定头之后的部分(csrc、扩展头、负载)全部参与异或
+            FecXor(fec_data + fec_header_size, media_data + kRtpHeaderSize,
+                    media_payload_length);
+
+            mask[i / 8] |= 0x80 >> (i % 8);
+        }
+
+        // E = 0, L标记掩码长度
+        fec_data[0] = (fec_data[0] & 0x3f) | (l_bit ? 0x40 : 0x00);
+        rtc::ByteWriter<uint16_t>::WriteBigEndian(fec_data + 2, seq_num_base);
+        rtc::ByteWriter<uint16_t>::WriteBigEndian(fec_data + 8, length_recovery);
+        rtc::ByteWriter<uint16_t>::WriteBigEndian(fec_data + kFecHeaderSize,
+                (uint16_t)protection_length);
+
+        fec_packets_.push_back(std::move(fec_packet));
+    }
+}
+
+} // namespace xrtc
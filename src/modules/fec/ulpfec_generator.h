@@ -0,0 +1,42 @@
+#ifndef  XRTCSERVER_MODULES_FEC_ULPFEC_GENERATOR_H_
+#define  XRTCSERVER_MODULES_FEC_ULPFEC_GENERATOR_H_
+
+#include <vector>
+
+#include <rtc_base/copy_on_write_buffer.h>
+
+namespace xrtc {
+
+// RFC5109 ULPFEC编码，每个拉流端一个
+// 输入最终发送的媒体包(序列号已经确定，没有RED封装)，一帧结束时按照保护比例
+// 生成FEC数据，FEC包之间交错保护(第j个FEC包保护第j, j+k, j+2k...个媒体包)，
+// 突发丢失连续的几个包时仍然可以恢复
+class UlpfecGenerator {
+public:
+    // 一组FEC最多保护的媒体包数，对应48bit的掩码
+    static const size_t kMaxMediaPackets = 48;
+
+    UlpfecGenerator();
+    ~UlpfecGenerator();
+
+    // 保护比例，FEC包数 = 媒体包数 * protection_factor / 256，向上取整，0表示不生成
+    void SetProtectionFactor(uint8_t protection_factor);
+    uint8_t protection_factor() const { return protection_factor_; }
+
+    // 帧结束(marker)或者达到上限时编码，序列号不连续时放弃当前这一组
+    void AddMediaPacket(const rtc::CopyOnWriteBuffer& packet, bool marker);
+    // 取出编码好的FEC数据(ULPFEC头 + 负载)，由调用方封装成RED包发送
+    std::vector<rtc::CopyOnWriteBuffer> GetFecPackets();
+
+private:
+    void Encode();
+
+private:
+    uint8_t protection_factor_ = 0;
+    std::vector<rtc::CopyOnWriteBuffer> media_packets_;
+    std::vector<rtc::CopyOnWriteBuffer> fec_packets_;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_FEC_ULPFEC_GENERATOR_H_
@@ -0,0 +1,270 @@
+#include "modules/pacing/paced_sender.h"
+
+#include <algorithm>
+
+#include "base/async_udp_socket.h"
+#include "base/conf.h"
+#include "base/metrics.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+#include "modules/video_coding/h264_utils.h"
+
+extern xrtc::GeneralConf* g_conf;
+
+namespace xrtc {
+
+namespace {
+
+// 预算最多累积两个发送周期，限制空闲之后的突发
+const int64_t kMaxBudgetIntervals = 2;
+// 排队时间超过这个值时，临时提高发送码率把队列排空
+const int64_t kMaxExpectedQueueTimeMs = 2000;
+// 等待关键帧期间，重复请求关键帧的间隔
+const int64_t kKeyFrameRequestIntervalMs = 1000;
+
+void PacerProcessCb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+    PacedSender* pacer = (PacedSender*)data;
+    pacer->Process();
+}
+
+void RewriteSequenceNumber(rtc::CopyOnWriteBuffer* packet, uint16_t delta) {
+    RtpPacketView view;
+    if (view.Parse(packet->MutableData(), packet->size())) {
+        view.SetSequenceNumber(view.SequenceNumber() - delta);
+    }
+}
+
+} // namespace
+
+PacedSender::PacedSender(webrtc::Clock* clock, EventLoop* el,
+        int64_t pacing_rate_bps) :
+    clock_(clock),
+    el_(el),
+    pacing_rate_bps_(pacing_rate_bps)
+{
+    process_timer_ = el_->CreateTimer(PacerProcessCb, this, true);
+}
+
+PacedSender::~PacedSender() {
+    if (process_timer_) {
+        el_->DeleteTimer(process_timer_);
+        process_timer_ = nullptr;
+    }
+}
+
+void PacedSender::SetPacingRate(int64_t pacing_rate_bps) {
+    pacing_rate_bps_ = pacing_rate_bps;
+}
+
+void PacedSender::EnqueuePacket(PacketPriority priority, webrtc::MediaType media_type,
+        rtc::CopyOnWriteBuffer packet)
+{
+    // 音频码率很低，对延迟敏感，不排队直接发送，只消耗预算
+    if (PacketPriority::kAudio == priority) {
+        budget_bytes_ -= packet.size();
+        SendPacket(priority, media_type, &packet);
+        return;
+    }
+
+    int64_t now_ms = clock_->TimeInMilliseconds();
+    QueuedPacket queued{media_type, std::move(packet), now_ms, 0, false};
+
+    if (PacketPriority::kVideo == priority) {
+        RtpPacketView view;
+        if (view.Parse(queued.packet.cdata(), queued.packet.size())) {
+            if (waiting_for_keyframe_ && IsH264KeyFrameStart(view.payload())) {
+                waiting_for_keyframe_ = false;
+            }
+            queued.timestamp = view.Timestamp();
+            queued.non_reference = IsH264NonReference(view.payload());
+        }
+    }
+
+    if (waiting_for_keyframe_) {
+        // 关键帧之前的视频和重传都已经没有意义
+        OnPacketDropped(queued);
+        if (PacketPriority::kVideo == priority) {
+            ++video_seq_offset_;
+        }
+        return;
+    }
+
+    if (PacketPriority::kVideo == priority && video_seq_offset_ != 0) {
+        RewriteSequenceNumber(&queued.packet, video_seq_offset_);
+    }
+
+    queue_bytes_ += queued.packet.size();
+    ++queue_packets_;
+    queues_[(int)priority].push_back(std::move(queued));
+
+    EnforceQueueLimits(now_ms);
+
+    // 队列原来是空的，立即发送预算内的包，剩余的交给定时器
+    if (!timer_started_) {
+        Process();
+    }
+}
+
+void PacedSender::Process() {
+    int64_t now_ms = clock_->TimeInMilliseconds();
+    EnforceQueueLimits(now_ms);
+    UpdateBudget(now_ms);
+
+    int64_t max_queue_delay_ms = 0;
+    {
+        ScopedUdpSendBatch batch;
+        for (int i = 0; i < (int)PacketPriority::kNumPriorities; ++i) {
+            std::deque<QueuedPacket>& queue = queues_[i];
+            while (!queue.empty() && budget_bytes_ > 0) {
+                QueuedPacket& queued = queue.front();
+                max_queue_delay_ms = std::max(max_queue_delay_ms,
+                        now_ms - queued.enqueue_time_ms);
+                budget_bytes_ -= queued.packet.size();
+                queue_bytes_ -= queued.packet.size();
+                --queue_packets_;
+                if (PacketPriority::kVideo == (PacketPriority)i) {
+                    has_sent_video_ = true;
+                    last_sent_video_timestamp_ = queued.timestamp;
+                }
+                SendPacket((PacketPriority)i, queued.media_type, &queued.packet);
+                queue.pop_front();
+            }
+        }
+    }
+
+    if (max_queue_delay_ms > 0) {
+        Metrics::ThreadInstance()->Observe("pacer_queue_delay_ms", max_queue_delay_ms);
+    }
+
+    if (waiting_for_keyframe_ && now_ms - last_keyframe_request_ms_ >=
+            kKeyFrameRequestIntervalMs)
+    {
+        RequestKeyFrame(now_ms);
+    }
+
+    // 等待关键帧期间保持定时器，用于重复请求关键帧
+    bool need_timer = queue_packets_ > 0 || waiting_for_keyframe_;
+    if (need_timer && !timer_started_) {
+        el_->StartTimer(process_timer_, g_conf->pacer_process_interval * 1000);
+        timer_started_ = true;
+    } else if (!need_timer && timer_started_) {
+        el_->StopTimer(process_timer_);
+        timer_started_ = false;
+    }
+}
+
+void PacedSender::UpdateBudget(int64_t now_ms) {
+    int64_t pacing_rate_bps = pacing_rate_bps_;
+    if (queue_bytes_ > 0) {
+        // 保证队列中的数据能够在限定的时间内发送完
+        pacing_rate_bps = std::max(pacing_rate_bps,
+                (int64_t)(queue_bytes_ * 8 * 1000 / kMaxExpectedQueueTimeMs));
+    }
+
+    int64_t max_budget_bytes = pacing_rate_bps * g_conf->pacer_process_interval *
+        kMaxBudgetIntervals / 8000;
+    if (last_process_time_ms_ < 0) {
+        budget_bytes_ = max_budget_bytes;
+    } else {
+        int64_t elapsed_ms = now_ms - last_process_time_ms_;
+        budget_bytes_ = std::min(budget_bytes_ + pacing_rate_bps * elapsed_ms / 8000,
+                max_budget_bytes);
+    }
+
+    last_process_time_ms_ = now_ms;
+}
+
+bool PacedSender::IsQueueOverLimit(int64_t now_ms) const {
+    if (queue_bytes_ > (size_t)g_conf->pacer_max_queue_bytes) {
+        return true;
+    }
+
+    for (const auto& queue : queues_) {
+        if (!queue.empty() &&
+            now_ms - queue.front().enqueue_time_ms > g_conf->pacer_max_queue_time_ms)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PacedSender::EnforceQueueLimits(int64_t now_ms) {
+    if (!IsQueueOverLimit(now_ms)) {
+        return;
+    }
+
+    DropNonReferencePackets();
+    if (!IsQueueOverLimit(now_ms)) {
+        return;
+    }
+
+    DropUntilKeyFrame(now_ms);
+}
+
+void PacedSender::DropNonReferencePackets() {
+    std::deque<QueuedPacket>& queue = queues_[(int)PacketPriority::kVideo];
+    std::deque<QueuedPacket> kept;
+    uint16_t dropped = 0;
+    for (auto& queued : queue) {
+        if (queued.non_reference && !(has_sent_video_ &&
+                    queued.timestamp == last_sent_video_timestamp_))
+        {
+            queue_bytes_ -= queued.packet.size();
+            --queue_packets_;
+            ++drop_stats_.dropped_non_reference_packets;
+            OnPacketDropped(queued);
+            ++dropped;
+            continue;
+        }
+
+        // 后面的包补上被丢弃的序列号
+        if (dropped > 0) {
+            RewriteSequenceNumber(&queued.packet, dropped);
+        }
+        kept.push_back(std::move(queued));
+    }
+
+    queue.swap(kept);
+    video_seq_offset_ += dropped;
+}
+
+void PacedSender::DropUntilKeyFrame(int64_t now_ms) {
+    std::deque<QueuedPacket>& video_queue = queues_[(int)PacketPriority::kVideo];
+    video_seq_offset_ += video_queue.size();
+
+    for (PacketPriority priority : {PacketPriority::kRetransmission,
+            PacketPriority::kVideo, PacketPriority::kPadding})
+    {
+        std::deque<QueuedPacket>& queue = queues_[(int)priority];
+        for (const auto& queued : queue) {
+            queue_bytes_ -= queued.packet.size();
+            --queue_packets_;
+            OnPacketDropped(queued);
+        }
+        queue.clear();
+    }
+
+    ++drop_stats_.keyframe_waits;
+    waiting_for_keyframe_ = true;
+    RequestKeyFrame(now_ms);
+}
+
+void PacedSender::OnPacketDropped(const QueuedPacket& queued) {
+    ++drop_stats_.dropped_packets;
+    drop_stats_.dropped_bytes += queued.packet.size();
+    Metrics::ThreadInstance()->Increment("pacer_dropped_packets");
+}
+
+void PacedSender::RequestKeyFrame(int64_t now_ms) {
+    last_keyframe_request_ms_ = now_ms;
+    SignalKeyFrameRequired();
+}
+
+void PacedSender::SendPacket(PacketPriority priority, webrtc::MediaType media_type,
+        rtc::CopyOnWriteBuffer* packet)
+{
+    SignalSendPacket(media_type, priority, packet);
+}
+
+} // namespace xrtc
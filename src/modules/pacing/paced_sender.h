@@ -0,0 +1,105 @@
+#ifndef  XRTCSERVER_MODULES_PACING_PACED_SENDER_H_
+#define  XRTCSERVER_MODULES_PACING_PACED_SENDER_H_
+
+#include <deque>
+
+#include <api/media_types.h>
+#include <rtc_base/copy_on_write_buffer.h>
+#include <rtc_base/third_party/sigslot/sigslot.h>
+#include <system_wrappers/include/clock.h>
+
+#include "base/event_loop.h"
+
+namespace xrtc {
+
+// 数值越小优先级越高
+enum class PacketPriority {
+    kAudio = 0,
+    kRetransmission,
+    kVideo,
+    kPadding,
+    kNumPriorities,
+};
+
+// 发送队列超限之后丢弃的统计
+struct PacerDropStats {
+    int64_t dropped_packets = 0;
+    int64_t dropped_bytes = 0;
+    // 其中因为不被参考而优先丢弃的视频包
+    int64_t dropped_non_reference_packets = 0;
+    // 清空队列并等待关键帧的次数
+    int64_t keyframe_waits = 0;
+};
+
+// 每个拉流端一个，按照下行带宽估计值平滑发送rtp包，避免关键帧的突发
+// 溢出NAT和路由器的缓冲区。音频不排队，其余的包按照优先级排队，
+// 由定时器驱动，每次唤醒在预算内批量发送
+//
+// 队列有字节数和排队时间的上限，超限时先丢弃不被参考的视频帧，
+// 仍然超限则清空视频和重传队列，丢弃之后的视频直到下一个关键帧，并请求关键帧。
+// 丢弃的视频包之后的序列号依次前移，拉流端看到的是一路连续的流
+class PacedSender {
+public:
+    PacedSender(webrtc::Clock* clock, EventLoop* el, int64_t pacing_rate_bps);
+    ~PacedSender();
+
+    void SetPacingRate(int64_t pacing_rate_bps);
+    void EnqueuePacket(PacketPriority priority, webrtc::MediaType media_type,
+            rtc::CopyOnWriteBuffer packet);
+    void Process();
+
+    size_t queue_packets() const { return queue_packets_; }
+    size_t queue_bytes() const { return queue_bytes_; }
+    const PacerDropStats& drop_stats() const { return drop_stats_; }
+
+    sigslot::signal3<webrtc::MediaType, PacketPriority, rtc::CopyOnWriteBuffer*>
+        SignalSendPacket;
+    sigslot::signal0<> SignalKeyFrameRequired;
+
+private:
+    struct QueuedPacket {
+        webrtc::MediaType media_type;
+        rtc::CopyOnWriteBuffer packet;
+        int64_t enqueue_time_ms;
+        uint32_t timestamp;
+        bool non_reference;
+    };
+
+    void UpdateBudget(int64_t now_ms);
+    bool IsQueueOverLimit(int64_t now_ms) const;
+    void EnforceQueueLimits(int64_t now_ms);
+    void DropNonReferencePackets();
+    void DropUntilKeyFrame(int64_t now_ms);
+    void OnPacketDropped(const QueuedPacket& queued);
+    void RequestKeyFrame(int64_t now_ms);
+    void SendPacket(PacketPriority priority, webrtc::MediaType media_type,
+            rtc::CopyOnWriteBuffer* packet);
+
+private:
+    webrtc::Clock* clock_;
+    EventLoop* el_;
+    TimerWatcher* process_timer_ = nullptr;
+    bool timer_started_ = false;
+
+    int64_t pacing_rate_bps_;
+    // 可以发送的字节数，发送大包之后可以为负
+    int64_t budget_bytes_ = 0;
+    int64_t last_process_time_ms_ = -1;
+
+    std::deque<QueuedPacket> queues_[(int)PacketPriority::kNumPriorities];
+    size_t queue_packets_ = 0;
+    size_t queue_bytes_ = 0;
+
+    // 已经丢弃的视频包个数，之后入队的视频包序列号减去这个值
+    uint16_t video_seq_offset_ = 0;
+    // 已经开始发送的帧不能再丢弃，否则拉流端会收到不完整的帧
+    bool has_sent_video_ = false;
+    uint32_t last_sent_video_timestamp_ = 0;
+    bool waiting_for_keyframe_ = false;
+    int64_t last_keyframe_request_ms_ = -1;
+    PacerDropStats drop_stats_;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_PACING_PACED_SENDER_H_
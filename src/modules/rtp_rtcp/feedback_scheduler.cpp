@@ -0,0 +1,131 @@
+#include "modules/rtp_rtcp/feedback_scheduler.h"
+
+#include "base/metrics.h"
+
+namespace xrtc {
+
+    namespace {
+
+        // 调度的精度，两次唤醒之间缓存的反馈最多延迟一个周期发送
+        const int kFeedbackTickMs = 5;
+
+        void FeedbackTickCb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+            FeedbackScheduler* scheduler = (FeedbackScheduler*)data;
+            scheduler->Process();
+        }
+
+    } // namespace
+
+    FeedbackScheduler::FeedbackScheduler(EventLoop* el, webrtc::Clock* clock) :
+            el_(el),
+            clock_(clock)
+    {
+        tick_timer_ = el_->CreateTimer(FeedbackTickCb, this, true);
+    }
+
+    FeedbackScheduler::~FeedbackScheduler() {
+        for (auto& entry : entries_) {
+            if (entry.module) {
+                entry.module->scheduler_index_ = FeedbackModule::kNotRegistered;
+            }
+        }
+
+        if (tick_timer_) {
+            el_->DeleteTimer(tick_timer_);
+            tick_timer_ = nullptr;
+        }
+    }
+
+    void FeedbackScheduler::AddModule(FeedbackModule* module, int64_t next_process_ms) {
+        if (IsRegistered(module)) {
+            entries_[module->scheduler_index_].next_process_ms = next_process_ms;
+            return;
+        }
+
+        module->scheduler_index_ = entries_.size();
+        entries_.push_back(Entry{next_process_ms, module});
+        ++num_modules_;
+
+        if (!timer_started_) {
+            el_->StartTimer(tick_timer_, kFeedbackTickMs * 1000);
+            timer_started_ = true;
+        }
+    }
+
+    void FeedbackScheduler::RemoveModule(FeedbackModule* module) {
+        if (!IsRegistered(module)) {
+            return;
+        }
+
+        size_t index = module->scheduler_index_;
+        module->scheduler_index_ = FeedbackModule::kNotRegistered;
+        --num_modules_;
+
+        if (processing_) {
+            entries_[index].module = nullptr;
+            need_compact_ = true;
+        } else {
+            // 和最后一个交换之后删除，其余模块的位置不变
+            entries_[index] = entries_.back();
+            entries_.pop_back();
+            if (index < entries_.size()) {
+                entries_[index].module->scheduler_index_ = index;
+            }
+        }
+
+        if (0 == num_modules_ && timer_started_) {
+            el_->StopTimer(tick_timer_);
+            timer_started_ = false;
+        }
+    }
+
+    void FeedbackScheduler::ScheduleNow(FeedbackModule* module) {
+        if (IsRegistered(module)) {
+            entries_[module->scheduler_index_].next_process_ms = 0;
+        }
+    }
+
+    void FeedbackScheduler::Process() {
+        int64_t now_ms = clock_->TimeInMilliseconds();
+        int processed = 0;
+
+        processing_ = true;
+        // 处理过程中可能有模块注册，数组可能重新分配，只能通过下标访问
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            FeedbackModule* module = entries_[i].module;
+            if (!module || entries_[i].next_process_ms > now_ms) {
+                continue;
+            }
+
+            int64_t next_process_ms = module->ProcessFeedback(now_ms);
+            if (entries_[i].module == module) {
+                entries_[i].next_process_ms = next_process_ms;
+            }
+            ++processed;
+        }
+        processing_ = false;
+
+        if (need_compact_) {
+            Compact();
+        }
+
+        Metrics::ThreadInstance()->Observe("feedback_modules_processed", processed);
+    }
+
+    void FeedbackScheduler::Compact() {
+        size_t n = 0;
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            if (!entries_[i].module) {
+                continue;
+            }
+
+            entries_[n] = entries_[i];
+            entries_[n].module->scheduler_index_ = n;
+            ++n;
+        }
+
+        entries_.resize(n);
+        need_compact_ = false;
+    }
+
+} // namespace xrtc
@@ -0,0 +1,74 @@
+#ifndef  __XRTCSERVER_MODULES_RTP_RTCP_FEEDBACK_SCHEDULER_H_
+#define  __XRTCSERVER_MODULES_RTP_RTCP_FEEDBACK_SCHEDULER_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <system_wrappers/include/clock.h>
+
+#include "base/event_loop.h"
+
+namespace xrtc {
+
+    class FeedbackScheduler;
+
+    // 需要周期性生成rtcp反馈的模块(RR/SR、NACK、transport-cc等)
+    class FeedbackModule {
+    public:
+        virtual ~FeedbackModule() {}
+
+        // 到期时由调度器调用，返回下一次需要处理的时间
+        virtual int64_t ProcessFeedback(int64_t now_ms) = 0;
+
+    private:
+        friend class FeedbackScheduler;
+        static const size_t kNotRegistered = static_cast<size_t>(-1);
+        // 在调度器数组中的位置
+        size_t scheduler_index_ = kNotRegistered;
+    };
+
+    // 每个worker一个，用一个定时器代替每个会话、每个模块各自的定时器，
+    // 每次唤醒按顺序遍历到期时间的数组，只调用到期的模块。
+    // 模块在两次唤醒之间产生的反馈(例如收包时触发的NACK)先缓存，
+    // 在下一次唤醒时和RR等一起打包成一个复合rtcp包
+    class FeedbackScheduler {
+    public:
+        FeedbackScheduler(EventLoop* el, webrtc::Clock* clock);
+        ~FeedbackScheduler();
+
+        void AddModule(FeedbackModule* module, int64_t next_process_ms);
+        void RemoveModule(FeedbackModule* module);
+        // 在下一次唤醒时处理该模块
+        void ScheduleNow(FeedbackModule* module);
+        bool IsRegistered(const FeedbackModule* module) const {
+            return module->scheduler_index_ != FeedbackModule::kNotRegistered;
+        }
+
+        void Process();
+        size_t num_modules() const { return num_modules_; }
+
+    private:
+        void Compact();
+
+    private:
+        struct Entry {
+            int64_t next_process_ms;
+            FeedbackModule* module;
+        };
+
+        EventLoop* el_;
+        webrtc::Clock* clock_;
+        TimerWatcher* tick_timer_ = nullptr;
+        bool timer_started_ = false;
+        // 到期时间和模块放在连续的数组中，遍历时只读取这个数组
+        std::vector<Entry> entries_;
+        size_t num_modules_ = 0;
+        bool processing_ = false;
+        // 处理过程中被删除的模块先置空，处理结束后再压缩
+        bool need_compact_ = false;
+    };
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_MODULES_RTP_RTCP_FEEDBACK_SCHEDULER_H_
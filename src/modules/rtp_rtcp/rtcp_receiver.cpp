@@ -3,14 +3,30 @@
 #include <rtc_base/logging.h>
 #include <modules/rtp_rtcp/source/rtcp_packet/sender_report.h>
 #include <modules/rtp_rtcp/source/rtcp_packet/receiver_report.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/rtpfb.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/psfb.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/nack.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/pli.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/fir.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/transport_feedback.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/extended_reports.h>
+#include <modules/rtp_rtcp/source/time_util.h>
 
 namespace xrtc {
 
     struct RTCPReceiver::PacketInformation {
+        uint32_t packet_type_flags = 0; // RTCPPacketTypeFlags
+        std::vector<uint16_t> nack_sequence_numbers;
+        std::unique_ptr<webrtc::rtcp::TransportFeedback> transport_feedback;
+        int64_t rtt_ms = 0;
     };
 
     RTCPReceiver::RTCPReceiver(const RtpRtcpConfig& config) :
-            clock_(config.clock)
+            clock_(config.clock),
+            audio_(config.audio),
+            local_media_ssrc_(config.local_media_ssrc),
+            rtp_rtcp_module_observer_(config.rtp_rtcp_module_observer),
+            non_sender_rtt_measurement_(config.non_sender_rtt_measurement)
     {
 
     }
@@ -73,6 +89,42 @@ namespace xrtc {
         if (!ParseCompoundPacket(packet, &packet_information)) {
             return;
         }
+
+        TriggerCallbacksFromRtcpPacket(packet_information);
+    }
+
+    void RTCPReceiver::TriggerCallbacksFromRtcpPacket(
+            const PacketInformation& packet_information)
+    {
+        if (!rtp_rtcp_module_observer_) {
+            return;
+        }
+
+        webrtc::MediaType media_type = audio_ ? webrtc::MediaType::AUDIO :
+                                       webrtc::MediaType::VIDEO;
+
+        // 反馈消息在本端处理，不再透传给其它的peerconnection
+        if ((packet_information.packet_type_flags & webrtc::kRtcpNack) &&
+            !packet_information.nack_sequence_numbers.empty())
+        {
+            rtp_rtcp_module_observer_->OnNackReceived(media_type,
+                    packet_information.nack_sequence_numbers);
+        }
+
+        if (packet_information.packet_type_flags & (webrtc::kRtcpPli | webrtc::kRtcpFir)) {
+            rtp_rtcp_module_observer_->OnKeyFrameRequested(media_type);
+        }
+
+        if ((packet_information.packet_type_flags & webrtc::kRtcpTransportFeedback) &&
+            packet_information.transport_feedback)
+        {
+            rtp_rtcp_module_observer_->OnTransportFeedback(media_type,
+                    *packet_information.transport_feedback);
+        }
+
+        if (packet_information.rtt_ms > 0) {
+            rtp_rtcp_module_observer_->OnRttUpdate(media_type, packet_information.rtt_ms);
+        }
     }
 
     bool RTCPReceiver::ParseCompoundPacket(rtc::ArrayView<const uint8_t> packet,
@@ -100,6 +152,35 @@ namespace xrtc {
                 case webrtc::rtcp::ReceiverReport::kPacketType:
                     HandleRr(rtcp_block, packet_information);
                     break;
+                case webrtc::rtcp::ExtendedReports::kPacketType:
+                    HandleXr(rtcp_block, packet_information);
+                    break;
+                case webrtc::rtcp::Rtpfb::kPacketType:
+                    switch (rtcp_block.fmt()) {
+                        case webrtc::rtcp::Nack::kFeedbackMessageType:
+                            HandleNack(rtcp_block, packet_information);
+                            break;
+                        case webrtc::rtcp::TransportFeedback::kFeedbackMessageType:
+                            HandleTransportFeedback(rtcp_block, packet_information);
+                            break;
+                        default:
+                            ++num_skipped_packets_;
+                            break;
+                    }
+                    break;
+                case webrtc::rtcp::Psfb::kPacketType:
+                    switch (rtcp_block.fmt()) {
+                        case webrtc::rtcp::Pli::kFeedbackMessageType:
+                            HandlePli(rtcp_block, packet_information);
+                            break;
+                        case webrtc::rtcp::Fir::kFeedbackMessageType:
+                            HandleFir(rtcp_block, packet_information);
+                            break;
+                        default:
+                            ++num_skipped_packets_;
+                            break;
+                    }
+                    break;
                 default:
                     RTC_LOG(LS_WARNING) << "unknown rtcp packet_type: " << rtcp_block.type();
                     ++num_skipped_packets_;
@@ -128,11 +209,134 @@ namespace xrtc {
             remote_sender_packet_count_ = sr.sender_packet_count();
             remote_sender_octet_count_ = sr.sender_octet_count();
         }
+
+        for (const webrtc::rtcp::ReportBlock& report_block : sr.report_blocks()) {
+            HandleReportBlock(report_block, packet_information);
+        }
     }
 
     void RTCPReceiver::HandleRr(const webrtc::rtcp::CommonHeader& rtcp_block,
                                 PacketInformation* packet_information)
     {
+        webrtc::rtcp::ReceiverReport rr;
+        if (!rr.Parse(rtcp_block)) {
+            ++num_skipped_packets_;
+            return;
+        }
+
+        for (const webrtc::rtcp::ReportBlock& report_block : rr.report_blocks()) {
+            HandleReportBlock(report_block, packet_information);
+        }
+    }
+
+    void RTCPReceiver::HandleReportBlock(const webrtc::rtcp::ReportBlock& report_block,
+                                         PacketInformation* packet_information)
+    {
+        // 只关心对端针对本端发送的媒体流的统计
+        if (report_block.source_ssrc() != local_media_ssrc_) {
+            return;
+        }
+
+        last_report_block_ = report_block;
+        packet_information->packet_type_flags |= webrtc::kRtcpReport;
+
+        // RFC3550: rtt = 收到RR的时间 - LSR - DLSR，LSR为0表示对端还没有收到过SR
+        if (report_block.last_sr() != 0) {
+            uint32_t now_ntp = webrtc::CompactNtp(clock_->CurrentNtpTime());
+            uint32_t rtt_ntp = now_ntp - report_block.delay_since_last_sr() -
+                report_block.last_sr();
+            packet_information->rtt_ms = webrtc::CompactNtpRttToMs(rtt_ntp);
+        }
+    }
+
+    void RTCPReceiver::HandleNack(const webrtc::rtcp::CommonHeader& rtcp_block,
+                                  PacketInformation* packet_information)
+    {
+        webrtc::rtcp::Nack nack;
+        if (!nack.Parse(rtcp_block)) {
+            ++num_skipped_packets_;
+            return;
+        }
+
+        if (nack.media_ssrc() != local_media_ssrc_) {
+            return;
+        }
+
+        packet_information->nack_sequence_numbers.insert(
+                packet_information->nack_sequence_numbers.end(),
+                nack.packet_ids().begin(), nack.packet_ids().end());
+        packet_information->packet_type_flags |= webrtc::kRtcpNack;
+    }
+
+    void RTCPReceiver::HandlePli(const webrtc::rtcp::CommonHeader& rtcp_block,
+                                 PacketInformation* packet_information)
+    {
+        webrtc::rtcp::Pli pli;
+        if (!pli.Parse(rtcp_block)) {
+            ++num_skipped_packets_;
+            return;
+        }
+
+        if (pli.media_ssrc() == local_media_ssrc_) {
+            packet_information->packet_type_flags |= webrtc::kRtcpPli;
+        }
+    }
+
+    void RTCPReceiver::HandleFir(const webrtc::rtcp::CommonHeader& rtcp_block,
+                                 PacketInformation* packet_information)
+    {
+        webrtc::rtcp::Fir fir;
+        if (!fir.Parse(rtcp_block)) {
+            ++num_skipped_packets_;
+            return;
+        }
+
+        for (const webrtc::rtcp::Fir::Request& fir_request : fir.requests()) {
+            if (fir_request.ssrc == local_media_ssrc_) {
+                packet_information->packet_type_flags |= webrtc::kRtcpFir;
+                break;
+            }
+        }
+    }
+
+    void RTCPReceiver::HandleTransportFeedback(const webrtc::rtcp::CommonHeader& rtcp_block,
+                                               PacketInformation* packet_information)
+    {
+        // transport-cc是整条传输通道的反馈，不区分media ssrc
+        auto transport_feedback = std::make_unique<webrtc::rtcp::TransportFeedback>();
+        if (!transport_feedback->Parse(rtcp_block)) {
+            ++num_skipped_packets_;
+            return;
+        }
+
+        packet_information->packet_type_flags |= webrtc::kRtcpTransportFeedback;
+        packet_information->transport_feedback = std::move(transport_feedback);
+    }
+
+    void RTCPReceiver::HandleXr(const webrtc::rtcp::CommonHeader& rtcp_block,
+                                PacketInformation* packet_information)
+    {
+        webrtc::rtcp::ExtendedReports xr;
+        if (!xr.Parse(rtcp_block)) {
+            ++num_skipped_packets_;
+            return;
+        }
+
+        // 只有发送了RRTR的模块才处理对应的DLRR，同一个ssrc的其它模块忽略
+        if (!non_sender_rtt_measurement_) {
+            return;
+        }
+
+        // RFC3611: rtt = 收到DLRR的时间 - LRR - DLRR
+        for (const webrtc::rtcp::ReceiveTimeInfo& time_info : xr.dlrr().sub_blocks()) {
+            if (time_info.ssrc != local_media_ssrc_ || 0 == time_info.last_rr) {
+                continue;
+            }
+
+            uint32_t now_ntp = webrtc::CompactNtp(clock_->CurrentNtpTime());
+            uint32_t rtt_ntp = now_ntp - time_info.delay_since_last_rr - time_info.last_rr;
+            packet_information->rtt_ms = webrtc::CompactNtpRttToMs(rtt_ntp);
+        }
     }
 
 } // namespace xrtc
\ No newline at end of file
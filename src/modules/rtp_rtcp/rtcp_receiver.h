@@ -1,8 +1,11 @@
 #ifndef  __XRTCSERVER_MODULES_RTP_RTCP_RTCP_RECEIVER_H_
 #define  __XRTCSERVER_MODULES_RTP_RTCP_RTCP_RECEIVER_H_
 
+#include <vector>
+
 #include <api/array_view.h>
 #include <modules/rtp_rtcp/source/rtcp_packet/common_header.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/report_block.h>
 
 #include "modules/rtp_rtcp/rtp_rtcp_config.h"
 
@@ -22,9 +25,17 @@ namespace xrtc {
                  uint32_t* rtcp_arrival_time_frac,
                  uint32_t* rtp_timestamp);
 
+        // 对端针对本端发送的媒体流，最近一次反馈的report block
+        const absl::optional<webrtc::rtcp::ReportBlock>& last_report_block() const {
+            return last_report_block_;
+        }
+
     private:
         struct PacketInformation;
 
+        void TriggerCallbacksFromRtcpPacket(
+                const PacketInformation& packet_information);
+
         bool ParseCompoundPacket(rtc::ArrayView<const uint8_t> packet,
                                  PacketInformation* packet_information);
 
@@ -32,9 +43,25 @@ namespace xrtc {
                       PacketInformation* packet_information);
         void HandleRr(const webrtc::rtcp::CommonHeader& rtcp_block,
                       PacketInformation* packet_information);
+        void HandleReportBlock(const webrtc::rtcp::ReportBlock& report_block,
+                               PacketInformation* packet_information);
+        void HandleNack(const webrtc::rtcp::CommonHeader& rtcp_block,
+                        PacketInformation* packet_information);
+        void HandlePli(const webrtc::rtcp::CommonHeader& rtcp_block,
+                       PacketInformation* packet_information);
+        void HandleFir(const webrtc::rtcp::CommonHeader& rtcp_block,
+                       PacketInformation* packet_information);
+        void HandleTransportFeedback(const webrtc::rtcp::CommonHeader& rtcp_block,
+                                     PacketInformation* packet_information);
+        void HandleXr(const webrtc::rtcp::CommonHeader& rtcp_block,
+                      PacketInformation* packet_information);
 
     private:
         webrtc::Clock* clock_;
+        bool audio_;
+        uint32_t local_media_ssrc_;
+        RtpRtcpModuleObserver* rtp_rtcp_module_observer_;
+        bool non_sender_rtt_measurement_;
         int num_skipped_packets_ = 0;
         uint32_t remote_ssrc_ = 0;
         webrtc::NtpTime remote_sender_ntp_time_;
@@ -42,6 +69,7 @@ namespace xrtc {
         webrtc::NtpTime last_received_sr_ntp_;
         uint32_t remote_sender_packet_count_ = 0;
         uint32_t remote_sender_octet_count_ = 0;
+        absl::optional<webrtc::rtcp::ReportBlock> last_report_block_;
     };
 
 } // namespace xrtc
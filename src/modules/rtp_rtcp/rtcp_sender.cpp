@@ -1,7 +1,12 @@
 #include "modules/rtp_rtcp/rtcp_sender.h"
 
 #include <rtc_base/logging.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/sender_report.h>
 #include <modules/rtp_rtcp/source/rtcp_packet/receiver_report.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/nack.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/pli.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/remb.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/extended_reports.h>
 #include <modules/rtp_rtcp/source/rtp_rtcp_config.h>
 #include <modules/rtp_rtcp/source/time_util.h>
 
@@ -10,6 +15,8 @@ namespace xrtc {
 
         const int kDefaultAudioReportInterval = 5000;
         const int kDefaultVideoReportInterval = 1000;
+        const int kAudioClockRateKhz = 48;
+        const int kVideoClockRateKhz = 90;
 
     } // namespace
 
@@ -67,9 +74,15 @@ namespace xrtc {
                     kDefaultVideoReportInterval)),
             cur_report_interval_ms_(report_interval_ms_ / 2),
             random_(clock_->TimeInMicroseconds()),
-            rtp_rtcp_module_observer_(config.rtp_rtcp_module_observer)
+            rtp_rtcp_module_observer_(config.rtp_rtcp_module_observer),
+            non_sender_rtt_measurement_(config.non_sender_rtt_measurement)
     {
+        builders_[webrtc::kRtcpSr] = &RTCPSender::BuildSR;
         builders_[webrtc::kRtcpRr] = &RTCPSender::BuildRR;
+        builders_[webrtc::kRtcpNack] = &RTCPSender::BuildNACK;
+        builders_[webrtc::kRtcpPli] = &RTCPSender::BuildPLI;
+        builders_[webrtc::kRtcpRemb] = &RTCPSender::BuildREMB;
+        builders_[webrtc::kRtcpXrReceiverReferenceTime] = &RTCPSender::BuildExtendedReports;
     }
 
     RTCPSender::~RTCPSender() {
@@ -80,6 +93,22 @@ namespace xrtc {
         method_ = method;
     }
 
+    void RTCPSender::SetLastRtpTime(uint32_t rtp_timestamp, int64_t send_time_ms) {
+        last_rtp_timestamp_ = rtp_timestamp;
+        last_rtp_send_time_ms_ = send_time_ms;
+    }
+
+    void RTCPSender::SetRemb(int64_t bitrate_bps, std::vector<uint32_t> ssrcs) {
+        remb_bitrate_bps_ = bitrate_bps;
+        remb_ssrcs_ = std::move(ssrcs);
+        // 非易失的flag，周期性的复合包都会带上REMB
+        SetFlag(webrtc::kRtcpRemb, false);
+    }
+
+    void RTCPSender::UnsetRemb() {
+        ConsumeFlag(webrtc::kRtcpRemb, true);
+    }
+
     void RTCPSender::SetFlag(uint32_t type, bool is_volatile) {
         report_flags_.insert(ReportFlag(type, is_volatile));
     }
@@ -105,9 +134,18 @@ namespace xrtc {
                              webrtc::RTCPPacketType packet_type,
                              int32_t nack_size,
                              const uint16_t* nack_list)
+    {
+        return SendCompoundRTCP(feedback_state, {packet_type}, nack_size, nack_list, {});
+    }
+
+    int RTCPSender::SendCompoundRTCP(const FeedbackState& feedback_state,
+                                     const std::set<webrtc::RTCPPacketType>& packet_types,
+                                     int32_t nack_size,
+                                     const uint16_t* nack_list,
+                                     const std::vector<webrtc::rtcp::TransportFeedback>&
+                                             transport_feedbacks)
     {
         auto callback = [&](rtc::ArrayView<const uint8_t> packet) {
-            RTC_LOG(LS_WARNING) << "=======build rtcp packet, size: " << packet.size();
             if (rtp_rtcp_module_observer_) {
                 rtp_rtcp_module_observer_->OnLocalRtcpPacket(
                         audio_ ? webrtc::MediaType::AUDIO : webrtc::MediaType::VIDEO,
@@ -119,20 +157,45 @@ namespace xrtc {
         sender.emplace(max_packet_size_, callback);
 
         auto result = ComputeCompoundRTCPPacket(feedback_state, nack_size, nack_list,
-                                                packet_type, *sender);
+                                                packet_types, *sender);
         if (result) {
             return *result;
         }
 
+        for (const auto& transport_feedback : transport_feedbacks) {
+            sender->AppendPacket(transport_feedback);
+        }
+
         sender->Send();
         return 0;
     }
 
+    bool RTCPSender::SendFeedbackPacket(const webrtc::rtcp::TransportFeedback& packet) {
+        if (method_ == webrtc::RtcpMode::kOff) {
+            return false;
+        }
+
+        bool result = false;
+        auto callback = [&](rtc::ArrayView<const uint8_t> packet) {
+            if (rtp_rtcp_module_observer_) {
+                rtp_rtcp_module_observer_->OnLocalRtcpPacket(
+                        audio_ ? webrtc::MediaType::AUDIO : webrtc::MediaType::VIDEO,
+                        packet.data(), packet.size());
+                result = true;
+            }
+        };
+
+        PacketSender sender(max_packet_size_, callback);
+        sender.AppendPacket(packet);
+        sender.Send();
+        return result;
+    }
+
     absl::optional<int32_t> RTCPSender::ComputeCompoundRTCPPacket(
             const FeedbackState& feedback_state,
             int32_t nack_size,
             const uint16_t* nack_list,
-            webrtc::RTCPPacketType packet_type,
+            const std::set<webrtc::RTCPPacketType>& packet_types,
             PacketSender& sender)
     {
         if (method_ == webrtc::RtcpMode::kOff) {
@@ -140,7 +203,9 @@ namespace xrtc {
             return -1;
         }
 
-        SetFlag(packet_type, true);
+        for (webrtc::RTCPPacketType packet_type : packet_types) {
+            SetFlag(packet_type, true);
+        }
 
         RtcpContext context(feedback_state, nack_size, nack_list, clock_->CurrentTime());
 
@@ -183,6 +248,11 @@ namespace xrtc {
             }
         }
 
+        // RFC3611: 随RR一起发送RRTR，对端回复DLRR之后计算rtt
+        if (generate_report && !sending_ && non_sender_rtt_measurement_) {
+            SetFlag(webrtc::kRtcpXrReceiverReferenceTime, true);
+        }
+
         uint32_t min_interval = report_interval_ms_;
         cur_report_interval_ms_ = random_.Rand(min_interval * 1 / 2, min_interval * 3 / 2);
     }
@@ -219,6 +289,25 @@ namespace xrtc {
         return result;
     }
 
+    void RTCPSender::BuildSR(const RtcpContext& ctx, PacketSender& sender) {
+        // 服务器只做转发，SR中的rtp时间戳由最近一次转发的rtp包推算得到
+        uint32_t rtp_timestamp = last_rtp_timestamp_;
+        if (last_rtp_send_time_ms_ >= 0) {
+            int64_t clock_rate_khz = audio_ ? kAudioClockRateKhz : kVideoClockRateKhz;
+            rtp_timestamp += static_cast<uint32_t>(
+                    (ctx.now_.ms() - last_rtp_send_time_ms_) * clock_rate_khz);
+        }
+
+        webrtc::rtcp::SenderReport sr;
+        sr.SetSenderSsrc(ssrc_);
+        sr.SetNtp(clock_->CurrentNtpTime());
+        sr.SetRtpTimestamp(rtp_timestamp);
+        sr.SetPacketCount(ctx.feedback_state_.packets_sent);
+        sr.SetOctetCount(ctx.feedback_state_.media_bytes_sent);
+        sr.SetReportBlocks(CreateRtcpReportBlocks(ctx.feedback_state_));
+        sender.AppendPacket(sr);
+    }
+
     void RTCPSender::BuildRR(const RtcpContext& ctx, PacketSender& sender) {
         webrtc::rtcp::ReceiverReport rr;
         rr.SetSenderSsrc(ssrc_);
@@ -226,4 +315,41 @@ namespace xrtc {
         sender.AppendPacket(rr);
     }
 
+    void RTCPSender::BuildNACK(const RtcpContext& ctx, PacketSender& sender) {
+        if (ctx.nack_size_ <= 0 || !ctx.nack_list_) {
+            return;
+        }
+
+        webrtc::rtcp::Nack nack;
+        nack.SetSenderSsrc(ssrc_);
+        nack.SetMediaSsrc(remote_ssrc_);
+        nack.SetPacketIds(ctx.nack_list_, ctx.nack_size_);
+        sender.AppendPacket(nack);
+    }
+
+    void RTCPSender::BuildPLI(const RtcpContext& /*ctx*/, PacketSender& sender) {
+        webrtc::rtcp::Pli pli;
+        pli.SetSenderSsrc(ssrc_);
+        pli.SetMediaSsrc(remote_ssrc_);
+        sender.AppendPacket(pli);
+    }
+
+    void RTCPSender::BuildREMB(const RtcpContext& /*ctx*/, PacketSender& sender) {
+        webrtc::rtcp::Remb remb;
+        remb.SetSenderSsrc(ssrc_);
+        remb.SetBitrateBps(remb_bitrate_bps_);
+        remb.SetSsrcs(remb_ssrcs_);
+        sender.AppendPacket(remb);
+    }
+
+    void RTCPSender::BuildExtendedReports(const RtcpContext& /*ctx*/, PacketSender& sender) {
+        webrtc::rtcp::ExtendedReports xr;
+        xr.SetSenderSsrc(ssrc_);
+
+        webrtc::rtcp::Rrtr rrtr;
+        rrtr.SetNtp(clock_->CurrentNtpTime());
+        xr.SetRrtr(rrtr);
+        sender.AppendPacket(xr);
+    }
+
 } // namespace xrtc
\ No newline at end of file
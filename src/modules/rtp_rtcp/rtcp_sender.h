@@ -6,6 +6,7 @@
 #include <rtc_base/random.h>
 #include <modules/rtp_rtcp/include/rtp_rtcp_defines.h>
 #include <modules/rtp_rtcp/source/rtcp_packet/report_block.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/transport_feedback.h>
 
 #include "modules/rtp_rtcp/rtp_rtcp_config.h"
 #include "modules/rtp_rtcp/receive_stat.h"
@@ -18,6 +19,8 @@ namespace xrtc {
             uint32_t last_rr_ntp_secs = 0; // 记录了最近一次收到SR包时，接收端的NTP时间
             uint32_t last_rr_ntp_frac = 0;
             uint32_t remote_sr = 0;       // 从最近的一次SR包中，提取的NTP时间
+            uint32_t packets_sent = 0;    // 本端实际发送的rtp包个数
+            size_t media_bytes_sent = 0;  // 本端实际发送的rtp负载字节数
         };
 
         RTCPSender(const RtpRtcpConfig& config);
@@ -27,8 +30,23 @@ namespace xrtc {
                      webrtc::RTCPPacketType packet_type,
                      int32_t nack_size = 0,
                      const uint16_t* nack_list = nullptr);
+        // packet_types中的各类rtcp包和缓存的transport-cc反馈打包成一个复合包，
+        // 超过MTU时拆分成多个包发送
+        int SendCompoundRTCP(const FeedbackState& feedback_state,
+                             const std::set<webrtc::RTCPPacketType>& packet_types,
+                             int32_t nack_size,
+                             const uint16_t* nack_list,
+                             const std::vector<webrtc::rtcp::TransportFeedback>&
+                                     transport_feedbacks);
+        // 不经过调度器时，transport-cc反馈单独发送
+        bool SendFeedbackPacket(const webrtc::rtcp::TransportFeedback& packet);
         void SetRtcpStatus(webrtc::RtcpMode method);
         void SetSendingStatus(bool sending) { sending_ = sending; }
+        void SetRemoteSsrc(uint32_t ssrc) { remote_ssrc_ = ssrc; }
+        void SetLastRtpTime(uint32_t rtp_timestamp, int64_t send_time_ms);
+        // 设置之后每一个复合包都会携带REMB，直到调用UnsetRemb
+        void SetRemb(int64_t bitrate_bps, std::vector<uint32_t> ssrcs);
+        void UnsetRemb();
 
         uint32_t cur_report_interval_ms() const { return cur_report_interval_ms_; }
 
@@ -40,7 +58,7 @@ namespace xrtc {
                 const FeedbackState& feedback_state,
                 int32_t nack_size,
                 const uint16_t* nack_list,
-                webrtc::RTCPPacketType packet_type,
+                const std::set<webrtc::RTCPPacketType>& packet_types,
                 PacketSender& sender);
         void SetFlag(uint32_t type, bool is_volatile);
         bool IsFlagPresent(uint32_t type);
@@ -50,12 +68,18 @@ namespace xrtc {
         std::vector<webrtc::rtcp::ReportBlock> CreateRtcpReportBlocks(
                 const FeedbackState& feedback_state);
 
+        void BuildSR(const RtcpContext& ctx, PacketSender& sender);
         void BuildRR(const RtcpContext& ctx, PacketSender& sender);
+        void BuildNACK(const RtcpContext& ctx, PacketSender& sender);
+        void BuildPLI(const RtcpContext& ctx, PacketSender& sender);
+        void BuildREMB(const RtcpContext& ctx, PacketSender& sender);
+        void BuildExtendedReports(const RtcpContext& ctx, PacketSender& sender);
 
     private:
         webrtc::Clock* clock_;
         bool audio_;
         uint32_t ssrc_;
+        uint32_t remote_ssrc_ = 0;
         ReceiveStat* receive_stat_;
         webrtc::RtcpMode method_ = webrtc::RtcpMode::kOff;
         bool sending_ = false;
@@ -64,6 +88,14 @@ namespace xrtc {
         uint32_t cur_report_interval_ms_;
         webrtc::Random random_;
         RtpRtcpModuleObserver* rtp_rtcp_module_observer_;
+        bool non_sender_rtt_measurement_;
+
+        // 最近一次发送的rtp包的时间戳，以及发送时刻，用于生成SR
+        uint32_t last_rtp_timestamp_ = 0;
+        int64_t last_rtp_send_time_ms_ = -1;
+
+        int64_t remb_bitrate_bps_ = 0;
+        std::vector<uint32_t> remb_ssrcs_;
 
         struct ReportFlag {
             ReportFlag(uint32_t type, bool is_volatile) :
@@ -0,0 +1,66 @@
+#include "modules/rtp_rtcp/rtp_packet_history.h"
+
+#include <algorithm>
+
+namespace xrtc {
+
+namespace {
+
+const int64_t kDefaultRttMs = 100;
+const int64_t kMinPacketDurationMs = 1000;
+
+} // namespace
+
+RtpPacketHistory::RtpPacketHistory(webrtc::Clock* clock, size_t max_packets) :
+    clock_(clock),
+    packets_(max_packets),
+    rtt_ms_(kDefaultRttMs)
+{
+}
+
+RtpPacketHistory::~RtpPacketHistory() {
+}
+
+void RtpPacketHistory::PutRtpPacket(uint16_t seq_num, const uint8_t* data,
+        size_t len)
+{
+    // 按照序列号取模存放，新包直接覆盖同一位置上的旧包
+    StoredPacket& stored = packets_[seq_num % packets_.size()];
+    stored.valid = true;
+    stored.seq_num = seq_num;
+    stored.send_time_ms = clock_->TimeInMilliseconds();
+    stored.times_retransmitted = 0;
+    stored.packet.SetData(data, len);
+}
+
+bool RtpPacketHistory::GetPacketForRetransmission(uint16_t seq_num,
+        rtc::CopyOnWriteBuffer* packet)
+{
+    StoredPacket& stored = packets_[seq_num % packets_.size()];
+    if (!stored.valid || stored.seq_num != seq_num) {
+        return false;
+    }
+
+    int64_t now_ms = clock_->TimeInMilliseconds();
+    if (now_ms - stored.send_time_ms > std::max(kMinPacketDurationMs, rtt_ms_ * 3)) {
+        // 包已经太旧，重传也没有意义
+        return false;
+    }
+
+    if (stored.times_retransmitted > 0 && now_ms - stored.send_time_ms < rtt_ms_) {
+        return false;
+    }
+
+    stored.send_time_ms = now_ms;
+    ++stored.times_retransmitted;
+    *packet = stored.packet;
+    return true;
+}
+
+void RtpPacketHistory::SetRtt(int64_t rtt_ms) {
+    if (rtt_ms > 0) {
+        rtt_ms_ = rtt_ms;
+    }
+}
+
+} // namespace xrtc
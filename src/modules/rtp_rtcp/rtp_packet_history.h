@@ -0,0 +1,40 @@
+#ifndef  XRTCSERVER_MODULES_RTP_RTCP_RTP_PACKET_HISTORY_H_
+#define  XRTCSERVER_MODULES_RTP_RTCP_RTP_PACKET_HISTORY_H_
+
+#include <vector>
+
+#include <rtc_base/copy_on_write_buffer.h>
+#include <system_wrappers/include/clock.h>
+
+namespace xrtc {
+
+// 缓存最近发送出去的rtp包，用于响应对端的NACK请求
+class RtpPacketHistory {
+public:
+    static const size_t kDefaultMaxPackets = 1024;
+
+    RtpPacketHistory(webrtc::Clock* clock, size_t max_packets = kDefaultMaxPackets);
+    ~RtpPacketHistory();
+
+    void PutRtpPacket(uint16_t seq_num, const uint8_t* data, size_t len);
+    // 距离上一次发送不足一个rtt的包不再重复重传
+    bool GetPacketForRetransmission(uint16_t seq_num, rtc::CopyOnWriteBuffer* packet);
+    void SetRtt(int64_t rtt_ms);
+
+private:
+    struct StoredPacket {
+        bool valid = false;
+        uint16_t seq_num = 0;
+        int64_t send_time_ms = 0;
+        int times_retransmitted = 0;
+        rtc::CopyOnWriteBuffer packet;
+    };
+
+    webrtc::Clock* clock_;
+    std::vector<StoredPacket> packets_;
+    int64_t rtt_ms_;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_RTP_RTCP_RTP_PACKET_HISTORY_H_
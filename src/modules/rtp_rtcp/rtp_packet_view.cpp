@@ -0,0 +1,187 @@
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+
+#include <rtc_base/byte_io.h>
+#include <rtc_base/checks.h>
+
+namespace xrtc {
+
+namespace {
+
+const uint8_t kRtpVersion = 2;
+const size_t kFixedHeaderSize = 12;
+const uint16_t kOneByteExtensionProfileId = 0xBEDE;
+const uint16_t kTwoByteExtensionProfileId = 0x1000;
+const int kOneByteExtensionReservedId = 15;
+
+} // namespace
+
+bool RtpPacketView::Parse(const uint8_t* data, size_t size) {
+    data_ = const_cast<uint8_t*>(data);
+    size_ = size;
+    writable_ = false;
+    return ParseInternal();
+}
+
+bool RtpPacketView::Parse(uint8_t* data, size_t size) {
+    data_ = data;
+    size_ = size;
+    writable_ = true;
+    return ParseInternal();
+}
+
+bool RtpPacketView::ParseInternal() {
+    //  0                   1                   2                   3
+    //  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+    // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    // |V=2|P|X|  CC   |M|     PT      |       sequence number         |
+    // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    // |                           timestamp                           |
+    // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    // |           synchronization source (SSRC) identifier            |
+    // +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+    // |            Contributing source (CSRC) identifiers             |
+    // |                             ....                              |
+    // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    extensions_offset_ = 0;
+    extensions_size_ = 0;
+    extension_profile_ = 0;
+    payload_offset_ = 0;
+    payload_size_ = 0;
+    padding_size_ = 0;
+
+    if (!data_ || size_ < kFixedHeaderSize || (data_[0] >> 6) != kRtpVersion) {
+        return false;
+    }
+
+    bool has_padding = (data_[0] & 0x20) != 0;
+    bool has_extension = (data_[0] & 0x10) != 0;
+    size_t offset = kFixedHeaderSize + (data_[0] & 0x0F) * 4;
+    if (size_ < offset) {
+        return false;
+    }
+
+    if (has_extension) {
+        if (size_ < offset + 4) {
+            return false;
+        }
+
+        extension_profile_ = rtc::ByteReader<uint16_t>::ReadBigEndian(data_ + offset);
+        extensions_size_ = rtc::ByteReader<uint16_t>::ReadBigEndian(data_ + offset + 2) * 4;
+        extensions_offset_ = offset + 4;
+        offset = extensions_offset_ + extensions_size_;
+        if (size_ < offset) {
+            return false;
+        }
+    }
+
+    if (has_padding) {
+        if (size_ == offset) {
+            return false;
+        }
+
+        padding_size_ = data_[size_ - 1];
+        if (padding_size_ == 0 || offset + padding_size_ > size_) {
+            return false;
+        }
+    }
+
+    payload_offset_ = offset;
+    payload_size_ = size_ - offset - padding_size_;
+    return true;
+}
+
+uint16_t RtpPacketView::SequenceNumber() const {
+    return rtc::ByteReader<uint16_t>::ReadBigEndian(data_ + 2);
+}
+
+uint32_t RtpPacketView::Timestamp() const {
+    return rtc::ByteReader<uint32_t>::ReadBigEndian(data_ + 4);
+}
+
+uint32_t RtpPacketView::Ssrc() const {
+    return rtc::ByteReader<uint32_t>::ReadBigEndian(data_ + 8);
+}
+
+rtc::ArrayView<const uint8_t> RtpPacketView::FindExtension(int id) const {
+    if (0 == extensions_size_) {
+        return {};
+    }
+
+    bool one_byte_header = (extension_profile_ == kOneByteExtensionProfileId);
+    if (!one_byte_header &&
+            (extension_profile_ & 0xFFF0) != kTwoByteExtensionProfileId)
+    {
+        return {};
+    }
+
+    const uint8_t* extensions = data_ + extensions_offset_;
+    size_t pos = 0;
+    while (pos < extensions_size_) {
+        if (extensions[pos] == 0) { // padding
+            ++pos;
+            continue;
+        }
+
+        int ext_id;
+        size_t ext_len;
+        if (one_byte_header) {
+            ext_id = extensions[pos] >> 4;
+            ext_len = (extensions[pos] & 0x0F) + 1;
+            if (ext_id == kOneByteExtensionReservedId) {
+                break;
+            }
+            pos += 1;
+        } else {
+            if (pos + 2 > extensions_size_) {
+                break;
+            }
+            ext_id = extensions[pos];
+            ext_len = extensions[pos + 1];
+            pos += 2;
+        }
+
+        if (pos + ext_len > extensions_size_) {
+            break;
+        }
+
+        if (ext_id == id) {
+            return rtc::MakeArrayView<const uint8_t>(extensions + pos, ext_len);
+        }
+
+        pos += ext_len;
+    }
+
+    return {};
+}
+
+void RtpPacketView::SetMarker(bool marker_bit) {
+    RTC_DCHECK(writable_);
+    if (marker_bit) {
+        data_[1] |= 0x80;
+    } else {
+        data_[1] &= 0x7F;
+    }
+}
+
+void RtpPacketView::SetPayloadType(uint8_t payload_type) {
+    RTC_DCHECK(writable_);
+    RTC_DCHECK_LE(payload_type, 0x7Fu);
+    data_[1] = (data_[1] & 0x80) | payload_type;
+}
+
+void RtpPacketView::SetSequenceNumber(uint16_t seq_num) {
+    RTC_DCHECK(writable_);
+    rtc::ByteWriter<uint16_t>::WriteBigEndian(data_ + 2, seq_num);
+}
+
+void RtpPacketView::SetTimestamp(uint32_t timestamp) {
+    RTC_DCHECK(writable_);
+    rtc::ByteWriter<uint32_t>::WriteBigEndian(data_ + 4, timestamp);
+}
+
+void RtpPacketView::SetSsrc(uint32_t ssrc) {
+    RTC_DCHECK(writable_);
+    rtc::ByteWriter<uint32_t>::WriteBigEndian(data_ + 8, ssrc);
+}
+
+} // namespace xrtc
@@ -0,0 +1,99 @@
+#ifndef  __XRTCSERVER_MODULES_RTP_RTCP_RTP_PACKET_VIEW_H_
+#define  __XRTCSERVER_MODULES_RTP_RTCP_RTP_PACKET_VIEW_H_
+
+#include <api/array_view.h>
+#include <modules/rtp_rtcp/include/rtp_header_extension_map.h>
+
+namespace xrtc {
+
+// rtp包的轻量视图，不拥有也不拷贝数据，只记录头部各字段的位置
+// 扩展头只在按照协商的id查找时才解析，转发路由只需要固定头部的几个字段，
+// 需要完整解析的模块(接收统计、组帧等)再单独构造RtpPacketReceived
+class RtpPacketView {
+public:
+    RtpPacketView() = default;
+
+    // 只读视图，不允许调用Set*方法
+    bool Parse(const uint8_t* data, size_t size);
+    // 可写视图，用于转发前原地改写头部字段
+    bool Parse(uint8_t* data, size_t size);
+
+    bool Marker() const { return (data_[1] & 0x80) != 0; }
+    uint8_t PayloadType() const { return data_[1] & 0x7F; }
+    uint16_t SequenceNumber() const;
+    uint32_t Timestamp() const;
+    uint32_t Ssrc() const;
+
+    size_t headers_size() const { return payload_offset_; }
+    size_t payload_size() const { return payload_size_; }
+    size_t padding_size() const { return padding_size_; }
+    size_t size() const { return size_; }
+    const uint8_t* data() const { return data_; }
+    rtc::ArrayView<const uint8_t> payload() const {
+        return rtc::MakeArrayView<const uint8_t>(data_ + payload_offset_, payload_size_);
+    }
+
+    // 按照协商的扩展id查找扩展数据，找不到时返回空
+    rtc::ArrayView<const uint8_t> FindExtension(int id) const;
+
+    template <typename Extension, typename... Values>
+    bool GetExtension(const webrtc::RtpHeaderExtensionMap& extension_map,
+            Values... values) const
+    {
+        int id = extension_map.GetId(Extension::kId);
+        if (id == webrtc::RtpHeaderExtensionMap::kInvalidId) {
+            return false;
+        }
+
+        rtc::ArrayView<const uint8_t> raw = FindExtension(id);
+        if (raw.empty()) {
+            return false;
+        }
+
+        return Extension::Parse(raw, values...);
+    }
+
+    // 原地改写已经存在的扩展，扩展不存在或者长度不一致时返回false
+    template <typename Extension, typename... Values>
+    bool SetExtension(const webrtc::RtpHeaderExtensionMap& extension_map,
+            const Values&... values)
+    {
+        int id = extension_map.GetId(Extension::kId);
+        if (!writable_ || id == webrtc::RtpHeaderExtensionMap::kInvalidId) {
+            return false;
+        }
+
+        rtc::ArrayView<const uint8_t> raw = FindExtension(id);
+        if (raw.empty() || raw.size() != Extension::ValueSize(values...)) {
+            return false;
+        }
+
+        return Extension::Write(rtc::MakeArrayView(const_cast<uint8_t*>(raw.data()),
+                    raw.size()), values...);
+    }
+
+    void SetMarker(bool marker_bit);
+    void SetPayloadType(uint8_t payload_type);
+    void SetSequenceNumber(uint16_t seq_num);
+    void SetTimestamp(uint32_t timestamp);
+    void SetSsrc(uint32_t ssrc);
+
+private:
+    bool ParseInternal();
+
+private:
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool writable_ = false;
+
+    size_t extensions_offset_ = 0;
+    size_t extensions_size_ = 0;
+    uint16_t extension_profile_ = 0;
+    size_t payload_offset_ = 0;
+    size_t payload_size_ = 0;
+    size_t padding_size_ = 0;
+};
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_MODULES_RTP_RTCP_RTP_PACKET_VIEW_H_
@@ -2,9 +2,11 @@
 #define  __XRTCSERVER_MODULES_RTP_RTCP_RTP_RTCP_CONFIG_H_
 
 #include <system_wrappers/include/clock.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/transport_feedback.h>
 
 #include "base/event_loop.h"
 #include "modules/rtp_rtcp/receive_stat.h"
+#include "modules/rtp_rtcp/feedback_scheduler.h"
 #include "modules/video_coding/rtp_frame_object.h"
 
 namespace xrtc {
@@ -15,16 +17,33 @@ namespace xrtc {
 
         virtual void OnLocalRtcpPacket(webrtc::MediaType media_type,
                                        const uint8_t* data, size_t len) = 0;
+        // 本端生成的rtp包（例如重传包），直接发送给对端
+        virtual void OnLocalRtpPacket(webrtc::MediaType media_type,
+                                      const uint8_t* data, size_t len) = 0;
         virtual void OnFrame(std::unique_ptr<RtpFrameObject> frame) = 0;
+        // 对端发来的NACK请求，在本地处理重传
+        virtual void OnNackReceived(webrtc::MediaType media_type,
+                                    const std::vector<uint16_t>& nack_list) = 0;
+        // 对端发来的PLI/FIR请求
+        virtual void OnKeyFrameRequested(webrtc::MediaType media_type) = 0;
+        // 对端发来的transport-cc反馈，用于发送端的带宽估计
+        virtual void OnTransportFeedback(webrtc::MediaType media_type,
+                                         const webrtc::rtcp::TransportFeedback& feedback) = 0;
+        // 通过RR的LSR/DLSR或者XR的DLRR计算出的一次rtt
+        virtual void OnRttUpdate(webrtc::MediaType media_type, int64_t rtt_ms) = 0;
     };
 
     struct RtpRtcpConfig {
         EventLoop* el = nullptr;
         webrtc::Clock* clock = nullptr;
+        // 不为空时由worker的调度器统一发送rtcp，否则使用自己的定时器
+        FeedbackScheduler* feedback_scheduler = nullptr;
         bool audio = false;
         uint32_t local_media_ssrc = 0;
         ReceiveStat* receive_stat = nullptr;
         absl::optional<uint32_t> rtcp_report_interval_ms;
+        // 只接收不发送时对端不会回复LSR/DLSR，通过XR RRTR/DLRR测量rtt
+        bool non_sender_rtt_measurement = false;
         RtpRtcpModuleObserver* rtp_rtcp_module_observer = nullptr;
     };
 
@@ -3,6 +3,7 @@
 #include <rtc_base/logging.h>
 
 #include "base/conf.h"
+#include "base/metrics.h"
 
 extern xrtc::GeneralConf* g_conf;
 
@@ -19,13 +20,19 @@ namespace xrtc {
 
     RtpRtcpImpl::RtpRtcpImpl(const RtpRtcpConfig& config)
             : el_(config.el),
+              clock_(config.clock),
               rtcp_sender_(config),
-              rtcp_receiver_(config)
+              rtcp_receiver_(config),
+              feedback_scheduler_(config.feedback_scheduler)
     {
 
     }
 
     RtpRtcpImpl::~RtpRtcpImpl() {
+        if (feedback_scheduler_) {
+            feedback_scheduler_->RemoveModule(this);
+        }
+
         if (rtcp_report_timer_) {
             el_->DeleteTimer(rtcp_report_timer_);
             rtcp_report_timer_ = nullptr;
@@ -39,17 +46,106 @@ namespace xrtc {
         el_->StartTimer(rtcp_report_timer_, interval * 1000);
     }
 
+    int64_t RtpRtcpImpl::ProcessFeedback(int64_t now_ms) {
+        bool report_due = now_ms >= next_report_ms_;
+        if (!report_due && pending_nack_list_.empty() &&
+            pending_transport_feedback_.empty())
+        {
+            return next_report_ms_;
+        }
+
+        std::set<webrtc::RTCPPacketType> packet_types;
+        if (report_due) {
+            packet_types.insert(webrtc::kRtcpReport);
+        }
+        if (!pending_nack_list_.empty()) {
+            packet_types.insert(webrtc::kRtcpNack);
+        }
+
+        rtcp_sender_.SendCompoundRTCP(GetFeedbackState(), packet_types,
+                                      pending_nack_list_.size(),
+                                      pending_nack_list_.data(),
+                                      pending_transport_feedback_);
+        pending_nack_list_.clear();
+        pending_transport_feedback_.clear();
+        Metrics::ThreadInstance()->Increment("rtcp_compound_packets_sent");
+
+        if (report_due) {
+            next_report_ms_ = now_ms + rtcp_sender_.cur_report_interval_ms();
+        }
+
+        return next_report_ms_;
+    }
+
     void RtpRtcpImpl::SendNack(const std::vector<uint16_t>& nack_list) {
+        if (feedback_scheduler_ && feedback_scheduler_->IsRegistered(this)) {
+            pending_nack_list_.insert(pending_nack_list_.end(),
+                                      nack_list.begin(), nack_list.end());
+            feedback_scheduler_->ScheduleNow(this);
+            return;
+        }
+
         rtcp_sender_.SendRTCP(GetFeedbackState(), webrtc::kRtcpNack,
                               nack_list.size(), nack_list.data());
     }
 
+    void RtpRtcpImpl::SendPLI() {
+        rtcp_sender_.SendRTCP(GetFeedbackState(), webrtc::kRtcpPli);
+    }
+
+    bool RtpRtcpImpl::SendTransportFeedback(
+            const webrtc::rtcp::TransportFeedback& packet)
+    {
+        if (feedback_scheduler_ && feedback_scheduler_->IsRegistered(this)) {
+            pending_transport_feedback_.push_back(packet);
+            feedback_scheduler_->ScheduleNow(this);
+            return true;
+        }
+
+        return rtcp_sender_.SendFeedbackPacket(packet);
+    }
+
+    void RtpRtcpImpl::SetRemb(int64_t bitrate_bps, std::vector<uint32_t> ssrcs,
+                              bool send_now)
+    {
+        rtcp_sender_.SetRemb(bitrate_bps, std::move(ssrcs));
+        if (send_now) {
+            rtcp_sender_.SendRTCP(GetFeedbackState(), webrtc::kRtcpRemb);
+        }
+    }
+
+    void RtpRtcpImpl::UnsetRemb() {
+        rtcp_sender_.UnsetRemb();
+    }
+
+    void RtpRtcpImpl::OnSendingRtpPacket(uint32_t rtp_timestamp, size_t payload_size) {
+        ++packets_sent_;
+        media_bytes_sent_ += payload_size;
+        rtcp_sender_.SetLastRtpTime(rtp_timestamp, clock_->TimeInMilliseconds());
+    }
+
+    void RtpRtcpImpl::SetSendingStatus(bool sending) {
+        rtcp_sender_.SetSendingStatus(sending);
+    }
+
     void RtpRtcpImpl::SetRTCPStatus(webrtc::RtcpMode method) {
         if (method == webrtc::RtcpMode::kOff) {
+            if (feedback_scheduler_) {
+                feedback_scheduler_->RemoveModule(this);
+                pending_nack_list_.clear();
+                pending_transport_feedback_.clear();
+            }
+
             if (rtcp_report_timer_) {
                 el_->DeleteTimer(rtcp_report_timer_);
                 rtcp_report_timer_ = nullptr;
             }
+        } else if (feedback_scheduler_) {
+            if (!feedback_scheduler_->IsRegistered(this)) {
+                next_report_ms_ = clock_->TimeInMilliseconds() +
+                    g_conf->rtcp_report_timer_interval;
+                feedback_scheduler_->AddModule(this, next_report_ms_);
+            }
         } else {
             if (!rtcp_report_timer_) {
                 rtcp_report_timer_ = el_->CreateTimer(RtcpReportCb, this, true);
@@ -65,6 +161,7 @@ namespace xrtc {
     }
 
     void RtpRtcpImpl::SetRemoteSsrc(uint32_t ssrc) {
+        rtcp_sender_.SetRemoteSsrc(ssrc);
         rtcp_receiver_.SetRemoteSsrc(ssrc);
     }
 
@@ -74,6 +171,8 @@ namespace xrtc {
         uint32_t receive_ntp_secs;
         uint32_t receive_ntp_frac;
         state.remote_sr = 0;
+        state.packets_sent = packets_sent_;
+        state.media_bytes_sent = media_bytes_sent_;
 
         if (rtcp_receiver_.NTP(&receive_ntp_secs,
                                &receive_ntp_frac,
@@ -7,26 +7,47 @@
 
 namespace xrtc {
 
-    class RtpRtcpImpl {
+    class RtpRtcpImpl : public FeedbackModule {
     public:
         RtpRtcpImpl(const RtpRtcpConfig& config);
-        ~RtpRtcpImpl();
+        ~RtpRtcpImpl() override;
 
         void SetRTCPStatus(webrtc::RtcpMode method);
+        void SetSendingStatus(bool sending);
         void TimeToSendRTCP();
         void IncomingRtcpPacket(const uint8_t* data, size_t len);
         void SetRemoteSsrc(uint32_t ssrc);
         void SendNack(const std::vector<uint16_t>& nack_list);
+        void SendPLI();
+        bool SendTransportFeedback(const webrtc::rtcp::TransportFeedback& packet);
+        // send_now为true时立即发送，否则跟随下一个周期的复合包发送
+        void SetRemb(int64_t bitrate_bps, std::vector<uint32_t> ssrcs, bool send_now);
+        // 之后的复合包不再携带REMB
+        void UnsetRemb();
+        // 本端实际发送出去的rtp包，用于生成SR
+        void OnSendingRtpPacket(uint32_t rtp_timestamp, size_t payload_size);
+
+        // 到期的RR/SR、缓存的NACK和transport-cc反馈打包成一个复合包发送
+        int64_t ProcessFeedback(int64_t now_ms) override;
 
     private:
         RTCPSender::FeedbackState GetFeedbackState();
 
     private:
         EventLoop* el_;
+        webrtc::Clock* clock_;
         RTCPSender rtcp_sender_;
         RTCPReceiver rtcp_receiver_;
 
         TimerWatcher* rtcp_report_timer_ = nullptr;
+        FeedbackScheduler* feedback_scheduler_;
+        int64_t next_report_ms_ = -1;
+        // 两次调度之间缓存的反馈
+        std::vector<uint16_t> pending_nack_list_;
+        std::vector<webrtc::rtcp::TransportFeedback> pending_transport_feedback_;
+
+        uint32_t packets_sent_ = 0;
+        size_t media_bytes_sent_ = 0;
     };
 
 } // namespace xrtc
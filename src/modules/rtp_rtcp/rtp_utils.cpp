@@ -2,6 +2,8 @@
 
 #include <rtc_base/byte_io.h>
 
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+
 namespace xrtc {
 
 const uint8_t kRtpVersion = 2;
@@ -48,6 +50,52 @@ uint32_t ParseRtpSsrc(rtc::ArrayView<const uint8_t> packet) {
     return rtc::ByteReader<uint32_t>::ReadBigEndian(packet.data() + 8);
 }
 
+rtc::ArrayView<const uint8_t> FindRtpHeaderExtension(
+        rtc::ArrayView<const uint8_t> packet, int id)
+{
+    RtpPacketView view;
+    if (!view.Parse(packet.data(), packet.size())) {
+        return {};
+    }
+
+    return view.FindExtension(id);
+}
+
+bool ParseRtpAudioLevel(rtc::ArrayView<const uint8_t> packet, int id,
+        bool* voice_activity, uint8_t* audio_level)
+{
+    rtc::ArrayView<const uint8_t> data = FindRtpHeaderExtension(packet, id);
+    if (data.empty()) {
+        return false;
+    }
+
+    // 0                   1
+    // 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5
+    // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    // |  ID   | len=0 |V| level       |
+    // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+    *voice_activity = (data[0] & 0x80) != 0;
+    *audio_level = data[0] & 0x7F;
+    return true;
+}
+
+uint32_t ParseRtpTimestamp(rtc::ArrayView<const uint8_t> packet) {
+    return rtc::ByteReader<uint32_t>::ReadBigEndian(packet.data() + 4);
+}
+
+uint8_t ParseRtpPayloadType(rtc::ArrayView<const uint8_t> packet) {
+    return packet[1] & 0x7F;
+}
+
+rtc::ArrayView<const uint8_t> ParseRtpPayload(rtc::ArrayView<const uint8_t> packet) {
+    RtpPacketView view;
+    if (!view.Parse(packet.data(), packet.size())) {
+        return {};
+    }
+
+    return view.payload();
+}
+
 bool GetRtcpType(const void* data, size_t len, int* type) {
     if (len < kMinRtcpPacketLen) {
         return false;
@@ -15,6 +15,16 @@ RtpPacketType InferRtpPacketType(rtc::ArrayView<const char> packet);
 
 uint16_t ParseRtpSequenceNumber(rtc::ArrayView<const uint8_t> packet);
 uint32_t ParseRtpSsrc(rtc::ArrayView<const uint8_t> packet);
+uint32_t ParseRtpTimestamp(rtc::ArrayView<const uint8_t> packet);
+uint8_t ParseRtpPayloadType(rtc::ArrayView<const uint8_t> packet);
+// 去掉rtp头部和padding之后的负载，包格式错误时返回空
+rtc::ArrayView<const uint8_t> ParseRtpPayload(rtc::ArrayView<const uint8_t> packet);
+// 不需要完整解析rtp包，直接在扩展头中查找指定id的扩展数据
+rtc::ArrayView<const uint8_t> FindRtpHeaderExtension(
+        rtc::ArrayView<const uint8_t> packet, int id);
+// RFC6464 ssrc-audio-level
+bool ParseRtpAudioLevel(rtc::ArrayView<const uint8_t> packet, int id,
+        bool* voice_activity, uint8_t* audio_level);
 bool GetRtcpType(const void* data, size_t len, int* type);
 
 } // namespace xrtc
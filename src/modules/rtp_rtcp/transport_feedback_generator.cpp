@@ -0,0 +1,143 @@
+#include "modules/rtp_rtcp/transport_feedback_generator.h"
+
+namespace xrtc {
+
+namespace {
+
+const int kFeedbackIntervalMs = 100;
+// 已经发送过反馈的记录保留一段时间，用于处理乱序到达的包
+const int64_t kBackWindowUs = 500000;
+const size_t kMaxNumberOfPackets = (1 << 15);
+
+void FeedbackTimerCb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+    TransportFeedbackGenerator* generator = (TransportFeedbackGenerator*)data;
+    generator->Process();
+}
+
+} // namespace
+
+TransportFeedbackGenerator::TransportFeedbackGenerator(webrtc::Clock* clock,
+        EventLoop* el, FeedbackScheduler* feedback_scheduler, uint32_t sender_ssrc) :
+    clock_(clock),
+    el_(el),
+    feedback_scheduler_(feedback_scheduler),
+    sender_ssrc_(sender_ssrc)
+{
+    if (feedback_scheduler_) {
+        feedback_scheduler_->AddModule(this,
+                clock_->TimeInMilliseconds() + kFeedbackIntervalMs);
+        return;
+    }
+
+    feedback_timer_ = el_->CreateTimer(FeedbackTimerCb, this, true);
+    el_->StartTimer(feedback_timer_, kFeedbackIntervalMs * 1000);
+}
+
+TransportFeedbackGenerator::~TransportFeedbackGenerator() {
+    if (feedback_scheduler_) {
+        feedback_scheduler_->RemoveModule(this);
+    }
+
+    if (feedback_timer_) {
+        el_->DeleteTimer(feedback_timer_);
+        feedback_timer_ = nullptr;
+    }
+}
+
+void TransportFeedbackGenerator::OnPacketArrival(uint16_t transport_seq,
+        int64_t arrival_time_us, uint32_t media_ssrc)
+{
+    if (arrival_time_us < 0) {
+        arrival_time_us = clock_->TimeInMicroseconds();
+    }
+
+    media_ssrc_ = media_ssrc;
+    int64_t seq = unwrapper_.Unwrap(transport_seq);
+
+    if (periodic_window_start_seq_ &&
+        packet_arrival_times_.lower_bound(*periodic_window_start_seq_) ==
+            packet_arrival_times_.end())
+    {
+        // 所有的记录都已经反馈过了，清理掉过期的记录
+        for (auto it = packet_arrival_times_.begin();
+                it != packet_arrival_times_.end() && it->first < seq &&
+                arrival_time_us - it->second >= kBackWindowUs;)
+        {
+            it = packet_arrival_times_.erase(it);
+        }
+    }
+
+    if (!periodic_window_start_seq_ || seq < *periodic_window_start_seq_) {
+        periodic_window_start_seq_ = seq;
+    }
+
+    // 重复到达的包只记录第一次的到达时间
+    if (packet_arrival_times_.find(seq) != packet_arrival_times_.end()) {
+        return;
+    }
+
+    packet_arrival_times_[seq] = arrival_time_us;
+
+    // 推流端长时间不处理反馈时，限制内存的使用
+    if (packet_arrival_times_.size() > kMaxNumberOfPackets) {
+        packet_arrival_times_.erase(packet_arrival_times_.begin());
+        if (*periodic_window_start_seq_ < packet_arrival_times_.begin()->first) {
+            periodic_window_start_seq_ = packet_arrival_times_.begin()->first;
+        }
+    }
+}
+
+void TransportFeedbackGenerator::Process() {
+    if (!periodic_window_start_seq_) {
+        return;
+    }
+
+    // 一个feedback包放不下时，拆分成多个连续发送
+    while (true) {
+        webrtc::rtcp::TransportFeedback feedback_packet;
+        int64_t next_seq = BuildFeedbackPacket(*periodic_window_start_seq_,
+                &feedback_packet);
+        if (next_seq == *periodic_window_start_seq_) {
+            break;
+        }
+
+        periodic_window_start_seq_ = next_seq;
+        SignalTransportFeedback(feedback_packet);
+    }
+}
+
+int64_t TransportFeedbackGenerator::ProcessFeedback(int64_t now_ms) {
+    Process();
+    return now_ms + kFeedbackIntervalMs;
+}
+
+int64_t TransportFeedbackGenerator::BuildFeedbackPacket(int64_t begin_seq,
+        webrtc::rtcp::TransportFeedback* feedback_packet)
+{
+    auto begin_iter = packet_arrival_times_.lower_bound(begin_seq);
+    if (begin_iter == packet_arrival_times_.end()) {
+        return begin_seq;
+    }
+
+    feedback_packet->SetSenderSsrc(sender_ssrc_);
+    feedback_packet->SetMediaSsrc(media_ssrc_);
+    feedback_packet->SetFeedbackSequenceNumber(feedback_packet_count_++);
+    feedback_packet->SetBase(static_cast<uint16_t>(begin_iter->first & 0xFFFF),
+            begin_iter->second);
+
+    int64_t next_seq = begin_seq;
+    for (auto it = begin_iter; it != packet_arrival_times_.end(); ++it) {
+        if (!feedback_packet->AddReceivedPacket(
+                    static_cast<uint16_t>(it->first & 0xFFFF), it->second))
+        {
+            // 时间差超出范围或者包已经满了，剩下的放到下一个feedback包中
+            break;
+        }
+
+        next_seq = it->first + 1;
+    }
+
+    return next_seq;
+}
+
+} // namespace xrtc
@@ -0,0 +1,55 @@
+#ifndef  __XRTCSERVER_MODULES_RTP_RTCP_TRANSPORT_FEEDBACK_GENERATOR_H_
+#define  __XRTCSERVER_MODULES_RTP_RTCP_TRANSPORT_FEEDBACK_GENERATOR_H_
+
+#include <map>
+
+#include <absl/types/optional.h>
+#include <modules/include/module_common_types_public.h>
+#include <modules/rtp_rtcp/source/rtcp_packet/transport_feedback.h>
+#include <rtc_base/third_party/sigslot/sigslot.h>
+#include <system_wrappers/include/clock.h>
+
+#include "base/event_loop.h"
+#include "modules/rtp_rtcp/feedback_scheduler.h"
+
+namespace xrtc {
+
+// 每个peerconnection一个，记录推流端每个transport-wide序列号的到达时间，
+// 定时打包成TransportFeedback发送给推流端，用于推流端的带宽估计
+class TransportFeedbackGenerator : public FeedbackModule {
+public:
+    // feedback_scheduler不为空时由调度器驱动，否则使用自己的定时器
+    TransportFeedbackGenerator(webrtc::Clock* clock, EventLoop* el,
+            FeedbackScheduler* feedback_scheduler, uint32_t sender_ssrc);
+    ~TransportFeedbackGenerator() override;
+
+    void OnPacketArrival(uint16_t transport_seq, int64_t arrival_time_us,
+            uint32_t media_ssrc);
+    void Process();
+    int64_t ProcessFeedback(int64_t now_ms) override;
+
+    sigslot::signal1<const webrtc::rtcp::TransportFeedback&> SignalTransportFeedback;
+
+private:
+    int64_t BuildFeedbackPacket(int64_t begin_seq,
+            webrtc::rtcp::TransportFeedback* feedback_packet);
+
+private:
+    webrtc::Clock* clock_;
+    EventLoop* el_;
+    TimerWatcher* feedback_timer_ = nullptr;
+    FeedbackScheduler* feedback_scheduler_;
+    uint32_t sender_ssrc_;
+    uint32_t media_ssrc_ = 0;
+    uint8_t feedback_packet_count_ = 0;
+
+    webrtc::SequenceNumberUnwrapper unwrapper_;
+    // 下一个feedback包从这个序列号开始
+    absl::optional<int64_t> periodic_window_start_seq_;
+    // 展开之后的序列号 -> 到达时间(微秒)
+    std::map<int64_t, int64_t> packet_arrival_times_;
+};
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_MODULES_RTP_RTCP_TRANSPORT_FEEDBACK_GENERATOR_H_
@@ -0,0 +1,67 @@
+#include "modules/video_coding/h264_utils.h"
+
+#include <common_video/h264/h264_common.h>
+#include <rtc_base/byte_io.h>
+
+namespace xrtc {
+
+namespace {
+
+const uint8_t kNaluTypeMask = 0x1F;
+const uint8_t kNriMask = 0x60;
+const uint8_t kFuAStartBit = 0x80;
+const size_t kStapAHeaderSize = 1;
+const size_t kLengthFieldSize = 2;
+
+bool IsKeyFrameNalu(uint8_t nalu_type) {
+    return nalu_type == webrtc::H264::NaluType::kSps ||
+        nalu_type == webrtc::H264::NaluType::kIdr;
+}
+
+} // namespace
+
+bool IsH264KeyFrameStart(rtc::ArrayView<const uint8_t> payload) {
+    if (payload.empty()) {
+        return false;
+    }
+
+    uint8_t nalu_type = payload[0] & kNaluTypeMask;
+    switch (nalu_type) {
+        case webrtc::H264::NaluType::kStapA: {
+            // 聚合包，逐个检查其中的NAL单元
+            size_t offset = kStapAHeaderSize;
+            while (offset + kLengthFieldSize < payload.size()) {
+                size_t nalu_size = rtc::ByteReader<uint16_t>::ReadBigEndian(
+                        payload.data() + offset);
+                offset += kLengthFieldSize;
+                if (0 == nalu_size || offset + nalu_size > payload.size()) {
+                    return false;
+                }
+
+                if (IsKeyFrameNalu(payload[offset] & kNaluTypeMask)) {
+                    return true;
+                }
+                offset += nalu_size;
+            }
+            return false;
+        }
+        case webrtc::H264::NaluType::kFuA:
+            // 分片包，只有第一个分片才是帧的开始
+            if (payload.size() < 2 || !(payload[1] & kFuAStartBit)) {
+                return false;
+            }
+            return IsKeyFrameNalu(payload[1] & kNaluTypeMask);
+        default:
+            return IsKeyFrameNalu(nalu_type);
+    }
+}
+
+bool IsH264NonReference(rtc::ArrayView<const uint8_t> payload) {
+    if (payload.empty()) {
+        return false;
+    }
+
+    return (payload[0] & kNriMask) == 0;
+}
+
+} // namespace xrtc
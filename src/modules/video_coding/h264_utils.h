@@ -0,0 +1,17 @@
+#ifndef  XRTCSERVER_MODULES_VIDEO_CODING_H264_UTILS_H_
+#define  XRTCSERVER_MODULES_VIDEO_CODING_H264_UTILS_H_
+
+#include <api/array_view.h>
+
+namespace xrtc {
+
+// 只检查NAL头，判断rtp负载是否是一个关键帧的开始(SPS或者IDR)，
+// 不需要解包以及组帧
+bool IsH264KeyFrameStart(rtc::ArrayView<const uint8_t> payload);
+// NAL头中的nal_ref_idc为0，表示这个包所属的帧不会被其它帧参考，
+// 丢弃之后不影响后续帧的解码。聚合包和分片包的NRI与其中的NAL单元一致
+bool IsH264NonReference(rtc::ArrayView<const uint8_t> payload);
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_MODULES_VIDEO_CODING_H264_UTILS_H_
@@ -1,3 +1,8 @@
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
 #include <rtc_base/logging.h>
 
 #include "modules/video_coding/nack_requester.h"
@@ -6,7 +11,6 @@ namespace xrtc {
 
 namespace {
 
-const int kMaxPacketAge = 10000;
 const int kMaxNackPackets = 1000;
 const int kDefaultRttMs = 100;
 const int kMaxNackRetries = 10;
@@ -14,6 +18,11 @@ const int kMaxReorderedPackets = 128;
 const int kNumReorderingBuckets = 10;
 const int kDefaultSendNackDelayMs = 0;
 const int kUpdateIntervalMs = 20;
+// 指数退避: 第n次重传的间隔 = max(rtt, min(rtt, kBackoffMaxRttMs) * kBackoffBase^(n-1))，
+// 避免高丢包时对同一个包反复请求重传
+const int64_t kBackoffMinRetryIntervalMs = 5;
+const int64_t kBackoffMaxRttMs = 160;
+const double kBackoffBase = 1.25;
 
 void nack_timer_cb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
     NackRequester* nack = (NackRequester*)data;
@@ -23,7 +32,7 @@ void nack_timer_cb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
 } // namespace
 
 NackRequester::NackInfo::NackInfo()
-	: seq_num(0), send_at_seq_num(0), sent_at_time(-1), retries(0) {}
+	: seq_num(0), send_at_seq_num(0), created_at_time(-1), sent_at_time(-1), retries(0) {}
 
 NackRequester::NackInfo::NackInfo(uint16_t seq_num,
 		uint16_t send_at_seq_num,
@@ -34,17 +43,33 @@ NackRequester::NackInfo::NackInfo(uint16_t seq_num,
 	sent_at_time(-1),
 	retries(0) {}
 
-NackRequester::NackRequester(webrtc::Clock* clock, EventLoop* el) :
+NackRequester::NackRequester(webrtc::Clock* clock, EventLoop* el,
+        FeedbackScheduler* feedback_scheduler) :
     clock_(clock),
     el_(el),
+    feedback_scheduler_(feedback_scheduler),
+    nack_ring_(kNackWindowSize),
     reordering_histogram_(kNumReorderingBuckets, kMaxReorderedPackets),
     rtt_ms_(kDefaultRttMs)
 {
+    memset(nack_bitmap_, 0, sizeof(nack_bitmap_));
+    memset(recovered_bitmap_, 0, sizeof(recovered_bitmap_));
+
+    if (feedback_scheduler_) {
+        feedback_scheduler_->AddModule(this,
+                clock_->TimeInMilliseconds() + kUpdateIntervalMs);
+        return;
+    }
+
     nack_timer_ = el_->CreateTimer(nack_timer_cb, this, true);
     el_->StartTimer(nack_timer_, kUpdateIntervalMs * 1000);
 }
 
 NackRequester::~NackRequester() {
+    if (feedback_scheduler_) {
+        feedback_scheduler_->RemoveModule(this);
+    }
+
     if (nack_timer_) {
         el_->DeleteTimer(nack_timer_);
         nack_timer_ = nullptr;
@@ -52,17 +77,43 @@ NackRequester::~NackRequester() {
 }
 
 void NackRequester::ClearUpTo(uint16_t seq_num) {
-	// Called via RtpVideoStreamReceiver2::FrameContinuous on the network thread.
-	nack_list_.erase(nack_list_.begin(), nack_list_.lower_bound(seq_num));
-	keyframe_list_.erase(keyframe_list_.begin(),
-			keyframe_list_.lower_bound(seq_num));
-	recovered_list_.erase(recovered_list_.begin(),
-			recovered_list_.lower_bound(seq_num));
+    RemoveNacksBefore(seq_num);
+
+    while (!keyframe_list_.empty() && webrtc::AheadOf(seq_num, keyframe_list_.front())) {
+        keyframe_list_.pop_front();
+    }
+
+    // 窗口内早于seq_num的恢复记录不再需要
+    uint16_t window_start = window_end_seq_num_ - (kNackWindowSize - 1);
+    if (webrtc::AheadOf(seq_num, window_start)) {
+        size_t count = webrtc::ForwardDiff(window_start, seq_num);
+        if (count > kNackWindowSize) {
+            count = kNackWindowSize;
+        }
+        ClearRange(recovered_bitmap_, Slot(window_start), count);
+    }
 }
 
-void NackRequester::UpdateRtt(int64_t rtt_ms) { 
+size_t NackRequester::ClearRange(uint64_t* bitmap, size_t slot, size_t count) {
+    size_t cleared = 0;
+    while (count > 0) {
+        size_t bit = slot % 64;
+        size_t n = std::min(count, 64 - bit);
+        uint64_t mask = (64 == n) ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1) << bit;
+        uint64_t& word = bitmap[slot / 64];
+        cleared += __builtin_popcountll(word & mask);
+        word &= ~mask;
+
+        // 窗口大小是64的整数倍，回绕时正好从第0个字开始
+        slot = (slot + n) & (kNackWindowSize - 1);
+        count -= n;
+    }
+
+    return cleared;
+}
+
+void NackRequester::UpdateRtt(int64_t rtt_ms) {
     rtt_ms_ = rtt_ms;
-    //RTC_LOG(LS_WARNING) << "===========nack rtt: " << rtt_ms_;
 }
 
 void NackRequester::ProcessNacks() {
@@ -71,54 +122,83 @@ void NackRequester::ProcessNacks() {
 		// This batch of NACKs is triggered externally; there is no external
 		// initiator who can batch them with other feedback messages.
 		SignalNackSend(nack_batch);
-	} 
+	}
+}
+
+int64_t NackRequester::ProcessFeedback(int64_t now_ms) {
+    ProcessNacks();
+    return now_ms + kUpdateIntervalMs;
+}
+
+template <typename Func>
+void NackRequester::ForEachNack(Func func) {
+    if (0 == nack_count_) {
+        return;
+    }
+
+    // 窗口中最旧的序列号所在的位置，从这里开始按照序列号顺序扫描
+    size_t start = Slot(window_end_seq_num_ + 1);
+    for (size_t n = 0; n < kBitmapWords + 1 && nack_count_ > 0; ++n) {
+        size_t word_index = (start / 64 + n) % kBitmapWords;
+        uint64_t word = nack_bitmap_[word_index];
+        // 起始位置所在的字被访问两次：第一次只看start之后的位，最后一次只看start之前的位
+        if (0 == n) {
+            word &= ~(uint64_t)0 << (start % 64);
+        } else if (kBitmapWords == n) {
+            word &= ((uint64_t)1 << (start % 64)) - 1;
+        }
+
+        while (word) {
+            size_t bit = __builtin_ctzll(word);
+            word &= word - 1;
+
+            size_t slot = word_index * 64 + bit;
+            if (!func(nack_ring_[slot])) {
+                ClearBit(nack_bitmap_, slot);
+                --nack_count_;
+            }
+        }
+    }
 }
 
 std::vector<uint16_t> NackRequester::GetNackBatch(NackFilterOptions options) {
     bool consider_seq_num = options != kTimeOnly;
     bool consider_timestamp = options != kSeqNumOnly;
-    webrtc::Timestamp now = clock_->CurrentTime();
+    int64_t now_ms = clock_->TimeInMilliseconds();
     std::vector<uint16_t> nack_batch;
-    auto it = nack_list_.begin();
-
-	while (it != nack_list_.end()) {
-        webrtc::TimeDelta resend_delay = webrtc::TimeDelta::Millis(rtt_ms_);
-		/*
-        if (backoff_settings_) {
-			resend_delay =
-				std::max(resend_delay, backoff_settings_->min_retry_interval);
-			if (it->second.retries > 1) {
-				TimeDelta exponential_backoff =
-					std::min(TimeDelta::Millis(rtt_ms_), backoff_settings_->max_rtt) *
-					std::pow(backoff_settings_->base, it->second.retries - 1);
-				resend_delay = std::max(resend_delay, exponential_backoff);
-			}
-		}
-        */
-
-		bool delay_timed_out =
-			now.ms() - it->second.created_at_time >= send_nack_delay_ms_;
-		bool nack_on_rtt_passed =
-			now.ms() - it->second.sent_at_time >= resend_delay.ms();
-		bool nack_on_seq_num_passed =
-			it->second.sent_at_time == -1 &&
-			webrtc::AheadOrAt(newest_seq_num_, it->second.send_at_seq_num);
-		if (delay_timed_out && ((consider_seq_num && nack_on_seq_num_passed) ||
-					(consider_timestamp && nack_on_rtt_passed))) {
-			nack_batch.emplace_back(it->second.seq_num);
-			++it->second.retries;
-			it->second.sent_at_time = now.ms();
-			if (it->second.retries >= kMaxNackRetries) {
-				RTC_LOG(LS_WARNING) << "Sequence number " << it->second.seq_num
-					<< " removed from NACK list due to max retries.";
-				it = nack_list_.erase(it);
-			} else {
-				++it;
-			}
-			continue;
-		}
-		++it; 
-	}
+
+    ForEachNack([&](NackInfo& nack_info) {
+        int64_t resend_delay_ms = std::max(rtt_ms_, kBackoffMinRetryIntervalMs);
+        if (nack_info.retries > 1) {
+            int64_t exponential_backoff_ms = (int64_t)(
+                    std::min(rtt_ms_, kBackoffMaxRttMs) *
+                    pow(kBackoffBase, nack_info.retries - 1));
+            resend_delay_ms = std::max(resend_delay_ms, exponential_backoff_ms);
+        }
+
+        bool delay_timed_out =
+            now_ms - nack_info.created_at_time >= send_nack_delay_ms_;
+        bool nack_on_rtt_passed = now_ms - nack_info.sent_at_time >= resend_delay_ms;
+        bool nack_on_seq_num_passed =
+            nack_info.sent_at_time == -1 &&
+            webrtc::AheadOrAt(newest_seq_num_, nack_info.send_at_seq_num);
+        if (!delay_timed_out || !((consider_seq_num && nack_on_seq_num_passed) ||
+                    (consider_timestamp && nack_on_rtt_passed)))
+        {
+            return true;
+        }
+
+        nack_batch.emplace_back(nack_info.seq_num);
+        ++nack_info.retries;
+        nack_info.sent_at_time = now_ms;
+        if (nack_info.retries >= kMaxNackRetries) {
+            RTC_LOG(LS_WARNING) << "Sequence number " << nack_info.seq_num
+                << " removed from NACK list due to max retries.";
+            return false;
+        }
+
+        return true;
+    });
 
     return nack_batch;
 }
@@ -128,22 +208,11 @@ int NackRequester::OnReceivedPacket(uint16_t seq_num, bool is_keyframe) {
 }
 
 int NackRequester::OnReceivedPacket(uint16_t seq_num, bool is_keyframe, bool is_recovered) {
-    /*
-    RTC_LOG(LS_WARNING) << "============nack_module, seq_num: " << seq_num
-        << ", is_keyframe: " << is_keyframe
-        << ", is_recovered: " << is_recovered;
-    */
-    
-    // TODO(philipel): When the packet includes information whether it is
-    //                 retransmitted or not, use that value instead. For
-    //                 now set it to true, which will cause the reordering
-    //                 statistics to never be updated.
-    bool is_retransmitted = true;
-
     if (!initialized_) {
         newest_seq_num_ = seq_num;
+        window_end_seq_num_ = seq_num;
         if (is_keyframe) {
-            keyframe_list_.insert(seq_num);
+            keyframe_list_.push_back(seq_num);
         }
         initialized_ = true;
         return 0;
@@ -155,39 +224,36 @@ int NackRequester::OnReceivedPacket(uint16_t seq_num, bool is_keyframe, bool is_
 
 	if (webrtc::AheadOf(newest_seq_num_, seq_num)) {
 		// An out of order packet has been received.
-		auto nack_list_it = nack_list_.find(seq_num);
 		int nacks_sent_for_packet = 0;
-		if (nack_list_it != nack_list_.end()) {
-			nacks_sent_for_packet = nack_list_it->second.retries;
-			nack_list_.erase(nack_list_it);
-		}
-        
-        if (!is_retransmitted) {
+        bool is_retransmitted = false;
+        if (HasNack(seq_num)) {
+            const NackInfo& nack_info = nack_ring_[Slot(seq_num)];
+            nacks_sent_for_packet = nack_info.retries;
+            // 已经请求过重传的包认为是重传包，其余的迟到包是乱序
+            is_retransmitted = nack_info.sent_at_time != -1;
+            RemoveNack(seq_num);
+        }
+
+        if (!is_retransmitted && !is_recovered) {
             UpdateReorderingStatistics(seq_num);
         }
-		
+
         return nacks_sent_for_packet;
 	}
 
+    AdvanceWindow(seq_num);
+
     if (is_keyframe) {
-        keyframe_list_.insert(seq_num);
+        keyframe_list_.push_back(seq_num);
     }
 
 	// And remove old ones so we don't accumulate keyframes.
-    auto it = keyframe_list_.lower_bound(seq_num - kMaxPacketAge);
-    if (it != keyframe_list_.begin()) {
-        keyframe_list_.erase(keyframe_list_.begin(), it); 
+    while (!keyframe_list_.empty() && !InWindow(keyframe_list_.front())) {
+        keyframe_list_.pop_front();
     }
 
 	if (is_recovered) {
-		recovered_list_.insert(seq_num);
-
-		// Remove old ones so we don't accumulate recovered packets.
-		auto it = recovered_list_.lower_bound(seq_num - kMaxPacketAge);
-		if (it != recovered_list_.begin()) {
-			recovered_list_.erase(recovered_list_.begin(), it);
-        }
-
+        SetBit(recovered_bitmap_, Slot(seq_num));
 		// Do not send nack for packets recovered by FEC or RTX.
 		return 0;
 	}
@@ -200,26 +266,77 @@ int NackRequester::OnReceivedPacket(uint16_t seq_num, bool is_keyframe, bool is_
 	if (!nack_batch.empty()) {
 		SignalNackSend(nack_batch);
 	}
-	
+
 	return 0;
 }
 
-void NackRequester::AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_end) {
-	// Remove old packets.
-	auto it = nack_list_.lower_bound(seq_num_end - kMaxPacketAge);
-	nack_list_.erase(nack_list_.begin(), it);
+void NackRequester::AdvanceWindow(uint16_t seq_num) {
+    if (!webrtc::AheadOf(seq_num, window_end_seq_num_)) {
+        return;
+    }
+
+    // 新的序列号会占用seq_num - kNackWindowSize的位置，清除这些超出窗口的旧记录
+    uint16_t advance = webrtc::ForwardDiff(window_end_seq_num_, seq_num);
+    uint16_t prev_window_end = window_end_seq_num_;
+    window_end_seq_num_ = seq_num;
+    if (advance >= kNackWindowSize) {
+        memset(nack_bitmap_, 0, sizeof(nack_bitmap_));
+        memset(recovered_bitmap_, 0, sizeof(recovered_bitmap_));
+        nack_count_ = 0;
+        return;
+    }
+
+    size_t start = Slot(prev_window_end + 1);
+    size_t removed = ClearRange(nack_bitmap_, start, advance);
+    ClearRange(recovered_bitmap_, start, advance);
+    if (removed > 0) {
+        nack_count_ -= removed;
+        RTC_LOG(LS_WARNING) << removed
+            << " sequence numbers removed from NACK list due to max packet age.";
+    }
+}
 
+bool NackRequester::InWindow(uint16_t seq_num) const {
+    return webrtc::ForwardDiff(seq_num, window_end_seq_num_) < kNackWindowSize;
+}
+
+bool NackRequester::HasNack(uint16_t seq_num) const {
+    size_t slot = Slot(seq_num);
+    return InWindow(seq_num) && TestBit(nack_bitmap_, slot) &&
+        nack_ring_[slot].seq_num == seq_num;
+}
+
+void NackRequester::RemoveNack(uint16_t seq_num) {
+    ClearBit(nack_bitmap_, Slot(seq_num));
+    --nack_count_;
+}
+
+size_t NackRequester::RemoveNacksBefore(uint16_t seq_num) {
+    size_t removed = 0;
+    ForEachNack([&](const NackInfo& nack_info) {
+        if (webrtc::AheadOf(seq_num, nack_info.seq_num)) {
+            ++removed;
+            return false;
+        }
+        return true;
+    });
+
+    return removed;
+}
+
+void NackRequester::AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_end) {
 	// If the nack list is too large, remove packets from the nack list until
 	// the latest first packet of a keyframe. If the list is still too large,
 	// clear it and request a keyframe.
 	uint16_t num_new_nacks = webrtc::ForwardDiff(seq_num_start, seq_num_end);
-	if (nack_list_.size() + num_new_nacks > kMaxNackPackets) {
+	if (nack_count_ + num_new_nacks > kMaxNackPackets) {
 		while (RemovePacketsUntilKeyFrame() &&
-				nack_list_.size() + num_new_nacks > kMaxNackPackets) {
+				nack_count_ + num_new_nacks > kMaxNackPackets) {
 		}
 
-		if (nack_list_.size() + num_new_nacks > kMaxNackPackets) {
-			nack_list_.clear();
+		if (nack_count_ + num_new_nacks > kMaxNackPackets) {
+            memset(nack_bitmap_, 0, sizeof(nack_bitmap_));
+            nack_count_ = 0;
 			RTC_LOG(LS_WARNING) << "NACK list full, clearing NACK"
 				" list and requesting keyframe.";
 			//keyframe_request_sender_->RequestKeyFrame();
@@ -227,19 +344,24 @@ void NackRequester::AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_en
 		}
 	}
 
+    int64_t now_ms = clock_->TimeInMilliseconds();
+    uint16_t wait_packets = WaitNumberOfPackets(0.5);
 	for (uint16_t seq_num = seq_num_start; seq_num != seq_num_end; ++seq_num) {
+        size_t slot = Slot(seq_num);
 		// Do not send nack for packets that are already recovered by FEC or RTX
-        if (recovered_list_.find(seq_num) != recovered_list_.end()) {
+        if (TestBit(recovered_bitmap_, slot)) {
             continue;
         }
-        NackInfo nack_info(seq_num, seq_num + WaitNumberOfPackets(0.5),
-                clock_->TimeInMilliseconds());
-        nack_list_[seq_num] = nack_info;
+
+        nack_ring_[slot] = NackInfo(seq_num, seq_num + wait_packets, now_ms);
+        if (!TestBit(nack_bitmap_, slot)) {
+            SetBit(nack_bitmap_, slot);
+            ++nack_count_;
+        }
     }
 }
 
 int NackRequester::WaitNumberOfPackets(float probability) const {
-	// Called on worker_thread_;
 	if (reordering_histogram_.NumValues() == 0) {
 		return 0;
 	}
@@ -247,20 +369,15 @@ int NackRequester::WaitNumberOfPackets(float probability) const {
 }
 
 bool NackRequester::RemovePacketsUntilKeyFrame() {
-	// Called on worker_thread_.
 	while (!keyframe_list_.empty()) {
-		auto it = nack_list_.lower_bound(*keyframe_list_.begin());
-
-		if (it != nack_list_.begin()) {
-			// We have found a keyframe that actually is newer than at least one
-			// packet in the nack list.
-			nack_list_.erase(nack_list_.begin(), it);
-			return true;
-		}
+        // 存在比这个关键帧更早的丢包时，关键帧之前的包都不再需要
+        if (RemoveNacksBefore(keyframe_list_.front()) > 0) {
+            return true;
+        }
 
 		// If this keyframe is so old it does not remove any packets from the list,
 		// remove it from the list of keyframes and try the next keyframe.
-		keyframe_list_.erase(keyframe_list_.begin());
+		keyframe_list_.pop_front();
 	}
 	return false;
 }
@@ -271,5 +388,3 @@ void NackRequester::UpdateReorderingStatistics(uint16_t seq_num) {
 }
 
 } // namespace xrtc
-
-
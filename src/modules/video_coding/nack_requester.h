@@ -1,8 +1,8 @@
 #ifndef  XRTCSERVER_MODULES_VIDEO_CODING_NACK_REQUESTER_H_
 #define  XRTCSERVER_MODULES_VIDEO_CODING_NACK_REQUESTER_H_
 
-#include <set>
-#include <map>
+#include <deque>
+#include <vector>
 
 #include <rtc_base/numerics/sequence_number_util.h>
 #include <rtc_base/third_party/sigslot/sigslot.h>
@@ -10,19 +10,26 @@
 
 #include "modules/video_coding/histogram.h"
 #include "base/event_loop.h"
+#include "modules/rtp_rtcp/feedback_scheduler.h"
 
 namespace xrtc {
 
-class NackRequester {
+// 丢包记录放在按照序列号取模索引的环形数组中，用位图标记哪些序列号需要重传，
+// 插入和删除都是O(1)，定时扫描时按64位一组跳过没有丢包的区间，
+// 只跟踪最近kNackWindowSize个序列号，更早的丢包不再请求重传
+class NackRequester : public FeedbackModule {
 public:
-    NackRequester(webrtc::Clock* clock, EventLoop* el);
-    ~NackRequester();
-    
+    // feedback_scheduler不为空时由调度器驱动，否则使用自己的定时器
+    NackRequester(webrtc::Clock* clock, EventLoop* el,
+            FeedbackScheduler* feedback_scheduler);
+    ~NackRequester() override;
+
     void ProcessNacks();
+    int64_t ProcessFeedback(int64_t now_ms) override;
 
     int OnReceivedPacket(uint16_t seq_num, bool is_keyframe);
     int OnReceivedPacket(uint16_t seq_num, bool is_keyframe, bool is_recovered);
-   
+
     void ClearUpTo(uint16_t seq_num);
     void UpdateRtt(int64_t rtt_ms);
     sigslot::signal1<const std::vector<uint16_t>&> SignalNackSend;
@@ -41,32 +48,66 @@ private:
         int64_t created_at_time;
         int64_t sent_at_time;
         int retries;
-    }; 
-   
+    };
+
+    // 2的幂，不小于kMaxNackPackets，保证同一时刻的丢包不会占用同一个位置
+    static const size_t kNackWindowSize = 2048;
+    static const size_t kBitmapWords = kNackWindowSize / 64;
+
     void AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_end);
     bool RemovePacketsUntilKeyFrame();
     std::vector<uint16_t> GetNackBatch(NackFilterOptions options);
     void UpdateReorderingStatistics(uint16_t seq_num);
-	// Returns how many packets we have to wait in order to receive the packet
-	// with probability `probabilty` or higher.
-	int WaitNumberOfPackets(float probability) const; 
+    // Returns how many packets we have to wait in order to receive the packet
+    // with probability `probabilty` or higher.
+    int WaitNumberOfPackets(float probability) const;
+
+    // 窗口前移到seq_num，复用的位置上是已经超出窗口的旧序列号，需要清除
+    void AdvanceWindow(uint16_t seq_num);
+    bool InWindow(uint16_t seq_num) const;
+    bool HasNack(uint16_t seq_num) const;
+    void RemoveNack(uint16_t seq_num);
+    // 删除所有早于seq_num的丢包记录，返回删除的个数
+    size_t RemoveNacksBefore(uint16_t seq_num);
+    // 从最旧到最新依次访问丢包记录，func返回false时删除该记录
+    template <typename Func>
+    void ForEachNack(Func func);
+
+    static size_t Slot(uint16_t seq_num) { return seq_num & (kNackWindowSize - 1); }
+    static bool TestBit(const uint64_t* bitmap, size_t slot) {
+        return (bitmap[slot / 64] >> (slot % 64)) & 1;
+    }
+    static void SetBit(uint64_t* bitmap, size_t slot) {
+        bitmap[slot / 64] |= (uint64_t)1 << (slot % 64);
+    }
+    static void ClearBit(uint64_t* bitmap, size_t slot) {
+        bitmap[slot / 64] &= ~((uint64_t)1 << (slot % 64));
+    }
+    // 清除环上从slot开始的count个位，中间整字清除，只有两端的字需要掩码，
+    // 返回清除之前置位的个数
+    static size_t ClearRange(uint64_t* bitmap, size_t slot, size_t count);
 
 private:
     webrtc::Clock* const clock_;
     EventLoop* el_;
     TimerWatcher* nack_timer_ = nullptr;
-    std::map<uint16_t, NackInfo, webrtc::DescendingSeqNumComp<uint16_t>> nack_list_;
-    std::set<uint16_t, webrtc::DescendingSeqNumComp<uint16_t>> keyframe_list_;
-    std::set<uint16_t, webrtc::DescendingSeqNumComp<uint16_t>> recovered_list_;
-    video_coding::Histogram reordering_histogram_; 
+    FeedbackScheduler* feedback_scheduler_;
+    std::vector<NackInfo> nack_ring_;
+    uint64_t nack_bitmap_[kBitmapWords];
+    // 已经通过FEC/RTX恢复的包，不再请求重传
+    uint64_t recovered_bitmap_[kBitmapWords];
+    size_t nack_count_ = 0;
+    // 关键帧第一个包的序列号，从旧到新
+    std::deque<uint16_t> keyframe_list_;
+    video_coding::Histogram reordering_histogram_;
     bool initialized_ = false;
     int64_t rtt_ms_;
     uint16_t newest_seq_num_ = 0;
+    // 窗口中最新的序列号，FEC/RTX恢复的包可能比newest_seq_num_更新
+    uint16_t window_end_seq_num_ = 0;
     const int64_t send_nack_delay_ms_ = 0;
 };
 
 } // namespace xrtc
 
 #endif  // XRTCSERVER_MODULES_VIDEO_CODING_NACK_REQUESTER_H_
-
-
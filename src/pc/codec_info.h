@@ -16,8 +16,8 @@ public:
         _id(id), _param(param) {}
     FeedbackParam(const std::string& id) : _id(id), _param("") {}
 
-    std::string id() { return _id; }
-    std::string param() { return _param; }
+    const std::string& id() const { return _id; }
+    const std::string& param() const { return _param; }
 
 private:
     std::string _id;
@@ -0,0 +1,55 @@
+#include "pc/offer_template.h"
+
+#include "base/metrics.h"
+
+namespace xrtc {
+
+OfferTemplateCache* OfferTemplateCache::ThreadInstance() {
+    static thread_local OfferTemplateCache cache;
+    return &cache;
+}
+
+std::string OfferTemplateCache::Render(uint32_t key, SessionDescription* desc) {
+    const auto& contents = desc->contents();
+
+    auto iter = templates_.find(key);
+    if (iter == templates_.end() || iter->second.media_heads.size() != contents.size()) {
+        OfferTemplate tmpl;
+        SdpWriter session_part(256);
+        desc->BuildSessionPart(session_part);
+        tmpl.session_part = session_part.Release();
+
+        for (auto content : contents) {
+            SdpWriter head(256);
+            desc->BuildMediaHead(content, head);
+            tmpl.media_heads.push_back(head.Release());
+
+            SdpWriter body(1024);
+            desc->BuildMediaBody(content, body);
+            tmpl.media_bodies.push_back(body.Release());
+        }
+
+        iter = templates_.emplace(key, std::move(tmpl)).first;
+
+        Metrics* metrics = Metrics::ThreadInstance();
+        metrics->Increment("offer_template_miss");
+        metrics->SetGauge("offer_template_num", templates_.size());
+    } else {
+        Metrics::ThreadInstance()->Increment("offer_template_hit");
+    }
+
+    OfferTemplate& tmpl = iter->second;
+    SdpWriter ss(tmpl.size_hint);
+    ss << tmpl.session_part;
+    for (size_t i = 0; i < contents.size(); ++i) {
+        ss << tmpl.media_heads[i];
+        desc->BuildMediaTransport(contents[i], ss);
+        ss << tmpl.media_bodies[i];
+        desc->BuildMediaSsrc(contents[i], ss);
+    }
+
+    tmpl.size_hint = ss.size();
+    return ss.Release();
+}
+
+} // namespace xrtc
@@ -0,0 +1,41 @@
+#ifndef  __XRTCSERVER_PC_OFFER_TEMPLATE_H_
+#define  __XRTCSERVER_PC_OFFER_TEMPLATE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pc/session_description.h"
+
+namespace xrtc {
+
+// 预先生成的offer。
+// 同一种结构(音视频、方向、dtls、fec等)的offer中，编码、rtcp-fb、扩展头、
+// BUNDLE等部分对所有会话都相同，只生成一次；candidate、ice、fingerprint和
+// ssrc部分作为空位，每个会话生成offer时再填入
+struct OfferTemplate {
+    std::string session_part;
+    // 和desc->contents()一一对应
+    std::vector<std::string> media_heads;
+    std::vector<std::string> media_bodies;
+    // 上一次生成的offer的长度，用于预分配缓冲区
+    size_t size_hint = SdpWriter::kDefaultCapacity;
+};
+
+// 每个rtc worker线程一份，不需要加锁
+class OfferTemplateCache {
+public:
+    static OfferTemplateCache* ThreadInstance();
+
+    // key需要唯一确定desc的结构，第一次遇到时根据desc生成模板
+    std::string Render(uint32_t key, SessionDescription* desc);
+
+private:
+    std::unordered_map<uint32_t, OfferTemplate> templates_;
+};
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_PC_OFFER_TEMPLATE_H_
@@ -1,27 +1,36 @@
 #include "pc/peer_connection.h"
 
-#include <absl/algorithm/container.h>
 #include <rtc_base/logging.h>
 #include <modules/rtp_rtcp/source/rtp_packet_received.h>
+#include <modules/rtp_rtcp/source/rtp_header_extensions.h>
 #include <modules/rtp_rtcp/source/rtcp_packet/receiver_report.h>
+#include <rtc_base/byte_io.h>
 
+#include "base/conf.h"
+#include "base/metrics.h"
 #include "ice/ice_credentials.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+#include "modules/rtp_rtcp/rtp_utils.h"
+#include "pc/offer_template.h"
+
+extern xrtc::GeneralConf* g_conf;
 
 namespace xrtc {
 
     namespace {
 
+        const uint32_t kDefaultAudioSsrc = 2;
         const uint32_t kDefaultVideoSsrc = 1;
+        const int kAudioPayloadTypeFrequency = 48000;
+        // 每隔多少个rtp包采样一次处理耗费的cpu时间
+        const uint32_t kCpuSampleMask = 0x3F;
+        // REMB下降超过3%时立即发送，其余情况跟随周期性的rtcp发送
+        const double kRembSendThreshold = 0.97;
+        // rtt平滑: new = old * 7/8 + sample * 1/8
+        const int64_t kRttSmoothingDenominator = 8;
 
     } // namespace
 
-    struct SsrcInfo {
-        uint32_t ssrc_id;
-        std::string cname;
-        std::string stream_id;
-        std::string track_id;
-    };
-
     static RtpDirection GetDirection(bool send, bool recv) {
         if (send && recv) {
             return RtpDirection::kSendRecv;
@@ -34,10 +43,36 @@ namespace xrtc {
         }
     }
 
-    PeerConnection::PeerConnection(EventLoop *el, PortAllocator *allocator) :
+    // simulcast的多层对拉流端只暴露成一路流：最低层的主ssrc以及它的rtx ssrc
+    static StreamParams ToSingleLayerStream(const StreamParams &stream) {
+        std::vector<uint32_t> primary_ssrcs;
+        stream.GetPrimarySsrcs(&primary_ssrcs);
+        if (primary_ssrcs.size() <= 1) {
+            return stream;
+        }
+
+        StreamParams result = stream;
+        result.ssrcs.clear();
+        result.ssrc_groups.clear();
+        result.ssrcs.push_back(primary_ssrcs[0]);
+
+        uint32_t rtx_ssrc = 0;
+        if (stream.GetFidSsrc(primary_ssrcs[0], &rtx_ssrc)) {
+            result.ssrcs.push_back(rtx_ssrc);
+            result.ssrc_groups.push_back(SsrcGroup(kFidSsrcGroupSemantics,
+                    {primary_ssrcs[0], rtx_ssrc}));
+        }
+
+        return result;
+    }
+
+    PeerConnection::PeerConnection(EventLoop *el, PortAllocator *allocator,
+                                   FeedbackScheduler *feedback_scheduler) :
             el_(el),
             clock_(webrtc::Clock::GetRealTimeClock()),
-            transport_controller_(new TransportController(el, allocator)) {
+            feedback_scheduler_(feedback_scheduler),
+            transport_controller_(new TransportController(el, allocator)),
+            video_frame_assembly_(!g_conf->video_relay_mode) {
         transport_controller_->SignalCandidateAllocateDone.connect(this,
                                                                    &PeerConnection::OnCandidateAllocateDone);
         transport_controller_->SignalConnectionState.connect(this,
@@ -78,36 +113,120 @@ namespace xrtc {
     }
 
     void PeerConnection::OnConnectionState(TransportController *, PeerConnectionState state) {
+        if (PeerConnectionState::kConnected == state && !rtt_from_rtcp_) {
+            int ice_rtt_ms = transport_controller_->GetIceRtt(
+                    GetTransportName(webrtc::MediaType::VIDEO));
+            if (ice_rtt_ms > 0) {
+                SetRtt(ice_rtt_ms);
+            }
+        }
+
         SignalConnectionState(this, state);
     }
 
     void PeerConnection::OnRtpPacketReceived(TransportController *,
                                              rtc::CopyOnWriteBuffer *packet, int64_t ts) {
-        webrtc::RtpPacketReceived parsed_packet;
-        if (!parsed_packet.Parse(std::move(*packet))) {
+        // 采样统计每个rtp包从解析到转发给所有拉流端消耗的cpu时间，
+        // 区分转发模式和组帧模式
+        ScopedCpuTimer cpu_timer(video_frame_assembly_ ?
+                "rtp_ingest_cpu_ns.assembly" : "rtp_ingest_cpu_ns.relay",
+                (++rtp_packets_received_ & kCpuSampleMask) == 0);
+
+        // 路由和转发只需要rtp固定头部，扩展头在用到时才解析
+        RtpPacketView view;
+        if (!view.Parse(packet->cdata(), packet->size())) {
             RTC_LOG(LS_WARNING) << "invalid rtp packet";
             return;
         }
 
-        if (ts > 0) {
-            parsed_packet.set_arrival_time(webrtc::Timestamp::Micros(ts));
-        } else {
-            parsed_packet.set_arrival_time(clock_->CurrentTime());
+        webrtc::MediaType packet_type = GetMediaType(view.Ssrc());
+        if (packet_type != webrtc::MediaType::ANY && transport_feedback_generator_) {
+            uint16_t transport_seq = 0;
+            if (view.GetExtension<webrtc::TransportSequenceNumber>(extension_map_,
+                        &transport_seq))
+            {
+                transport_feedback_generator_->OnPacketArrival(transport_seq, ts,
+                        view.Ssrc());
+            }
+        }
+
+        if (packet_type != webrtc::MediaType::ANY && receive_side_bwe_) {
+            uint32_t abs_send_time = 0;
+            if (view.GetExtension<webrtc::AbsoluteSendTime>(extension_map_,
+                        &abs_send_time) &&
+                receive_side_bwe_->OnPacketArrival(abs_send_time, ts / 1000,
+                        packet->size()))
+            {
+                UpdateRemb();
+            }
         }
 
-        webrtc::MediaType packet_type = GetMediaType(parsed_packet.Ssrc());
         if (packet_type == webrtc::MediaType::VIDEO) {
-            parsed_packet.set_payload_type_frequency(webrtc::kVideoPayloadTypeFrequency);
-            if (video_receive_stream_) {
-                video_receive_stream_->OnRtpPacket(parsed_packet);
+            uint32_t media_ssrc = view.Ssrc();
+            auto rtx_iter = remote_video_rtx_ssrcs_.find(media_ssrc);
+            bool is_rtx = (rtx_iter != remote_video_rtx_ssrcs_.end());
+            if (is_rtx) {
+                media_ssrc = rtx_iter->second;
+            }
+
+            auto iter = video_receive_streams_.find(media_ssrc);
+            if (iter != video_receive_streams_.end()) {
+                webrtc::RtpPacketReceived parsed_packet(&extension_map_);
+                if (BuildReceivedPacket(*packet, ts,
+                            webrtc::kVideoPayloadTypeFrequency, &parsed_packet))
+                {
+                    if (is_rtx) {
+                        // 推流端的rtx包修复的是上行丢包，拉流端同样没有收到原始包，
+                        // 还原成原始的ssrc、序列号和payload type之后继续转发；
+                        // 下行的重传由本端的发送流负责
+                        rtc::CopyOnWriteBuffer media_packet;
+                        if (iter->second->OnRtxPacket(parsed_packet, &media_packet)) {
+                            SignalRtpPacketReceived(this, &media_packet, ts);
+                        }
+                    } else {
+                        iter->second->OnRtpPacket(parsed_packet);
+                    }
+                }
+            }
+
+            if (!is_rtx) {
+                SignalRtpPacketReceived(this, packet, ts);
+            }
+        } else if (packet_type == webrtc::MediaType::AUDIO) {
+            if (audio_receive_stream_) {
+                webrtc::RtpPacketReceived parsed_packet(&extension_map_);
+                if (BuildReceivedPacket(*packet, ts, kAudioPayloadTypeFrequency,
+                            &parsed_packet))
+                {
+                    audio_receive_stream_->OnRtpPacket(parsed_packet);
+                }
             }
+
+            SignalRtpPacketReceived(this, packet, ts);
+        }
+    }
+
+    bool PeerConnection::BuildReceivedPacket(const rtc::CopyOnWriteBuffer &buffer,
+                                             int64_t ts, int payload_type_frequency,
+                                             webrtc::RtpPacketReceived *parsed_packet) {
+        // 只有接收统计、组帧等模块需要完整解析的rtp包，和转发共享同一块内存
+        if (!parsed_packet->Parse(buffer)) {
+            RTC_LOG(LS_WARNING) << "parse rtp packet failed";
+            return false;
+        }
+
+        if (ts > 0) {
+            parsed_packet->set_arrival_time(webrtc::Timestamp::Micros(ts));
+        } else {
+            parsed_packet->set_arrival_time(clock_->CurrentTime());
         }
 
-        //SignalRtpPacketReceived(this, packet, ts);
+        parsed_packet->set_payload_type_frequency(payload_type_frequency);
+        return true;
     }
 
     webrtc::MediaType PeerConnection::GetMediaType(uint32_t ssrc) const {
-        if (ssrc == remote_video_ssrc_ || ssrc == remote_video_rtx_ssrc_) {
+        if (video_receive_streams_.count(ssrc) || remote_video_rtx_ssrcs_.count(ssrc)) {
             return webrtc::MediaType::VIDEO;
         } else if (ssrc == remote_audio_ssrc_) {
             return webrtc::MediaType::AUDIO;
@@ -118,10 +237,22 @@ namespace xrtc {
 
     void PeerConnection::OnRtcpPacketReceived(TransportController *,
                                               rtc::CopyOnWriteBuffer *packet, int64_t ts) {
-        if (video_receive_stream_) {
-            video_receive_stream_->DeliverRtcp(packet->data(), packet->size());
+        // rtcp在每一路peerconnection上终结，由本端的收发模块各自处理
+        if (audio_receive_stream_) {
+            audio_receive_stream_->DeliverRtcp(packet->data(), packet->size());
+        }
+
+        if (audio_send_stream_) {
+            audio_send_stream_->DeliverRtcp(packet->data(), packet->size());
+        }
+
+        for (auto &video_receive_stream: video_receive_streams_) {
+            video_receive_stream.second->DeliverRtcp(packet->data(), packet->size());
+        }
+
+        if (video_send_stream_) {
+            video_send_stream_->DeliverRtcp(packet->data(), packet->size());
         }
-        //SignalRtcpPacketReceived(this, packet, ts);
     }
 
     int PeerConnection::Init(rtc::RTCCertificate *certificate) {
@@ -159,6 +290,7 @@ namespace xrtc {
         local_desc_ = std::make_unique<SessionDescription>(SdpType::kOffer);
 
         IceParameters ice_param = IceCredentials::CreateRandomIceCredentials();
+        bool with_fec = false;
 
         if (options.recv_audio || options.send_audio) {
             auto audio = std::make_shared<AudioContentDescription>();
@@ -183,9 +315,15 @@ namespace xrtc {
 
             if (options.send_video) {
                 for (auto stream: video_source_) {
-                    video->add_stream(stream);
+                    video->add_stream(ToSingleLayerStream(stream));
                 }
             }
+
+            // 只给拉流端生成FEC，推流端不需要协商red/ulpfec
+            if (options.send_video && !options.recv_video && g_conf->fec_enabled) {
+                video->AddFecCodecs();
+                with_fec = true;
+            }
         }
 
         if (options.use_rtp_mux) {
@@ -201,341 +339,539 @@ namespace xrtc {
 
         transport_controller_->SetLocalDescription(local_desc_.get());
 
-        return local_desc_->ToString();
+        // 结构相同的offer共用一个模板，只填入每个会话不同的部分。
+        // m行的协议取决于是否真正生成了fingerprint
+        bool with_fingerprint = !local_desc_->contents().empty();
+        for (auto content: local_desc_->contents()) {
+            auto td = local_desc_->GetTransportInfo(content->mid());
+            if (!td || !td->identity_fingerprint) {
+                with_fingerprint = false;
+            }
+        }
+
+        uint32_t template_key = (options.send_audio ? 0x01 : 0)
+            | (options.recv_audio ? 0x02 : 0)
+            | (options.send_video ? 0x04 : 0)
+            | (options.recv_video ? 0x08 : 0)
+            | (options.use_rtp_mux ? 0x10 : 0)
+            | (options.use_rtcp_mux ? 0x20 : 0)
+            | (with_fingerprint ? 0x40 : 0)
+            | (with_fec ? 0x80 : 0);
+        return OfferTemplateCache::ThreadInstance()->Render(template_key,
+                local_desc_.get());
     }
 
-    static std::string GetAttribute(const std::string &line) {
-        std::vector<std::string> fields;
-        size_t size = rtc::tokenize(line, ':', &fields);
-        if (size != 2) {
-            RTC_LOG(LS_WARNING) << "get attribute error: " << line;
-            return "";
+    int PeerConnection::SetRemoteDescription(std::shared_ptr<RemoteDescription> remote) {
+        if (!remote) {
+            RTC_LOG(LS_WARNING) << "remote description is null";
+            return -1;
         }
 
-        return fields[1];
+        remote_desc_ = remote->desc;
+        remote_ulpfec_ = remote->ulpfec;
+        remote_video_rtx_payload_types_ = remote->video_rtx_apts;
+
+        CreateRtpHeaderExtensionMap();
+        CreateAudioReceiveStream(remote->audio_content.get());
+        CreateAudioSendStream(remote->audio_content.get());
+        CreateVideoReceiveStream(remote->video_content.get());
+        CreateVideoSendStream(remote->video_content.get());
+        CreateTransportFeedbackGenerator();
+        CreateSendSideBandwidthEstimation();
+        CreateReceiveSideBandwidthEstimation();
+        CreatePacedSender();
+        CreateFecController();
+
+        transport_controller_->SetRemoteDescription(remote_desc_.get());
+        return 0;
     }
 
-    static int ParseTransportInfo(TransportDescription *td, const std::string &line) {
-        if (line.find("a=ice-ufrag") != std::string::npos) {
-            td->ice_ufrag = GetAttribute(line);
-            if (td->ice_ufrag.empty()) {
-                return -1;
-            }
-        } else if (line.find("a=ice-pwd") != std::string::npos) {
-            td->ice_pwd = GetAttribute(line);
-            if (td->ice_pwd.empty()) {
-                return -1;
-            }
-        } else if (line.find("a=fingerprint") != std::string::npos) {
-            std::vector<std::string> items;
-            rtc::tokenize(line, ' ', &items);
-            if (items.size() != 2) {
-                RTC_LOG(LS_WARNING) << "parse a=fingerprint error: " << line;
-                return -1;
+    void PeerConnection::CreateRtpHeaderExtensionMap() {
+        extension_map_ = webrtc::RtpHeaderExtensionMap();
+        for (auto content: remote_desc_->contents()) {
+            for (auto &ext: content->rtp_header_extensions()) {
+                extension_map_.RegisterByUri(ext.id, ext.uri);
             }
+        }
+    }
 
-            // a=fingerprint: 14
-            std::string alg = items[0].substr(14);
-            absl::c_transform(alg, alg.begin(), ::tolower);
-            std::string content = items[1];
+    void PeerConnection::CreateTransportFeedbackGenerator() {
+        // 只有推流端协商了transport-cc扩展时，才需要给推流端发送反馈
+        if (!extension_map_.IsRegistered(webrtc::kRtpExtensionTransportSequenceNumber)) {
+            return;
+        }
 
-            td->identity_fingerprint = rtc::SSLFingerprint::CreateUniqueFromRfc4572(
-                    alg, content);
-            if (!(td->identity_fingerprint.get())) {
-                RTC_LOG(LS_WARNING) << "create fingerprint error: " << line;
-                return -1;
-            }
+        if (!audio_receive_stream_ && video_receive_streams_.empty()) {
+            return;
         }
 
-        return 0;
+        transport_feedback_generator_ = std::make_unique<TransportFeedbackGenerator>(
+                clock_, el_, feedback_scheduler_, kDefaultVideoSsrc);
+        transport_feedback_generator_->SignalTransportFeedback.connect(this,
+                &PeerConnection::OnLocalTransportFeedback);
     }
 
-    static int ParseSsrcInfo(std::vector<SsrcInfo> &ssrc_info, const std::string &line) {
-        if (line.find("a=ssrc:") == std::string::npos) {
-            return 0;
+    void PeerConnection::OnLocalTransportFeedback(
+            const webrtc::rtcp::TransportFeedback &feedback) {
+        // transport-cc是整条传输通道的反馈，任选一路接收流的rtcp模块发送
+        if (!video_receive_streams_.empty()) {
+            video_receive_streams_.begin()->second->SendTransportFeedback(feedback);
+        } else if (audio_receive_stream_) {
+            audio_receive_stream_->SendTransportFeedback(feedback);
         }
+    }
 
-        //rfc5576
-        // a=ssrc:<ssrc-id> <attribute>
-        // a=ssrc:<ssrc-id> <attribute>:<value>
-        std::string field1, field2;
-        if (!rtc::tokenize_first(line.substr(2), ' ', &field1, &field2)) {
-            RTC_LOG(LS_WARNING) << "parse a=ssrc failed, line: " << line;
-            return -1;
+    void PeerConnection::CreateSendSideBandwidthEstimation() {
+        // 拉流端协商了transport-cc扩展时，根据拉流端的反馈估计下行带宽
+        if (!extension_map_.IsRegistered(webrtc::kRtpExtensionTransportSequenceNumber)) {
+            return;
         }
 
-        // ssrc:<ssrc-id>
-        std::string ssrc_id_s = field1.substr(5);
-        uint32_t ssrc_id = 0;
-        if (!rtc::FromString(ssrc_id_s, &ssrc_id)) {
-            RTC_LOG(LS_WARNING) << "invalid ssrc_id, line: " << line;
-            return -1;
+        if (!audio_send_stream_ && !video_send_stream_) {
+            return;
         }
 
-        // <attribute>
-        std::string attribute;
-        std::string value;
-        if (!rtc::tokenize_first(field2, ':', &attribute, &value)) {
-            RTC_LOG(LS_WARNING) << "get ssrc attribute failed, line: " << line;
-            return -1;
-        }
+        send_side_bwe_ = std::make_unique<SendSideBandwidthEstimation>(
+                (int64_t)g_conf->subscriber_bitrate_kbps * 1000,
+                (int64_t)g_conf->bwe_min_bitrate_kbps * 1000,
+                (int64_t)g_conf->bwe_max_bitrate_kbps * 1000);
+    }
 
-        auto iter = ssrc_info.begin();
-        for (; iter != ssrc_info.end(); ++iter) {
-            if (iter->ssrc_id == ssrc_id) {
-                break;
-            }
+    void PeerConnection::CreatePacedSender() {
+        if (!g_conf->pacer_enabled) {
+            return;
         }
 
-        if (iter == ssrc_info.end()) {
-            SsrcInfo info;
-            info.ssrc_id = ssrc_id;
-            ssrc_info.push_back(info);
-            iter = ssrc_info.end() - 1;
+        if (!audio_send_stream_ && !video_send_stream_) {
+            return;
         }
 
-        if ("cname" == attribute) {
-            iter->cname = value;
-        } else if ("msid" == attribute) {
-            std::vector<std::string> fields;
-            rtc::split(value, ' ', &fields);
-            if (fields.size() < 1 || fields.size() > 2) {
-                RTC_LOG(LS_WARNING) << "msid format error, line: " << line;
-                return -1;
-            }
+        int64_t bitrate_bps = send_side_bwe_ ? send_side_bwe_->target_bitrate_bps() :
+            (int64_t)g_conf->subscriber_bitrate_kbps * 1000;
+        pacer_ = std::make_unique<PacedSender>(clock_, el_,
+                (int64_t)(bitrate_bps * g_conf->pacing_factor));
+        pacer_->SignalSendPacket.connect(this, &PeerConnection::OnPacedPacket);
+        pacer_->SignalKeyFrameRequired.connect(this, &PeerConnection::OnPacerKeyFrameRequired);
+    }
 
-            iter->stream_id = fields[0];
-            if (fields.size() == 2) {
-                iter->track_id = fields[1];
-            }
+    void PeerConnection::CreateFecController() {
+        if (!g_conf->fec_enabled || !remote_ulpfec_ || !video_send_stream_) {
+            return;
         }
 
-        return 0;
+        FecControllerConfig config;
+        config.min_loss_fraction = g_conf->fec_min_loss_fraction;
+        config.low_rtt_ms = g_conf->fec_low_rtt_ms;
+        config.high_rtt_ms = g_conf->fec_high_rtt_ms;
+        fec_controller_ = std::make_unique<FecController>(config);
+        video_send_stream_->EnableUlpfec();
     }
 
-    static int ParseSsrcGroupInfo(std::vector<SsrcGroup> &ssrc_groups,
-                                  const std::string &line) {
-        if (line.find("a=ssrc-group:") == std::string::npos) {
-            return 0;
+    void PeerConnection::UpdateFecProtection() {
+        if (!fec_controller_ || !send_side_bwe_) {
+            return;
         }
 
-        // rfc5576
-        // a=ssrc-group:<semantics> <ssrc-id> ...
-        std::vector<std::string> fields;
-        rtc::split(line.substr(2), ' ', &fields);
-        if (fields.size() < 2) {
-            RTC_LOG(LS_WARNING) << "ssrc-group field size < 2, line: " << line;
-            return -1;
+        ProtectionMode prev_mode = fec_controller_->mode();
+        fec_controller_->Update(send_side_bwe_->loss_fraction(), rtt_ms_);
+        video_send_stream_->SetFecProtectionFactor(fec_controller_->protection_factor());
+
+        if (fec_controller_->mode() != prev_mode) {
+            RTC_LOG(LS_INFO) << "protection mode changed, mode: "
+                             << ProtectionModeToString(fec_controller_->mode())
+                             << ", protection_factor: "
+                             << (int)fec_controller_->protection_factor()
+                             << ", loss_fraction: "
+                             << fec_controller_->smoothed_loss_fraction();
         }
+    }
 
-        std::string semantics = GetAttribute(fields[0]);
-        if (semantics.empty()) {
-            return -1;
+    void PeerConnection::CreateReceiveSideBandwidthEstimation() {
+        // 推流端协商了abs-send-time时，估计推流端的上行带宽，通过REMB反馈
+        if (!extension_map_.IsRegistered(webrtc::kRtpExtensionAbsoluteSendTime)) {
+            return;
         }
 
-        std::vector<uint32_t> ssrcs;
-        for (size_t i = 1; i < fields.size(); ++i) {
-            uint32_t ssrc_id = 0;
-            if (!rtc::FromString(fields[i], &ssrc_id)) {
-                return -1;
-            }
-            ssrcs.push_back(ssrc_id);
+        if (video_receive_streams_.empty()) {
+            return;
         }
 
-        ssrc_groups.push_back(SsrcGroup(semantics, ssrcs));
+        // 初始不限制推流端，检测到上行过载之后再降低
+        receive_side_bwe_ = std::make_unique<ReceiveSideBandwidthEstimation>(
+                (int64_t)g_conf->bwe_max_bitrate_kbps * 1000,
+                (int64_t)g_conf->bwe_min_bitrate_kbps * 1000,
+                (int64_t)g_conf->bwe_max_bitrate_kbps * 1000);
+    }
 
-        return 0;
+    void PeerConnection::SetReceiveBitrateCap(int64_t bitrate_cap_bps) {
+        // simulcast推流时每个拉流端只接收其中一层，低层必须保持发送，
+        // 限制总码率会让推流端关掉高层，所以只对单层推流生效
+        if (video_receive_streams_.size() > 1) {
+            return;
+        }
+
+        if (receive_bitrate_cap_bps_ != bitrate_cap_bps) {
+            receive_bitrate_cap_bps_ = bitrate_cap_bps;
+            UpdateRemb();
+        }
     }
 
-    static void CreateTrackFromSsrcInfo(const std::vector<SsrcInfo> &ssrc_infos,
-                                        std::vector<StreamParams> &tracks) {
-        for (auto ssrc_info: ssrc_infos) {
-            std::string track_id = ssrc_info.track_id;
+    void PeerConnection::UpdateRemb() {
+        if (video_receive_streams_.empty()) {
+            return;
+        }
 
-            auto iter = tracks.begin();
-            for (; iter != tracks.end(); ++iter) {
-                if (iter->id == track_id) {
-                    break;
-                }
-            }
+        int64_t bitrate_bps = receive_side_bwe_ ? receive_side_bwe_->target_bitrate_bps() :
+            (int64_t)g_conf->bwe_max_bitrate_kbps * 1000;
+        if (receive_bitrate_cap_bps_ > 0) {
+            bitrate_bps = std::min(bitrate_bps, receive_bitrate_cap_bps_);
+        }
 
-            if (iter == tracks.end()) {
-                StreamParams track;
-                track.id = track_id;
-                tracks.push_back(track);
-                iter = tracks.end() - 1;
+        // 既没有估计值也没有上限时不发送REMB。最后一个拉流端停止之后上限被清除，
+        // 之前设置的REMB也要撤销，否则推流端会一直被限制在最后一个拉流端的码率
+        if (!receive_side_bwe_ && receive_bitrate_cap_bps_ <= 0) {
+            if (last_remb_bps_ > 0) {
+                last_remb_bps_ = 0;
+                video_receive_streams_.begin()->second->UnsetRemb();
             }
-
-            iter->cname = ssrc_info.cname;
-            iter->stream_id = ssrc_info.stream_id;
-            iter->ssrcs.push_back(ssrc_info.ssrc_id);
+            return;
         }
-    }
 
-    int PeerConnection::SetRemoteSdp(const std::string &sdp) {
-        std::vector<std::string> fields;
-        size_t size = rtc::tokenize(sdp, '\n', &fields);
-        if (size <= 0) {
-            RTC_LOG(LS_WARNING) << "sdp invalid";
-            return -1;
+        if (bitrate_bps == last_remb_bps_) {
+            return;
         }
 
-        bool is_rn = false;
-        if (sdp.find("\r\n") != std::string::npos) {
-            is_rn = true;
+        bool send_now = last_remb_bps_ <= 0 ||
+            bitrate_bps < last_remb_bps_ * kRembSendThreshold;
+        last_remb_bps_ = bitrate_bps;
+
+        std::vector<uint32_t> ssrcs;
+        for (auto &video_receive_stream: video_receive_streams_) {
+            ssrcs.push_back(video_receive_stream.first);
         }
 
-        remote_desc_ = std::make_unique<SessionDescription>(SdpType::kAnswer);
+        // REMB是对整个推流端的反馈，任选一路接收流的rtcp模块发送
+        video_receive_streams_.begin()->second->SetRemb(bitrate_bps, std::move(ssrcs),
+                send_now);
+    }
 
-        std::string media_type;
+    int64_t PeerConnection::bitrate_estimate_bps() const {
+        return send_side_bwe_ ? send_side_bwe_->target_bitrate_bps() : 0;
+    }
 
-        auto audio_content = std::make_shared<AudioContentDescription>();
-        auto video_content = std::make_shared<VideoContentDescription>();
-        auto audio_td = std::make_shared<TransportDescription>();
-        auto video_td = std::make_shared<TransportDescription>();
-        std::vector<SsrcInfo> audio_ssrc_info;
-        std::vector<SsrcInfo> video_ssrc_info;
-        std::vector<SsrcGroup> video_ssrc_groups;
-        std::vector<StreamParams> audio_tracks;
-        std::vector<StreamParams> video_tracks;
+    void PeerConnection::CreateAudioReceiveStream(AudioContentDescription *audio_content) {
+        for (auto send_stream: audio_content->streams()) {
+            uint32_t ssrc = send_stream.FirstSsrc();
+            if (ssrc != 0) {
+                remote_audio_ssrc_ = ssrc;
 
-        for (auto field: fields) {
-            if (is_rn) {
-                field = field.substr(0, field.length() - 1);
+                AudioReceiveStreamConfig config;
+                config.el = el_;
+                config.clock = clock_;
+                config.feedback_scheduler = feedback_scheduler_;
+                config.rtp.local_ssrc = kDefaultAudioSsrc;
+                config.rtp.remote_ssrc = remote_audio_ssrc_;
+                config.rtp_rtcp_module_observer = this;
+                audio_receive_stream_ = std::make_unique<AudioReceiveStream>(config);
             }
 
-            if (field.find("m=group:BUNDLE") != std::string::npos) {
-                std::vector<std::string> items;
-                rtc::split(field, ' ', &items);
-                if (items.size() > 1) {
-                    ContentGroup answer_bundle("BUNDLE");
-                    for (size_t i = 1; i < items.size(); ++i) {
-                        answer_bundle.AddContentName(items[i]);
-                    }
-                    remote_desc_->AddGroup(answer_bundle);
-                }
-            } else if (field.find("m=") != std::string::npos) {
-                std::vector<std::string> items;
-                rtc::split(field, ' ', &items);
-                if (items.size() <= 2) {
-                    RTC_LOG(LS_WARNING) << "parse m= error: " << field;
-                    return -1;
-                }
+            break;
+        }
+    }
 
-                // m=audio/video
-                media_type = items[0].substr(2);
-                if ("audio" == media_type) {
-                    remote_desc_->AddContent(audio_content);
-                    audio_td->mid = "audio";
-                } else if ("video" == media_type) {
-                    remote_desc_->AddContent(video_content);
-                    video_td->mid = "video";
-                }
+    void PeerConnection::CreateAudioSendStream(AudioContentDescription *audio_content) {
+        for (auto stream: audio_source_) {
+            uint32_t ssrc = stream.FirstSsrc();
+            if (ssrc == 0) {
+                continue;
             }
 
-            if ("audio" == media_type) {
-                if (ParseTransportInfo(audio_td.get(), field) != 0) {
-                    return -1;
-                }
+            AudioSendStreamConfig config;
+            config.el = el_;
+            config.clock = clock_;
+            config.feedback_scheduler = feedback_scheduler_;
+            config.rtp.ssrc = ssrc;
+            for (auto &remote_stream: audio_content->streams()) {
+                config.rtp.remote_ssrc = remote_stream.FirstSsrc();
+                break;
+            }
 
-                if (ParseSsrcInfo(audio_ssrc_info, field) != 0) {
-                    return -1;
+            for (auto &ext: audio_content->rtp_header_extensions()) {
+                if (ext.uri == webrtc::RtpExtension::kAudioLevelUri) {
+                    config.rtp.audio_level_extension_id = ext.id;
                 }
+            }
 
-            } else if ("video" == media_type) {
-                if (ParseTransportInfo(video_td.get(), field) != 0) {
-                    return -1;
-                }
+            config.skip_silence = skip_silent_audio_;
+            config.rtp_rtcp_module_observer = this;
+            audio_send_stream_ = std::make_unique<AudioSendStream>(config);
+            break;
+        }
+    }
 
-                if (ParseSsrcGroupInfo(video_ssrc_groups, field) != 0) {
-                    return -1;
-                }
+    void PeerConnection::SetVideoFrameAssembly(bool enabled) {
+        video_frame_assembly_ = enabled;
+        for (auto &video_receive_stream: video_receive_streams_) {
+            video_receive_stream.second->SetFrameAssembly(enabled);
+        }
+    }
+
+    void PeerConnection::CreateVideoReceiveStream(VideoContentDescription *video_content) {
+        // 按照系统的推拉流原子设计原则，一个peerconnection只允许推一个或者拉一个视频，
+        // 开启simulcast时，每一层单独创建一个接收流
+        for (auto send_stream: video_content->streams()) {
+            std::vector<uint32_t> primary_ssrcs;
+            send_stream.GetPrimarySsrcs(&primary_ssrcs);
 
-                if (ParseSsrcInfo(video_ssrc_info, field) != 0) {
-                    return -1;
+            for (uint32_t ssrc: primary_ssrcs) {
+                uint32_t rtx_ssrc = 0;
+                if (send_stream.GetFidSsrc(ssrc, &rtx_ssrc)) {
+                    remote_video_rtx_ssrcs_[rtx_ssrc] = ssrc;
                 }
+
+                VideoReceiveStreamConfig config;
+                config.el = el_;
+                config.clock = clock_;
+                config.feedback_scheduler = feedback_scheduler_;
+                config.rtp.local_ssrc = kDefaultVideoSsrc;
+                config.rtp.remote_ssrc = ssrc;
+                config.rtp.rtx_ssrc = rtx_ssrc;
+                config.rtp.rtx_associated_payload_types = remote_video_rtx_payload_types_;
+                config.frame_assembly = video_frame_assembly_;
+                // simulcast的各层使用同一个本端ssrc，只需要一路测量rtt
+                config.rtp.rtcp_xr_rrtr = video_receive_streams_.empty();
+                config.rtp_rtcp_module_observer = this;
+                video_receive_streams_[ssrc] = std::make_unique<VideoReceiveStream>(config);
             }
+
+            break;
         }
+    }
+
+    void PeerConnection::CreateVideoSendStream(VideoContentDescription *video_content) {
+        // 拉流端发送的是推流端的视频，ssrc沿用推流端(simulcast时为最低层)的ssrc
+        for (auto stream: video_source_) {
+            std::vector<uint32_t> primary_ssrcs;
+            stream.GetPrimarySsrcs(&primary_ssrcs);
+            if (primary_ssrcs.empty()) {
+                continue;
+            }
 
-        if (!audio_ssrc_info.empty()) {
-            CreateTrackFromSsrcInfo(audio_ssrc_info, audio_tracks);
+            uint32_t ssrc = primary_ssrcs[0];
+            VideoSendStreamConfig config;
+            config.el = el_;
+            config.clock = clock_;
+            config.feedback_scheduler = feedback_scheduler_;
+            config.rtp.ssrc = ssrc;
+            stream.GetFidSsrc(ssrc, &config.rtp.rtx_ssrc);
 
-            for (auto track: audio_tracks) {
-                audio_content->add_stream(track);
+            for (auto &remote_stream: video_content->streams()) {
+                config.rtp.remote_ssrc = remote_stream.FirstSsrc();
+                break;
+            }
+
+            config.rtp_rtcp_module_observer = this;
+            video_send_stream_ = std::make_unique<VideoSendStream>(config);
+
+            if (primary_ssrcs.size() > 1) {
+                layer_selector_ = std::make_unique<SimulcastLayerSelector>(clock_,
+                        primary_ssrcs, ssrc,
+                        (int64_t)g_conf->subscriber_bitrate_kbps * 1000);
+                layer_selector_->SignalKeyFrameRequest.connect(this,
+                        &PeerConnection::OnLayerKeyFrameRequest);
             }
+            break;
         }
+    }
 
-        if (!video_ssrc_info.empty()) {
-            CreateTrackFromSsrcInfo(video_ssrc_info, video_tracks);
+    void PeerConnection::OnLayerKeyFrameRequest(uint32_t ssrc) {
+        SignalKeyFrameRequest(this, ssrc);
+    }
 
-            for (auto ssrc_group: video_ssrc_groups) {
-                if (ssrc_group.ssrcs.empty()) {
-                    continue;
-                }
+    void PeerConnection::SetBitrateBudget(int64_t bitrate_budget_bps) {
+        if (layer_selector_) {
+            layer_selector_->SetBitrateBudget(bitrate_budget_bps);
+        }
+    }
 
-                uint32_t ssrc = ssrc_group.ssrcs.front();
-                for (StreamParams &track: video_tracks) {
-                    if (track.HasSsrc(ssrc)) {
-                        track.ssrc_groups.push_back(ssrc_group);
-                    }
-                }
+    std::string PeerConnection::GetTransportName(webrtc::MediaType media_type) {
+        std::string mid = (webrtc::MediaType::AUDIO == media_type) ? "audio" : "video";
+        if (local_desc_ && local_desc_->IsBundle(mid)) {
+            return local_desc_->GetFirstBundleMid();
+        }
+
+        return mid;
+    }
+
+    int PeerConnection::SendRtp(const char *data, size_t len) {
+        webrtc::MediaType media_type = webrtc::MediaType::AUDIO;
+        RtpPacketView view;
+        if (!view.Parse((const uint8_t*)data, len)) {
+            return -1;
+        }
+
+        uint32_t ssrc = view.Ssrc();
+        if (layer_selector_ && video_send_stream_ && layer_selector_->HasSsrc(ssrc)) {
+            // simulcast: 只转发选中的一层，并改写成一路连续的流。
+            // 先用只读视图判断，没有选中的层不需要拷贝
+            if (!layer_selector_->OnRtpPacket(view)) {
+                return 0;
             }
 
-            for (auto track: video_tracks) {
-                video_content->add_stream(track);
+            rtc::CopyOnWriteBuffer buffer(data, len);
+            RtpPacketView rewrite_view;
+            rewrite_view.Parse(buffer.MutableData(), buffer.size());
+            layer_selector_->RewritePacket(&rewrite_view);
+
+            return SendRtp(webrtc::MediaType::VIDEO, std::move(buffer),
+                    PacketPriority::kVideo);
+        } else if (video_send_stream_ && ssrc == video_send_stream_->ssrc()) {
+            media_type = webrtc::MediaType::VIDEO;
+        } else if (audio_send_stream_ && ssrc == audio_send_stream_->ssrc()) {
+            uint16_t seq_num = 0;
+            if (!audio_send_stream_->OnSendingRtpPacket(view, &seq_num)) {
+                // 静音包在加密之前直接丢弃
+                return 0;
             }
+
+            if (seq_num != view.SequenceNumber()) {
+                rtc::CopyOnWriteBuffer buffer(data, len);
+                RtpPacketView rewrite_view;
+                rewrite_view.Parse(buffer.MutableData(), buffer.size());
+                rewrite_view.SetSequenceNumber(seq_num);
+                return SendRtp(media_type, std::move(buffer), PacketPriority::kAudio);
+            }
+        }
+
+        return SendRtp(media_type, data, len, webrtc::MediaType::AUDIO == media_type ?
+                PacketPriority::kAudio : PacketPriority::kVideo);
+    }
+
+    int PeerConnection::SendRtp(webrtc::MediaType media_type, const char *data, size_t len,
+                                PacketPriority priority) {
+        if (!transport_controller_) {
+            return -1;
         }
 
-        remote_desc_->AddTransportInfo(audio_td);
-        remote_desc_->AddTransportInfo(video_td);
+        // 不需要排队也不需要改写时直接发送，避免拷贝
+        if (!pacer_ && !send_side_bwe_ && !fec_controller_) {
+            RtpPacketView view;
+            if (!view.Parse((const uint8_t*)data, len)) {
+                return -1;
+            }
 
-        CreateVideoReceiveStream(video_content.get());
+            OnRtpPacketSent(view, priority);
+            return transport_controller_->SendRtp(GetTransportName(media_type), data, len);
+        }
 
-        transport_controller_->SetRemoteDescription(remote_desc_.get());
-        return 0;
+        return SendRtp(media_type, rtc::CopyOnWriteBuffer(data, len), priority);
     }
 
-    void PeerConnection::CreateVideoReceiveStream(VideoContentDescription *video_content) {
-        // 按照系统的推拉流原子设计原则，一个peerconnection只允许推一个或者拉一个视频
-        for (auto send_stream: video_content->streams()) {
-            uint32_t ssrc = send_stream.FirstSsrc();
-            if (ssrc != 0) {
-                remote_video_ssrc_ = ssrc;
-                if (send_stream.ssrcs.size() >= 2) {
-                    remote_video_rtx_ssrc_ = send_stream.ssrcs[1];
-                }
+    int PeerConnection::SendRtp(webrtc::MediaType media_type, rtc::CopyOnWriteBuffer packet,
+                                PacketPriority priority) {
+        if (pacer_) {
+            size_t size = packet.size();
+            pacer_->EnqueuePacket(priority, media_type, std::move(packet));
+            return size;
+        }
 
-                VideoReceiveStreamConfig config;
-                config.el = el_;
-                config.clock = clock_;
-                config.rtp.local_ssrc = kDefaultVideoSsrc;
-                config.rtp.remote_ssrc = remote_video_ssrc_;
-                config.rtp_rtcp_module_observer = this;
-                video_receive_stream_ = std::make_unique<VideoReceiveStream>(config);
+        return SendRtpToTransport(media_type, priority, &packet);
+    }
+
+    void PeerConnection::OnPacedPacket(webrtc::MediaType media_type, PacketPriority priority,
+                                       rtc::CopyOnWriteBuffer *packet) {
+        SendRtpToTransport(media_type, priority, packet);
+    }
+
+    int PeerConnection::SendRtpToTransport(webrtc::MediaType media_type,
+                                           PacketPriority priority,
+                                           rtc::CopyOnWriteBuffer *packet) {
+        if (!transport_controller_) {
+            return -1;
+        }
+
+        RtpPacketView view;
+        if (!view.Parse(packet->MutableData(), packet->size())) {
+            return -1;
+        }
+
+        bool protect = PacketPriority::kVideo == priority && video_send_stream_ &&
+            video_send_stream_->ulpfec_enabled();
+        if (protect) {
+            video_send_stream_->UpdateSequenceNumber(&view);
+        }
+
+        SetTransportSequenceNumber(&view);
+        OnRtpPacketSent(view, priority);
+        if (!protect) {
+            return transport_controller_->SendRtp(GetTransportName(media_type),
+                    packet->data<char>(), packet->size());
+        }
+
+        // FEC包紧跟在被保护的帧之后发送，不再经过发送队列
+        std::vector<rtc::CopyOnWriteBuffer> fec_packets;
+        rtc::CopyOnWriteBuffer red_packet = video_send_stream_->ProtectRtpPacket(*packet,
+                view, &fec_packets);
+        int ret = transport_controller_->SendRtp(GetTransportName(media_type),
+                red_packet.data<char>(), red_packet.size());
+
+        for (rtc::CopyOnWriteBuffer &fec_packet: fec_packets) {
+            RtpPacketView fec_view;
+            if (!fec_view.Parse(fec_packet.MutableData(), fec_packet.size())) {
+                continue;
             }
 
-            break;
+            SetTransportSequenceNumber(&fec_view);
+            transport_controller_->SendRtp(GetTransportName(media_type),
+                    fec_packet.data<char>(), fec_packet.size());
         }
+
+        return ret;
     }
 
-    int PeerConnection::SendRtp(const char *data, size_t len) {
-        if (transport_controller_) {
-            // todo: 需要根据实际情况完善
-            return transport_controller_->SendRtp("audio", data, len);
+    void PeerConnection::SetTransportSequenceNumber(RtpPacketView *view) {
+        // 每一个拉流端使用独立的transport-wide序列号，离开发送队列时改写并记录发送时间
+        if (send_side_bwe_ && view->SetExtension<webrtc::TransportSequenceNumber>(
+                    extension_map_, transport_seq_))
+        {
+            send_side_bwe_->OnSentPacket(transport_seq_++, view->size(),
+                    clock_->TimeInMilliseconds());
         }
+    }
 
-        return -1;
+    void PeerConnection::OnRtpPacketSent(const RtpPacketView &view, PacketPriority priority) {
+        // 发送队列可能丢包并改写序列号，只有真正发送出去的视频包才放入重传缓存，
+        // 重传包已经在缓存中
+        if (PacketPriority::kVideo == priority && video_send_stream_) {
+            video_send_stream_->OnSendingRtpPacket(view);
+        }
+    }
+
+    PacerDropStats PeerConnection::egress_drop_stats() const {
+        return pacer_ ? pacer_->drop_stats() : PacerDropStats();
+    }
+
+    void PeerConnection::OnPacerKeyFrameRequired() {
+        // 发送队列丢弃了视频，需要推流端的关键帧才能恢复
+        OnKeyFrameRequested(webrtc::MediaType::VIDEO);
     }
 
-    int PeerConnection::SendRtcp(const char *data, size_t len) {
+    int PeerConnection::SendRtcp(webrtc::MediaType media_type, const char *data, size_t len) {
         if (transport_controller_) {
-            // todo: 需要根据实际情况完善
-            return transport_controller_->SendRtcp("audio", data, len);
+            return transport_controller_->SendRtcp(GetTransportName(media_type), data, len);
         }
 
         return -1;
     }
 
+    void PeerConnection::RequestKeyFrame(uint32_t ssrc) {
+        for (auto &video_receive_stream: video_receive_streams_) {
+            if (0 == ssrc || video_receive_stream.first == ssrc) {
+                video_receive_stream.second->RequestKeyFrame();
+            }
+        }
+    }
+
     static void DebugCompoundRtcpPacket(const uint8_t *data, size_t len) {
         auto packet = rtc::MakeArrayView<const uint8_t>(data, len);
 
@@ -588,7 +924,90 @@ namespace xrtc {
         DebugCompoundRtcpPacket(data, len);
 
         // 将本地打包好的rtcp包，发送给对方
-        SendRtcp((const char *) data, len);
+        SendRtcp(media_type, (const char *) data, len);
+    }
+
+    void PeerConnection::OnLocalRtpPacket(webrtc::MediaType media_type,
+                                          const uint8_t *data, size_t len) {
+        // 本端生成的rtp包只有重传包
+        SendRtp(media_type, (const char *) data, len, PacketPriority::kRetransmission);
+    }
+
+    void PeerConnection::OnNackReceived(webrtc::MediaType media_type,
+                                        const std::vector<uint16_t> &nack_list) {
+        if (webrtc::MediaType::VIDEO == media_type && video_send_stream_) {
+            // rtt太大时重传来不及，只依靠FEC恢复
+            if (fec_controller_ && ProtectionMode::kFec == fec_controller_->mode()) {
+                return;
+            }
+
+            video_send_stream_->OnNackReceived(nack_list);
+        }
+    }
+
+    void PeerConnection::OnTransportFeedback(webrtc::MediaType media_type,
+                                             const webrtc::rtcp::TransportFeedback &feedback) {
+        if (!send_side_bwe_) {
+            return;
+        }
+
+        // 同一个反馈会交给每一路发送流的rtcp模块，只处理其中一路
+        webrtc::MediaType feedback_media_type = video_send_stream_ ?
+            webrtc::MediaType::VIDEO : webrtc::MediaType::AUDIO;
+        if (media_type != feedback_media_type) {
+            return;
+        }
+
+        bool estimate_changed = send_side_bwe_->OnTransportFeedback(feedback,
+                clock_->TimeInMilliseconds());
+        UpdateFecProtection();
+        if (estimate_changed) {
+            int64_t target_bitrate_bps = send_side_bwe_->target_bitrate_bps();
+            RTC_LOG(LS_INFO) << "bandwidth estimate changed, target: " << target_bitrate_bps
+                             << ", delay_based: " << send_side_bwe_->delay_based_bitrate_bps()
+                             << ", loss_based: " << send_side_bwe_->loss_based_bitrate_bps()
+                             << ", loss_fraction: " << send_side_bwe_->loss_fraction();
+            SetBitrateBudget(target_bitrate_bps);
+            if (pacer_) {
+                pacer_->SetPacingRate(
+                        (int64_t)(target_bitrate_bps * g_conf->pacing_factor));
+            }
+            SignalBitrateEstimate(this, target_bitrate_bps);
+        }
+    }
+
+    void PeerConnection::OnRttUpdate(webrtc::MediaType /*media_type*/, int64_t rtt_ms) {
+        Metrics::ThreadInstance()->Observe("rtcp_rtt_ms", rtt_ms);
+
+        // 音视频的rtcp测量的是同一条链路，合并成一个平滑值，第一次测量替换掉ice的rtt
+        int64_t smoothed_rtt_ms = rtt_ms;
+        if (rtt_from_rtcp_) {
+            smoothed_rtt_ms = (rtt_ms_ * (kRttSmoothingDenominator - 1) + rtt_ms) /
+                kRttSmoothingDenominator;
+        }
+
+        rtt_from_rtcp_ = true;
+        SetRtt(smoothed_rtt_ms);
+    }
+
+    void PeerConnection::SetRtt(int64_t rtt_ms) {
+        rtt_ms_ = std::max<int64_t>(rtt_ms, 1);
+        for (auto &video_receive_stream: video_receive_streams_) {
+            video_receive_stream.second->UpdateRtt(rtt_ms_);
+        }
+
+        if (video_send_stream_) {
+            video_send_stream_->SetRtt(rtt_ms_);
+        }
+    }
+
+    void PeerConnection::OnKeyFrameRequested(webrtc::MediaType media_type) {
+        if (webrtc::MediaType::VIDEO == media_type && video_send_stream_) {
+            // 拉流端请求的是当前正在转发的那一层的关键帧
+            uint32_t ssrc = layer_selector_ ? layer_selector_->current_ssrc() :
+                video_send_stream_->ssrc();
+            SignalKeyFrameRequest(this, ssrc);
+        }
     }
 
     void PeerConnection::OnFrame(std::unique_ptr<RtpFrameObject> frame) {
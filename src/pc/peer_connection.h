@@ -3,15 +3,28 @@
 
 #include <string>
 #include <memory>
+#include <map>
 
 #include <rtc_base/rtc_certificate.h>
 #include <api/media_types.h>
+#include <modules/rtp_rtcp/include/rtp_header_extension_map.h>
 
 #include "base/event_loop.h"
 #include "pc/session_description.h"
+#include "pc/remote_description.h"
 #include "pc/transport_controller.h"
 #include "pc/stream_params.h"
+#include "audio/audio_receive_stream.h"
+#include "audio/audio_send_stream.h"
 #include "video/video_receive_stream.h"
+#include "video/video_send_stream.h"
+#include "video/simulcast_layer_selector.h"
+#include "modules/rtp_rtcp/transport_feedback_generator.h"
+#include "modules/congestion_controller/send_side_bandwidth_estimation.h"
+#include "modules/congestion_controller/receive_side_bandwidth_estimation.h"
+#include "modules/pacing/paced_sender.h"
+#include "modules/fec/fec_controller.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
 
 namespace xrtc {
 
@@ -29,12 +42,14 @@ class PeerConnection : public sigslot::has_slots<>,
                        public RtpRtcpModuleObserver
 {
 public:
-    PeerConnection(EventLoop* el, PortAllocator* allocator);
+    PeerConnection(EventLoop* el, PortAllocator* allocator,
+            FeedbackScheduler* feedback_scheduler);
     
     int Init(rtc::RTCCertificate* certificate);
     void Destroy();
     std::string CreateOffer(const RTCOfferAnswerOptions& options);
-    int SetRemoteSdp(const std::string& sdp);
+    // answer已经在signaling线程中解析好，这里只应用
+    int SetRemoteDescription(std::shared_ptr<RemoteDescription> remote);
     
     SessionDescription* remote_desc() { return remote_desc_.get(); }
     SessionDescription* local_desc() { return local_desc_.get(); }
@@ -46,16 +61,34 @@ public:
     void AddVideoSource(const std::vector<StreamParams>& source) {
         video_source_ = source;
     }
+
+    void set_skip_silent_audio(bool skip) { skip_silent_audio_ = skip; }
     
     int SendRtp(const char* data, size_t len);
-    int SendRtcp(const char* data, size_t len);
+    // 向推流端请求关键帧，ssrc为0时请求所有的simulcast层
+    void RequestKeyFrame(uint32_t ssrc);
+    // 拉流端的带宽预算，用于选择simulcast层
+    void SetBitrateBudget(int64_t bitrate_budget_bps);
+    // 默认只转发视频包，录制、帧统计等需要完整帧的功能需要开启组帧
+    void SetVideoFrameAssembly(bool enabled);
+    // 下行带宽估计值，拉流端没有协商transport-cc时返回0
+    int64_t bitrate_estimate_bps() const;
+    // 推流端REMB的上限，一般是拉流端能够接收的码率，0表示不限制
+    void SetReceiveBitrateCap(int64_t bitrate_cap_bps);
+    // 发送队列超限丢弃的统计
+    PacerDropStats egress_drop_stats() const;
+    // 平滑之后的rtt，0表示还没有测量到
+    int64_t rtt_ms() const { return rtt_ms_; }
 
     sigslot::signal2<PeerConnection*, PeerConnectionState>
         SignalConnectionState;
     sigslot::signal3<PeerConnection*, rtc::CopyOnWriteBuffer*, int64_t>
         SignalRtpPacketReceived;
-    sigslot::signal3<PeerConnection*, rtc::CopyOnWriteBuffer*, int64_t>
-        SignalRtcpPacketReceived;
+    // 拉流端请求关键帧，rtcp在本端终结，只把请求本身通知给上层
+    // 参数是需要关键帧的推流端ssrc
+    sigslot::signal2<PeerConnection*, uint32_t> SignalKeyFrameRequest;
+    // 拉流端的下行带宽估计值发生变化
+    sigslot::signal2<PeerConnection*, int64_t> SignalBitrateEstimate;
 
 private:
     ~PeerConnection();
@@ -72,18 +105,58 @@ private:
     
     void OnLocalRtcpPacket(webrtc::MediaType media_type,
             const uint8_t* data, size_t len) override;
+    void OnLocalRtpPacket(webrtc::MediaType media_type,
+            const uint8_t* data, size_t len) override;
+    void OnNackReceived(webrtc::MediaType media_type,
+            const std::vector<uint16_t>& nack_list) override;
+    void OnKeyFrameRequested(webrtc::MediaType media_type) override;
+    void OnTransportFeedback(webrtc::MediaType media_type,
+            const webrtc::rtcp::TransportFeedback& feedback) override;
+    void OnRttUpdate(webrtc::MediaType media_type, int64_t rtt_ms) override;
+    void SetRtt(int64_t rtt_ms);
 
+    int SendRtp(webrtc::MediaType media_type, const char* data, size_t len,
+            PacketPriority priority);
+    int SendRtp(webrtc::MediaType media_type, rtc::CopyOnWriteBuffer packet,
+            PacketPriority priority);
+    int SendRtpToTransport(webrtc::MediaType media_type, PacketPriority priority,
+            rtc::CopyOnWriteBuffer* packet);
+    void OnPacedPacket(webrtc::MediaType media_type, PacketPriority priority,
+            rtc::CopyOnWriteBuffer* packet);
+    void SetTransportSequenceNumber(RtpPacketView* view);
+    void OnRtpPacketSent(const RtpPacketView& view, PacketPriority priority);
+    void OnPacerKeyFrameRequired();
+    int SendRtcp(webrtc::MediaType media_type, const char* data, size_t len);
+    std::string GetTransportName(webrtc::MediaType media_type);
+
+    bool BuildReceivedPacket(const rtc::CopyOnWriteBuffer& buffer, int64_t ts,
+            int payload_type_frequency, webrtc::RtpPacketReceived* parsed_packet);
     webrtc::MediaType GetMediaType(uint32_t ssrc) const;
+    void CreateRtpHeaderExtensionMap();
+    void CreateAudioReceiveStream(AudioContentDescription* audio_content);
+    void CreateAudioSendStream(AudioContentDescription* audio_content);
     void CreateVideoReceiveStream(VideoContentDescription* video_content);
+    void CreateVideoSendStream(VideoContentDescription* video_content);
+    void CreateTransportFeedbackGenerator();
+    void OnLocalTransportFeedback(const webrtc::rtcp::TransportFeedback& feedback);
+    void CreateSendSideBandwidthEstimation();
+    void CreateReceiveSideBandwidthEstimation();
+    void CreatePacedSender();
+    void CreateFecController();
+    void UpdateFecProtection();
+    void UpdateRemb();
+    void OnLayerKeyFrameRequest(uint32_t ssrc);
     void OnFrame(std::unique_ptr<RtpFrameObject> frame) override;
     friend void DestroyTimerCb(EventLoop* el, TimerWatcher* w, void* data);
 
 private:
     EventLoop* el_;
     webrtc::Clock* clock_;
+    // worker内所有会话共享，统一发送rtcp反馈
+    FeedbackScheduler* feedback_scheduler_;
     bool is_dtls_ = true;
     std::unique_ptr<SessionDescription> local_desc_;
-    std::unique_ptr<SessionDescription> remote_desc_;
+    std::shared_ptr<SessionDescription> remote_desc_;
     rtc::RTCCertificate* certificate_ = nullptr;
     std::unique_ptr<TransportController> transport_controller_;
     TimerWatcher* destroy_timer_ = nullptr;
@@ -91,10 +164,35 @@ private:
     std::vector<StreamParams> video_source_;
     
     uint32_t remote_audio_ssrc_ = 0;
-    uint32_t remote_video_ssrc_ = 0;
-    uint32_t remote_video_rtx_ssrc_ = 0;
+    // rtx ssrc -> 对应的主ssrc
+    std::map<uint32_t, uint32_t> remote_video_rtx_ssrcs_;
+    // rtx payload type -> 原始包的payload type
+    std::map<int, int> remote_video_rtx_payload_types_;
+    bool skip_silent_audio_ = false;
+
+    webrtc::RtpHeaderExtensionMap extension_map_;
+    std::unique_ptr<AudioReceiveStream> audio_receive_stream_;
+    std::unique_ptr<AudioSendStream> audio_send_stream_;
 
-    std::unique_ptr<VideoReceiveStream> video_receive_stream_;
+    // 推流端每一个simulcast层对应一个接收流，以主ssrc为key
+    std::map<uint32_t, std::unique_ptr<VideoReceiveStream>> video_receive_streams_;
+    std::unique_ptr<VideoSendStream> video_send_stream_;
+    std::unique_ptr<SimulcastLayerSelector> layer_selector_;
+    std::unique_ptr<TransportFeedbackGenerator> transport_feedback_generator_;
+    std::unique_ptr<SendSideBandwidthEstimation> send_side_bwe_;
+    uint16_t transport_seq_ = 0;
+    std::unique_ptr<ReceiveSideBandwidthEstimation> receive_side_bwe_;
+    int64_t receive_bitrate_cap_bps_ = 0;
+    int64_t last_remb_bps_ = 0;
+    std::unique_ptr<PacedSender> pacer_;
+    // 拉流端的answer中保留了red/ulpfec
+    bool remote_ulpfec_ = false;
+    std::unique_ptr<FecController> fec_controller_;
+    int64_t rtt_ms_ = 0;
+    // rtcp测量出rtt之前，使用ice的rtt
+    bool rtt_from_rtcp_ = false;
+    bool video_frame_assembly_ = false;
+    uint32_t rtp_packets_received_ = 0;
 };
 
 } // namespace xrtc
@@ -0,0 +1,468 @@
+#include "pc/remote_description.h"
+
+#include <limits>
+#include <unordered_map>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/string_view.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/string_encode.h>
+
+namespace xrtc {
+
+namespace {
+
+// 和offer中的red/ulpfec负载类型一致
+const int kRedPayloadType = 116;
+const int kUlpfecPayloadType = 117;
+
+struct SsrcInfo {
+    uint32_t ssrc_id;
+    std::string cname;
+    std::string stream_id;
+    std::string track_id;
+};
+
+// 一个m段内解析出的信息
+struct MediaSection {
+    TransportDescription* td = nullptr;
+    MediaContentDescription* content = nullptr;
+    // 按出现的顺序保存，ssrc_index用于按ssrc查找
+    std::vector<SsrcInfo> ssrc_infos;
+    std::unordered_map<uint32_t, size_t> ssrc_index;
+    std::vector<SsrcGroup> ssrc_groups;
+};
+
+// 会话级别的transport属性，m段中没有对应的属性时使用，
+// 例如Firefox的answer中fingerprint在会话级别
+struct SessionTransport {
+    absl::string_view fingerprint;
+    absl::string_view ice_ufrag;
+    absl::string_view ice_pwd;
+};
+
+} // namespace
+
+// 取出第一个delim之前的部分，s指向delim之后的剩余部分，没有delim时取出全部
+static absl::string_view NextToken(absl::string_view* s, char delim) {
+    size_t pos = s->find(delim);
+    absl::string_view token = s->substr(0, pos);
+    if (pos == absl::string_view::npos) {
+        *s = absl::string_view();
+    } else {
+        s->remove_prefix(pos + 1);
+    }
+
+    return token;
+}
+
+// 取出下一行，去掉行尾的\r
+static absl::string_view NextLine(absl::string_view* sdp) {
+    absl::string_view line = NextToken(sdp, '\n');
+    if (!line.empty() && '\r' == line.back()) {
+        line.remove_suffix(1);
+    }
+
+    return line;
+}
+
+template <typename T>
+static bool ParseNumber(absl::string_view s, T* value) {
+    if (s.empty() || s.size() > 10) {
+        return false;
+    }
+
+    uint64_t v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        v = v * 10 + (c - '0');
+    }
+
+    if (v > (uint64_t)std::numeric_limits<T>::max()) {
+        return false;
+    }
+
+    *value = (T)v;
+    return true;
+}
+
+// a=fingerprint:<hash-func> <fingerprint>
+static int ParseFingerprint(TransportDescription* td, absl::string_view value) {
+    absl::string_view alg = NextToken(&value, ' ');
+    if (alg.empty() || value.empty() || value.find(' ') != absl::string_view::npos) {
+        RTC_LOG(LS_WARNING) << "parse a=fingerprint error: " << std::string(alg)
+            << " " << std::string(value);
+        return -1;
+    }
+
+    td->identity_fingerprint = rtc::SSLFingerprint::CreateUniqueFromRfc4572(
+            absl::AsciiStrToLower(alg), std::string(value));
+    if (!(td->identity_fingerprint.get())) {
+        RTC_LOG(LS_WARNING) << "create fingerprint error: " << std::string(value);
+        return -1;
+    }
+
+    return 0;
+}
+
+// rfc8285
+// a=extmap:<value>["/"<direction>] <URI> <extensionattributes>
+static int ParseExtmap(MediaContentDescription* content, absl::string_view value) {
+    absl::string_view id_s = NextToken(&value, ' ');
+    id_s = id_s.substr(0, id_s.find('/'));
+    absl::string_view uri = NextToken(&value, ' ');
+
+    int id = 0;
+    if (uri.empty() || !ParseNumber(id_s, &id)) {
+        RTC_LOG(LS_WARNING) << "invalid extmap: " << std::string(id_s)
+            << " " << std::string(uri);
+        return -1;
+    }
+
+    content->AddRtpHeaderExtension(webrtc::RtpExtension(std::string(uri), id));
+    return 0;
+}
+
+// rfc5576
+// a=ssrc:<ssrc-id> <attribute>
+// a=ssrc:<ssrc-id> <attribute>:<value>
+static int ParseSsrc(MediaSection* section, absl::string_view value) {
+    absl::string_view ssrc_s = NextToken(&value, ' ');
+    uint32_t ssrc_id = 0;
+    if (!ParseNumber(ssrc_s, &ssrc_id)) {
+        RTC_LOG(LS_WARNING) << "invalid ssrc_id: " << std::string(ssrc_s);
+        return -1;
+    }
+
+    absl::string_view attribute = NextToken(&value, ':');
+
+    auto iter = section->ssrc_index.find(ssrc_id);
+    if (iter == section->ssrc_index.end()) {
+        SsrcInfo info;
+        info.ssrc_id = ssrc_id;
+        section->ssrc_infos.push_back(info);
+        iter = section->ssrc_index.emplace(ssrc_id,
+                section->ssrc_infos.size() - 1).first;
+    }
+
+    SsrcInfo& info = section->ssrc_infos[iter->second];
+    if ("cname" == attribute) {
+        info.cname = std::string(value);
+    } else if ("msid" == attribute) {
+        absl::string_view stream_id = NextToken(&value, ' ');
+        if (value.find(' ') != absl::string_view::npos) {
+            RTC_LOG(LS_WARNING) << "msid format error, ssrc: " << ssrc_id;
+            return -1;
+        }
+
+        info.stream_id = std::string(stream_id);
+        info.track_id = std::string(value);
+    }
+
+    return 0;
+}
+
+// rfc5576
+// a=ssrc-group:<semantics> <ssrc-id> ...
+static int ParseSsrcGroup(MediaSection* section, absl::string_view value) {
+    absl::string_view semantics = NextToken(&value, ' ');
+    if (semantics.empty() || value.empty()) {
+        RTC_LOG(LS_WARNING) << "ssrc-group field size < 2: " << std::string(semantics);
+        return -1;
+    }
+
+    std::vector<uint32_t> ssrcs;
+    while (!value.empty()) {
+        uint32_t ssrc_id = 0;
+        if (!ParseNumber(NextToken(&value, ' '), &ssrc_id)) {
+            return -1;
+        }
+        ssrcs.push_back(ssrc_id);
+    }
+
+    section->ssrc_groups.push_back(SsrcGroup(std::string(semantics), ssrcs));
+    return 0;
+}
+
+// rfc4588
+// a=fmtp:<rtx payload type> apt=<associated payload type>
+static int ParseRtxApt(std::map<int, int>* rtx_apts, absl::string_view value) {
+    absl::string_view pt_s = NextToken(&value, ' ');
+    absl::string_view params = NextToken(&value, ' ');
+    while (!params.empty()) {
+        absl::string_view param = NextToken(&params, ';');
+        if (param.substr(0, 4) != "apt=") {
+            continue;
+        }
+
+        int rtx_payload_type = 0;
+        int apt = 0;
+        if (!ParseNumber(pt_s, &rtx_payload_type) ||
+            !ParseNumber(param.substr(4), &apt))
+        {
+            RTC_LOG(LS_WARNING) << "invalid rtx apt: " << std::string(param);
+            return -1;
+        }
+
+        (*rtx_apts)[rtx_payload_type] = apt;
+    }
+
+    return 0;
+}
+
+// m段内的属性行，按属性名分发，每行只比较一次
+static int ParseAttribute(MediaSection* section, std::map<int, int>* rtx_apts,
+        absl::string_view attr)
+{
+    absl::string_view name = NextToken(&attr, ':');
+    if (name.empty()) {
+        return 0;
+    }
+
+    bool is_video = MediaType::MEDIA_TYPE_VIDEO == section->content->type();
+
+    switch (name[0]) {
+        case 'e':
+            if ("extmap" == name) {
+                return ParseExtmap(section->content, attr);
+            }
+            break;
+        case 'f':
+            if ("fingerprint" == name) {
+                return ParseFingerprint(section->td, attr);
+            } else if ("fmtp" == name && is_video) {
+                return ParseRtxApt(rtx_apts, attr);
+            }
+            break;
+        case 'i':
+            if ("ice-ufrag" == name || "ice-pwd" == name) {
+                if (attr.empty()) {
+                    RTC_LOG(LS_WARNING) << "get attribute error: " << std::string(name);
+                    return -1;
+                }
+
+                if ("ice-ufrag" == name) {
+                    section->td->ice_ufrag = std::string(attr);
+                } else {
+                    section->td->ice_pwd = std::string(attr);
+                }
+            }
+            break;
+        case 's':
+            if ("ssrc" == name) {
+                return ParseSsrc(section, attr);
+            } else if ("ssrc-group" == name && is_video) {
+                return ParseSsrcGroup(section, attr);
+            }
+            break;
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+// 会话级别的属性行，只关心transport相关的属性
+static void ParseSessionAttribute(SessionTransport* session, absl::string_view attr) {
+    absl::string_view name = NextToken(&attr, ':');
+    if ("fingerprint" == name) {
+        session->fingerprint = attr;
+    } else if ("ice-ufrag" == name) {
+        session->ice_ufrag = attr;
+    } else if ("ice-pwd" == name) {
+        session->ice_pwd = attr;
+    }
+}
+
+static int ApplySessionTransport(const SessionTransport& session,
+        TransportDescription* td)
+{
+    if (td->ice_ufrag.empty()) {
+        td->ice_ufrag = std::string(session.ice_ufrag);
+    }
+
+    if (td->ice_pwd.empty()) {
+        td->ice_pwd = std::string(session.ice_pwd);
+    }
+
+    if (!td->identity_fingerprint && !session.fingerprint.empty()) {
+        return ParseFingerprint(td, session.fingerprint);
+    }
+
+    return 0;
+}
+
+static void CreateTrackFromSsrcInfo(const std::vector<SsrcInfo> &ssrc_infos,
+                                    std::vector<StreamParams> &tracks) {
+    for (auto ssrc_info: ssrc_infos) {
+        std::string track_id = ssrc_info.track_id;
+
+        auto iter = tracks.begin();
+        for (; iter != tracks.end(); ++iter) {
+            if (iter->id == track_id) {
+                break;
+            }
+        }
+
+        if (iter == tracks.end()) {
+            StreamParams track;
+            track.id = track_id;
+            tracks.push_back(track);
+            iter = tracks.end() - 1;
+        }
+
+        iter->cname = ssrc_info.cname;
+        iter->stream_id = ssrc_info.stream_id;
+        iter->ssrcs.push_back(ssrc_info.ssrc_id);
+    }
+}
+
+// 一次遍历sdp，按行首的类型字符和属性名分发，行和字段都是原文的引用，
+// 只有最终保存的值才会拷贝
+std::shared_ptr<RemoteDescription> ParseRemoteDescription(const std::string& sdp) {
+    if (sdp.empty()) {
+        RTC_LOG(LS_WARNING) << "sdp invalid";
+        return nullptr;
+    }
+
+    auto remote = std::make_shared<RemoteDescription>();
+    remote->desc = std::make_shared<SessionDescription>(SdpType::kAnswer);
+
+    auto audio_content = std::make_shared<AudioContentDescription>();
+    auto video_content = std::make_shared<VideoContentDescription>();
+    // 以answer中协商的扩展头为准
+    audio_content->ClearRtpHeaderExtensions();
+    video_content->ClearRtpHeaderExtensions();
+    auto audio_td = std::make_shared<TransportDescription>();
+    auto video_td = std::make_shared<TransportDescription>();
+    MediaSection audio_section;
+    audio_section.td = audio_td.get();
+    audio_section.content = audio_content.get();
+    MediaSection video_section;
+    video_section.td = video_td.get();
+    video_section.content = video_content.get();
+    // rtx payload type -> 原始包的payload type
+    std::map<int, int> video_rtx_apts;
+
+    SessionTransport session_transport;
+
+    // 当前所在的m段，会话级别和不支持的媒体类型为nullptr
+    MediaSection* section = nullptr;
+    bool in_session = true;
+
+    absl::string_view rest(sdp);
+    while (!rest.empty()) {
+        absl::string_view line = NextLine(&rest);
+        if (line.size() < 2 || line[1] != '=') {
+            continue;
+        }
+
+        char type = line[0];
+        line.remove_prefix(2);
+
+        if ('m' == type) {
+            in_session = false;
+
+            // m=<media> <port> <proto> <fmt> ...
+            absl::string_view media_type = NextToken(&line, ' ');
+            absl::string_view port = NextToken(&line, ' ');
+            absl::string_view proto = NextToken(&line, ' ');
+            if (media_type.empty() || port.empty() || proto.empty()) {
+                RTC_LOG(LS_WARNING) << "parse m= error: " << std::string(media_type);
+                return nullptr;
+            }
+
+            if ("audio" == media_type) {
+                remote->desc->AddContent(audio_content);
+                audio_td->mid = "audio";
+                section = &audio_section;
+            } else if ("video" == media_type) {
+                remote->desc->AddContent(video_content);
+                video_td->mid = "video";
+                section = &video_section;
+
+                // answer中保留了red和ulpfec时才能给对端发送FEC
+                bool has_red = false;
+                bool has_ulpfec = false;
+                while (!line.empty()) {
+                    int payload_type = 0;
+                    if (ParseNumber(NextToken(&line, ' '), &payload_type)) {
+                        has_red = has_red || kRedPayloadType == payload_type;
+                        has_ulpfec = has_ulpfec || kUlpfecPayloadType == payload_type;
+                    }
+                }
+                remote->ulpfec = has_red && has_ulpfec;
+            } else {
+                section = nullptr;
+            }
+        } else if ('a' == type && section && !line.empty()) {
+            if (ParseAttribute(section, &video_rtx_apts, line) != 0) {
+                return nullptr;
+            }
+        } else if ('a' == type && in_session) {
+            ParseSessionAttribute(&session_transport, line);
+        }
+    }
+
+    if (ApplySessionTransport(session_transport, audio_td.get()) != 0 ||
+        ApplySessionTransport(session_transport, video_td.get()) != 0)
+    {
+        return nullptr;
+    }
+
+    if (!audio_section.ssrc_infos.empty()) {
+        std::vector<StreamParams> audio_tracks;
+        CreateTrackFromSsrcInfo(audio_section.ssrc_infos, audio_tracks);
+
+        for (auto track: audio_tracks) {
+            audio_content->add_stream(track);
+        }
+    }
+
+    if (!video_section.ssrc_infos.empty()) {
+        std::vector<StreamParams> video_tracks;
+        CreateTrackFromSsrcInfo(video_section.ssrc_infos, video_tracks);
+
+        for (auto ssrc_group: video_section.ssrc_groups) {
+            if (ssrc_group.ssrcs.empty()) {
+                continue;
+            }
+
+            uint32_t ssrc = ssrc_group.ssrcs.front();
+            for (StreamParams &track: video_tracks) {
+                if (track.HasSsrc(ssrc)) {
+                    track.ssrc_groups.push_back(ssrc_group);
+                }
+            }
+        }
+
+        for (auto track: video_tracks) {
+            video_content->add_stream(track);
+        }
+    }
+
+    // answer中没有携带apt时，沿用offer中的rtx映射
+    if (video_rtx_apts.empty()) {
+        for (auto &codec: video_content->codecs()) {
+            auto apt_iter = codec->codec_param.find("apt");
+            int apt = 0;
+            if (apt_iter != codec->codec_param.end() &&
+                rtc::FromString(apt_iter->second, &apt))
+            {
+                video_rtx_apts[codec->id] = apt;
+            }
+        }
+    }
+
+    remote->desc->AddTransportInfo(audio_td);
+    remote->desc->AddTransportInfo(video_td);
+    remote->audio_content = audio_content;
+    remote->video_content = video_content;
+    remote->video_rtx_apts = std::move(video_rtx_apts);
+
+    return remote;
+}
+
+} // namespace xrtc
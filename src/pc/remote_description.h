@@ -0,0 +1,31 @@
+#ifndef  __XRTCSERVER_PC_REMOTE_DESCRIPTION_H_
+#define  __XRTCSERVER_PC_REMOTE_DESCRIPTION_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "pc/session_description.h"
+
+namespace xrtc {
+
+// 解析之后的answer。
+// 在signaling worker线程中解析，随RtcMsg交给rtc worker，媒体线程只负责应用，
+// 不再在事件循环中解析sdp文本。构造完成之后不再修改
+struct RemoteDescription {
+    std::shared_ptr<SessionDescription> desc;
+    // answer中没有对应的m行时也不为空，和offer中的默认编码一致
+    std::shared_ptr<AudioContentDescription> audio_content;
+    std::shared_ptr<VideoContentDescription> video_content;
+    // answer中保留了red和ulpfec时才能给对端发送FEC
+    bool ulpfec = false;
+    // rtx payload type -> 原始包的payload type
+    std::map<int, int> video_rtx_apts;
+};
+
+// 解析失败返回nullptr
+std::shared_ptr<RemoteDescription> ParseRemoteDescription(const std::string& sdp);
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_PC_REMOTE_DESCRIPTION_H_
@@ -0,0 +1,75 @@
+#ifndef  __XRTCSERVER_PC_SDP_WRITER_H_
+#define  __XRTCSERVER_PC_SDP_WRITER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <type_traits>
+
+#include <absl/strings/string_view.h>
+
+namespace xrtc {
+
+// 生成sdp文本，直接追加到预先分配的缓冲区中，代替std::stringstream，
+// 没有locale和格式状态的开销，整数直接转换成十进制
+class SdpWriter {
+public:
+    // 一个完整的offer一般在4K以内
+    static const size_t kDefaultCapacity = 4096;
+
+    explicit SdpWriter(size_t capacity = kDefaultCapacity) {
+        buf_.reserve(capacity);
+    }
+
+    SdpWriter& operator<<(absl::string_view s) {
+        buf_.append(s.data(), s.size());
+        return *this;
+    }
+
+    SdpWriter& operator<<(const char* s) {
+        return *this << absl::string_view(s);
+    }
+
+    SdpWriter& operator<<(const std::string& s) {
+        buf_.append(s);
+        return *this;
+    }
+
+    SdpWriter& operator<<(char c) {
+        buf_.push_back(c);
+        return *this;
+    }
+
+    template <typename T,
+              typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    SdpWriter& operator<<(T value) {
+        char tmp[24];
+        char* end = tmp + sizeof(tmp);
+        char* p = end;
+        bool negative = value < 0;
+        // 负数按无符号取绝对值，避免最小值溢出
+        uint64_t v = negative ? 0 - (uint64_t)value : (uint64_t)value;
+        do {
+            *--p = '0' + v % 10;
+            v /= 10;
+        } while (v);
+
+        if (negative) {
+            *--p = '-';
+        }
+
+        buf_.append(p, end - p);
+        return *this;
+    }
+
+    size_t size() const { return buf_.size(); }
+    std::string& str() { return buf_; }
+    std::string Release() { return std::move(buf_); }
+
+private:
+    std::string buf_;
+};
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_PC_SDP_WRITER_H_
@@ -1,7 +1,5 @@
 #include "pc/session_description.h"
 
-#include <sstream>
-
 #include <rtc_base/logging.h>
 
 namespace xrtc {
@@ -9,6 +7,11 @@ namespace xrtc {
 const char kMediaProtocolDtlsSavpf[] = "UDP/TLS/RTP/SAVPF";
 const char kMediaProtocolSavpf[] = "RTP/SAVPF";
 
+// 服务器总是offer方，推拉流两端协商出的扩展头id是一致的
+const int kAudioLevelExtensionId = 1;
+const int kAbsSendTimeExtensionId = 2;
+const int kTransportSequenceNumberExtensionId = 3;
+
 AudioContentDescription::AudioContentDescription() {
     auto codec = std::make_shared<AudioCodecInfo>();
     codec->id = 111;
@@ -24,6 +27,13 @@ AudioContentDescription::AudioContentDescription() {
     codec->codec_param["useinbandfec"] = "1";
 
     codecs_.push_back(codec);
+
+    // RFC6464
+    rtp_header_extensions_.push_back(webrtc::RtpExtension(
+            webrtc::RtpExtension::kAudioLevelUri, kAudioLevelExtensionId));
+    rtp_header_extensions_.push_back(webrtc::RtpExtension(
+            webrtc::RtpExtension::kTransportSequenceNumberUri,
+            kTransportSequenceNumberExtensionId));
 }
 
 VideoContentDescription::VideoContentDescription() {
@@ -53,6 +63,28 @@ VideoContentDescription::VideoContentDescription() {
     // add codec param
     rtx_codec->codec_param["apt"] = std::to_string(codec->id);
     codecs_.push_back(rtx_codec);
+
+    // 推流端的接收端带宽估计(REMB)依赖abs-send-time
+    rtp_header_extensions_.push_back(webrtc::RtpExtension(
+            webrtc::RtpExtension::kAbsSendTimeUri, kAbsSendTimeExtensionId));
+    // bundle时音视频共用同一个transport-wide序列号空间，id必须一致
+    rtp_header_extensions_.push_back(webrtc::RtpExtension(
+            webrtc::RtpExtension::kTransportSequenceNumberUri,
+            kTransportSequenceNumberExtensionId));
+}
+
+void VideoContentDescription::AddFecCodecs() {
+    auto red_codec = std::make_shared<VideoCodecInfo>();
+    red_codec->id = 116;
+    red_codec->name = "red";
+    red_codec->clockrate = 90000;
+    codecs_.push_back(red_codec);
+
+    auto ulpfec_codec = std::make_shared<VideoCodecInfo>();
+    ulpfec_codec->id = 117;
+    ulpfec_codec->name = "ulpfec";
+    ulpfec_codec->clockrate = 90000;
+    codecs_.push_back(ulpfec_codec);
 }
 
 bool ContentGroup::HasContentName(const std::string& content_name) {
@@ -113,7 +145,7 @@ std::vector<const ContentGroup*> SessionDescription::GetGroupByName(
     return content_groups;
 }
 
-static std::string ConnectionRoleToString(ConnectionRole role) {
+static const char* ConnectionRoleToString(ConnectionRole role) {
     switch (role) {
         case ConnectionRole::ACTIVE:
             return "active";
@@ -201,9 +233,9 @@ std::string SessionDescription::GetFirstBundleMid() {
 }
 
 static void AddRtcpFbLine(std::shared_ptr<CodecInfo> codec,
-        std::stringstream& ss)
+        SdpWriter& ss)
 {
-    for (auto param : codec->feedback_param) {
+    for (const auto& param : codec->feedback_param) {
         ss << "a=rtcp-fb:" << codec->id << " " << param.id();
         if (!param.param().empty()) {
             ss << " " << param.param();
@@ -213,24 +245,24 @@ static void AddRtcpFbLine(std::shared_ptr<CodecInfo> codec,
 }
 
 static void AddFmtpLine(std::shared_ptr<CodecInfo> codec,
-        std::stringstream& ss)
+        SdpWriter& ss)
 {
     if (!codec->codec_param.empty()) {
+        // a=fmtp:<pt> key1=value1;key2=value2
         ss << "a=fmtp:" << codec->id << " ";
-        std::string data;
-        for (auto param : codec->codec_param) {
-            data += (";" + param.first + "=" + param.second);
+        const char* sep = "";
+        for (const auto& param : codec->codec_param) {
+            ss << sep << param.first << "=" << param.second;
+            sep = ";";
         }
-        // data = ";key1=value1;key2=value2"
-        data = data.substr(1);
-        ss << data << "\r\n";
+        ss << "\r\n";
     }
 }
 
 static void BuildRtpMap(std::shared_ptr<MediaContentDescription> content,
-        std::stringstream& ss)
+        SdpWriter& ss)
 {
-    for (auto codec : content->codecs()) {
+    for (const auto& codec : content->codecs()) {
         ss << "a=rtpmap:" << codec->id << " " << codec->name << "/" << codec->clockrate;
         if (MediaType::MEDIA_TYPE_AUDIO == content->type()) {
             auto audio_codec = codec->as_audio();
@@ -243,8 +275,16 @@ static void BuildRtpMap(std::shared_ptr<MediaContentDescription> content,
     }
 }
 
+static void BuildRtpHeaderExtensions(std::shared_ptr<MediaContentDescription> content,
+        SdpWriter& ss)
+{
+    for (const auto& ext : content->rtp_header_extensions()) {
+        ss << "a=extmap:" << ext.id << " " << ext.uri << "\r\n";
+    }
+}
+
 static void BuildRtpDirection(std::shared_ptr<MediaContentDescription> content,
-        std::stringstream& ss)
+        SdpWriter& ss)
 {
     switch (content->direction()) {
         case RtpDirection::kSendRecv:
@@ -263,11 +303,11 @@ static void BuildRtpDirection(std::shared_ptr<MediaContentDescription> content,
 }
 
 static void BuildCandidates(std::shared_ptr<MediaContentDescription> content,
-        std::stringstream& ss)
+        SdpWriter& ss)
 {
-    for (auto c : content->candidates()) {
+    for (const auto& c : content->candidates()) {
         ss << "a=candidate:" << c.foundation
-           << " " << c.component
+           << " " << (int)c.component
            << " " << c.protocol
            << " " << c.priority
            << " " << c.address.HostAsURIString()
@@ -278,18 +318,18 @@ static void BuildCandidates(std::shared_ptr<MediaContentDescription> content,
 }
 
 static void AddSsrcLine(uint32_t ssrc,
-        const std::string& attribute,
-        const std::string& value,
-        std::stringstream& ss)
+        absl::string_view attribute,
+        absl::string_view value,
+        SdpWriter& ss)
 {
     ss << "a=ssrc:" << ssrc << " " << attribute << ":" << value << "\r\n";
 }
 
 static void BuildSsrc(std::shared_ptr<MediaContentDescription> content,
-        std::stringstream& ss)
+        SdpWriter& ss)
 {
-    for (auto track : content->streams()) {
-        for (auto ssrc_group : track.ssrc_groups) {
+    for (const auto& track : content->streams()) {
+        for (const auto& ssrc_group : track.ssrc_groups) {
             if (ssrc_group.ssrcs.empty()) {
                 continue;
             }
@@ -301,18 +341,17 @@ static void BuildSsrc(std::shared_ptr<MediaContentDescription> content,
             ss << "\r\n";
         }
     
-        std::string msid = track.stream_id + " " + track.id;
         for (auto ssrc : track.ssrcs) {
             AddSsrcLine(ssrc, "cname", track.cname, ss);
-            AddSsrcLine(ssrc, "msid", msid, ss);
+            ss << "a=ssrc:" << ssrc << " msid:" << track.stream_id << " " << track.id
+                << "\r\n";
             AddSsrcLine(ssrc, "mslabel", track.stream_id, ss);
             AddSsrcLine(ssrc, "lable", track.id, ss);
         }
     }
 }
 
-std::string SessionDescription::ToString() {
-    std::stringstream ss;
+void SessionDescription::BuildSessionPart(SdpWriter& ss) {
     // version
     ss << "v=0\r\n";
 	// session origin
@@ -337,55 +376,81 @@ std::string SessionDescription::ToString() {
     }
     
     ss << "a=msid-semantic: WMS\r\n";
+}
 
-    for (auto content : contents_) {
-        // RFC 4566
-        // m=<media> <port> <proto> <fmt>
-        std::string fmt;
-        for (auto codec : content->codecs()) {
-            fmt.append(" ");
-            fmt.append(std::to_string(codec->id));
-        }
+void SessionDescription::BuildMediaHead(std::shared_ptr<MediaContentDescription> content,
+        SdpWriter& ss)
+{
+    // RFC 4566
+    // m=<media> <port> <proto> <fmt>
+    auto transport_info = GetTransportInfo(content->mid());
+    if (transport_info && transport_info->identity_fingerprint.get()) {
+        ss << "m=" << content->mid() << " 9 " << kMediaProtocolDtlsSavpf;
+    } else {
+        ss << "m=" << content->mid() << " 9 " << kMediaProtocolSavpf;
+    }
 
-        auto transport_info = GetTransportInfo(content->mid());
-        if (transport_info && transport_info->identity_fingerprint.get()) {
-            ss << "m=" << content->mid() << " 9 " << kMediaProtocolDtlsSavpf
-                << fmt << "\r\n";
-        } else {
-            ss << "m=" << content->mid() << " 9 " << kMediaProtocolSavpf
-                << fmt << "\r\n";
-        }
+    for (const auto& codec : content->codecs()) {
+        ss << " " << codec->id;
+    }
+    ss << "\r\n";
 
-        ss << "c=IN IP4 0.0.0.0\r\n";
-        ss << "a=rtcp:9 IN IP4 0.0.0.0\r\n";
-        
-        BuildCandidates(content, ss);
-
-        if (transport_info) {
-            ss << "a=ice-ufrag:" << transport_info->ice_ufrag << "\r\n";
-            ss << "a=ice-pwd:" << transport_info->ice_pwd << "\r\n";
-
-            auto fp = transport_info->identity_fingerprint.get();
-            if (fp) {
-                ss << "a=fingerprint:" << fp->algorithm << " " << fp->GetRfc4572Fingerprint()
-                    << "\r\n";
-                ss << "a=setup:" << ConnectionRoleToString(
-                        transport_info->connection_role) << "\r\n";
-            }
+    ss << "c=IN IP4 0.0.0.0\r\n";
+    ss << "a=rtcp:9 IN IP4 0.0.0.0\r\n";
+}
+
+void SessionDescription::BuildMediaTransport(
+        std::shared_ptr<MediaContentDescription> content, SdpWriter& ss)
+{
+    BuildCandidates(content, ss);
+
+    auto transport_info = GetTransportInfo(content->mid());
+    if (transport_info) {
+        ss << "a=ice-ufrag:" << transport_info->ice_ufrag << "\r\n";
+        ss << "a=ice-pwd:" << transport_info->ice_pwd << "\r\n";
+
+        auto fp = transport_info->identity_fingerprint.get();
+        if (fp) {
+            ss << "a=fingerprint:" << fp->algorithm << " " << fp->GetRfc4572Fingerprint()
+                << "\r\n";
+            ss << "a=setup:" << ConnectionRoleToString(
+                    transport_info->connection_role) << "\r\n";
         }
+    }
+}
 
-        ss << "a=mid:" << content->mid() << "\r\n";
-        BuildRtpDirection(content, ss);
+void SessionDescription::BuildMediaBody(std::shared_ptr<MediaContentDescription> content,
+        SdpWriter& ss)
+{
+    ss << "a=mid:" << content->mid() << "\r\n";
+    BuildRtpHeaderExtensions(content, ss);
+    BuildRtpDirection(content, ss);
 
-        if (content->rtcp_mux()) {
-            ss << "a=rtcp-mux\r\n";
-        }
+    if (content->rtcp_mux()) {
+        ss << "a=rtcp-mux\r\n";
+    }
+
+    BuildRtpMap(content, ss);
+}
 
-        BuildRtpMap(content, ss);
-        BuildSsrc(content, ss);
+void SessionDescription::BuildMediaSsrc(std::shared_ptr<MediaContentDescription> content,
+        SdpWriter& ss)
+{
+    BuildSsrc(content, ss);
+}
+
+std::string SessionDescription::ToString() {
+    SdpWriter ss;
+    BuildSessionPart(ss);
+
+    for (auto content : contents_) {
+        BuildMediaHead(content, ss);
+        BuildMediaTransport(content, ss);
+        BuildMediaBody(content, ss);
+        BuildMediaSsrc(content, ss);
     }
 
-    return ss.str();
+    return ss.Release();
 }
 
 } // namespace xrtc
@@ -6,10 +6,12 @@
 #include <memory>
 
 #include <rtc_base/ssl_fingerprint.h>
+#include <api/rtp_parameters.h>
 
 #include "ice/ice_credentials.h"
 #include "ice/candidate.h"
 #include "pc/codec_info.h"
+#include "pc/sdp_writer.h"
 #include "pc/stream_params.h"
 
 namespace xrtc {
@@ -57,9 +59,18 @@ public:
         send_streams_.push_back(stream);
     }
 
+    const std::vector<webrtc::RtpExtension>& rtp_header_extensions() const {
+        return rtp_header_extensions_;
+    }
+    void AddRtpHeaderExtension(const webrtc::RtpExtension& ext) {
+        rtp_header_extensions_.push_back(ext);
+    }
+    void ClearRtpHeaderExtensions() { rtp_header_extensions_.clear(); }
+
 protected:
     std::vector<std::shared_ptr<CodecInfo>> codecs_;
-    RtpDirection direction_;
+    std::vector<webrtc::RtpExtension> rtp_header_extensions_;
+    RtpDirection direction_ = RtpDirection::kSendRecv;
     bool rtcp_mux_ = true;
     std::vector<Candidate> candidates_;
     std::vector<StreamParams> send_streams_;
@@ -77,6 +88,9 @@ public:
     VideoContentDescription();
     MediaType type() override { return MediaType::MEDIA_TYPE_VIDEO; }
     std::string mid() override { return "video"; }
+
+    // 服务器生成FEC时使用RED封装的ULPFEC
+    void AddFecCodecs();
 };
 
 class ContentGroup {
@@ -135,6 +149,16 @@ public:
 
     std::string ToString();
 
+    // 分段生成sdp，ToString按顺序输出所有的段。
+    // 会话部分、m行和媒体属性部分只和sdp的结构有关，可以被offer模板缓存，
+    // transport(candidate、ice、fingerprint)和ssrc部分每个会话都不同
+    void BuildSessionPart(SdpWriter& ss);
+    void BuildMediaHead(std::shared_ptr<MediaContentDescription> content, SdpWriter& ss);
+    void BuildMediaTransport(std::shared_ptr<MediaContentDescription> content,
+            SdpWriter& ss);
+    void BuildMediaBody(std::shared_ptr<MediaContentDescription> content, SdpWriter& ss);
+    void BuildMediaSsrc(std::shared_ptr<MediaContentDescription> content, SdpWriter& ss);
+
 private:
     SdpType sdp_type_;
     std::vector<std::shared_ptr<MediaContentDescription>> contents_;
@@ -2,6 +2,9 @@
 
 namespace xrtc {
 
+const char kFidSsrcGroupSemantics[] = "FID";
+const char kSimSsrcGroupSemantics[] = "SIM";
+
 SsrcGroup::SsrcGroup(const std::string& semantics, const std::vector<uint32_t>& ssrcs) :
     semantics(semantics), ssrcs(ssrcs) {}
 
@@ -14,6 +17,41 @@ bool StreamParams::HasSsrc(uint32_t ssrc) {
     return false;
 }
 
+const SsrcGroup* StreamParams::GetSsrcGroup(const std::string& semantics) const {
+    for (const SsrcGroup& ssrc_group : ssrc_groups) {
+        if (ssrc_group.semantics == semantics) {
+            return &ssrc_group;
+        }
+    }
+    return nullptr;
+}
+
+void StreamParams::GetPrimarySsrcs(std::vector<uint32_t>* primary_ssrcs) const {
+    const SsrcGroup* sim_group = GetSsrcGroup(kSimSsrcGroupSemantics);
+    if (sim_group) {
+        primary_ssrcs->insert(primary_ssrcs->end(), sim_group->ssrcs.begin(),
+                sim_group->ssrcs.end());
+        return;
+    }
+
+    uint32_t ssrc = FirstSsrc();
+    if (ssrc != 0) {
+        primary_ssrcs->push_back(ssrc);
+    }
+}
+
+bool StreamParams::GetFidSsrc(uint32_t primary_ssrc, uint32_t* fid_ssrc) const {
+    for (const SsrcGroup& ssrc_group : ssrc_groups) {
+        if (ssrc_group.semantics == kFidSsrcGroupSemantics &&
+                ssrc_group.ssrcs.size() >= 2 && ssrc_group.ssrcs[0] == primary_ssrc)
+        {
+            *fid_ssrc = ssrc_group.ssrcs[1];
+            return true;
+        }
+    }
+    return false;
+}
+
 } // namespace xrtc
 
 
@@ -6,6 +6,9 @@
 
 namespace xrtc {
 
+extern const char kFidSsrcGroupSemantics[];
+extern const char kSimSsrcGroupSemantics[];
+
 struct SsrcGroup {
     SsrcGroup(const std::string& semantics, const std::vector<uint32_t>& ssrcs);
 
@@ -15,6 +18,11 @@ struct SsrcGroup {
 
 struct StreamParams {
     bool HasSsrc(uint32_t ssrc);
+    const SsrcGroup* GetSsrcGroup(const std::string& semantics) const;
+    // 所有的主ssrc，simulcast时按照SIM group的顺序，从低分辨率到高分辨率
+    void GetPrimarySsrcs(std::vector<uint32_t>* ssrcs) const;
+    // 主ssrc对应的rtx ssrc
+    bool GetFidSsrc(uint32_t primary_ssrc, uint32_t* fid_ssrc) const;
     
     uint32_t FirstSsrc() const {
         if (ssrcs.empty()) {
@@ -322,6 +322,11 @@ int TransportController::SendRtcp(const std::string& transport_name,
     return -1;
 }
 
+int TransportController::GetIceRtt(const std::string& transport_name) {
+    auto ice_channel = ice_agent_->GetChannel(transport_name, IceCandidateComponent::RTP);
+    return ice_channel ? ice_channel->rtt() : -1;
+}
+
 } // namespace xrtc
 
 
@@ -23,6 +23,8 @@ public:
     void SetLocalCertificate(rtc::RTCCertificate* cert);
     int SendRtp(const std::string& transport_name, const char* data, size_t len);
     int SendRtcp(const std::string& transport_name, const char* data, size_t len);
+    // ice层测量的rtt，在rtcp测量出rtt之前使用，没有选中连接时返回-1
+    int GetIceRtt(const std::string& transport_name);
 
     void set_dtls(bool is_dtls) { is_dtls_ = is_dtls; }
 
@@ -3,15 +3,21 @@
 #include <unistd.h>
 
 #include <rtc_base/logging.h>
-#include <rtc_base/crc32.h>
 #include <rtc_base/rtc_certificate_generator.h>
 #include <yaml-cpp/yaml.h>
 
+#include "base/conf.h"
 #include "server/rtc_worker.h"
 
+extern xrtc::GeneralConf* g_conf;
+
 namespace xrtc {
 
 const uint64_t kYearInMs = 365 * 24 * 3600 * 1000L;
+// 证书在过期前这么久更新
+const uint64_t kCertificateRefreshMarginMs = 7 * 24 * 3600 * 1000L;
+// 检查证书的周期，单位毫秒
+const unsigned int kCertificateCheckIntervalMs = 3600 * 1000;
 
 void RtcServerRecvNotify(EventLoop* /*el*/, IOWatcher* /*w*/, 
         int fd, int /*events*/, void* data)
@@ -27,6 +33,11 @@ void RtcServerRecvNotify(EventLoop* /*el*/, IOWatcher* /*w*/,
     server->ProcessNotify(msg);
 }
 
+void RtcServerCertificateCb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+    RtcServer* server = (RtcServer*)data;
+    server->GenerateAndCheckCertificate();
+}
+
 RtcServer::RtcServer() :
     el_(new EventLoop(this))
 {
@@ -53,18 +64,23 @@ RtcServer::~RtcServer() {
 }
 
 int RtcServer::GenerateAndCheckCertificate() {
-    if (!certificate_ || certificate_->HasExpired(time(NULL) * 1000)) {
+    uint64_t now_ms = time(NULL) * 1000;
+    if (!certificate_ || certificate_->Expires() <= now_ms + kCertificateRefreshMarginMs) {
         rtc::KeyParams key_params;
         RTC_LOG(LS_INFO) << "dtls enabled, key type: " << key_params.type();
-        certificate_ = rtc::RTCCertificateGenerator::GenerateCertificate(key_params,
-                kYearInMs);
-        if (certificate_) {
-            rtc::RTCCertificatePEM pem = certificate_->ToPEM();
+        rtc::scoped_refptr<rtc::RTCCertificate> certificate =
+            rtc::RTCCertificateGenerator::GenerateCertificate(key_params, kYearInMs);
+        if (certificate) {
+            rtc::RTCCertificatePEM pem = certificate->ToPEM();
             RTC_LOG(LS_INFO) << "rtc certificate: \n" << pem.certificate();
+            prev_certificate_ = certificate_;
+            certificate_ = certificate;
+            certificate_snapshot_.store(certificate_.get(), std::memory_order_release);
         }
     }
     
-    if (!certificate_) {
+    // 生成失败时继续使用还没有过期的证书
+    if (!certificate_ || certificate_->HasExpired(now_ms)) {
         RTC_LOG(LS_WARNING) << "get certificate error";
         return -1;
     }
@@ -72,7 +88,7 @@ int RtcServer::GenerateAndCheckCertificate() {
     return 0;
 }
 
-int RtcServer::Init(const char* conf_file) { 
+int RtcServer::Init(const char* conf_file, int signaling_worker_num) { 
     if (!conf_file) {
         RTC_LOG(LS_WARNING) << "conf_file is null";
         return -1;
@@ -82,6 +98,7 @@ int RtcServer::Init(const char* conf_file) {
         YAML::Node config = YAML::LoadFile(conf_file);
         RTC_LOG(LS_INFO) << "rtc server options:\n" << config;
         options_.worker_num = config["worker_num"].as<int>();
+        options_.signaling_worker_num = signaling_worker_num;
 
     } catch (const YAML::Exception& e) {
         RTC_LOG(LS_WARNING) << "rtc server load conf file error: " << e.msg;
@@ -105,6 +122,20 @@ int RtcServer::Init(const char* conf_file) {
 
     pipe_watcher_ = el_->CreateIOEvent(RtcServerRecvNotify, this);
     el_->StartIOEvent(pipe_watcher_, notify_recv_fd_, EventLoop::READ);
+
+    if (g_conf->fanout_enabled) {
+        if (options_.worker_num <= StreamFanout::kMaxWorkers) {
+            fanout_.reset(new StreamFanout(options_.worker_num));
+        } else {
+            RTC_LOG(LS_WARNING) << "fanout supports at most " << StreamFanout::kMaxWorkers
+                << " workers, disabled, worker_num: " << options_.worker_num;
+        }
+    }
+
+    placement_.reset(new StreamPlacement(options_.worker_num, fanout_ != nullptr));
+
+    certificate_watcher_ = el_->CreateTimer(RtcServerCertificateCb, this, true);
+    el_->StartTimer(certificate_watcher_, kCertificateCheckIntervalMs * 1000u);
     
     for (int i = 0; i < options_.worker_num; ++i) {
         if (CreateWorker(i) != 0) {
@@ -112,12 +143,23 @@ int RtcServer::Init(const char* conf_file) {
         }
     }
 
+    if (fanout_) {
+        for (RtcWorker* worker : workers_) {
+            fanout_->SetWakeup(worker->worker_id(), [worker]() {
+                worker->Notify(RtcWorker::FANOUT_MSG);
+            });
+        }
+    }
+
+    workers_ready_.store(true, std::memory_order_release);
+
     return 0;
 }
 
 int RtcServer::CreateWorker(int worker_id) {
     RTC_LOG(LS_INFO) << "rtc server create worker, worker_id: " << worker_id;
-    RtcWorker* worker = new RtcWorker(worker_id, options_);
+    RtcWorker* worker = new RtcWorker(worker_id, options_, placement_.get(),
+            fanout_.get());
     
     if (worker->Init() != 0) {
         return -1;
@@ -162,25 +204,12 @@ void RtcServer::Join() {
     }
 }
 
-void RtcServer::PushMsg(std::shared_ptr<RtcMsg> msg) {
-    std::unique_lock<std::mutex> lock(q_msg_mtx_);
-    q_msg_.push(msg);
-}
-
-std::shared_ptr<RtcMsg> RtcServer::PopMsg() {
-    std::unique_lock<std::mutex> lock(q_msg_mtx_);
-    
-    if (q_msg_.empty()) {
-        return nullptr;
-    }
-
-    std::shared_ptr<RtcMsg> msg = q_msg_.front();
-    q_msg_.pop();
-    return msg;
-}
-
 void RtcServer::InnerStop() {
     el_->DeleteIOEvent(pipe_watcher_);
+    if (certificate_watcher_) {
+        el_->DeleteTimer(certificate_watcher_);
+        certificate_watcher_ = nullptr;
+    }
     el_->Stop();
     close(notify_recv_fd_);
     close(notify_send_fd_);
@@ -193,37 +222,34 @@ void RtcServer::InnerStop() {
     }
 }
 
-int RtcServer::SendRtcMsg(std::shared_ptr<RtcMsg> msg) {
-    PushMsg(msg);
-    return Notify(RTC_MSG);
-}
+int RtcServer::SendRtcMsg(int producer_id, std::shared_ptr<RtcMsg> msg) {
+    rtc::RTCCertificate* certificate =
+        certificate_snapshot_.load(std::memory_order_acquire);
+    if (!certificate) {
+        RTC_LOG(LS_WARNING) << "no certificate, log_id: " << msg->log_id;
+        return -1;
+    }
+    
+    msg->certificate = certificate;
 
-RtcWorker* RtcServer::GetWorker(const std::string& stream_name) {
-    if (workers_.size() == 0 || workers_.size() != (size_t)options_.worker_num) {
-        return nullptr;
+    RtcWorker* worker = GetWorker(*msg);
+    if (!worker) {
+        RTC_LOG(LS_WARNING) << "no rtc worker, stream_name: " << msg->stream_name
+            << ", log_id: " << msg->log_id;
+        return -1;
     }
 
-    uint32_t num = rtc::ComputeCrc32(stream_name);
-    size_t index = num % options_.worker_num;
-    return workers_[index];
+    return worker->SendRtcMsg(producer_id, msg);
 }
 
-void RtcServer::ProcessRtcMsg() {
-    std::shared_ptr<RtcMsg> msg = PopMsg();
-    if (!msg) {
-        return;
-    }
-    
-    if (GenerateAndCheckCertificate() != 0) {
-        return;
+RtcWorker* RtcServer::GetWorker(const RtcMsg& msg) {
+    if (!workers_ready_.load(std::memory_order_acquire)
+            || workers_.size() != (size_t)options_.worker_num)
+    {
+        return nullptr;
     }
-    
-    msg->certificate = certificate_.get();
 
-    RtcWorker* worker = GetWorker(msg->stream_name);
-    if (worker) {
-        worker->SendRtcMsg(msg);
-    }
+    return workers_[placement_->Route(msg)];
 }
 
 void RtcServer::ProcessNotify(int msg) {
@@ -231,9 +257,6 @@ void RtcServer::ProcessNotify(int msg) {
         case QUIT:
             InnerStop();
             break;
-        case RTC_MSG:
-            ProcessRtcMsg();
-            break;
         default:
             RTC_LOG(LS_WARNING) << "unknown msg: " << msg;
             break;
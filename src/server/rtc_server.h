@@ -1,19 +1,24 @@
 #ifndef  __XRTCSERVER_SERVER_RTC_SERVER_H_
 #define  __XRTCSERVER_SERVER_RTC_SERVER_H_
 
+#include <atomic>
+#include <memory>
 #include <thread>
-#include <queue>
-#include <mutex>
+#include <vector>
 
 #include <rtc_base/rtc_certificate.h>
 
 #include "xrtcserver_def.h"
 #include "base/event_loop.h"
+#include "server/stream_placement.h"
+#include "stream/stream_fanout.h"
 
 namespace xrtc {
 
 struct RtcServerOptions {
     int worker_num;
+    // 向rtc worker发送消息的signaling worker个数，每一对之间一个单生产者队列
+    int signaling_worker_num = 1;
 };
 
 class RtcWorker;
@@ -21,30 +26,29 @@ class RtcWorker;
 class RtcServer {
 public:
     enum {
-        QUIT = 0,
-        RTC_MSG = 1
+        QUIT = 0
     };
 
     RtcServer();
     ~RtcServer();
     
-    int Init(const char* conf_file);
+    int Init(const char* conf_file, int signaling_worker_num);
     bool Start();
     void Stop();
     int Notify(int msg);
     void Join();
-    int SendRtcMsg(std::shared_ptr<RtcMsg>);
-    void PushMsg(std::shared_ptr<RtcMsg>);
-    std::shared_ptr<RtcMsg> PopMsg();
+    // 在signaling worker线程中调用，带上证书之后直接投递到负责该流的rtc worker，
+    // producer_id为signaling worker的编号
+    int SendRtcMsg(int producer_id, std::shared_ptr<RtcMsg> msg);
 
     friend void RtcServerRecvNotify(EventLoop*, IOWatcher*, int, int, void*);
+    friend void RtcServerCertificateCb(EventLoop*, TimerWatcher*, void*);
 
 private:
     void ProcessNotify(int msg);
     void InnerStop();
-    void ProcessRtcMsg();
     int CreateWorker(int worker_id);
-    RtcWorker* GetWorker(const std::string& stream_name);
+    RtcWorker* GetWorker(const RtcMsg& msg);
     int GenerateAndCheckCertificate();
 
 private:
@@ -54,14 +58,20 @@ private:
     std::thread* thread_ = nullptr;
 
     IOWatcher* pipe_watcher_ = nullptr;
+    TimerWatcher* certificate_watcher_ = nullptr;
     int notify_recv_fd_ = -1;
     int notify_send_fd_ = -1;
 
-    std::queue<std::shared_ptr<RtcMsg>> q_msg_;
-    std::mutex q_msg_mtx_;
-
+    // 路由表，Init之后只读，所有worker创建完成之后才对signaling worker可见
     std::vector<RtcWorker*> workers_;
+    std::atomic<bool> workers_ready_{false};
+    std::unique_ptr<StreamPlacement> placement_;
+    std::unique_ptr<StreamFanout> fanout_;
+    // 证书由server线程在后台更新，signaling worker读取快照。
+    // 更新时保留上一个证书，已经投递、还没有被rtc worker引用的消息仍然有效
     rtc::scoped_refptr<rtc::RTCCertificate> certificate_;
+    rtc::scoped_refptr<rtc::RTCCertificate> prev_certificate_;
+    std::atomic<rtc::RTCCertificate*> certificate_snapshot_{nullptr};
 };
 
 } // namespace xrtc
@@ -4,10 +4,17 @@
 
 #include <rtc_base/logging.h>
 
+#include "base/conf.h"
+#include "base/metrics.h"
 #include "server/signaling_worker.h"
 
+extern xrtc::GeneralConf* g_conf;
+
 namespace xrtc {
 
+// 负载上报的周期，单位毫秒
+const int kLoadReportIntervalMs = 1000;
+
 void RtcWorkerRecvNotify(EventLoop* /*el*/, IOWatcher* /*w*/, int fd, 
         int /*events*/, void* data)
 {
@@ -22,12 +29,29 @@ void RtcWorkerRecvNotify(EventLoop* /*el*/, IOWatcher* /*w*/, int fd,
     worker->ProcessNotify(msg);
 }
 
-RtcWorker::RtcWorker(int worker_id, const RtcServerOptions& options) :
+void RtcWorkerMetricsCb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+    RtcWorker* worker = (RtcWorker*)data;
+    worker->DumpMetrics();
+}
+
+void RtcWorkerLoadCb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+    RtcWorker* worker = (RtcWorker*)data;
+    worker->ReportLoad();
+}
+
+RtcWorker::RtcWorker(int worker_id, const RtcServerOptions& options,
+        StreamPlacement* placement, StreamFanout* fanout) :
     options_(options),
     worker_id_(worker_id),
     el_(new EventLoop(this)),
-    rtc_stream_mgr_(new RtcStreamManager(el_))
+    placement_(placement),
+    rtc_stream_mgr_(new RtcStreamManager(el_, fanout, worker_id))
 {
+    for (int i = 0; i < options_.signaling_worker_num; ++i) {
+        q_msgs_.emplace_back(new LockFreeQueue<std::shared_ptr<RtcMsg>>());
+    }
+
+    rtc_stream_mgr_->SignalStreamRemoved.connect(this, &RtcWorker::OnStreamRemoved);
 }
 
 RtcWorker::~RtcWorker() {
@@ -56,6 +80,16 @@ int RtcWorker::Init() {
     pipe_watcher_ = el_->CreateIOEvent(RtcWorkerRecvNotify, this);
     el_->StartIOEvent(pipe_watcher_, notify_recv_fd_, EventLoop::READ);
 
+    if (g_conf->metrics_dump_interval > 0) {
+        metrics_watcher_ = el_->CreateTimer(RtcWorkerMetricsCb, this, true);
+        el_->StartTimer(metrics_watcher_, g_conf->metrics_dump_interval * 1000);
+    }
+
+    if (placement_) {
+        load_watcher_ = el_->CreateTimer(RtcWorkerLoadCb, this, true);
+        el_->StartTimer(load_watcher_, kLoadReportIntervalMs * 1000);
+    }
+
     return 0;
 }
 
@@ -89,17 +123,32 @@ void RtcWorker::Join() {
     }
 }
 
-void RtcWorker::PushMsg(std::shared_ptr<RtcMsg> msg) {
-    q_msg_.Produce(msg);
+void RtcWorker::PushMsg(int producer_id, std::shared_ptr<RtcMsg> msg) {
+    q_msgs_[producer_id]->Produce(msg);
 }
 
 bool RtcWorker::PopMsg(std::shared_ptr<RtcMsg>* msg) {
-    return q_msg_.Consume(msg);
+    // 每次通知对应一条消息，轮流检查各个队列，避免某个signaling worker饿死其他的
+    for (size_t i = 0; i < q_msgs_.size(); ++i) {
+        size_t index = next_queue_index_;
+        next_queue_index_ = (next_queue_index_ + 1) % q_msgs_.size();
+        if (q_msgs_[index]->Consume(msg)) {
+            return true;
+        }
+    }
+
+    return false;
 }
 
-int RtcWorker::SendRtcMsg(std::shared_ptr<RtcMsg> msg) {
+int RtcWorker::SendRtcMsg(int producer_id, std::shared_ptr<RtcMsg> msg) {
+    if (producer_id < 0 || (size_t)producer_id >= q_msgs_.size()) {
+        RTC_LOG(LS_WARNING) << "invalid producer_id: " << producer_id
+            << ", worker_id: " << worker_id_;
+        return -1;
+    }
+
     // 将消息投递到worker的队列
-    PushMsg(msg);
+    PushMsg(producer_id, msg);
     return Notify(RTC_MSG);
 }
 
@@ -110,11 +159,49 @@ void RtcWorker::InnerStop() {
     }
 
     el_->DeleteIOEvent(pipe_watcher_);
+    if (metrics_watcher_) {
+        el_->DeleteTimer(metrics_watcher_);
+        metrics_watcher_ = nullptr;
+    }
+    if (load_watcher_) {
+        el_->DeleteTimer(load_watcher_);
+        load_watcher_ = nullptr;
+    }
     el_->Stop();
     close(notify_recv_fd_);
     close(notify_send_fd_);
 }
 
+void RtcWorker::ReportLoad() {
+    unsigned long now = el_->now();
+    uint64_t packets = rtc_stream_mgr_->rtp_packets_received();
+    int packets_per_sec = 0;
+    int loop_lag_ms = 0;
+    if (last_load_report_time_ > 0 && now > last_load_report_time_) {
+        unsigned long elapsed_us = now - last_load_report_time_;
+        packets_per_sec = (int)((packets - last_rtp_packets_received_)
+                * 1000000 / elapsed_us);
+        // 定时器比预期晚触发的时间，反映事件循环的繁忙程度
+        if (elapsed_us > (unsigned long)kLoadReportIntervalMs * 1000) {
+            loop_lag_ms = (elapsed_us - kLoadReportIntervalMs * 1000) / 1000;
+        }
+    }
+
+    last_load_report_time_ = now;
+    last_rtp_packets_received_ = packets;
+
+    placement_->UpdateLoad(worker_id_, rtc_stream_mgr_->num_streams(),
+            packets_per_sec, loop_lag_ms);
+}
+
+void RtcWorker::DumpMetrics() {
+    // 统计数据属于worker线程，在worker线程中输出并清零
+    Metrics* metrics = Metrics::ThreadInstance();
+    RTC_LOG(LS_INFO) << "rtc worker metrics, worker_id: " << worker_id_
+        << ", " << metrics->ToString();
+    metrics->Reset();
+}
+
 void RtcWorker::ProcessPush(std::shared_ptr<RtcMsg> msg) {
     std::string offer;
     int ret = rtc_stream_mgr_->CreatePushStream(msg->uid, msg->stream_name,
@@ -126,9 +213,10 @@ void RtcWorker::ProcessPush(std::shared_ptr<RtcMsg> msg) {
     
     RTC_LOG(LS_INFO) << "offer: " << offer;
 
-    msg->sdp = offer;
+    msg->sdp = std::move(offer);
     if (ret != 0) {
         msg->err_no = -1;
+        OnStreamRemoved(RtcStreamType::k_push, msg->uid, msg->stream_name);
     }
 
     SignalingWorker* worker = (SignalingWorker*)(msg->worker);
@@ -140,7 +228,7 @@ void RtcWorker::ProcessPush(std::shared_ptr<RtcMsg> msg) {
 void RtcWorker::ProcessPull(std::shared_ptr<RtcMsg> msg) {
     std::string offer;
     int ret = rtc_stream_mgr_->CreatePullStream(msg->uid, msg->stream_name,
-            msg->audio, msg->video, 
+            msg->audio, msg->video, msg->skip_silent_audio,
             msg->is_dtls, msg->log_id, 
             (rtc::RTCCertificate*)(msg->certificate),
             offer);
@@ -148,9 +236,10 @@ void RtcWorker::ProcessPull(std::shared_ptr<RtcMsg> msg) {
 
     RTC_LOG(LS_INFO) << "offer: " << offer;
 
-    msg->sdp = offer;
+    msg->sdp = std::move(offer);
     if (ret != 0) {
         msg->err_no = -1;
+        OnStreamRemoved(RtcStreamType::k_pull, msg->uid, msg->stream_name);
     }
 
     SignalingWorker* worker = (SignalingWorker*)(msg->worker);
@@ -161,7 +250,7 @@ void RtcWorker::ProcessPull(std::shared_ptr<RtcMsg> msg) {
 
 void RtcWorker::ProcessAnswer(std::shared_ptr<RtcMsg> msg) {
     int ret = rtc_stream_mgr_->SetAnswer(msg->uid, msg->stream_name,
-            msg->sdp, msg->stream_type, msg->log_id);
+            msg->remote_desc, msg->stream_type, msg->log_id);
      
     RTC_LOG(LS_INFO) << "rtc worker process answer, uid: " << msg->uid
         << ", stream_name: " << msg->stream_name
@@ -190,6 +279,17 @@ void RtcWorker::ProcessStopPull(std::shared_ptr<RtcMsg> msg) {
         << ", ret: " << ret;
 }
 
+// 创建失败或者异常结束的流，从placement的目录中移除，
+// 否则后续的请求会一直被路由到这个worker
+void RtcWorker::OnStreamRemoved(RtcStreamType stream_type, uint64_t uid,
+        const std::string& stream_name)
+{
+    if (placement_) {
+        placement_->OnStreamRemoved(uid, stream_name,
+                RtcStreamType::k_push == stream_type);
+    }
+}
+
 void RtcWorker::ProcessRtcMsg() {
     std::shared_ptr<RtcMsg> msg;
     if (!PopMsg(&msg)) {
@@ -233,6 +333,9 @@ void RtcWorker::ProcessNotify(int msg) {
         case RTC_MSG:
             ProcessRtcMsg();
             break;
+        case FANOUT_MSG:
+            rtc_stream_mgr_->ProcessFanout();
+            break;
         default:
             RTC_LOG(LS_WARNING) << "unknown msg: " << msg;
             break;
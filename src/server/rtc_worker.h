@@ -2,6 +2,7 @@
 #define  __XRTCSERVER_SERVER_RTC_WORKER_H_
 
 #include <thread>
+#include <vector>
 
 #include "xrtcserver_def.h"
 #include "base/lock_free_queue.h"
@@ -10,14 +11,16 @@
 
 namespace xrtc {
 
-class RtcWorker {
+class RtcWorker : public sigslot::has_slots<> {
 public:
     enum {
         QUIT = 0,
-        RTC_MSG = 1
+        RTC_MSG = 1,
+        FANOUT_MSG = 2
     };
 
-    RtcWorker(int worker_id, const RtcServerOptions& options);
+    RtcWorker(int worker_id, const RtcServerOptions& options,
+            StreamPlacement* placement, StreamFanout* fanout);
     ~RtcWorker();
 
     int Init();
@@ -25,22 +28,32 @@ public:
     void Stop();
     int Notify(int msg);
     void Join();
-    void PushMsg(std::shared_ptr<RtcMsg> msg);
+    // producer_id为发送消息的signaling worker的编号，只能在该线程中调用
+    void PushMsg(int producer_id, std::shared_ptr<RtcMsg> msg);
     bool PopMsg(std::shared_ptr<RtcMsg>* msg);
-    int SendRtcMsg(std::shared_ptr<RtcMsg> msg);
+    int SendRtcMsg(int producer_id, std::shared_ptr<RtcMsg> msg);
+    int worker_id() const { return worker_id_; }
 
     friend void RtcWorkerRecvNotify(EventLoop* /*el*/, IOWatcher* /*w*/, int fd, 
         int /*events*/, void* data);
+    friend void RtcWorkerMetricsCb(EventLoop* /*el*/, TimerWatcher* /*w*/,
+        void* data);
+    friend void RtcWorkerLoadCb(EventLoop* /*el*/, TimerWatcher* /*w*/,
+        void* data);
 
 private:
     void ProcessNotify(int msg);
     void InnerStop();
+    void DumpMetrics();
+    void ReportLoad();
     void ProcessRtcMsg();
     void ProcessPush(std::shared_ptr<RtcMsg> msg);
     void ProcessPull(std::shared_ptr<RtcMsg> msg);
     void ProcessStopPush(std::shared_ptr<RtcMsg> msg);
     void ProcessStopPull(std::shared_ptr<RtcMsg> msg);
     void ProcessAnswer(std::shared_ptr<RtcMsg> msg);
+    void OnStreamRemoved(RtcStreamType stream_type, uint64_t uid,
+            const std::string& stream_name);
 
 private:
     RtcServerOptions options_;
@@ -48,11 +61,19 @@ private:
     EventLoop* el_;
 
     IOWatcher* pipe_watcher_ = nullptr;
+    TimerWatcher* metrics_watcher_ = nullptr;
+    // 周期性地把负载上报给placement
+    StreamPlacement* placement_;
+    TimerWatcher* load_watcher_ = nullptr;
+    unsigned long last_load_report_time_ = 0;
+    uint64_t last_rtp_packets_received_ = 0;
     int notify_recv_fd_ = -1;
     int notify_send_fd_ = -1;
 
     std::thread* thread_ = nullptr;
-    LockFreeQueue<std::shared_ptr<RtcMsg>> q_msg_;
+    // 每个signaling worker一个单生产者单消费者队列
+    std::vector<std::unique_ptr<LockFreeQueue<std::shared_ptr<RtcMsg>>>> q_msgs_;
+    size_t next_queue_index_ = 0;
 
     std::unique_ptr<RtcStreamManager> rtc_stream_mgr_;
 };
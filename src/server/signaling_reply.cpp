@@ -0,0 +1,182 @@
+#include "server/signaling_reply.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <streambuf>
+#include <ostream>
+
+#include <rtc_base/zmalloc.h>
+
+namespace xrtc {
+
+namespace {
+
+const size_t kClassSizes[] = {256, 1024, 4096, 16384, 65536};
+// 每一级最多缓存的空闲缓冲区个数
+const size_t kMaxFreePerClass = 32;
+
+int FindClass(size_t size) {
+    for (size_t i = 0; i < sizeof(kClassSizes) / sizeof(kClassSizes[0]); ++i) {
+        if (size <= kClassSizes[i]) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// 写入内存池缓冲区的streambuf，空间不够时从内存池申请更大的缓冲区
+class ReplyStreamBuf : public std::streambuf {
+public:
+    ReplyStreamBuf(ReplyBufferPool* pool, size_t size_hint) : pool_(pool) {
+        buf_ = pool_->Alloc(size_hint, &capacity_);
+        if (buf_) {
+            setp(buf_, buf_ + capacity_);
+        }
+    }
+
+    ~ReplyStreamBuf() override {
+        if (buf_) {
+            pool_->Free(buf_, capacity_);
+        }
+    }
+
+    char* Release(size_t* len, size_t* capacity) {
+        char* buf = buf_;
+        *len = pptr() - pbase();
+        *capacity = capacity_;
+        buf_ = nullptr;
+        capacity_ = 0;
+        setp(nullptr, nullptr);
+        return buf;
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+
+        if (!Grow(1)) {
+            return traits_type::eof();
+        }
+
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+        return ch;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (epptr() - pptr() < n && !Grow(n)) {
+            return 0;
+        }
+
+        memcpy(pptr(), s, n);
+        pbump(n);
+        return n;
+    }
+
+private:
+    bool Grow(size_t n) {
+        size_t used = buf_ ? pptr() - pbase() : 0;
+        size_t new_capacity = 0;
+        char* new_buf = pool_->Alloc(std::max(capacity_ * 2, used + n),
+                &new_capacity);
+        if (!new_buf) {
+            return false;
+        }
+
+        if (buf_) {
+            memcpy(new_buf, buf_, used);
+            pool_->Free(buf_, capacity_);
+        }
+
+        buf_ = new_buf;
+        capacity_ = new_capacity;
+        setp(buf_, buf_ + capacity_);
+        pbump(used);
+        return true;
+    }
+
+private:
+    ReplyBufferPool* pool_;
+    char* buf_ = nullptr;
+    size_t capacity_ = 0;
+};
+
+} // namespace
+
+ReplyBufferPool::~ReplyBufferPool() {
+    for (int i = 0; i < kNumClasses; ++i) {
+        for (char* buf : free_lists_[i]) {
+            zfree(buf);
+        }
+    }
+}
+
+char* ReplyBufferPool::Alloc(size_t size, size_t* capacity) {
+    int index = FindClass(size);
+    if (index < 0) {
+        *capacity = size;
+        return (char*)zmalloc(size);
+    }
+
+    *capacity = kClassSizes[index];
+    if (!free_lists_[index].empty()) {
+        char* buf = free_lists_[index].back();
+        free_lists_[index].pop_back();
+        return buf;
+    }
+
+    return (char*)zmalloc(kClassSizes[index]);
+}
+
+void ReplyBufferPool::Free(char* buf, size_t capacity) {
+    if (!buf) {
+        return;
+    }
+
+    int index = FindClass(capacity);
+    if (index >= 0 && kClassSizes[index] == capacity
+            && free_lists_[index].size() < kMaxFreePerClass)
+    {
+        free_lists_[index].push_back(buf);
+        return;
+    }
+
+    zfree(buf);
+}
+
+int BuildJsonReply(ReplyBufferPool* pool, const Json::Value& root,
+        size_t size_hint, SignalingReply* reply)
+{
+    // 每个signaling worker线程复用一个writer
+    static thread_local std::unique_ptr<Json::StreamWriter> writer;
+    if (!writer) {
+        Json::StreamWriterBuilder write_builder;
+        write_builder.settings_["indentation"] = "";
+        writer.reset(write_builder.newStreamWriter());
+    }
+
+    ReplyStreamBuf sbuf(pool, size_hint);
+    std::ostream os(&sbuf);
+    writer->write(root, &os);
+    if (!os) {
+        return -1;
+    }
+
+    size_t len = 0;
+    reply->body = sbuf.Release(&len, &reply->capacity);
+    reply->header.body_len = len;
+    return 0;
+}
+
+void FreeReply(ReplyBufferPool* pool, SignalingReply* reply) {
+    pool->Free(reply->body, reply->capacity);
+    reply->body = nullptr;
+    reply->capacity = 0;
+}
+
+} // namespace xrtc
@@ -0,0 +1,48 @@
+#ifndef  __XRTCSERVER_SERVER_SIGNALING_REPLY_H_
+#define  __XRTCSERVER_SERVER_SIGNALING_REPLY_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <json/json.h>
+
+#include "base/xhead.h"
+
+namespace xrtc {
+
+// 信令响应，xhead和body分开存放，发送时分别作为一个iovec
+struct SignalingReply {
+    xhead_t header;
+    char* body = nullptr;
+    // body缓冲区的大小，归还给内存池时使用
+    size_t capacity = 0;
+
+    size_t size() const { return XHEAD_SIZE + header.body_len; }
+};
+
+// 响应body的内存池，每个signaling worker一个，只在worker线程中访问。
+// 按大小分级，申请时向上取整到所在级别，超过最大级别的直接分配和释放
+class ReplyBufferPool {
+public:
+    ReplyBufferPool() = default;
+    ~ReplyBufferPool();
+
+    char* Alloc(size_t size, size_t* capacity);
+    void Free(char* buf, size_t capacity);
+
+private:
+    static const int kNumClasses = 5;
+    std::vector<char*> free_lists_[kNumClasses];
+};
+
+// 把json直接序列化到内存池的缓冲区中，header中除body_len以外的字段
+// 由调用者设置
+int BuildJsonReply(ReplyBufferPool* pool, const Json::Value& root,
+        size_t size_hint, SignalingReply* reply);
+
+void FreeReply(ReplyBufferPool* pool, SignalingReply* reply);
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_SERVER_SIGNALING_REPLY_H_
@@ -0,0 +1,739 @@
+#include "server/signaling_request.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <limits>
+
+namespace xrtc {
+
+namespace {
+
+// 跳过未知字段时允许的最大嵌套层数，和json reader默认的stackLimit一致
+const int kMaxDepth = 1000;
+
+// 请求中用到的字段，取值的类型由SignalingRequest中的成员类型决定
+#define XRTC_SIGNALING_FIELDS(F) \
+    F(cmdno) \
+    F(uid) \
+    F(stream_name) \
+    F(audio) \
+    F(video) \
+    F(is_dtls) \
+    F(skip_silent_audio) \
+    F(answer) \
+    F(type)
+
+enum FieldIndex {
+#define XRTC_SIGNALING_FIELD_INDEX(name) kIndex_##name,
+    XRTC_SIGNALING_FIELDS(XRTC_SIGNALING_FIELD_INDEX)
+#undef XRTC_SIGNALING_FIELD_INDEX
+    kFieldCount,
+    kFieldUnknown = kFieldCount,
+};
+
+const char* const kFieldNames[] = {
+#define XRTC_SIGNALING_FIELD_NAME(name) #name,
+    XRTC_SIGNALING_FIELDS(XRTC_SIGNALING_FIELD_NAME)
+#undef XRTC_SIGNALING_FIELD_NAME
+};
+
+// 和json reader的数字类型一致：不带小数和指数、且不溢出的整数为int或uint，
+// 其余为double
+struct JsonNumber {
+    enum Type {
+        kInt,
+        kUint,
+        kReal,
+    };
+
+    Type type = kInt;
+    int64_t int_value = 0;
+    uint64_t uint_value = 0;
+    double real_value = 0;
+};
+
+class RequestScanner {
+public:
+    RequestScanner(const char* data, size_t len, std::string* err) :
+        p_(data), end_(data + len), err_(err) {}
+
+    int Parse(SignalingRequest* req);
+
+private:
+    bool Fail(const char* reason) {
+        if (err_) {
+            *err_ = reason;
+        }
+        return false;
+    }
+
+    void SkipWs() {
+        while (p_ < end_ && (' ' == *p_ || '\t' == *p_ || '\n' == *p_ || '\r' == *p_)) {
+            ++p_;
+        }
+    }
+
+    bool SkipWsAndComments();
+
+    bool Expect(char ch) {
+        SkipWs();
+        if (p_ >= end_ || *p_ != ch) {
+            return false;
+        }
+        ++p_;
+        return true;
+    }
+
+    bool ParseKey(const char** key, size_t* key_len);
+    bool ParseString(std::string* out);
+    bool ParseHex4(uint32_t* cp);
+    bool ParseNumber(JsonNumber* num);
+    bool ParseLiteral(const char* literal);
+    bool ParseObject(SignalingRequest* req, int depth);
+    bool SkipArray(int depth);
+    bool SkipValue(int depth);
+
+    // 返回false表示json语法错误，类型不能转换时convertible为false
+    bool ParseField(int* out, bool* convertible);
+    bool ParseField(uint64_t* out, bool* convertible);
+    bool ParseField(std::string* out, bool* convertible);
+
+private:
+    const char* p_;
+    const char* end_;
+    std::string* err_;
+    // key中有转义字符时解码到这里，正常的key直接引用body中的内容
+    std::string escaped_key_;
+    // 取值不能转换的字段，同一个key重复出现时以最后一次为准
+    uint32_t bad_fields_ = 0;
+};
+
+void AppendUtf8(uint32_t cp, std::string* out) {
+    if (cp < 0x80) {
+        out->push_back((char)cp);
+    } else if (cp < 0x800) {
+        out->push_back((char)(0xC0 | (cp >> 6)));
+        out->push_back((char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out->push_back((char)(0xE0 | (cp >> 12)));
+        out->push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        out->push_back((char)(0x80 | (cp & 0x3F)));
+    } else {
+        out->push_back((char)(0xF0 | (cp >> 18)));
+        out->push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+        out->push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        out->push_back((char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+bool IsNumberStart(char ch) {
+    return ('-' == ch || '+' == ch || (ch >= '0' && ch <= '9'));
+}
+
+// json reader默认允许/* */和//注释，出现在值的前后和key之前
+bool RequestScanner::SkipWsAndComments() {
+    while (true) {
+        SkipWs();
+        if (p_ >= end_ || *p_ != '/') {
+            return true;
+        }
+
+        if (end_ - p_ < 2) {
+            return Fail("invalid comment");
+        }
+
+        if ('*' == p_[1]) {
+            const char* q = p_ + 2;
+            while (q + 1 < end_ && !('*' == q[0] && '/' == q[1])) {
+                ++q;
+            }
+            if (q + 1 >= end_) {
+                return Fail("unterminated comment");
+            }
+            p_ = q + 2;
+        } else if ('/' == p_[1]) {
+            p_ += 2;
+            while (p_ < end_ && *p_ != '\n' && *p_ != '\r') {
+                ++p_;
+            }
+        } else {
+            return Fail("invalid comment");
+        }
+    }
+}
+
+bool RequestScanner::ParseHex4(uint32_t* cp) {
+    if (end_ - p_ < 4) {
+        return Fail("invalid unicode escape");
+    }
+
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) {
+        char ch = *p_++;
+        v <<= 4;
+        if (ch >= '0' && ch <= '9') {
+            v |= ch - '0';
+        } else if (ch >= 'a' && ch <= 'f') {
+            v |= ch - 'a' + 10;
+        } else if (ch >= 'A' && ch <= 'F') {
+            v |= ch - 'A' + 10;
+        } else {
+            return Fail("invalid unicode escape");
+        }
+    }
+
+    *cp = v;
+    return true;
+}
+
+// out为空时只跳过字符串
+bool RequestScanner::ParseString(std::string* out) {
+    if (!Expect('"')) {
+        return Fail("expect string");
+    }
+
+    while (p_ < end_) {
+        // 连续的普通字符一次追加
+        const char* run = p_;
+        while (p_ < end_ && *p_ != '"' && *p_ != '\\') {
+            ++p_;
+        }
+
+        if (out && p_ > run) {
+            out->append(run, p_ - run);
+        }
+
+        if (p_ >= end_) {
+            break;
+        }
+
+        if ('"' == *p_) {
+            ++p_;
+            return true;
+        }
+
+        // 转义字符
+        ++p_;
+        if (p_ >= end_) {
+            break;
+        }
+
+        char ch = *p_++;
+        char decoded = 0;
+        switch (ch) {
+            case '"': decoded = '"'; break;
+            case '\\': decoded = '\\'; break;
+            case '/': decoded = '/'; break;
+            case 'b': decoded = '\b'; break;
+            case 'f': decoded = '\f'; break;
+            case 'n': decoded = '\n'; break;
+            case 'r': decoded = '\r'; break;
+            case 't': decoded = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!ParseHex4(&cp)) {
+                    return false;
+                }
+
+                // utf-16代理对，和json reader一致，高位代理之后必须是\u，
+                // 但不检查它是否为低位代理，单独的低位代理按普通字符处理
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (end_ - p_ < 6 || p_[0] != '\\' || p_[1] != 'u') {
+                        return Fail("invalid surrogate pair");
+                    }
+                    p_ += 2;
+                    if (!ParseHex4(&low)) {
+                        return false;
+                    }
+                    cp = 0x10000 + ((cp & 0x3FF) << 10) + (low & 0x3FF);
+                }
+
+                if (out) {
+                    AppendUtf8(cp, out);
+                }
+                continue;
+            }
+            default:
+                return Fail("invalid escape");
+        }
+
+        if (out) {
+            out->push_back(decoded);
+        }
+    }
+
+    return Fail("unterminated string");
+}
+
+bool RequestScanner::ParseKey(const char** key, size_t* key_len) {
+    if (p_ >= end_ || *p_ != '"') {
+        return Fail("expect key");
+    }
+
+    const char* start = p_ + 1;
+    const char* q = start;
+    while (q < end_ && *q != '"' && *q != '\\') {
+        ++q;
+    }
+
+    if (q < end_ && '"' == *q) {
+        *key = start;
+        *key_len = q - start;
+        p_ = q + 1;
+        return true;
+    }
+
+    escaped_key_.clear();
+    if (!ParseString(&escaped_key_)) {
+        return false;
+    }
+
+    *key = escaped_key_.data();
+    *key_len = escaped_key_.size();
+    return true;
+}
+
+// 数字的边界和json reader一致：可选的正负号、整数部分、小数部分、指数部分
+// 都可以为空，之后再按照类型转换，转换失败才报错。例如"-"为0，"1."为1.0，
+// "1e"报错
+bool RequestScanner::ParseNumber(JsonNumber* num) {
+    const char* start = p_;
+    const char* q = p_;
+    bool negative = false;
+    bool is_real = false;
+    if (q < end_ && ('-' == *q || '+' == *q)) {
+        negative = ('-' == *q);
+        is_real = ('+' == *q);
+        ++q;
+    }
+
+    uint64_t magnitude = 0;
+    bool overflow = false;
+    while (q < end_ && *q >= '0' && *q <= '9') {
+        uint64_t d = *q - '0';
+        if (magnitude > (std::numeric_limits<uint64_t>::max() - d) / 10) {
+            overflow = true;
+        } else {
+            magnitude = magnitude * 10 + d;
+        }
+        ++q;
+    }
+
+    if (q < end_ && '.' == *q) {
+        is_real = true;
+        ++q;
+        while (q < end_ && *q >= '0' && *q <= '9') {
+            ++q;
+        }
+    }
+
+    if (q < end_ && ('e' == *q || 'E' == *q)) {
+        is_real = true;
+        ++q;
+        if (q < end_ && ('+' == *q || '-' == *q)) {
+            ++q;
+        }
+        while (q < end_ && *q >= '0' && *q <= '9') {
+            ++q;
+        }
+    }
+
+    p_ = q;
+
+    // 负数超出int64，正数超出uint64时按double处理
+    const uint64_t kInt64MinMagnitude = (uint64_t)std::numeric_limits<int64_t>::max() + 1;
+    if (!is_real && !overflow && !(negative && magnitude > kInt64MinMagnitude)) {
+        if (negative) {
+            num->type = JsonNumber::kInt;
+            num->int_value = (int64_t)(0 - magnitude);
+        } else if (magnitude <= (uint64_t)std::numeric_limits<int64_t>::max()) {
+            num->type = JsonNumber::kInt;
+            num->int_value = (int64_t)magnitude;
+        } else {
+            num->type = JsonNumber::kUint;
+            num->uint_value = magnitude;
+        }
+        return true;
+    }
+
+    // body不是以\0结尾，拷贝出来再转换，一般的数字不会超过栈上的buffer
+    size_t len = q - start;
+    char buf[64];
+    std::string long_buf;
+    char* str = buf;
+    if (len >= sizeof(buf)) {
+        long_buf.assign(start, len);
+        str = &long_buf[0];
+    } else {
+        memcpy(buf, start, len);
+        buf[len] = '\0';
+    }
+
+    char* str_end;
+    double value = strtod(str, &str_end);
+    if (str_end != str + len
+            || value == std::numeric_limits<double>::infinity()
+            || value == -std::numeric_limits<double>::infinity())
+    {
+        return Fail("invalid number");
+    }
+
+    num->type = JsonNumber::kReal;
+    num->real_value = value;
+    return true;
+}
+
+bool RequestScanner::ParseLiteral(const char* literal) {
+    size_t len = strlen(literal);
+    if ((size_t)(end_ - p_) < len || memcmp(p_, literal, len) != 0) {
+        return Fail("invalid literal");
+    }
+
+    p_ += len;
+    return true;
+}
+
+FieldIndex LookupField(const char* key, size_t key_len) {
+    for (int i = 0; i < kFieldCount; ++i) {
+        const char* name = kFieldNames[i];
+        if (key_len == strlen(name) && 0 == memcmp(key, name, key_len)) {
+            return (FieldIndex)i;
+        }
+    }
+
+    return kFieldUnknown;
+}
+
+// '{'已经读取，req为空时只跳过对象
+bool RequestScanner::ParseObject(SignalingRequest* req, int depth) {
+    while (true) {
+        if (!SkipWsAndComments()) {
+            return false;
+        }
+
+        if (p_ < end_ && '}' == *p_) {
+            // 空对象，或者末尾的逗号，json reader默认允许
+            ++p_;
+            return true;
+        }
+
+        const char* key;
+        size_t key_len;
+        if (!ParseKey(&key, &key_len)) {
+            return false;
+        }
+
+        // key和':'之间不允许注释
+        if (!Expect(':')) {
+            return Fail("expect ':'");
+        }
+
+        FieldIndex index = req ? LookupField(key, key_len) : kFieldUnknown;
+        if (!SkipWsAndComments()) {
+            return false;
+        }
+
+        bool ok = true;
+        bool convertible = true;
+        switch (index) {
+#define XRTC_SIGNALING_FIELD_CASE(name) \
+            case kIndex_##name: \
+                ok = ParseField(&req->name, &convertible); \
+                break;
+            XRTC_SIGNALING_FIELDS(XRTC_SIGNALING_FIELD_CASE)
+#undef XRTC_SIGNALING_FIELD_CASE
+            default:
+                ok = SkipValue(depth + 1);
+                break;
+        }
+
+        if (!ok) {
+            return false;
+        }
+
+        if (index != kFieldUnknown) {
+            if (convertible) {
+                bad_fields_ &= ~(1u << index);
+            } else {
+                bad_fields_ |= 1u << index;
+            }
+        }
+
+        if (!SkipWsAndComments()) {
+            return false;
+        }
+
+        if (p_ < end_ && '}' == *p_) {
+            ++p_;
+            return true;
+        }
+
+        if (p_ >= end_ || *p_ != ',') {
+            return Fail("expect ',' or '}'");
+        }
+        ++p_;
+    }
+}
+
+// '['已经读取
+bool RequestScanner::SkipArray(int depth) {
+    if (Expect(']')) {
+        return true;
+    }
+
+    while (true) {
+        if (!SkipValue(depth + 1)) {
+            return false;
+        }
+
+        if (!SkipWsAndComments()) {
+            return false;
+        }
+
+        if (p_ < end_ && ']' == *p_) {
+            ++p_;
+            return true;
+        }
+
+        if (p_ >= end_ || *p_ != ',') {
+            return Fail("expect ',' or ']'");
+        }
+        ++p_;
+
+        // 末尾的逗号，和json reader一致，逗号和']'之间不允许注释
+        if (Expect(']')) {
+            return true;
+        }
+    }
+}
+
+bool RequestScanner::SkipValue(int depth) {
+    if (depth > kMaxDepth) {
+        return Fail("too deep");
+    }
+
+    if (!SkipWsAndComments()) {
+        return false;
+    }
+
+    if (p_ >= end_) {
+        return Fail("expect value");
+    }
+
+    switch (*p_) {
+        case '"':
+            return ParseString(nullptr);
+        case '{':
+            ++p_;
+            return ParseObject(nullptr, depth);
+        case '[':
+            ++p_;
+            return SkipArray(depth);
+        case 't':
+            return ParseLiteral("true");
+        case 'f':
+            return ParseLiteral("false");
+        case 'n':
+            return ParseLiteral("null");
+        default:
+            if (IsNumberStart(*p_)) {
+                JsonNumber num;
+                return ParseNumber(&num);
+            }
+            return Fail("expect value");
+    }
+}
+
+// 字段的取值按照Json::Value的转换规则，不能转换时跳过取值，
+// 由调用方记录该字段无效
+
+// 和Json::Value::asInt一致，bool和null可以转换，double截断，字符串不能转换
+bool RequestScanner::ParseField(int* out, bool* convertible) {
+    if (p_ < end_ && ('t' == *p_ || 'f' == *p_ || 'n' == *p_)) {
+        *out = ('t' == *p_) ? 1 : 0;
+        return SkipValue(0);
+    }
+
+    if (p_ < end_ && ('"' == *p_ || '{' == *p_ || '[' == *p_)) {
+        *convertible = false;
+        return SkipValue(0);
+    }
+
+    if (p_ >= end_ || !IsNumberStart(*p_)) {
+        return SkipValue(0);
+    }
+
+    JsonNumber num;
+    if (!ParseNumber(&num)) {
+        return false;
+    }
+
+    switch (num.type) {
+        case JsonNumber::kInt:
+            *convertible = num.int_value >= std::numeric_limits<int>::min()
+                && num.int_value <= std::numeric_limits<int>::max();
+            break;
+        case JsonNumber::kUint:
+            *convertible = false;
+            break;
+        case JsonNumber::kReal:
+            *convertible = num.real_value >= std::numeric_limits<int>::min()
+                && num.real_value <= std::numeric_limits<int>::max();
+            break;
+    }
+
+    if (*convertible) {
+        *out = (JsonNumber::kInt == num.type) ? (int)num.int_value : (int)num.real_value;
+    }
+    return true;
+}
+
+bool RequestScanner::ParseField(uint64_t* out, bool* convertible) {
+    if (p_ < end_ && ('t' == *p_ || 'f' == *p_ || 'n' == *p_)) {
+        *out = ('t' == *p_) ? 1 : 0;
+        return SkipValue(0);
+    }
+
+    if (p_ < end_ && ('"' == *p_ || '{' == *p_ || '[' == *p_)) {
+        *convertible = false;
+        return SkipValue(0);
+    }
+
+    if (p_ >= end_ || !IsNumberStart(*p_)) {
+        return SkipValue(0);
+    }
+
+    JsonNumber num;
+    if (!ParseNumber(&num)) {
+        return false;
+    }
+
+    switch (num.type) {
+        case JsonNumber::kInt:
+            *convertible = num.int_value >= 0;
+            *out = (uint64_t)num.int_value;
+            break;
+        case JsonNumber::kUint:
+            *out = num.uint_value;
+            break;
+        case JsonNumber::kReal:
+            // json reader的范围检查包含2^64本身，转换的结果为0
+            *convertible = num.real_value >= 0
+                && num.real_value <= 18446744073709551616.0;
+            *out = (num.real_value < 18446744073709551616.0) ?
+                (uint64_t)num.real_value : 0;
+            break;
+    }
+
+    return true;
+}
+
+// 和Json::Value::asString一致，null为空字符串，bool和数字转换成字符串，
+// double按%.17g输出，没有小数点和指数时补".0"
+bool RequestScanner::ParseField(std::string* out, bool* convertible) {
+    out->clear();
+    if (p_ >= end_) {
+        return SkipValue(0);
+    }
+
+    if (!IsNumberStart(*p_)) {
+        switch (*p_) {
+            case '"':
+                return ParseString(out);
+            case 't':
+                out->assign("true");
+                break;
+            case 'f':
+                out->assign("false");
+                break;
+            case '{':
+            case '[':
+                *convertible = false;
+                break;
+        }
+        return SkipValue(0);
+    }
+
+    JsonNumber num;
+    if (!ParseNumber(&num)) {
+        return false;
+    }
+
+    char buf[32];
+    switch (num.type) {
+        case JsonNumber::kInt:
+            snprintf(buf, sizeof(buf), "%lld", (long long)num.int_value);
+            break;
+        case JsonNumber::kUint:
+            snprintf(buf, sizeof(buf), "%llu", (unsigned long long)num.uint_value);
+            break;
+        case JsonNumber::kReal:
+            snprintf(buf, sizeof(buf), "%.17g", num.real_value);
+            if (!strchr(buf, '.') && !strchr(buf, 'e')) {
+                strcat(buf, ".0");
+            }
+            break;
+    }
+
+    out->assign(buf);
+    return true;
+}
+
+int RequestScanner::Parse(SignalingRequest* req) {
+    if (!SkipWsAndComments()) {
+        return -1;
+    }
+
+    // 和json reader的默认设置一致，对象之后的内容忽略
+    if (Expect('{')) {
+        if (!ParseObject(req, 0)) {
+            return -1;
+        }
+    } else if (p_ < end_ && 'n' == *p_) {
+        // body为null时，原来的取值都是默认值
+        if (!ParseLiteral("null")) {
+            return -1;
+        }
+    } else {
+        Fail("body is not a json object");
+        return -1;
+    }
+
+    for (int i = 0; i < kFieldCount; ++i) {
+        if (bad_fields_ & (1u << i)) {
+            if (err_) {
+                *err_ = std::string("invalid value of ") + kFieldNames[i];
+            }
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace
+
+void SignalingRequest::Reset() {
+    cmdno = 0;
+    uid = 0;
+    stream_name.clear();
+    audio = 0;
+    video = 0;
+    is_dtls = 0;
+    skip_silent_audio = 0;
+    answer.clear();
+    type.clear();
+}
+
+int ParseSignalingRequest(const char* data, size_t len,
+        SignalingRequest* req, std::string* err)
+{
+    req->Reset();
+    RequestScanner scanner(data, len, err);
+    return scanner.Parse(req);
+}
+
+} // namespace xrtc
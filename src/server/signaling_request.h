@@ -0,0 +1,37 @@
+#ifndef  __XRTCSERVER_SERVER_SIGNALING_REQUEST_H_
+#define  __XRTCSERVER_SERVER_SIGNALING_REQUEST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace xrtc {
+
+// 信令请求中用到的字段，缺少的字段和原来json取值的行为一致，
+// 数字为0，字符串为空
+struct SignalingRequest {
+    int cmdno = 0;
+    uint64_t uid = 0;
+    std::string stream_name;
+    int audio = 0;
+    int video = 0;
+    int is_dtls = 0;
+    int skip_silent_audio = 0;
+    std::string answer;
+    std::string type;
+
+    // 清空字段，字符串保留已经分配的空间，每个signaling worker复用一个对象
+    void Reset();
+};
+
+// 只针对固定的信令字段的json解析，直接从请求body中解析到对应字段，
+// 不构造json对象，不认识的字段跳过。语法和字段的类型转换与原来的
+// Json::CharReader默认设置一致(注释、末尾的逗号等)，见test/signaling_request_test.cpp。
+// body不是合法的json对象，或者字段类型不对时返回-1，err中为错误原因
+int ParseSignalingRequest(const char* data, size_t len,
+        SignalingRequest* req, std::string* err);
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_SERVER_SIGNALING_REQUEST_H_
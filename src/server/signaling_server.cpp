@@ -78,6 +78,7 @@ int SignalingServer::Init(const char* conf_file) {
         options_.port = config["port"].as<int>();
         options_.worker_num = config["worker_num"].as<int>();
         options_.connection_timeout = config["connection_timeout"].as<int>();
+        options_.reuse_port = config["reuse_port"].as<bool>(false);
 
     } catch (const YAML::Exception& e) {
         RTC_LOG(LS_WARNING) << "catch a YAML exception, line:" << e.mark.line + 1
@@ -99,15 +100,17 @@ int SignalingServer::Init(const char* conf_file) {
     pipe_watcher_ = el_->CreateIOEvent(SignalingServerRecvNotify, this);
     el_->StartIOEvent(pipe_watcher_, notify_recv_fd_, EventLoop::READ);
 
-    // 创建tcp server
-    listen_fd_ = CreateTcpServer(options_.host.c_str(), options_.port); 
-    if (-1 == listen_fd_) {
-        return -1;
+    // 创建tcp server，reuse_port模式下由worker各自监听
+    if (!options_.reuse_port) {
+        listen_fd_ = CreateTcpServer(options_.host.c_str(), options_.port); 
+        if (-1 == listen_fd_) {
+            return -1;
+        }
+        
+        io_watcher_ = el_->CreateIOEvent(AcceptNewConn, this); 
+        el_->StartIOEvent(io_watcher_, listen_fd_, EventLoop::READ); 
     }
     
-    io_watcher_ = el_->CreateIOEvent(AcceptNewConn, this); 
-    el_->StartIOEvent(io_watcher_, listen_fd_, EventLoop::READ); 
-    
     // 创建worker
     for (int i = 0; i < options_.worker_num; ++i) {
         if (CreateWorker(i) != 0) {
@@ -188,12 +191,18 @@ void SignalingServer::InnerStop() {
     }
 
     el_->DeleteIOEvent(pipe_watcher_);
-    el_->DeleteIOEvent(io_watcher_);
+    if (io_watcher_) {
+        el_->DeleteIOEvent(io_watcher_);
+        io_watcher_ = nullptr;
+    }
     el_->Stop();
 
     close(notify_recv_fd_);
     close(notify_send_fd_);
-    close(listen_fd_);
+    if (listen_fd_ != -1) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
 
     RTC_LOG(LS_INFO) << "signaling server stop";
 
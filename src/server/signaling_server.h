@@ -16,6 +16,8 @@ struct SignalingServerOptions {
     int port;
     int worker_num;
     int connection_timeout;
+    // 每个worker各自用SO_REUSEPORT监听，直接accept，不经过server线程转发
+    bool reuse_port = false;
 };
 
 class SignalingServer {
@@ -29,6 +31,7 @@ public:
     
     int Init(const char* conf_file);
     bool Start();
+    int worker_num() const { return options_.worker_num; }
     void Stop();
     int Notify(int msg);
     void Join();
@@ -2,18 +2,32 @@
 
 #include <unistd.h>
 
-#include <rtc_base/zmalloc.h>
+#include <algorithm>
+
 #include <rtc_base/logging.h>
 
 #include "xrtcserver_def.h"
+#include "base/conf.h"
+#include "base/metrics.h"
 #include "base/socket.h"
+#include "pc/remote_description.h"
 #include "server/tcp_connection.h"
 #include "server/rtc_server.h"
 
 extern xrtc::RtcServer* g_rtc_server;
+extern xrtc::GeneralConf* g_conf;
 
 namespace xrtc {
 
+namespace {
+
+// 每次至少读取这么多字节，长连接上多个请求可以一次读入
+const size_t kMinReadSize = 4096;
+const uint32_t kMaxRequestBodySize = 1024 * 1024;
+const int kMaxWriteIovecs = 64;
+
+} // namespace
+
 void SignalingWorkerRecvNotify(EventLoop* /*el*/, IOWatcher* /*w*/, int fd, 
         int /*events*/, void *data) 
 {
@@ -28,6 +42,31 @@ void SignalingWorkerRecvNotify(EventLoop* /*el*/, IOWatcher* /*w*/, int fd,
     worker->ProcessNotify(msg);
 }
 
+void WorkerAcceptNewConn(EventLoop* /*el*/, IOWatcher* /*w*/, int fd,
+        int /*events*/, void* data)
+{
+    int cfd;
+    char cip[128];
+    int cport;
+
+    cfd = TcpAccept(fd, cip, &cport);
+    if (-1 == cfd) {
+        return;
+    }
+
+    SignalingWorker* worker = (SignalingWorker*)data;
+    RTC_LOG(LS_INFO) << "signaling worker " << worker->worker_id_
+        << " accept new conn, fd: " << cfd << ", ip: " << cip
+        << ", port: " << cport;
+
+    worker->NewConn(cfd);
+}
+
+void SignalingWorkerMetricsCb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+    SignalingWorker* worker = (SignalingWorker*)data;
+    worker->DumpMetrics();
+}
+
 SignalingWorker::SignalingWorker(int worker_id, const SignalingServerOptions& options) :
     worker_id_(worker_id),
     options_(options),
@@ -69,6 +108,23 @@ int SignalingWorker::Init() {
     pipe_watcher_ = el_->CreateIOEvent(SignalingWorkerRecvNotify, this);
     el_->StartIOEvent(pipe_watcher_, notify_recv_fd_, EventLoop::READ);
 
+    // 流的分配在signaling worker线程中进行，统计数据也在这里输出
+    if (g_conf->metrics_dump_interval > 0) {
+        metrics_watcher_ = el_->CreateTimer(SignalingWorkerMetricsCb, this, true);
+        el_->StartTimer(metrics_watcher_, g_conf->metrics_dump_interval * 1000);
+    }
+
+    // 每个worker监听同一个端口，内核负责分配连接
+    if (options_.reuse_port) {
+        listen_fd_ = CreateTcpServer(options_.host.c_str(), options_.port, true);
+        if (-1 == listen_fd_) {
+            return -1;
+        }
+
+        listen_watcher_ = el_->CreateIOEvent(WorkerAcceptNewConn, this);
+        el_->StartIOEvent(listen_watcher_, listen_fd_, EventLoop::READ);
+    }
+
     return 0;
 }
 
@@ -103,10 +159,29 @@ void SignalingWorker::InnerStop() {
     }
 
     el_->DeleteIOEvent(pipe_watcher_);
+    if (metrics_watcher_) {
+        el_->DeleteTimer(metrics_watcher_);
+        metrics_watcher_ = nullptr;
+    }
+    if (listen_watcher_) {
+        el_->DeleteIOEvent(listen_watcher_);
+        listen_watcher_ = nullptr;
+    }
     el_->Stop();
 
     close(notify_recv_fd_);
     close(notify_send_fd_);
+    if (listen_fd_ != -1) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+void SignalingWorker::DumpMetrics() {
+    Metrics* metrics = Metrics::ThreadInstance();
+    RTC_LOG(LS_INFO) << "signaling worker metrics, worker_id: " << worker_id_
+        << ", " << metrics->ToString();
+    metrics->Reset();
 }
 
 void SignalingWorker::ResponseServerOffer(std::shared_ptr<RtcMsg> msg) {
@@ -124,17 +199,7 @@ void SignalingWorker::ResponseServerOffer(std::shared_ptr<RtcMsg> msg) {
         return;
     }
 
-    // 构造响应头
-    xhead_t* xh = (xhead_t*)(c->querybuf);
-    rtc::Slice header(c->querybuf, XHEAD_SIZE);
-    char* buf = (char*)zmalloc(XHEAD_SIZE + MAX_RES_BUF);
-    if (!buf) {
-        RTC_LOG(LS_WARNING) << "zmalloc error, log_id: " << xh->log_id;
-        return;
-    }
-
-    memcpy(buf, header.data(), header.size());
-    xhead_t* res_xh = (xhead_t*)buf;
+    --c->pending_requests;
 
     Json::Value res_root;
     res_root["err_no"] = msg->err_no;
@@ -146,19 +211,21 @@ void SignalingWorker::ResponseServerOffer(std::shared_ptr<RtcMsg> msg) {
         res_root["offer"] = msg->sdp;
     }
 
-    Json::StreamWriterBuilder write_builder;
-    write_builder.settings_["indentation"] = "";
-    std::string json_data = Json::writeString(write_builder, res_root);
-    RTC_LOG(LS_INFO) << "response body: " << json_data;
-
-    res_xh->body_len = json_data.size();
-    snprintf(buf + XHEAD_SIZE, MAX_RES_BUF, "%s", json_data.c_str());
+    // 长连接上querybuf中已经是后续的请求，使用请求时保存的xhead构造响应头
+    SignalingReply reply;
+    reply.header = msg->header;
+    // sdp中的换行转义之后会变长，不够时再扩容
+    if (BuildJsonReply(&reply_pool_, res_root, msg->sdp.size() + 128, &reply) != 0) {
+        RTC_LOG(LS_WARNING) << "build reply error, log_id: " << msg->header.log_id;
+        return;
+    }
 
-    rtc::Slice reply(buf, XHEAD_SIZE + res_xh->body_len);
+    RTC_LOG(LS_INFO) << "response body: "
+        << std::string(reply.body, reply.header.body_len);
     AddReply(c, reply);
 }
 
-void SignalingWorker::AddReply(TcpConnection* c, const rtc::Slice& reply) {
+void SignalingWorker::AddReply(TcpConnection* c, const SignalingReply& reply) {
     c->reply_list.push_back(reply);
     el_->StartIOEvent(c->io_watcher, c->fd, EventLoop::WRITE);
 }
@@ -236,24 +303,57 @@ void SignalingWorker::WriteReply(int fd) {
     }
     
     while (!c->reply_list.empty()) {
-        rtc::Slice reply = c->reply_list.front();
-        int nwritten = SockWriteData(c->fd, reply.data() + c->cur_resp_pos,
-                reply.size() - c->cur_resp_pos);
+        // 每个响应的xhead和body各占一个iovec，一次writev发送所有待发送的响应
+        struct iovec iov[kMaxWriteIovecs];
+        int iovcnt = 0;
+        size_t skip = c->cur_resp_pos;
+        for (auto it = c->reply_list.begin();
+                it != c->reply_list.end() && iovcnt + 2 <= kMaxWriteIovecs; ++it)
+        {
+            if (skip < XHEAD_SIZE) {
+                iov[iovcnt].iov_base = (char*)&it->header + skip;
+                iov[iovcnt].iov_len = XHEAD_SIZE - skip;
+                ++iovcnt;
+                skip = 0;
+            } else {
+                skip -= XHEAD_SIZE;
+            }
+
+            if (it->header.body_len > skip) {
+                iov[iovcnt].iov_base = it->body + skip;
+                iov[iovcnt].iov_len = it->header.body_len - skip;
+                ++iovcnt;
+            }
+            skip = 0;
+        }
+
+        int nwritten = SockWritevData(c->fd, iov, iovcnt);
         if (-1 == nwritten) {
             CloseConn(c);
             return;
         } else if (0 == nwritten) {
+            // 发送缓冲区满，等待下一次可写事件
             RTC_LOG(LS_WARNING) << "write zero bytes, fd: " << c->fd
                 << ", worker_id: " << worker_id_;
-        } else if ((nwritten + c->cur_resp_pos) >= reply.size()) {
+            break;
+        }
+
+        size_t remain = nwritten;
+        while (remain > 0 && !c->reply_list.empty()) {
+            SignalingReply& reply = c->reply_list.front();
+            size_t left = reply.size() - c->cur_resp_pos;
+            if (remain < left) {
+                c->cur_resp_pos += remain;
+                break;
+            }
+
             // 写入完成
+            remain -= left;
+            FreeReply(&reply_pool_, &reply);
             c->reply_list.pop_front();
-            zfree((void*)reply.data());
             c->cur_resp_pos = 0;
             RTC_LOG(LS_INFO) << "write finished, fd: " << c->fd
                 << ", worker_id: " << worker_id_;
-        } else {
-            c->cur_resp_pos += nwritten;
         }
     }
 
@@ -266,6 +366,11 @@ void SignalingWorker::WriteReply(int fd) {
 }
 
 void SignalingWorker::ProcessTimeout(TcpConnection* c) {
+    // 等待rtc worker处理的请求还没有响应
+    if (c->pending_requests > 0) {
+        return;
+    }
+
     if (el_->now() - c->last_interaction >= (unsigned long)options_.connection_timeout) {
         RTC_LOG(LS_INFO) << "connection timeout, fd: " << c->fd; 
         CloseConn(c);
@@ -311,7 +416,7 @@ void SignalingWorker::ReadQuery(int fd) {
 
     TcpConnection* c = conns_[fd];
     int nread = 0;
-    int read_len = c->bytes_expected;
+    int read_len = std::max(c->bytes_expected, kMinReadSize);
     int qb_len = sdslen(c->querybuf);
     c->querybuf = sdsMakeRoomFor(c->querybuf, read_len);
     nread = SockReadData(fd, c->querybuf + qb_len, read_len);
@@ -344,35 +449,58 @@ void SignalingWorker::RemoveConn(TcpConnection* c) {
     el_->DeleteTimer(c->timer_watcher);
     el_->DeleteIOEvent(c->io_watcher);
     conns_[c->fd] = nullptr;
+    for (auto& reply : c->reply_list) {
+        FreeReply(&reply_pool_, &reply);
+    }
+    c->reply_list.clear();
     delete c;
 }
 
 int SignalingWorker::ProcessQueryBuffer(TcpConnection* c) {
+    // 长连接，一个连接上可以连续发送多个请求，不需要等待上一个请求的响应
+    size_t request_start = 0;
     while (sdslen(c->querybuf) >= c->bytes_processed + c->bytes_expected) {
-        xhead_t* head = (xhead_t*)(c->querybuf);
+        // 请求在querybuf中不一定对齐，拷贝出xhead再访问
+        xhead_t head;
+        memcpy(&head, c->querybuf + request_start, XHEAD_SIZE);
         if (TcpConnection::STATE_HEAD == c->current_state) {
-            if (XHEAD_MAGIC_NUM != head->magic_num) {
+            if (XHEAD_MAGIC_NUM != head.magic_num) {
                 RTC_LOG(LS_WARNING) << "invalid data, fd: " << c->fd;
                 return -1;
             }
 
+            if (head.body_len > kMaxRequestBodySize) {
+                RTC_LOG(LS_WARNING) << "request body too large, fd: " << c->fd
+                    << ", body_len: " << head.body_len
+                    << ", log_id: " << head.log_id;
+                return -1;
+            }
+
             c->current_state = TcpConnection::STATE_BODY;
-            c->bytes_processed = XHEAD_SIZE;
-            c->bytes_expected = head->body_len;
+            c->bytes_processed += XHEAD_SIZE;
+            c->bytes_expected = head.body_len;
         } else {
-            rtc::Slice header(c->querybuf, XHEAD_SIZE);
-            rtc::Slice body(c->querybuf + XHEAD_SIZE, head->body_len);
+            rtc::Slice header(c->querybuf + request_start, XHEAD_SIZE);
+            rtc::Slice body(c->querybuf + c->bytes_processed, head.body_len);
 
             int ret = ProcessRequest(c, header, body);
             if (ret != 0) {
                 return -1;
             }
 
-            // 短连接处理
-            c->bytes_processed = 65535;
+            c->bytes_processed += head.body_len;
+            c->current_state = TcpConnection::STATE_HEAD;
+            c->bytes_expected = XHEAD_SIZE;
+            request_start = c->bytes_processed;
         }
     }
 
+    // 移除已经处理完的请求，未处理完的请求移动到querybuf的开头
+    if (request_start > 0) {
+        sdsrange(c->querybuf, request_start, -1);
+        c->bytes_processed -= request_start;
+    }
+
     return 0;
 }
 
@@ -380,45 +508,36 @@ int SignalingWorker::ProcessRequest(TcpConnection* c,
         const rtc::Slice& header,
         const rtc::Slice& body)
 {
-    RTC_LOG(LS_INFO) << "receive body: " << body.data();
+    RTC_LOG(LS_INFO) << "receive body: " << std::string(body.data(), body.size());
    
-    xhead_t* xh = (xhead_t*)(header.data());
-
-    Json::CharReaderBuilder builder;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-    Json::Value root;
-    JSONCPP_STRING err;
-    reader->parse(body.data(), body.data() + body.size(), &root, &err);
-    if (!err.empty()) {
+    xhead_t xh_copy;
+    memcpy(&xh_copy, header.data(), XHEAD_SIZE);
+    xhead_t* xh = &xh_copy;
+
+    // 只解析信令用到的字段，request_在请求之间复用
+    std::string err;
+    if (ParseSignalingRequest(body.data(), body.size(), &request_, &err) != 0) {
         RTC_LOG(LS_WARNING) << "parse json body error: " << err << ", fd" << c->fd
             << ", log_id: " << xh->log_id;
         return -1;
     }
    
     int ret = 0;
-
-    int cmdno;
-    try {
-        cmdno = root["cmdno"].asInt();
-
-    } catch (const Json::Exception& e) {
-        RTC_LOG(LS_WARNING) << "no cmdno field in body, log_id: " << xh->log_id;
-        return -1;
-    }
+    int cmdno = request_.cmdno;
     
     switch (cmdno) {
         case CMDNO_PUSH:
-            return ProcessPush(cmdno, c, root, xh->log_id);
+            return ProcessPush(cmdno, c, request_, *xh);
         case CMDNO_PULL:
-            return ProcessPull(cmdno, c, root, xh->log_id);
+            return ProcessPull(cmdno, c, request_, *xh);
         case CMDNO_STOPPUSH:
-            ret = ProcessStopPush(cmdno, c, root, xh->log_id);
+            ret = ProcessStopPush(cmdno, c, request_, xh->log_id);
             break; 
         case CMDNO_STOPPULL:
-            ret = ProcessStopPull(cmdno, c, root, xh->log_id);
+            ret = ProcessStopPull(cmdno, c, request_, xh->log_id);
             break; 
         case CMDNO_ANSWER:
-            ret = ProcessAnswer(cmdno, c, root, xh->log_id);
+            ret = ProcessAnswer(cmdno, c, request_, xh->log_id);
             break;
         default:
             ret = -1;
@@ -427,10 +546,6 @@ int SignalingWorker::ProcessRequest(TcpConnection* c,
     }
     
     // 返回处理结果
-    char* buf = (char*)zmalloc(XHEAD_SIZE + MAX_RES_BUF);
-    xhead_t* res_xh = (xhead_t*)buf;
-    memcpy(res_xh, header.data(), header.size());
-    
     Json::Value res_root;
     if (0 == ret) {
         res_root["err_no"] = 0;
@@ -439,198 +554,149 @@ int SignalingWorker::ProcessRequest(TcpConnection* c,
         res_root["err_no"] = -1;
         res_root["err_msg"] = "process error";
     }
-    
-    Json::StreamWriterBuilder write_builder;
-    write_builder.settings_["indentation"] = "";
-    std::string json_data = Json::writeString(write_builder, res_root);
-    RTC_LOG(LS_INFO) << "response body: " << json_data;
-    
-    res_xh->body_len = json_data.size();
-    snprintf(buf + XHEAD_SIZE, MAX_RES_BUF, "%s", json_data.c_str());
-    
-    rtc::Slice reply(buf, XHEAD_SIZE + res_xh->body_len);
+
+    SignalingReply reply;
+    memcpy(&reply.header, header.data(), XHEAD_SIZE);
+    if (BuildJsonReply(&reply_pool_, res_root, 0, &reply) != 0) {
+        RTC_LOG(LS_WARNING) << "build reply error, log_id: " << xh->log_id;
+        return -1;
+    }
+
+    RTC_LOG(LS_INFO) << "response body: "
+        << std::string(reply.body, reply.header.body_len);
     AddReply(c, reply);
 
     return 0;
 }
 
 int SignalingWorker::ProcessPush(int cmdno, TcpConnection* c,
-        const Json::Value& root, uint32_t log_id)
+        const SignalingRequest& req, const xhead_t& header)
 {
-    uint64_t uid;
-    std::string stream_name;
-    int audio;
-    int video;
-    int is_dtls;
-
-    try {
-        uid = root["uid"].asUInt64();
-        stream_name = root["stream_name"].asString();
-        audio = root["audio"].asInt();
-        video = root["video"].asInt();
-        is_dtls = root["is_dtls"].asInt();
-    } catch (const Json::Exception& e) {
-        RTC_LOG(LS_WARNING) << "parse json body error: " << e.what()
-            << "log_id: " << log_id;
-        return -1;
-    }
+    uint32_t log_id = header.log_id;
     
     RTC_LOG(LS_INFO) << "cmdno: " << cmdno 
-        << " uid: " << uid 
-        << " stream_name: " << stream_name 
-        << " auido: " << audio 
-        << " video: " << video 
-        << " is_dtls: " << is_dtls
+        << " uid: " << req.uid 
+        << " stream_name: " << req.stream_name 
+        << " auido: " << req.audio 
+        << " video: " << req.video 
+        << " is_dtls: " << req.is_dtls
         << " signaling server push request";
     
     std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
     msg->cmdno = cmdno;
-    msg->uid = uid;
-    msg->stream_name = stream_name;
-    msg->audio = audio;
-    msg->video = video;
-    msg->is_dtls = is_dtls;
+    msg->uid = req.uid;
+    msg->stream_name = req.stream_name;
+    msg->audio = req.audio;
+    msg->video = req.video;
+    msg->is_dtls = req.is_dtls;
     msg->log_id = log_id;
     msg->worker = this;
     msg->conn = c;
     msg->fd = c->fd;
+    msg->header = header;
+
+    int ret = g_rtc_server->SendRtcMsg(worker_id_, msg);
+    if (0 == ret) {
+        ++c->pending_requests;
+    }
 
-    return g_rtc_server->SendRtcMsg(msg);
+    return ret;
 }
 
 int SignalingWorker::ProcessPull(int cmdno, TcpConnection* c,
-        const Json::Value& root, uint32_t log_id)
+        const SignalingRequest& req, const xhead_t& header)
 {
-    uint64_t uid;
-    std::string stream_name;
-    int audio;
-    int video;
-    int is_dtls;
-
-    try {
-        uid = root["uid"].asUInt64();
-        stream_name = root["stream_name"].asString();
-        audio = root["audio"].asInt();
-        video = root["video"].asInt();
-        is_dtls = root["is_dtls"].asInt();
-    } catch (const Json::Exception& e) {
-        RTC_LOG(LS_WARNING) << "parse json body error: " << e.what()
-            << "log_id: " << log_id;
-        return -1;
-    }
+    uint32_t log_id = header.log_id;
     
+    // skip_silent_audio为可选字段，拉流端选择是否跳过静音包
     RTC_LOG(LS_INFO) << "cmdno: " << cmdno 
-        << " uid: " << uid 
-        << " stream_name: " << stream_name 
-        << " auido: " << audio 
-        << " video: " << video 
-        << " is_dtls: " << is_dtls
+        << " uid: " << req.uid 
+        << " stream_name: " << req.stream_name 
+        << " auido: " << req.audio 
+        << " video: " << req.video 
+        << " is_dtls: " << req.is_dtls
+        << " skip_silent_audio: " << req.skip_silent_audio
         << " signaling server pull request";
     
     std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
     msg->cmdno = cmdno;
-    msg->uid = uid;
-    msg->stream_name = stream_name;
-    msg->audio = audio;
-    msg->video = video;
-    msg->is_dtls = is_dtls;
+    msg->uid = req.uid;
+    msg->stream_name = req.stream_name;
+    msg->audio = req.audio;
+    msg->video = req.video;
+    msg->is_dtls = req.is_dtls;
+    msg->skip_silent_audio = req.skip_silent_audio;
     msg->log_id = log_id;
     msg->worker = this;
     msg->conn = c;
     msg->fd = c->fd;
+    msg->header = header;
 
-    return g_rtc_server->SendRtcMsg(msg);
+    int ret = g_rtc_server->SendRtcMsg(worker_id_, msg);
+    if (0 == ret) {
+        ++c->pending_requests;
+    }
+
+    return ret;
 }
 
 int SignalingWorker::ProcessStopPush(int cmdno, TcpConnection* /*c*/,
-        const Json::Value& root, uint32_t log_id)
+        const SignalingRequest& req, uint32_t log_id)
 {
-    uint64_t uid;
-    std::string stream_name;
-    
-    try {
-        uid = root["uid"].asUInt64();
-        stream_name = root["stream_name"].asString();
-    } catch (const Json::Exception& e) {
-        RTC_LOG(LS_WARNING) << "parse json body error: " << e.what()
-            << "log_id: " << log_id;
-        return -1;
-    }
-    
-    RTC_LOG(LS_INFO) << "cmdno[" << cmdno << "] uid[" << uid 
-        << "] stream_name[" << stream_name 
+    RTC_LOG(LS_INFO) << "cmdno[" << cmdno << "] uid[" << req.uid 
+        << "] stream_name[" << req.stream_name 
         << "] signaling server send stop push request";
     
     std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
     msg->cmdno = cmdno;
-    msg->uid = uid;
-    msg->stream_name = stream_name;
+    msg->uid = req.uid;
+    msg->stream_name = req.stream_name;
     msg->log_id = log_id;
 
-    return g_rtc_server->SendRtcMsg(msg);
+    return g_rtc_server->SendRtcMsg(worker_id_, msg);
 }
 
 int SignalingWorker::ProcessStopPull(int cmdno, TcpConnection* /*c*/,
-        const Json::Value& root, uint32_t log_id)
+        const SignalingRequest& req, uint32_t log_id)
 {
-    uint64_t uid;
-    std::string stream_name;
-    
-    try {
-        uid = root["uid"].asUInt64();
-        stream_name = root["stream_name"].asString();
-    } catch (const Json::Exception& e) {
-        RTC_LOG(LS_WARNING) << "parse json body error: " << e.what()
-            << "log_id: " << log_id;
-        return -1;
-    }
-    
-    RTC_LOG(LS_INFO) << "cmdno[" << cmdno << "] uid[" << uid 
-        << "] stream_name[" << stream_name 
+    RTC_LOG(LS_INFO) << "cmdno[" << cmdno << "] uid[" << req.uid 
+        << "] stream_name[" << req.stream_name 
         << "] signaling server send stop pull request";
     
     std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
     msg->cmdno = cmdno;
-    msg->uid = uid;
-    msg->stream_name = stream_name;
+    msg->uid = req.uid;
+    msg->stream_name = req.stream_name;
     msg->log_id = log_id;
 
-    return g_rtc_server->SendRtcMsg(msg);
+    return g_rtc_server->SendRtcMsg(worker_id_, msg);
 }
 
 int SignalingWorker::ProcessAnswer(int cmdno, TcpConnection* /*c*/,
-        const Json::Value& root, uint32_t log_id)
+        const SignalingRequest& req, uint32_t log_id)
 {
-    uint64_t uid;
-    std::string stream_name;
-    std::string answer;
-    std::string stream_type;
+    RTC_LOG(LS_INFO) << "cmdno[" << cmdno << "] uid[" << req.uid 
+        << "] stream_name[" << req.stream_name 
+        << "] answer[" << req.answer 
+        << "] stream_type[" << req.type << "] signaling server send answer request";
     
-    try {
-        uid = root["uid"].asUInt64();
-        stream_name = root["stream_name"].asString();
-        answer = root["answer"].asString();
-        stream_type = root["type"].asString();
-    } catch (const Json::Exception& e) {
-        RTC_LOG(LS_WARNING) << "parse json body error: " << e.what()
-            << "log_id: " << log_id;
+    // 在signaling线程中解析answer，rtc worker的事件循环只负责应用
+    std::shared_ptr<RemoteDescription> remote_desc = ParseRemoteDescription(req.answer);
+    if (!remote_desc) {
+        RTC_LOG(LS_WARNING) << "parse answer error, uid: " << req.uid
+            << ", stream_name: " << req.stream_name << ", log_id: " << log_id;
         return -1;
     }
-    
-    RTC_LOG(LS_INFO) << "cmdno[" << cmdno << "] uid[" << uid 
-        << "] stream_name[" << stream_name 
-        << "] answer[" << answer 
-        << "] stream_type[" << stream_type << "] signaling server send answer request";
-    
+
     std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
     msg->cmdno = cmdno;
-    msg->uid = uid;
-    msg->stream_name = stream_name;
-    msg->sdp = answer;
-    msg->stream_type = stream_type;
+    msg->uid = req.uid;
+    msg->stream_name = req.stream_name;
+    msg->remote_desc = std::move(remote_desc);
+    msg->stream_type = req.type;
     msg->log_id = log_id;
 
-    return g_rtc_server->SendRtcMsg(msg);
+    return g_rtc_server->SendRtcMsg(worker_id_, msg);
 }
 
 int SignalingWorker::NotifyNewConn(int fd) {
@@ -12,6 +12,8 @@
 #include "base/lock_free_queue.h"
 #include "base/event_loop.h"
 #include "server/signaling_server.h"
+#include "server/signaling_reply.h"
+#include "server/signaling_request.h"
 
 namespace xrtc {
 
@@ -42,11 +44,16 @@ public:
         int events, void *data);
 
     friend void ConnIOCb(EventLoop*, IOWatcher*, int fd, int events, void* data);
+    friend void SignalingWorkerMetricsCb(EventLoop* el, TimerWatcher* w,
+            void* data);
+    friend void WorkerAcceptNewConn(EventLoop* el, IOWatcher* w,
+            int fd, int events, void* data);
     friend void ConnTimeCb(EventLoop* el, TimerWatcher* /*w*/, void* data);
 
 private:
     void ProcessNotify(int msg);
     void InnerStop();
+    void DumpMetrics();
     void NewConn(int fd);
     void ReadQuery(int fd);
     int ProcessQueryBuffer(TcpConnection* c);
@@ -57,18 +64,18 @@ private:
     void RemoveConn(TcpConnection* c);
     void ProcessTimeout(TcpConnection* c);
     int ProcessPush(int cmdno, TcpConnection* c,
-            const Json::Value& root, uint32_t log_id);
+            const SignalingRequest& req, const xhead_t& header);
     int ProcessPull(int cmdno, TcpConnection* c,
-            const Json::Value& root, uint32_t log_id);
+            const SignalingRequest& req, const xhead_t& header);
     int ProcessStopPush(int cmdno, TcpConnection* c,
-            const Json::Value& root, uint32_t log_id);
+            const SignalingRequest& req, uint32_t log_id);
     int ProcessStopPull(int cmdno, TcpConnection* c,
-            const Json::Value& root, uint32_t log_id);
+            const SignalingRequest& req, uint32_t log_id);
     int ProcessAnswer(int cmdno, TcpConnection* c,
-            const Json::Value& root, uint32_t log_id);
+            const SignalingRequest& req, uint32_t log_id);
     void ProcessRtcMsg();
     void ResponseServerOffer(std::shared_ptr<RtcMsg> msg);
-    void AddReply(TcpConnection* c, const rtc::Slice& reply);
+    void AddReply(TcpConnection* c, const SignalingReply& reply);
     void WriteReply(int fd);
 
 private:
@@ -76,12 +83,18 @@ private:
     SignalingServerOptions options_;
     EventLoop* el_;
     IOWatcher* pipe_watcher_ = nullptr;
+    TimerWatcher* metrics_watcher_ = nullptr;
     int notify_recv_fd_ = -1;
     int notify_send_fd_ = -1;
+    // reuse_port模式下worker自己的监听socket
+    int listen_fd_ = -1;
+    IOWatcher* listen_watcher_ = nullptr;
 
     std::thread* thread_ = nullptr;
     LockFreeQueue<int> q_conn_;
     std::vector<TcpConnection*> conns_;
+    ReplyBufferPool reply_pool_;
+    SignalingRequest request_;
 
     std::queue<std::shared_ptr<RtcMsg>> q_msg_;
     std::mutex q_msg_mtx_;
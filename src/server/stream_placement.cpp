@@ -0,0 +1,300 @@
+#include "server/stream_placement.h"
+
+#include <algorithm>
+#include <functional>
+
+#include <rtc_base/crc32.h>
+
+#include "xrtcserver_def.h"
+#include "base/metrics.h"
+
+namespace xrtc {
+
+namespace {
+
+// 每个worker在环上的虚拟节点个数
+const int kVirtualNodes = 64;
+// 新推流在环上的候选worker个数
+const int kPlacementCandidates = 2;
+
+} // namespace
+
+StreamPlacement::StreamPlacement(int worker_num, bool fanout_enabled) :
+    worker_num_(worker_num),
+    fanout_enabled_(fanout_enabled),
+    loads_(new WorkerLoad[worker_num])
+{
+    for (int i = 0; i < worker_num_; ++i) {
+        for (int v = 0; v < kVirtualNodes; ++v) {
+            std::string node = std::to_string(i) + "#" + std::to_string(v);
+            ring_.emplace_back(rtc::ComputeCrc32(node), i);
+        }
+    }
+
+    std::sort(ring_.begin(), ring_.end());
+}
+
+StreamPlacement::DirectoryShard& StreamPlacement::ShardOf(
+        const std::string& stream_name)
+{
+    return shards_[std::hash<std::string>()(stream_name) % kDirectoryShards];
+}
+
+int StreamPlacement::PrimaryWorker(const std::string& stream_name) const {
+    uint32_t hash = rtc::ComputeCrc32(stream_name);
+    auto it = std::lower_bound(ring_.begin(), ring_.end(),
+            std::make_pair(hash, 0));
+    if (it == ring_.end()) {
+        it = ring_.begin();
+    }
+
+    return it->second;
+}
+
+// 以会话数为主，包速率和事件循环的延迟作为补充
+int64_t StreamPlacement::LoadScore(int worker_id) const {
+    const WorkerLoad& load = loads_[worker_id];
+    return (int64_t)load.sessions.load(std::memory_order_relaxed) * 100
+        + load.packets_per_sec.load(std::memory_order_relaxed) / 100
+        + (int64_t)load.loop_lag_ms.load(std::memory_order_relaxed) * 10;
+}
+
+int StreamPlacement::PlacePush(const std::string& stream_name) {
+    uint32_t hash = rtc::ComputeCrc32(stream_name);
+    size_t start = std::lower_bound(ring_.begin(), ring_.end(),
+            std::make_pair(hash, 0)) - ring_.begin();
+
+    // 顺时针找到前几个不同的worker
+    int candidates[kPlacementCandidates];
+    int num_candidates = 0;
+    for (size_t i = 0; i < ring_.size() && num_candidates < kPlacementCandidates; ++i) {
+        int worker_id = ring_[(start + i) % ring_.size()].second;
+        if (std::find(candidates, candidates + num_candidates, worker_id)
+                == candidates + num_candidates)
+        {
+            candidates[num_candidates++] = worker_id;
+        }
+    }
+
+    int best = candidates[0];
+    int64_t best_score = LoadScore(best);
+    for (int i = 1; i < num_candidates; ++i) {
+        int64_t score = LoadScore(candidates[i]);
+        if (score < best_score) {
+            best = candidates[i];
+            best_score = score;
+        }
+    }
+
+    // 上报之前先计入，避免短时间内大量推流都放到同一个worker
+    loads_[best].sessions.fetch_add(1, std::memory_order_relaxed);
+
+    Metrics* metrics = Metrics::ThreadInstance();
+    metrics->Increment("placement_push_placed");
+    if (best != candidates[0]) {
+        metrics->Increment("placement_push_spilled");
+    }
+    metrics->Observe("placement_push_load_score", best_score);
+
+    return best;
+}
+
+int StreamPlacement::PlacePull() {
+    int best = 0;
+    int64_t best_score = LoadScore(0);
+    for (int i = 1; i < worker_num_; ++i) {
+        int64_t score = LoadScore(i);
+        if (score < best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+
+    loads_[best].sessions.fetch_add(1, std::memory_order_relaxed);
+    Metrics::ThreadInstance()->Increment("placement_pull_placed");
+    return best;
+}
+
+std::string StreamPlacement::PullKey(uint64_t uid,
+        const std::string& stream_name) const
+{
+    return stream_name + "/" + std::to_string(uid);
+}
+
+// 调用者持有shard.mtx
+int StreamPlacement::RoutePull(DirectoryShard& shard, const RtcMsg& msg) {
+    std::string key = PullKey(msg.uid, msg.stream_name);
+    auto it = shard.pull_directory.find(key);
+    int worker_id;
+    if (CMDNO_PULL == msg.cmdno) {
+        if (it != shard.pull_directory.end()) {
+            worker_id = it->second;
+        } else {
+            worker_id = PlacePull();
+            shard.pull_directory[key] = worker_id;
+            pull_directory_size_.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        if (it == shard.pull_directory.end()) {
+            return PrimaryWorker(msg.stream_name);
+        }
+
+        worker_id = it->second;
+        if (CMDNO_STOPPULL == msg.cmdno) {
+            shard.pull_directory.erase(it);
+            pull_directory_size_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    Metrics::ThreadInstance()->SetGauge("placement_pull_directory_size",
+            pull_directory_size_.load(std::memory_order_relaxed));
+    return worker_id;
+}
+
+int StreamPlacement::Route(const RtcMsg& msg) {
+    int cmdno = msg.cmdno;
+    const std::string& stream_name = msg.stream_name;
+    DirectoryShard& shard = ShardOf(stream_name);
+    std::unique_lock<std::mutex> lock(shard.mtx);
+
+    // 开启fanout时拉流单独放置，推流的其他worker通过fanout订阅
+    if (fanout_enabled_ && (CMDNO_PULL == cmdno || CMDNO_STOPPULL == cmdno
+                || (CMDNO_ANSWER == cmdno && "pull" == msg.stream_type)))
+    {
+        return RoutePull(shard, msg);
+    }
+
+    std::unordered_map<std::string, Entry>& directory = shard.directory;
+    auto it = directory.find(stream_name);
+    Metrics* metrics = Metrics::ThreadInstance();
+    metrics->Increment(it != directory.end() ? "placement_directory_hit"
+            : "placement_directory_miss");
+
+    int worker_id;
+    switch (cmdno) {
+        case CMDNO_PUSH:
+            if (it == directory.end()) {
+                it = directory.emplace(stream_name, Entry()).first;
+                it->second.worker_id = PlacePush(stream_name);
+                directory_size_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // 重新推流时沿用原来的worker，已经有拉流在上面
+            it->second.has_push = true;
+            it->second.push_uid = msg.uid;
+            worker_id = it->second.worker_id;
+            break;
+        case CMDNO_PULL:
+            if (it == directory.end()) {
+                // 先拉流后推流时，推流跟随拉流所在的worker
+                it = directory.emplace(stream_name, Entry()).first;
+                it->second.worker_id = PrimaryWorker(stream_name);
+                directory_size_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // 重试的拉流请求不重复计数
+            it->second.pull_uids.insert(msg.uid);
+            worker_id = it->second.worker_id;
+            break;
+        case CMDNO_STOPPUSH:
+        case CMDNO_STOPPULL:
+            worker_id = (it != directory.end()) ? it->second.worker_id
+                : PrimaryWorker(stream_name);
+            if (CMDNO_STOPPUSH == cmdno) {
+                RemovePush(shard, msg.uid, stream_name);
+            } else {
+                RemovePull(shard, msg.uid, stream_name);
+            }
+            break;
+        default:
+            worker_id = (it != directory.end()) ? it->second.worker_id
+                : PrimaryWorker(stream_name);
+            break;
+    }
+
+    metrics->SetGauge("placement_directory_size",
+            directory_size_.load(std::memory_order_relaxed));
+    return worker_id;
+}
+
+// 调用者持有shard.mtx
+void StreamPlacement::RemovePush(DirectoryShard& shard, uint64_t uid,
+        const std::string& stream_name)
+{
+    auto it = shard.directory.find(stream_name);
+    // 同一个流已经被其他uid重新推流
+    if (it == shard.directory.end() || uid != it->second.push_uid) {
+        return;
+    }
+
+    it->second.has_push = false;
+    if (it->second.pull_uids.empty()) {
+        shard.directory.erase(it);
+        directory_size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// 调用者持有shard.mtx
+void StreamPlacement::RemovePull(DirectoryShard& shard, uint64_t uid,
+        const std::string& stream_name)
+{
+    if (fanout_enabled_) {
+        if (shard.pull_directory.erase(PullKey(uid, stream_name)) > 0) {
+            pull_directory_size_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    auto it = shard.directory.find(stream_name);
+    if (it == shard.directory.end()) {
+        return;
+    }
+
+    it->second.pull_uids.erase(uid);
+    if (!it->second.has_push && it->second.pull_uids.empty()) {
+        shard.directory.erase(it);
+        directory_size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void StreamPlacement::OnStreamRemoved(uint64_t uid, const std::string& stream_name,
+        bool is_push)
+{
+    DirectoryShard& shard = ShardOf(stream_name);
+    {
+        std::unique_lock<std::mutex> lock(shard.mtx);
+        if (is_push) {
+            RemovePush(shard, uid, stream_name);
+        } else {
+            RemovePull(shard, uid, stream_name);
+        }
+    }
+
+    Metrics* metrics = Metrics::ThreadInstance();
+    metrics->Increment("placement_stream_removed");
+    metrics->SetGauge("placement_directory_size",
+            directory_size_.load(std::memory_order_relaxed));
+    metrics->SetGauge("placement_pull_directory_size",
+            pull_directory_size_.load(std::memory_order_relaxed));
+}
+
+void StreamPlacement::UpdateLoad(int worker_id, int sessions, int packets_per_sec,
+        int loop_lag_ms)
+{
+    if (worker_id < 0 || worker_id >= worker_num_) {
+        return;
+    }
+
+    WorkerLoad& load = loads_[worker_id];
+    load.sessions.store(sessions, std::memory_order_relaxed);
+    load.packets_per_sec.store(packets_per_sec, std::memory_order_relaxed);
+    load.loop_lag_ms.store(loop_lag_ms, std::memory_order_relaxed);
+
+    Metrics* metrics = Metrics::ThreadInstance();
+    metrics->SetGauge("placement_worker_sessions", sessions);
+    metrics->SetGauge("placement_worker_packets_per_sec", packets_per_sec);
+    metrics->SetGauge("placement_worker_loop_lag_ms", loop_lag_ms);
+    metrics->SetGauge("placement_worker_load_score", LoadScore(worker_id));
+}
+
+} // namespace xrtc
@@ -0,0 +1,89 @@
+#ifndef  __XRTCSERVER_SERVER_STREAM_PLACEMENT_H_
+#define  __XRTCSERVER_SERVER_STREAM_PLACEMENT_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace xrtc {
+
+struct RtcMsg;
+
+// 决定流由哪个rtc worker处理。
+// worker按虚拟节点放在一致性哈希环上，新的推流在环上顺时针的前几个worker中
+// 选择负载最低的一个，拉流、answer和停止请求通过流到worker的目录跟随推流。
+// 开启fanout时拉流不需要和推流在同一个worker，放到负载最低的worker上。
+// 由signaling worker线程调用Route，rtc worker线程调用UpdateLoad和OnStreamRemoved。
+// 目录按stream_name的哈希分片，每个分片一把锁，不同流的请求互不阻塞
+class StreamPlacement {
+public:
+    StreamPlacement(int worker_num, bool fanout_enabled);
+
+    // 返回处理该请求的worker编号
+    int Route(const RtcMsg& msg);
+    // rtc worker周期性上报的负载
+    void UpdateLoad(int worker_id, int sessions, int packets_per_sec,
+            int loop_lag_ms);
+    // 没有经过stop请求就结束的流(创建失败、连接失败或异常)，由rtc worker上报，
+    // 和stop请求一样从目录中移除
+    void OnStreamRemoved(uint64_t uid, const std::string& stream_name, bool is_push);
+
+private:
+    struct WorkerLoad {
+        std::atomic<int> sessions{0};
+        std::atomic<int> packets_per_sec{0};
+        std::atomic<int> loop_lag_ms{0};
+    };
+
+    struct Entry {
+        int worker_id;
+        bool has_push = false;
+        uint64_t push_uid = 0;
+        // 该worker上拉流的uid，同一个uid重复拉流只算一次，
+        // 推流和拉流都停止之后删除目录项
+        std::unordered_set<uint64_t> pull_uids;
+    };
+
+    // 同一个流的推流和拉流目录项在同一个分片中
+    struct DirectoryShard {
+        std::mutex mtx;
+        std::unordered_map<std::string, Entry> directory;
+        // 开启fanout时拉流各自的位置，key为stream_name和uid
+        std::unordered_map<std::string, int> pull_directory;
+    };
+
+    static const int kDirectoryShards = 32;
+
+    DirectoryShard& ShardOf(const std::string& stream_name);
+    int PlacePush(const std::string& stream_name);
+    int PlacePull();
+    int RoutePull(DirectoryShard& shard, const RtcMsg& msg);
+    void RemovePush(DirectoryShard& shard, uint64_t uid, const std::string& stream_name);
+    void RemovePull(DirectoryShard& shard, uint64_t uid, const std::string& stream_name);
+    std::string PullKey(uint64_t uid, const std::string& stream_name) const;
+    int PrimaryWorker(const std::string& stream_name) const;
+    int64_t LoadScore(int worker_id) const;
+
+private:
+    int worker_num_;
+    bool fanout_enabled_;
+    // (哈希值, worker编号)，按哈希值排序，构造之后只读
+    std::vector<std::pair<uint32_t, int>> ring_;
+    std::unique_ptr<WorkerLoad[]> loads_;
+
+    DirectoryShard shards_[kDirectoryShards];
+    // 所有分片的目录项个数，只用于监控
+    std::atomic<int> directory_size_{0};
+    std::atomic<int> pull_directory_size_{0};
+};
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_SERVER_STREAM_PLACEMENT_H_
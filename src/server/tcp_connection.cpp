@@ -13,10 +13,9 @@ TcpConnection::TcpConnection(int fd) :
 TcpConnection::~TcpConnection() {
     sdsfree(querybuf);
 
-    while (!reply_list.empty()) {
-        rtc::Slice reply = reply_list.front();
-        zfree((void*)reply.data());
-        reply_list.pop_front();
+    // 正常关闭时已经由signaling worker归还给内存池
+    for (auto& reply : reply_list) {
+        zfree(reply.body);
     }
 
     reply_list.clear();
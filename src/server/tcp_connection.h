@@ -4,10 +4,10 @@
 #include <list>
 
 #include <rtc_base/sds.h>
-#include <rtc_base/slice.h>
 
 #include "base/xhead.h"
 #include "base/event_loop.h"
+#include "server/signaling_reply.h"
 
 namespace xrtc {
 
@@ -30,10 +30,14 @@ public:
     TimerWatcher* timer_watcher = nullptr;
     sds querybuf;
     size_t bytes_expected = XHEAD_SIZE;
+    // querybuf中已经解析的字节数，处理完的请求会从querybuf中移除
     size_t bytes_processed = 0;
     int current_state = STATE_HEAD;
     unsigned long last_interaction = 0;
-    std::list<rtc::Slice> reply_list;
+    // 已经转发给rtc worker、还没有响应的请求数，不为0时不做超时断开
+    int pending_requests = 0;
+    std::list<SignalingReply> reply_list;
+    // reply_list第一个响应中已经发送的字节数
     size_t cur_resp_pos = 0;
 };
 
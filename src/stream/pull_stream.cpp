@@ -5,9 +5,11 @@
 namespace xrtc {
 
 PullStream::PullStream(EventLoop* el, PortAllocator* allocator, 
+        FeedbackScheduler* feedback_scheduler,
         uint64_t uid, const std::string& stream_name,
         bool audio, bool video, uint32_t log_id) :
-    RtcStream(el, allocator, uid, stream_name, audio, video, log_id)
+    RtcStream(el, allocator, feedback_scheduler, uid, stream_name, audio, video,
+            log_id)
 {
 }
 
@@ -37,6 +39,20 @@ void PullStream::AddVideoSource(const std::vector<StreamParams>& source) {
     }
 }
 
+void PullStream::SetSkipSilentAudio(bool skip) {
+    if (pc) {
+        pc->set_skip_silent_audio(skip);
+    }
+}
+
+int64_t PullStream::GetBitrateEstimate() {
+    return pc ? pc->bitrate_estimate_bps() : 0;
+}
+
+PacerDropStats PullStream::GetEgressDropStats() {
+    return pc ? pc->egress_drop_stats() : PacerDropStats();
+}
+
 } // namespace xrtc
 
 
@@ -7,7 +7,8 @@ namespace xrtc {
 
 class PullStream : public RtcStream {
 public:
-    PullStream(EventLoop* el, PortAllocator* allocator, uint64_t uid, 
+    PullStream(EventLoop* el, PortAllocator* allocator,
+            FeedbackScheduler* feedback_scheduler, uint64_t uid,
             const std::string& stream_name,
             bool audio, bool video, uint32_t log_id);
     ~PullStream() override;
@@ -17,6 +18,11 @@ public:
 
     void AddAudioSource(const std::vector<StreamParams>& source);
     void AddVideoSource(const std::vector<StreamParams>& source);
+    void SetSkipSilentAudio(bool skip);
+    // 下行带宽估计值(bps)，可用于选择simulcast层、发送节奏和fec冗余度
+    int64_t GetBitrateEstimate();
+    // 发送队列超限丢弃的包数、字节数等统计
+    PacerDropStats GetEgressDropStats();
 };
 
 } // namespace xrtc
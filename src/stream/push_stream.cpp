@@ -5,9 +5,11 @@
 namespace xrtc {
 
 PushStream::PushStream(EventLoop* el, PortAllocator* allocator, 
+        FeedbackScheduler* feedback_scheduler,
         uint64_t uid, const std::string& stream_name,
         bool audio, bool video, uint32_t log_id) :
-    RtcStream(el, allocator, uid, stream_name, audio, video, log_id)
+    RtcStream(el, allocator, feedback_scheduler, uid, stream_name, audio, video,
+            log_id)
 {
 }
 
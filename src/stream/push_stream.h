@@ -7,7 +7,8 @@ namespace xrtc {
 
 class PushStream : public RtcStream {
 public:
-    PushStream(EventLoop* el, PortAllocator* allocator, uint64_t uid, 
+    PushStream(EventLoop* el, PortAllocator* allocator,
+            FeedbackScheduler* feedback_scheduler, uint64_t uid,
             const std::string& stream_name,
             bool audio, bool video, uint32_t log_id);
     ~PushStream() override;
@@ -7,15 +7,16 @@ namespace xrtc {
 const size_t kIceTimeout = 30000; // 30s;
 
 RtcStream::RtcStream(EventLoop* el, PortAllocator* allocator,
-        uint64_t uid, const std::string& stream_name,
-        bool audio, bool video, uint32_t log_id):
+        FeedbackScheduler* feedback_scheduler, uint64_t uid,
+        const std::string& stream_name, bool audio, bool video, uint32_t log_id):
     el(el), uid(uid), stream_name(stream_name), audio(audio),
     video(video), log_id(log_id),
-    pc(new PeerConnection(el, allocator))
+    pc(new PeerConnection(el, allocator, feedback_scheduler))
 {
     pc->SignalConnectionState.connect(this, &RtcStream::OnConnectionState);
     pc->SignalRtpPacketReceived.connect(this, &RtcStream::OnRtpPacketReceived);
-    pc->SignalRtcpPacketReceived.connect(this, &RtcStream::OnRtcpPacketReceived);
+    pc->SignalKeyFrameRequest.connect(this, &RtcStream::OnKeyFrameRequest);
+    pc->SignalBitrateEstimate.connect(this, &RtcStream::OnBitrateEstimate);
 }
 
 RtcStream::~RtcStream() {
@@ -56,11 +57,15 @@ void RtcStream::OnRtpPacketReceived(PeerConnection*,
     }
 }
 
-void RtcStream::OnRtcpPacketReceived(PeerConnection*, 
-        rtc::CopyOnWriteBuffer* packet, int64_t /*ts*/)
-{
+void RtcStream::OnKeyFrameRequest(PeerConnection*, uint32_t ssrc) {
+    if (listener_) {
+        listener_->OnKeyFrameRequest(this, ssrc);
+    }
+}
+
+void RtcStream::OnBitrateEstimate(PeerConnection*, int64_t bitrate_bps) {
     if (listener_) {
-        listener_->OnRtcpPacketReceived(this, (const char*)packet->data(), packet->size());
+        listener_->OnBitrateEstimate(this, bitrate_bps);
     }
 }
 
@@ -80,8 +85,8 @@ int RtcStream::Start(rtc::RTCCertificate* certificate) {
     return pc->Init(certificate);
 }
 
-int RtcStream::SetRemoteSdp(const std::string& sdp) {
-    return pc->SetRemoteSdp(sdp);
+int RtcStream::SetRemoteDescription(std::shared_ptr<RemoteDescription> remote) {
+    return pc->SetRemoteDescription(remote);
 }
 
 int RtcStream::SendRtp(const char* data, size_t len) {
@@ -91,11 +96,16 @@ int RtcStream::SendRtp(const char* data, size_t len) {
     return -1;
 }
 
-int RtcStream::SendRtcp(const char* data, size_t len) {
+void RtcStream::RequestKeyFrame(uint32_t ssrc) {
     if (pc) {
-        return pc->SendRtcp(data, len);
+        pc->RequestKeyFrame(ssrc);
+    }
+}
+
+void RtcStream::SetReceiveBitrateCap(int64_t bitrate_cap_bps) {
+    if (pc) {
+        pc->SetReceiveBitrateCap(bitrate_cap_bps);
     }
-    return -1;
 }
 
 std::string RtcStream::ToString() {
@@ -22,19 +22,21 @@ class RtcStreamListener {
 public:
     virtual void OnConnectionState(RtcStream* stream, PeerConnectionState state) = 0;
     virtual void OnRtpPacketReceived(RtcStream* stream, const char* data, size_t len) = 0;
-    virtual void OnRtcpPacketReceived(RtcStream* stream, const char* data, size_t len) = 0;
+    virtual void OnKeyFrameRequest(RtcStream* stream, uint32_t ssrc) = 0;
+    virtual void OnBitrateEstimate(RtcStream* stream, int64_t bitrate_bps) = 0;
     virtual void OnStreamException(RtcStream* stream) = 0;
 };
 
 class RtcStream : public sigslot::has_slots<> {
 public:
-    RtcStream(EventLoop* el, PortAllocator* allocator, uint64_t uid, 
+    RtcStream(EventLoop* el, PortAllocator* allocator,
+            FeedbackScheduler* feedback_scheduler, uint64_t uid,
             const std::string& stream_name, bool audio, bool video, 
             uint32_t log_id);
     virtual ~RtcStream();
     
     int Start(rtc::RTCCertificate* certificate);
-    int SetRemoteSdp(const std::string& sdp);
+    int SetRemoteDescription(std::shared_ptr<RemoteDescription> remote);
     void RegisterListener(RtcStreamListener* listener) { listener_ = listener; }
 
     virtual std::string CreateOffer() = 0;
@@ -44,7 +46,8 @@ public:
     const std::string& get_stream_name() { return stream_name; }
     
     int SendRtp(const char* data, size_t len);
-    int SendRtcp(const char* data, size_t len);
+    void RequestKeyFrame(uint32_t ssrc);
+    void SetReceiveBitrateCap(int64_t bitrate_cap_bps);
 
     std::string ToString();
 
@@ -52,8 +55,8 @@ private:
     void OnConnectionState(PeerConnection*, PeerConnectionState);
     void OnRtpPacketReceived(PeerConnection*, 
         rtc::CopyOnWriteBuffer* packet, int64_t /*ts*/);
-    void OnRtcpPacketReceived(PeerConnection*, 
-            rtc::CopyOnWriteBuffer* packet, int64_t /*ts*/);
+    void OnKeyFrameRequest(PeerConnection*, uint32_t ssrc);
+    void OnBitrateEstimate(PeerConnection*, int64_t bitrate_bps);
 
 protected:
     EventLoop* el;
@@ -1,5 +1,7 @@
 #include "stream/rtc_stream_manager.h"
 
+#include <algorithm>
+
 #include <rtc_base/logging.h>
 
 #include "base/conf.h"
@@ -10,9 +12,12 @@ extern xrtc::GeneralConf* g_conf;
 
 namespace xrtc {
 
-RtcStreamManager::RtcStreamManager(EventLoop* el) :
+RtcStreamManager::RtcStreamManager(EventLoop* el, StreamFanout* fanout, int worker_id) :
     el_(el),
-    allocator_(new PortAllocator())
+    allocator_(new PortAllocator()),
+    feedback_scheduler_(new FeedbackScheduler(el, webrtc::Clock::GetRealTimeClock())),
+    fanout_(fanout),
+    worker_id_(worker_id)
 {
     allocator_->SetPortRange(g_conf->ice_min_port, g_conf->ice_max_port);
 }
@@ -38,6 +43,28 @@ PullStream* RtcStreamManager::FindPullStream(const std::string& stream_name) {
     return nullptr;
 }
 
+std::shared_ptr<FanoutSource> RtcStreamManager::FindPublishedSource(
+        const std::string& stream_name)
+{
+    auto iter = published_sources_.find(stream_name);
+    if (iter != published_sources_.end()) {
+        return iter->second;
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<FanoutSource> RtcStreamManager::FindSubscribedSource(
+        const std::string& stream_name)
+{
+    auto iter = subscribed_sources_.find(stream_name);
+    if (iter != subscribed_sources_.end()) {
+        return iter->second;
+    }
+
+    return nullptr;
+}
+
 void RtcStreamManager::RemovePushStream(RtcStream* stream) {
     if (!stream) {
         return;
@@ -51,6 +78,12 @@ void RtcStreamManager::RemovePushStream(uint64_t uid, const std::string& stream_
     if (push_stream && uid == push_stream->get_uid()) {
         push_streams_.erase(stream_name);
         delete push_stream;
+
+        std::shared_ptr<FanoutSource> source = FindPublishedSource(stream_name);
+        if (source) {
+            fanout_->Unpublish(source);
+            published_sources_.erase(stream_name);
+        }
     }
 }
 
@@ -65,11 +98,58 @@ void RtcStreamManager::RemovePullStream(RtcStream* stream) {
 void RtcStreamManager::RemovePullStream(uint64_t uid, const std::string& stream_name) {
     PullStream* pull_stream = FindPullStream(stream_name);
     if (pull_stream && uid == pull_stream->get_uid()) {
+        PacerDropStats drop_stats = pull_stream->GetEgressDropStats();
+        if (drop_stats.dropped_packets > 0) {
+            RTC_LOG(LS_INFO) << pull_stream->ToString() << " egress dropped packets: "
+                << drop_stats.dropped_packets
+                << ", bytes: " << drop_stats.dropped_bytes
+                << ", non_reference: " << drop_stats.dropped_non_reference_packets
+                << ", keyframe_waits: " << drop_stats.keyframe_waits;
+        }
+
         pull_streams_.erase(stream_name);
         delete pull_stream;
+        UpdatePublishBitrateCap(stream_name);
+
+        std::shared_ptr<FanoutSource> source = FindSubscribedSource(stream_name);
+        if (source) {
+            // 推流所在的worker不再把本worker计入REMB上限
+            if (g_conf->remb_subscriber_cap) {
+                fanout_->SendBitrateEstimate(worker_id_, source, 0);
+            }
+
+            fanout_->Unsubscribe(source.get(), worker_id_);
+            subscribed_sources_.erase(stream_name);
+        }
     }
 }
 
+void RtcStreamManager::UpdatePublishBitrateCap(const std::string& stream_name) {
+    if (!g_conf->remb_subscriber_cap) {
+        return;
+    }
+
+    PushStream* push_stream = FindPushStream(stream_name);
+    if (!push_stream) {
+        return;
+    }
+
+    // 推流端的码率以拉流端中最大的带宽估计值为上限，包括其他worker上
+    // 通过fanout订阅的拉流，没有拉流端时不限制
+    int64_t bitrate_cap_bps = 0;
+    PullStream* pull_stream = FindPullStream(stream_name);
+    if (pull_stream) {
+        bitrate_cap_bps = std::max(bitrate_cap_bps, pull_stream->GetBitrateEstimate());
+    }
+
+    std::shared_ptr<FanoutSource> source = FindPublishedSource(stream_name);
+    if (source) {
+        bitrate_cap_bps = std::max(bitrate_cap_bps, source->MaxSubscriberBitrate());
+    }
+
+    push_stream->SetReceiveBitrateCap(bitrate_cap_bps);
+}
+
 int RtcStreamManager::CreatePushStream(uint64_t uid, const std::string& stream_name,
         bool audio, bool video, 
         bool is_dtls, uint32_t log_id,
@@ -82,8 +162,8 @@ int RtcStreamManager::CreatePushStream(uint64_t uid, const std::string& stream_n
         delete stream;
     }
 
-    stream = new PushStream(el_, allocator_.get(), uid, stream_name,
-            audio, video, log_id);
+    stream = new PushStream(el_, allocator_.get(), feedback_scheduler_.get(),
+            uid, stream_name, audio, video, log_id);
     stream->RegisterListener(this);
     
     if (is_dtls) {
@@ -99,13 +179,19 @@ int RtcStreamManager::CreatePushStream(uint64_t uid, const std::string& stream_n
 }
 
 int RtcStreamManager::CreatePullStream(uint64_t uid, const std::string& stream_name,
-        bool audio, bool video, 
+        bool audio, bool video, bool skip_silent_audio,
         bool is_dtls, uint32_t log_id,
         rtc::RTCCertificate* certificate,
         std::string& offer)
 {
     PushStream* push_stream = FindPushStream(stream_name);
-    if (!push_stream) {
+    // 推流在其他worker上，通过fanout订阅
+    std::shared_ptr<FanoutSource> source;
+    if (!push_stream && fanout_) {
+        source = fanout_->FindSource(stream_name);
+    }
+
+    if (!push_stream && !source) {
         RTC_LOG(LS_WARNING) << "Stream not found, uid: " << uid << ", stream_name: "
             << stream_name << ", log_id: " << log_id;
         return -1;
@@ -115,14 +201,20 @@ int RtcStreamManager::CreatePullStream(uint64_t uid, const std::string& stream_n
     
     std::vector<StreamParams> audio_source;
     std::vector<StreamParams> video_source;
-    push_stream->GetAudioSource(audio_source);
-    push_stream->GetVideoSource(video_source);
+    if (push_stream) {
+        push_stream->GetAudioSource(audio_source);
+        push_stream->GetVideoSource(video_source);
+    } else {
+        audio_source = source->audio_source();
+        video_source = source->video_source();
+    }
 
-    PullStream* stream = new PullStream(el_, allocator_.get(), uid, stream_name,
-            audio, video, log_id);
+    PullStream* stream = new PullStream(el_, allocator_.get(), feedback_scheduler_.get(),
+            uid, stream_name, audio, video, log_id);
     stream->RegisterListener(this);
     stream->AddAudioSource(audio_source);
     stream->AddVideoSource(video_source);
+    stream->SetSkipSilentAudio(skip_silent_audio);
     if (is_dtls) {
         stream->Start(certificate);
     } else {
@@ -132,11 +224,20 @@ int RtcStreamManager::CreatePullStream(uint64_t uid, const std::string& stream_n
     offer = stream->CreateOffer();
     
     pull_streams_[stream_name] = stream;
+
+    if (source) {
+        fanout_->Subscribe(source.get(), worker_id_);
+        subscribed_sources_[stream_name] = source;
+        RTC_LOG(LS_INFO) << "pull stream subscribe from worker "
+            << source->owner_worker_id() << ", stream_name: " << stream_name
+            << ", worker_id: " << worker_id_ << ", log_id: " << log_id;
+    }
+
     return 0;
 }
 
 int RtcStreamManager::SetAnswer(uint64_t uid, const std::string& stream_name,
-        const std::string& answer, const std::string& stream_type, 
+        std::shared_ptr<RemoteDescription> answer, const std::string& stream_type,
         uint32_t log_id)
 {
     if ("push" == stream_type) {
@@ -155,7 +256,17 @@ int RtcStreamManager::SetAnswer(uint64_t uid, const std::string& stream_name,
             return -1;
         }
         
-        push_stream->SetRemoteSdp(answer);
+        push_stream->SetRemoteDescription(answer);
+
+        // answer之后才知道推流的ssrc，发布给其他worker上的拉流
+        if (fanout_) {
+            std::vector<StreamParams> audio_source;
+            std::vector<StreamParams> video_source;
+            push_stream->GetAudioSource(audio_source);
+            push_stream->GetVideoSource(video_source);
+            published_sources_[stream_name] = fanout_->Publish(stream_name,
+                    worker_id_, audio_source, video_source);
+        }
 
     } else if ("pull" == stream_type) {
         PullStream* pull_stream = FindPullStream(stream_name);
@@ -173,7 +284,7 @@ int RtcStreamManager::SetAnswer(uint64_t uid, const std::string& stream_name,
             return -1;
         }
 
-        pull_stream->SetRemoteSdp(answer);
+        pull_stream->SetRemoteDescription(answer);
     }
 
     return 0;
@@ -193,11 +304,7 @@ void RtcStreamManager::OnConnectionState(RtcStream* stream,
         PeerConnectionState state)
 {
     if (state == PeerConnectionState::kFailed) {
-        if (stream->stream_type() == RtcStreamType::k_push) {
-            RemovePushStream(stream);
-        } else if (stream->stream_type() == RtcStreamType::k_pull) {
-            RemovePullStream(stream);
-        }
+        RemoveFailedStream(stream);
     } 
 }
 
@@ -205,35 +312,110 @@ void RtcStreamManager::OnRtpPacketReceived(RtcStream* stream,
         const char* data, size_t len) 
 {
     if (RtcStreamType::k_push == stream->stream_type()) {
+        ++rtp_packets_received_;
         PullStream* pull_stream = FindPullStream(stream->get_stream_name());
         if (pull_stream) {
             pull_stream->SendRtp(data, len);
         }
+
+        if (fanout_) {
+            std::shared_ptr<FanoutSource> source =
+                FindPublishedSource(stream->get_stream_name());
+            if (source) {
+                fanout_->DeliverRtp(worker_id_, source, data, len);
+            }
+        }
     }
 }
 
-void RtcStreamManager::OnRtcpPacketReceived(RtcStream* stream, 
-        const char* data, size_t len)
-{
-    if (RtcStreamType::k_push == stream->stream_type()) {
-        PullStream* pull_stream = FindPullStream(stream->get_stream_name());
+void RtcStreamManager::OnKeyFrameRequest(RtcStream* stream, uint32_t ssrc) {
+    // rtcp在各自的peerconnection上终结，只有关键帧请求需要转给推流端
+    if (RtcStreamType::k_pull == stream->stream_type()) {
+        PushStream* push_stream = FindPushStream(stream->get_stream_name());
+        if (push_stream) {
+            push_stream->RequestKeyFrame(ssrc);
+            return;
+        }
+
+        std::shared_ptr<FanoutSource> source =
+            FindSubscribedSource(stream->get_stream_name());
+        if (source) {
+            fanout_->SendKeyFrameRequest(worker_id_, source, ssrc);
+        }
+    }
+}
+
+void RtcStreamManager::OnBitrateEstimate(RtcStream* stream, int64_t bitrate_bps) {
+    if (RtcStreamType::k_pull != stream->stream_type()) {
+        return;
+    }
+
+    // 推流在其他worker上，交给推流所在的worker汇总
+    std::shared_ptr<FanoutSource> source = FindSubscribedSource(stream->get_stream_name());
+    if (source) {
+        if (g_conf->remb_subscriber_cap) {
+            fanout_->SendBitrateEstimate(worker_id_, source, bitrate_bps);
+        }
+        return;
+    }
+
+    UpdatePublishBitrateCap(stream->get_stream_name());
+}
+
+void RtcStreamManager::ProcessFanout() {
+    if (fanout_) {
+        fanout_->Drain(worker_id_, this);
+    }
+}
+
+void RtcStreamManager::OnFanoutMsg(const FanoutMsg& msg) {
+    const std::string& stream_name = msg.source->stream_name();
+    if (FanoutMsg::kRtp == msg.type) {
+        // 拉流已经停止或者重新订阅了新的推流
+        if (FindSubscribedSource(stream_name) != msg.source) {
+            return;
+        }
+
+        PullStream* pull_stream = FindPullStream(stream_name);
         if (pull_stream) {
-            pull_stream->SendRtcp(data, len);
+            pull_stream->SendRtp((const char*)msg.packet.cdata(), msg.packet.size());
         }
-    } else if (RtcStreamType::k_pull == stream->stream_type()) {
-        PushStream* push_stream = FindPushStream(stream->get_stream_name());
+    } else if (FanoutMsg::kKeyFrameRequest == msg.type) {
+        if (FindPublishedSource(stream_name) != msg.source) {
+            return;
+        }
+
+        PushStream* push_stream = FindPushStream(stream_name);
         if (push_stream) {
-            push_stream->SendRtcp(data, len);
+            push_stream->RequestKeyFrame(msg.ssrc);
         }
+    } else if (FanoutMsg::kBitrateEstimate == msg.type) {
+        if (FindPublishedSource(stream_name) != msg.source) {
+            return;
+        }
+
+        msg.source->SetSubscriberBitrate(msg.from_worker_id, msg.bitrate_bps);
+        UpdatePublishBitrateCap(stream_name);
     }
 }
 
 void RtcStreamManager::OnStreamException(RtcStream* stream) {
-    if (RtcStreamType::k_push == stream->stream_type()) {
-        RemovePushStream(stream);
-    } else if (RtcStreamType::k_pull == stream->stream_type()) {
-        RemovePullStream(stream);
+    RemoveFailedStream(stream);
+}
+
+void RtcStreamManager::RemoveFailedStream(RtcStream* stream) {
+    // 删除之后stream不再可用
+    RtcStreamType stream_type = stream->stream_type();
+    uint64_t uid = stream->get_uid();
+    std::string stream_name = stream->get_stream_name();
+
+    if (RtcStreamType::k_push == stream_type) {
+        RemovePushStream(uid, stream_name);
+    } else if (RtcStreamType::k_pull == stream_type) {
+        RemovePullStream(uid, stream_name);
     }
+
+    SignalStreamRemoved(stream_type, uid, stream_name);
 }
 
 } // namespace xrtc
@@ -5,19 +5,26 @@
 #include <unordered_map>
 
 #include <rtc_base/rtc_certificate.h>
+#include <rtc_base/third_party/sigslot/sigslot.h>
 
 #include "ice/port_allocator.h"
 #include "base/event_loop.h"
+#include "modules/rtp_rtcp/feedback_scheduler.h"
 #include "stream/rtc_stream.h"
+#include "stream/stream_fanout.h"
 
 namespace xrtc {
 
 class PushStream;
 class PullStream;
 
-class RtcStreamManager : public RtcStreamListener {
+class RtcStreamManager : public RtcStreamListener,
+                         public FanoutListener
+{
 public:
-    RtcStreamManager(EventLoop* el);
+    // fanout不为空时，推流发布到其他worker，本worker上没有推流的拉流从其他worker订阅
+    RtcStreamManager(EventLoop* el, StreamFanout* fanout = nullptr,
+            int worker_id = 0);
     ~RtcStreamManager();
     
     int CreatePushStream(uint64_t uid, const std::string& stream_name,
@@ -27,21 +34,32 @@ public:
             std::string& offer);
     
     int CreatePullStream(uint64_t uid, const std::string& stream_name,
-            bool audio, bool video, 
+            bool audio, bool video, bool skip_silent_audio,
             bool is_dtls, uint32_t log_id,
             rtc::RTCCertificate* certificate,
             std::string& offer);
 
     int SetAnswer(uint64_t uid, const std::string& stream_name,
-            const std::string& answer, const std::string& stream_type, 
+            std::shared_ptr<RemoteDescription> answer, const std::string& stream_type,
             uint32_t log_id);
     int StopPush(uint64_t uid, const std::string& stream_name);
     int StopPull(uint64_t uid, const std::string& stream_name);
  
     void OnConnectionState(RtcStream* stream, PeerConnectionState state) override;
     void OnRtpPacketReceived(RtcStream* stream, const char* data, size_t len) override;
-    void OnRtcpPacketReceived(RtcStream* stream, const char* data, size_t len) override;
+    void OnKeyFrameRequest(RtcStream* stream, uint32_t ssrc) override;
+    void OnBitrateEstimate(RtcStream* stream, int64_t bitrate_bps) override;
     void OnStreamException(RtcStream* stream) override;
+    void OnFanoutMsg(const FanoutMsg& msg) override;
+
+    // 处理其他worker发来的fanout消息
+    void ProcessFanout();
+
+    // 连接失败或者异常时，流没有经过stop请求就被删除
+    sigslot::signal3<RtcStreamType, uint64_t, const std::string&> SignalStreamRemoved;
+
+    size_t num_streams() const { return push_streams_.size() + pull_streams_.size(); }
+    uint64_t rtp_packets_received() const { return rtp_packets_received_; }
 
 private:
     PushStream* FindPushStream(const std::string& stream_name);
@@ -50,12 +68,25 @@ private:
     PullStream* FindPullStream(const std::string& stream_name);
     void RemovePullStream(RtcStream* stream);
     void RemovePullStream(uint64_t uid, const std::string& stream_name);
+    void RemoveFailedStream(RtcStream* stream);
+    void UpdatePublishBitrateCap(const std::string& stream_name);
+    std::shared_ptr<FanoutSource> FindPublishedSource(const std::string& stream_name);
+    std::shared_ptr<FanoutSource> FindSubscribedSource(const std::string& stream_name);
 
 private:
     EventLoop* el_;
     std::unordered_map<std::string, PushStream*> push_streams_;
     std::unordered_map<std::string, PullStream*> pull_streams_;
+    // 推流端收到的rtp包个数，用于计算worker的负载
+    uint64_t rtp_packets_received_ = 0;
     std::unique_ptr<PortAllocator> allocator_;
+    // 所有会话的rtcp反馈由一个定时器统一调度
+    std::unique_ptr<FeedbackScheduler> feedback_scheduler_;
+    StreamFanout* fanout_;
+    int worker_id_;
+    // 本worker发布的推流，和本worker上的拉流订阅的其他worker的推流
+    std::unordered_map<std::string, std::shared_ptr<FanoutSource>> published_sources_;
+    std::unordered_map<std::string, std::shared_ptr<FanoutSource>> subscribed_sources_;
 };
 
 } // namespace xrtc
@@ -0,0 +1,236 @@
+#include "stream/stream_fanout.h"
+
+#include <algorithm>
+
+#include "base/metrics.h"
+
+namespace xrtc {
+
+namespace {
+
+// 每对worker之间队列的容量，推流所在worker比订阅worker快太多时丢包
+const size_t kRingCapacity = 4096;
+
+} // namespace
+
+FanoutSource::FanoutSource(const std::string& stream_name, int owner_worker_id,
+        const std::vector<StreamParams>& audio_source,
+        const std::vector<StreamParams>& video_source) :
+    stream_name_(stream_name),
+    owner_worker_id_(owner_worker_id),
+    audio_source_(audio_source),
+    video_source_(video_source)
+{
+}
+
+void FanoutSource::SetSubscriberBitrate(int worker_id, int64_t bitrate_bps) {
+    if (worker_id < 0 || worker_id >= StreamFanout::kMaxWorkers) {
+        return;
+    }
+
+    if (subscriber_bitrates_bps_.size() <= static_cast<size_t>(worker_id)) {
+        subscriber_bitrates_bps_.resize(worker_id + 1, 0);
+    }
+
+    subscriber_bitrates_bps_[worker_id] = bitrate_bps;
+}
+
+int64_t FanoutSource::MaxSubscriberBitrate() const {
+    int64_t max_bitrate_bps = 0;
+    for (int64_t bitrate_bps : subscriber_bitrates_bps_) {
+        max_bitrate_bps = std::max(max_bitrate_bps, bitrate_bps);
+    }
+
+    return max_bitrate_bps;
+}
+
+StreamFanout::StreamFanout(int worker_num) :
+    worker_num_(worker_num),
+    rings_(new std::atomic<SpscRing<FanoutMsg>*>[worker_num * worker_num]),
+    wakeups_(worker_num),
+    wake_pending_(new std::atomic<bool>[worker_num])
+{
+    for (int i = 0; i < worker_num_ * worker_num_; ++i) {
+        rings_[i].store(nullptr);
+    }
+
+    for (int i = 0; i < worker_num_; ++i) {
+        wake_pending_[i].store(false);
+    }
+}
+
+StreamFanout::~StreamFanout() {
+    for (int i = 0; i < worker_num_ * worker_num_; ++i) {
+        delete rings_[i].load();
+    }
+}
+
+void StreamFanout::CreateRing(int from, int to) {
+    std::atomic<SpscRing<FanoutMsg>*>& ring = rings_[from * worker_num_ + to];
+    if (ring.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // 两个worker可能同时订阅对方的推流
+    std::unique_lock<std::mutex> lock(rings_mtx_);
+    if (!ring.load(std::memory_order_relaxed)) {
+        ring.store(new SpscRing<FanoutMsg>(kRingCapacity), std::memory_order_release);
+        Metrics::ThreadInstance()->Increment("fanout_ring_created");
+    }
+}
+
+void StreamFanout::SetWakeup(int worker_id, std::function<void()> wakeup) {
+    wakeups_[worker_id] = std::move(wakeup);
+}
+
+std::shared_ptr<FanoutSource> StreamFanout::Publish(const std::string& stream_name,
+        int worker_id,
+        const std::vector<StreamParams>& audio_source,
+        const std::vector<StreamParams>& video_source)
+{
+    std::shared_ptr<FanoutSource> source = std::make_shared<FanoutSource>(
+            stream_name, worker_id, audio_source, video_source);
+
+    std::unique_lock<std::mutex> lock(sources_mtx_);
+    sources_[stream_name] = source;
+    return source;
+}
+
+void StreamFanout::Unpublish(const std::shared_ptr<FanoutSource>& source) {
+    std::unique_lock<std::mutex> lock(sources_mtx_);
+    auto iter = sources_.find(source->stream_name());
+    // 重新推流时已经被新的source替换
+    if (iter != sources_.end() && iter->second == source) {
+        sources_.erase(iter);
+    }
+}
+
+std::shared_ptr<FanoutSource> StreamFanout::FindSource(const std::string& stream_name) {
+    std::unique_lock<std::mutex> lock(sources_mtx_);
+    auto iter = sources_.find(stream_name);
+    if (iter != sources_.end()) {
+        return iter->second;
+    }
+
+    return nullptr;
+}
+
+void StreamFanout::Subscribe(FanoutSource* source, int worker_id) {
+    // 先创建队列再设置订阅位，推流所在worker看到订阅位时队列一定已经存在。
+    // 反方向的队列用于发送关键帧请求和带宽估计值
+    int owner = source->owner_worker_id();
+    if (owner != worker_id) {
+        CreateRing(owner, worker_id);
+        CreateRing(worker_id, owner);
+    }
+
+    source->subscribers_.fetch_or(1ULL << worker_id, std::memory_order_acq_rel);
+}
+
+void StreamFanout::Unsubscribe(FanoutSource* source, int worker_id) {
+    source->subscribers_.fetch_and(~(1ULL << worker_id), std::memory_order_acq_rel);
+}
+
+bool StreamFanout::Push(int from, int to, FanoutMsg&& msg) {
+    SpscRing<FanoutMsg>* ring = rings_[from * worker_num_ + to].load(
+            std::memory_order_acquire);
+    if (!ring || !ring->TryPush(std::move(msg))) {
+        Metrics::ThreadInstance()->Increment("fanout_ring_dropped");
+        return false;
+    }
+
+    // 只有队列从空变为非空时才需要唤醒，避免每个包一次管道写
+    if (!wake_pending_[to].exchange(true, std::memory_order_acq_rel)
+            && wakeups_[to])
+    {
+        wakeups_[to]();
+    }
+
+    return true;
+}
+
+void StreamFanout::DeliverRtp(int worker_id, const std::shared_ptr<FanoutSource>& source,
+        const char* data, size_t len)
+{
+    uint64_t subscribers = source->subscribers_.load(std::memory_order_acquire)
+        & ~(1ULL << worker_id);
+    if (0 == subscribers) {
+        return;
+    }
+
+    // 只拷贝一次，各个worker共享引用计数的buffer
+    rtc::CopyOnWriteBuffer packet(data, len);
+    for (int to = 0; to < worker_num_; ++to) {
+        if (!(subscribers & (1ULL << to))) {
+            continue;
+        }
+
+        FanoutMsg msg;
+        msg.type = FanoutMsg::kRtp;
+        msg.source = source;
+        msg.packet = packet;
+        if (Push(worker_id, to, std::move(msg))) {
+            Metrics::ThreadInstance()->Increment("fanout_packets_published");
+        }
+    }
+}
+
+void StreamFanout::SendKeyFrameRequest(int worker_id,
+        const std::shared_ptr<FanoutSource>& source, uint32_t ssrc)
+{
+    int owner = source->owner_worker_id();
+    if (owner == worker_id) {
+        return;
+    }
+
+    FanoutMsg msg;
+    msg.type = FanoutMsg::kKeyFrameRequest;
+    msg.source = source;
+    msg.ssrc = ssrc;
+    Push(worker_id, owner, std::move(msg));
+}
+
+void StreamFanout::SendBitrateEstimate(int worker_id,
+        const std::shared_ptr<FanoutSource>& source, int64_t bitrate_bps)
+{
+    int owner = source->owner_worker_id();
+    if (owner == worker_id) {
+        return;
+    }
+
+    FanoutMsg msg;
+    msg.type = FanoutMsg::kBitrateEstimate;
+    msg.source = source;
+    msg.from_worker_id = worker_id;
+    msg.bitrate_bps = bitrate_bps;
+    Push(worker_id, owner, std::move(msg));
+}
+
+void StreamFanout::Drain(int worker_id, FanoutListener* listener) {
+    // 先清除标记再处理，处理过程中新到的消息会再次唤醒
+    wake_pending_[worker_id].store(false, std::memory_order_release);
+
+    FanoutMsg msg;
+    int delivered = 0;
+    for (int from = 0; from < worker_num_; ++from) {
+        if (from == worker_id) {
+            continue;
+        }
+
+        SpscRing<FanoutMsg>* ring = rings_[from * worker_num_ + worker_id].load(
+                std::memory_order_acquire);
+        if (!ring) {
+            continue;
+        }
+
+        while (ring->TryPop(&msg)) {
+            listener->OnFanoutMsg(msg);
+            ++delivered;
+        }
+    }
+
+    msg = FanoutMsg();
+    Metrics::ThreadInstance()->Observe("fanout_drain_batch", delivered);
+}
+
+} // namespace xrtc
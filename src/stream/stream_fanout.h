@@ -0,0 +1,131 @@
+#ifndef  __XRTCSERVER_STREAM_STREAM_FANOUT_H_
+#define  __XRTCSERVER_STREAM_STREAM_FANOUT_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <rtc_base/copy_on_write_buffer.h>
+
+#include "base/spsc_ring.h"
+#include "pc/stream_params.h"
+
+namespace xrtc {
+
+// 推流在所属worker上发布的信息，其他worker上的拉流据此创建并订阅
+class FanoutSource {
+public:
+    FanoutSource(const std::string& stream_name, int owner_worker_id,
+            const std::vector<StreamParams>& audio_source,
+            const std::vector<StreamParams>& video_source);
+
+    const std::string& stream_name() const { return stream_name_; }
+    int owner_worker_id() const { return owner_worker_id_; }
+    const std::vector<StreamParams>& audio_source() const { return audio_source_; }
+    const std::vector<StreamParams>& video_source() const { return video_source_; }
+
+    // 只在推流所在的worker线程中调用。
+    // 其他worker上拉流的带宽估计值，0表示该worker上没有拉流或者还没有估计值
+    void SetSubscriberBitrate(int worker_id, int64_t bitrate_bps);
+    int64_t MaxSubscriberBitrate() const;
+
+private:
+    friend class StreamFanout;
+
+    std::string stream_name_;
+    int owner_worker_id_;
+    std::vector<StreamParams> audio_source_;
+    std::vector<StreamParams> video_source_;
+    // 有拉流订阅的worker，按位表示
+    std::atomic<uint64_t> subscribers_{0};
+    // 按worker_id下标
+    std::vector<int64_t> subscriber_bitrates_bps_;
+};
+
+struct FanoutMsg {
+    enum {
+        kRtp = 0,
+        // 其他worker上的拉流请求关键帧，发给推流所在的worker
+        kKeyFrameRequest = 1,
+        // 其他worker上拉流的带宽估计值，发给推流所在的worker汇总REMB上限
+        kBitrateEstimate = 2
+    };
+
+    int type = kRtp;
+    std::shared_ptr<FanoutSource> source;
+    // 解密之后的rtp包，所有订阅的worker共享同一份数据
+    rtc::CopyOnWriteBuffer packet;
+    uint32_t ssrc = 0;
+    // kBitrateEstimate的发送方和估计值
+    int from_worker_id = -1;
+    int64_t bitrate_bps = 0;
+};
+
+class FanoutListener {
+public:
+    virtual ~FanoutListener() {}
+    virtual void OnFanoutMsg(const FanoutMsg& msg) = 0;
+};
+
+// 热门流的跨worker分发。推流所在的worker把解密后的rtp包按引用计数放到
+// 每个订阅worker的单生产者单消费者队列中，拉流可以分布在任意worker上，
+// 各自在本地改写和SRTP加密，一个流的发送开销分摊到所有的核上
+class StreamFanout {
+public:
+    static const int kMaxWorkers = 64;
+
+    StreamFanout(int worker_num);
+    ~StreamFanout();
+
+    // 在worker开始处理消息之前设置，队列由空变为非空时唤醒对应的worker
+    void SetWakeup(int worker_id, std::function<void()> wakeup);
+
+    std::shared_ptr<FanoutSource> Publish(const std::string& stream_name,
+            int worker_id,
+            const std::vector<StreamParams>& audio_source,
+            const std::vector<StreamParams>& video_source);
+    void Unpublish(const std::shared_ptr<FanoutSource>& source);
+    std::shared_ptr<FanoutSource> FindSource(const std::string& stream_name);
+
+    void Subscribe(FanoutSource* source, int worker_id);
+    void Unsubscribe(FanoutSource* source, int worker_id);
+
+    // 在推流所在的worker线程中调用
+    void DeliverRtp(int worker_id, const std::shared_ptr<FanoutSource>& source,
+            const char* data, size_t len);
+    // 在拉流所在的worker线程中调用
+    void SendKeyFrameRequest(int worker_id,
+            const std::shared_ptr<FanoutSource>& source, uint32_t ssrc);
+    // 在拉流所在的worker线程中调用，拉流停止时发送0。
+    // 反方向的队列只有关键帧请求和估计值，不会满，丢失时下一次估计值变化会覆盖
+    void SendBitrateEstimate(int worker_id,
+            const std::shared_ptr<FanoutSource>& source, int64_t bitrate_bps);
+    // 处理发给worker_id的所有消息
+    void Drain(int worker_id, FanoutListener* listener);
+
+private:
+    bool Push(int from, int to, FanoutMsg&& msg);
+    void CreateRing(int from, int to);
+
+private:
+    int worker_num_;
+    // rings_[from * worker_num_ + to]，第一次订阅时才创建，之后不再释放，
+    // 没有跨worker订阅的worker之间不占用内存
+    std::unique_ptr<std::atomic<SpscRing<FanoutMsg>*>[]> rings_;
+    std::mutex rings_mtx_;
+    std::vector<std::function<void()>> wakeups_;
+    std::unique_ptr<std::atomic<bool>[]> wake_pending_;
+
+    std::mutex sources_mtx_;
+    std::unordered_map<std::string, std::shared_ptr<FanoutSource>> sources_;
+};
+
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_STREAM_STREAM_FANOUT_H_
@@ -2,11 +2,15 @@
 
 #include <rtc_base/logging.h>
 
+#include "modules/video_coding/h264_utils.h"
+
 namespace xrtc {
     namespace {
 
         const int kPacketBufferStartSize = 512;
         const int kPacketBufferMaxSize = 2048;
+        // 多个拉流端同时请求关键帧时，合并成一个PLI发送给推流端
+        const int64_t kMinKeyFrameRequestIntervalMs = 300;
 
         std::unique_ptr<RtpRtcpImpl> CreateRtpRtcpModule(
                 const VideoReceiveStreamConfig& vconf,
@@ -15,8 +19,10 @@ namespace xrtc {
             RtpRtcpConfig config;
             config.el = vconf.el;
             config.clock = vconf.clock;
+            config.feedback_scheduler = vconf.feedback_scheduler;
             config.local_media_ssrc = vconf.rtp.local_ssrc;
             config.receive_stat = receive_stat;
+            config.non_sender_rtt_measurement = vconf.rtp.rtcp_xr_rrtr;
             config.rtp_rtcp_module_observer = vconf.rtp_rtcp_module_observer;
 
             auto rtp_rtcp = std::make_unique<RtpRtcpImpl>(config);
@@ -34,7 +40,9 @@ namespace xrtc {
             video_rtp_depacketizer_(std::make_unique<webrtc::VideoRtpDepacketizerH264>()),
             packet_buffer_(std::make_unique<webrtc::video_coding::PacketBuffer>(
                     kPacketBufferStartSize, kPacketBufferMaxSize)),
-            nack_module_(std::make_unique<NackRequester>(config.clock, config.el))
+            nack_module_(std::make_unique<NackRequester>(config.clock, config.el,
+                    config.feedback_scheduler)),
+            frame_assembly_(config.frame_assembly)
     {
         rtp_rtcp_->SetRemoteSsrc(config.rtp.remote_ssrc);
         nack_module_->SignalNackSend.connect(this, &RtpVideoStreamReceiver::OnNackSend);
@@ -57,6 +65,11 @@ namespace xrtc {
             return;
         }
 
+        if (!frame_assembly_) {
+            ReceivePacketForRelay(packet);
+            return;
+        }
+
         absl::optional<webrtc::VideoRtpDepacketizer::ParsedRtpPayload> parsed_payload =
                 video_rtp_depacketizer_->Parse(packet.PayloadBuffer());
         if (absl::nullopt == parsed_payload) {
@@ -68,6 +81,22 @@ namespace xrtc {
                               packet, parsed_payload->video_header);
     }
 
+    void RtpVideoStreamReceiver::ReceivePacketForRelay(
+            const webrtc::RtpPacketReceived& packet)
+    {
+        // 转发模式下不解包也不组帧，只根据NAL头判断关键帧的开始，
+        // 用于nack模块清理历史以及simulcast层的切换
+        bool is_keyframe = IsH264KeyFrameStart(packet.payload());
+        if (is_keyframe) {
+            last_keyframe_received_ms_ = config_.clock->TimeInMilliseconds();
+        }
+
+        if (nack_module_) {
+            nack_module_->OnReceivedPacket(packet.SequenceNumber(), is_keyframe,
+                    packet.recovered());
+        }
+    }
+
     void RtpVideoStreamReceiver::OnReceivedPayloadData(
             rtc::CopyOnWriteBuffer codec_payload,
             const webrtc::RtpPacketReceived& rtp_packet,
@@ -78,9 +107,13 @@ namespace xrtc {
         webrtc::RTPVideoHeader& video_header = packet->video_header;
         video_header.is_last_packet_in_frame |= rtp_packet.Marker();
 
+        bool is_keyframe = (video_header.is_first_packet_in_frame &&
+                            video_header.frame_type == webrtc::VideoFrameType::kVideoFrameKey);
+        if (is_keyframe) {
+            last_keyframe_received_ms_ = config_.clock->TimeInMilliseconds();
+        }
+
         if (nack_module_) {
-            bool is_keyframe = (video_header.is_first_packet_in_frame &&
-                                video_header.frame_type == webrtc::VideoFrameType::kVideoFrameKey);
             packet->times_nacked = nack_module_->OnReceivedPacket(
                     rtp_packet.SequenceNumber(), is_keyframe,
                     rtp_packet.recovered());
@@ -139,6 +172,37 @@ namespace xrtc {
         rtp_rtcp_->IncomingRtcpPacket(data, len);
     }
 
+    void RtpVideoStreamReceiver::UpdateRtt(int64_t rtt_ms) {
+        if (nack_module_) {
+            nack_module_->UpdateRtt(rtt_ms);
+        }
+    }
+
+    void RtpVideoStreamReceiver::SetFrameAssembly(bool enabled) {
+        if (frame_assembly_ == enabled) {
+            return;
+        }
+
+        frame_assembly_ = enabled;
+        // 切换模式后，缓存中残留的包无法再组成完整的帧，从下一个关键帧开始组帧
+        packet_buffer_->Clear();
+        if (enabled) {
+            RequestKeyFrame();
+        }
+    }
+
+    void RtpVideoStreamReceiver::RequestKeyFrame() {
+        int64_t now_ms = config_.clock->TimeInMilliseconds();
+        if (last_keyframe_request_ms_ >= 0 &&
+            now_ms - last_keyframe_request_ms_ < kMinKeyFrameRequestIntervalMs)
+        {
+            return;
+        }
+
+        last_keyframe_request_ms_ = now_ms;
+        rtp_rtcp_->SendPLI();
+    }
+
 } // namespace xrtc
 
 
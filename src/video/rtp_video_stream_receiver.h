@@ -21,9 +21,26 @@ public:
 
     void OnRtpPacket(const webrtc::RtpPacketReceived& packet);
     void DeliverRtcp(const uint8_t* data, size_t len);
+    void RequestKeyFrame();
+    bool SendTransportFeedback(const webrtc::rtcp::TransportFeedback& packet) {
+        return rtp_rtcp_->SendTransportFeedback(packet);
+    }
+    void SetRemb(int64_t bitrate_bps, std::vector<uint32_t> ssrcs, bool send_now) {
+        rtp_rtcp_->SetRemb(bitrate_bps, std::move(ssrcs), send_now);
+    }
+    void UnsetRemb() {
+        rtp_rtcp_->UnsetRemb();
+    }
+    // 重新请求重传之前等待的时间
+    void UpdateRtt(int64_t rtt_ms);
+    // 录制、帧统计等需要完整帧的功能开启组帧，其余情况只做转发
+    void SetFrameAssembly(bool enabled);
+    bool frame_assembly() const { return frame_assembly_; }
+    int64_t last_keyframe_received_ms() const { return last_keyframe_received_ms_; }
 
 private:
     void ReceivePacket(const webrtc::RtpPacketReceived& packet);
+    void ReceivePacketForRelay(const webrtc::RtpPacketReceived& packet);
     void OnReceivedPayloadData(
             rtc::CopyOnWriteBuffer codec_payload,
             const webrtc::RtpPacketReceived& packet,
@@ -40,6 +57,9 @@ private:
     std::unique_ptr<webrtc::VideoRtpDepacketizer> video_rtp_depacketizer_;
     std::unique_ptr<webrtc::video_coding::PacketBuffer> packet_buffer_;
     std::unique_ptr<NackRequester> nack_module_;
+    bool frame_assembly_ = false;
+    int64_t last_keyframe_request_ms_ = -1;
+    int64_t last_keyframe_received_ms_ = -1;
 };
 
 } // namespace xrtc
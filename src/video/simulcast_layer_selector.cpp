@@ -0,0 +1,171 @@
+#include "video/simulcast_layer_selector.h"
+
+#include <algorithm>
+
+#include <rtc_base/logging.h>
+#include <modules/include/module_common_types_public.h>
+
+#include "modules/video_coding/h264_utils.h"
+
+namespace xrtc {
+
+namespace {
+
+const int64_t kRateWindowMs = 1000;
+const float kRateScaleBps = 8000.0f;
+// 升层时预留一部分余量，避免在临界值附近来回切换
+const double kUpswitchBudgetFactor = 0.85;
+const int64_t kMinKeyFrameRequestIntervalMs = 500;
+const uint32_t kVideoClockRateKhz = 90;
+
+} // namespace
+
+SimulcastLayerSelector::Layer::Layer(uint32_t ssrc) :
+    ssrc(ssrc),
+    rate(kRateWindowMs, kRateScaleBps)
+{
+}
+
+SimulcastLayerSelector::SimulcastLayerSelector(webrtc::Clock* clock,
+        const std::vector<uint32_t>& layer_ssrcs,
+        uint32_t output_ssrc,
+        int64_t bitrate_budget_bps) :
+    clock_(clock),
+    output_ssrc_(output_ssrc),
+    bitrate_budget_bps_(bitrate_budget_bps)
+{
+    for (uint32_t ssrc : layer_ssrcs) {
+        layers_.emplace_back(ssrc);
+    }
+}
+
+SimulcastLayerSelector::~SimulcastLayerSelector() {
+}
+
+uint32_t SimulcastLayerSelector::current_ssrc() const {
+    int layer = current_layer_ >= 0 ? current_layer_ : target_layer_;
+    return layers_[layer].ssrc;
+}
+
+void SimulcastLayerSelector::SetBitrateBudget(int64_t bitrate_budget_bps) {
+    bitrate_budget_bps_ = bitrate_budget_bps;
+}
+
+int SimulcastLayerSelector::GetLayerIndex(uint32_t ssrc) const {
+    for (size_t i = 0; i < layers_.size(); ++i) {
+        if (layers_[i].ssrc == ssrc) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int SimulcastLayerSelector::SelectTargetLayer(int64_t now_ms) {
+    // 选择码率不超过预算的最高层；都超过时退回到最低的活跃层
+    int target = -1;
+    int lowest_active = -1;
+    for (size_t i = 0; i < layers_.size(); ++i) {
+        absl::optional<uint32_t> rate = layers_[i].rate.Rate(now_ms);
+        if (!rate) {
+            continue;
+        }
+
+        if (lowest_active < 0) {
+            lowest_active = i;
+        }
+
+        double budget = bitrate_budget_bps_;
+        if ((int)i > current_layer_) {
+            budget *= kUpswitchBudgetFactor;
+        }
+
+        if (*rate <= budget) {
+            target = i;
+        }
+    }
+
+    if (target < 0) {
+        target = lowest_active >= 0 ? lowest_active : 0;
+    }
+
+    return target;
+}
+
+bool SimulcastLayerSelector::OnRtpPacket(const RtpPacketView& packet) {
+    int layer = GetLayerIndex(packet.Ssrc());
+    if (layer < 0) {
+        return false;
+    }
+
+    int64_t now_ms = clock_->TimeInMilliseconds();
+    layers_[layer].rate.Update(packet.size(), now_ms);
+    target_layer_ = SelectTargetLayer(now_ms);
+
+    if (layer != current_layer_) {
+        if (layer != target_layer_) {
+            return false;
+        }
+
+        if (!IsH264KeyFrameStart(packet.payload())) {
+            MaybeRequestKeyFrame(layer, now_ms);
+            return false;
+        }
+
+        RTC_LOG(LS_INFO) << "simulcast switch layer from " << current_layer_
+            << " to " << layer << ", output_ssrc: " << output_ssrc_;
+        SwitchToLayer(layer, packet.SequenceNumber(), packet.Timestamp(), now_ms);
+    } else if (target_layer_ != current_layer_) {
+        MaybeRequestKeyFrame(target_layer_, now_ms);
+    }
+
+    return true;
+}
+
+void SimulcastLayerSelector::RewritePacket(RtpPacketView* packet) {
+    uint16_t seq_num = packet->SequenceNumber() + seq_num_offset_;
+    uint32_t timestamp = packet->Timestamp() + timestamp_offset_;
+    packet->SetSequenceNumber(seq_num);
+    packet->SetTimestamp(timestamp);
+    packet->SetSsrc(output_ssrc_);
+
+    if (!has_output_ || webrtc::IsNewerSequenceNumber(seq_num, last_output_seq_num_)) {
+        last_output_seq_num_ = seq_num;
+    }
+
+    if (!has_output_ || webrtc::IsNewerTimestamp(timestamp, last_output_timestamp_)) {
+        last_output_timestamp_ = timestamp;
+        last_output_time_ms_ = clock_->TimeInMilliseconds();
+    }
+
+    has_output_ = true;
+}
+
+void SimulcastLayerSelector::SwitchToLayer(int layer, uint16_t seq_num,
+        uint32_t timestamp, int64_t now_ms)
+{
+    current_layer_ = layer;
+    if (!has_output_) {
+        seq_num_offset_ = 0;
+        timestamp_offset_ = 0;
+        return;
+    }
+
+    // 新层的第一个包紧接着上一层的最后一个包，时间戳按照经过的时间推算
+    seq_num_offset_ = static_cast<uint16_t>(last_output_seq_num_ + 1 - seq_num);
+    int64_t elapsed_ms = std::max<int64_t>(now_ms - last_output_time_ms_, 1);
+    timestamp_offset_ = last_output_timestamp_ +
+        static_cast<uint32_t>(elapsed_ms * kVideoClockRateKhz) - timestamp;
+}
+
+void SimulcastLayerSelector::MaybeRequestKeyFrame(int layer, int64_t now_ms) {
+    if (last_keyframe_request_ms_ >= 0 &&
+            now_ms - last_keyframe_request_ms_ < kMinKeyFrameRequestIntervalMs)
+    {
+        return;
+    }
+
+    last_keyframe_request_ms_ = now_ms;
+    SignalKeyFrameRequest(layers_[layer].ssrc);
+}
+
+} // namespace xrtc
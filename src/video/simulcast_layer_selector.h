@@ -0,0 +1,74 @@
+#ifndef  XRTCSERVER_VIDEO_SIMULCAST_LAYER_SELECTOR_H_
+#define  XRTCSERVER_VIDEO_SIMULCAST_LAYER_SELECTOR_H_
+
+#include <vector>
+
+#include <rtc_base/rate_statistics.h>
+#include <rtc_base/third_party/sigslot/sigslot.h>
+#include <system_wrappers/include/clock.h>
+
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+
+namespace xrtc {
+
+// 每个拉流端一个，根据该拉流端的带宽预算，从推流端的多个simulcast层中
+// 选择一层转发，并把ssrc/序列号/时间戳改写成一路连续的流。
+// 层的切换只发生在关键帧处。
+class SimulcastLayerSelector {
+public:
+    SimulcastLayerSelector(webrtc::Clock* clock,
+            const std::vector<uint32_t>& layer_ssrcs,
+            uint32_t output_ssrc,
+            int64_t bitrate_budget_bps);
+    ~SimulcastLayerSelector();
+
+    bool HasSsrc(uint32_t ssrc) const { return GetLayerIndex(ssrc) >= 0; }
+    uint32_t output_ssrc() const { return output_ssrc_; }
+    // 当前正在转发的层的ssrc，还没有开始转发时返回目标层的ssrc
+    uint32_t current_ssrc() const;
+
+    void SetBitrateBudget(int64_t bitrate_budget_bps);
+
+    // 返回false表示这个包不需要转发给拉流端，只读取包头，不修改包的内容
+    bool OnRtpPacket(const RtpPacketView& packet);
+    // 对OnRtpPacket接受的包，把ssrc/序列号/时间戳原地改写成输出流
+    void RewritePacket(RtpPacketView* packet);
+
+    // 需要目标层的关键帧才能完成切换
+    sigslot::signal1<uint32_t> SignalKeyFrameRequest;
+
+private:
+    struct Layer {
+        Layer(uint32_t ssrc);
+
+        uint32_t ssrc;
+        webrtc::RateStatistics rate;
+    };
+
+    int GetLayerIndex(uint32_t ssrc) const;
+    int SelectTargetLayer(int64_t now_ms);
+    void SwitchToLayer(int layer, uint16_t seq_num, uint32_t timestamp, int64_t now_ms);
+    void MaybeRequestKeyFrame(int layer, int64_t now_ms);
+
+private:
+    webrtc::Clock* clock_;
+    std::vector<Layer> layers_;
+    uint32_t output_ssrc_;
+    int64_t bitrate_budget_bps_;
+
+    int current_layer_ = -1;
+    int target_layer_ = 0;
+    int64_t last_keyframe_request_ms_ = -1;
+
+    // 输出流的序列号和时间戳 = 输入 + offset
+    bool has_output_ = false;
+    uint16_t seq_num_offset_ = 0;
+    uint32_t timestamp_offset_ = 0;
+    uint16_t last_output_seq_num_ = 0;
+    uint32_t last_output_timestamp_ = 0;
+    int64_t last_output_time_ms_ = 0;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_VIDEO_SIMULCAST_LAYER_SELECTOR_H_
@@ -1,7 +1,19 @@
 #include "video/video_receive_stream.h"
 
+#include <string.h>
+
+#include <rtc_base/byte_io.h>
+#include <rtc_base/logging.h>
+
 namespace xrtc {
 
+namespace {
+
+// rtx包的payload前两个字节是原始包的序列号(OSN)
+const size_t kRtxHeaderSize = 2;
+
+} // namespace
+
 VideoReceiveStream::VideoReceiveStream(const VideoReceiveStreamConfig& config) :
     config_(config),
     rtp_receive_stat_(ReceiveStat::Create(config.clock)),
@@ -16,10 +28,55 @@ void VideoReceiveStream::OnRtpPacket(const webrtc::RtpPacketReceived& packet) {
     rtp_video_stream_receiver_.OnRtpPacket(packet);
 }
 
+bool VideoReceiveStream::OnRtxPacket(const webrtc::RtpPacketReceived& rtx_packet,
+        rtc::CopyOnWriteBuffer* media_packet)
+{
+    // rtx的padding包只用于带宽探测，不携带原始包
+    if (rtx_packet.payload_size() < kRtxHeaderSize) {
+        return false;
+    }
+
+    auto iter = config_.rtp.rtx_associated_payload_types.find(
+            rtx_packet.PayloadType());
+    if (iter == config_.rtp.rtx_associated_payload_types.end()) {
+        RTC_LOG(LS_WARNING) << "unknown rtx payload type: "
+            << (int)rtx_packet.PayloadType();
+        return false;
+    }
+
+    rtc::ArrayView<const uint8_t> payload = rtx_packet.payload();
+    webrtc::RtpPacketReceived restored_packet;
+    restored_packet.CopyHeaderFrom(rtx_packet);
+    restored_packet.SetSsrc(config_.rtp.remote_ssrc);
+    restored_packet.SetSequenceNumber(
+            rtc::ByteReader<uint16_t>::ReadBigEndian(payload.data()));
+    restored_packet.SetPayloadType(iter->second);
+    // 重传恢复的包不参与丢包和jitter统计，nack模块也不把它当作乱序
+    restored_packet.set_recovered(true);
+    restored_packet.set_arrival_time(rtx_packet.arrival_time());
+    restored_packet.set_payload_type_frequency(rtx_packet.payload_type_frequency());
+
+    // 去掉OSN，rtx包尾部的padding也不带到原始包中
+    rtc::ArrayView<const uint8_t> media_payload = payload.subview(kRtxHeaderSize);
+    uint8_t* media_payload_data = restored_packet.AllocatePayload(media_payload.size());
+    if (!media_payload_data) {
+        return false;
+    }
+    memcpy(media_payload_data, media_payload.data(), media_payload.size());
+
+    rtp_video_stream_receiver_.OnRtpPacket(restored_packet);
+    *media_packet = restored_packet.Buffer();
+    return true;
+}
+
 void VideoReceiveStream::DeliverRtcp(const uint8_t* data, size_t len) {
     rtp_video_stream_receiver_.DeliverRtcp(data, len);
 }
 
+void VideoReceiveStream::RequestKeyFrame() {
+    rtp_video_stream_receiver_.RequestKeyFrame();
+}
+
 } // namespace xrtc
 
 
@@ -12,7 +12,32 @@ public:
     ~VideoReceiveStream();
     
     void OnRtpPacket(const webrtc::RtpPacketReceived& packet);
+    // RFC4588: 还原rtx包中的原始序列号、ssrc和payload type之后再交给接收流，
+    // 还原出来的原始包通过media_packet返回，用于继续转发给拉流端
+    bool OnRtxPacket(const webrtc::RtpPacketReceived& rtx_packet,
+            rtc::CopyOnWriteBuffer* media_packet);
     void DeliverRtcp(const uint8_t* data, size_t len);
+    void RequestKeyFrame();
+    bool SendTransportFeedback(const webrtc::rtcp::TransportFeedback& packet) {
+        return rtp_video_stream_receiver_.SendTransportFeedback(packet);
+    }
+    void SetRemb(int64_t bitrate_bps, std::vector<uint32_t> ssrcs, bool send_now) {
+        rtp_video_stream_receiver_.SetRemb(bitrate_bps, std::move(ssrcs), send_now);
+    }
+    void UnsetRemb() {
+        rtp_video_stream_receiver_.UnsetRemb();
+    }
+    void UpdateRtt(int64_t rtt_ms) {
+        rtp_video_stream_receiver_.UpdateRtt(rtt_ms);
+    }
+    void SetFrameAssembly(bool enabled) {
+        rtp_video_stream_receiver_.SetFrameAssembly(enabled);
+    }
+
+    uint32_t remote_ssrc() const { return config_.rtp.remote_ssrc; }
+    int64_t last_keyframe_received_ms() const {
+        return rtp_video_stream_receiver_.last_keyframe_received_ms();
+    }
 
 private:
     VideoReceiveStreamConfig config_;
@@ -1,6 +1,8 @@
 #ifndef  XRTCSERVER_VIDEO_VIDEO_RECEIVE_STREAM_CONFIG_H_
 #define  XRTCSERVER_VIDEO_VIDEO_RECEIVE_STREAM_CONFIG_H_
 
+#include <map>
+
 #include <system_wrappers/include/clock.h>
 
 #include "base/event_loop.h"
@@ -8,17 +10,27 @@
 namespace xrtc {
 
 class RtpRtcpModuleObserver;
+class FeedbackScheduler;
 
 class VideoReceiveStreamConfig {
 public:
     EventLoop* el = nullptr;
     webrtc::Clock* clock = nullptr;
+    FeedbackScheduler* feedback_scheduler = nullptr;
 
     struct Rtp {
         uint32_t local_ssrc = 0;
         uint32_t remote_ssrc = 0;
+        uint32_t rtx_ssrc = 0;
+        // rtx payload type -> 原始包的payload type(apt)
+        std::map<int, int> rtx_associated_payload_types;
+        // 发送XR RRTR，推流端回复DLRR之后计算rtt
+        bool rtcp_xr_rrtr = false;
     } rtp;
 
+    // 是否解包组帧，关闭时只读取rtp头和NAL头判断关键帧，直接转发
+    bool frame_assembly = false;
+
     RtpRtcpModuleObserver* rtp_rtcp_module_observer = nullptr;
 };
 
@@ -0,0 +1,179 @@
+#include "video/video_send_stream.h"
+
+#include <rtc_base/logging.h>
+#include <rtc_base/byte_io.h>
+#include <modules/rtp_rtcp/source/rtp_packet.h>
+
+#include "base/metrics.h"
+
+namespace xrtc {
+
+namespace {
+
+// RFC2198: 只有一个block时RED头是1个字节，F=0，后面是block的负载类型
+const size_t kRedHeaderSize = 1;
+
+std::unique_ptr<RtpRtcpImpl> CreateRtpRtcpModule(
+        const VideoSendStreamConfig& vconf)
+{
+    RtpRtcpConfig config;
+    config.el = vconf.el;
+    config.clock = vconf.clock;
+    config.feedback_scheduler = vconf.feedback_scheduler;
+    config.audio = false;
+    config.local_media_ssrc = vconf.rtp.ssrc;
+    config.rtp_rtcp_module_observer = vconf.rtp_rtcp_module_observer;
+
+    auto rtp_rtcp = std::make_unique<RtpRtcpImpl>(config);
+    rtp_rtcp->SetRTCPStatus(webrtc::RtcpMode::kCompound);
+    rtp_rtcp->SetSendingStatus(true);
+    rtp_rtcp->SetRemoteSsrc(vconf.rtp.remote_ssrc);
+    return rtp_rtcp;
+}
+
+} // namespace
+
+VideoSendStream::VideoSendStream(const VideoSendStreamConfig& config) :
+    config_(config),
+    rtp_rtcp_(CreateRtpRtcpModule(config)),
+    packet_history_(config.clock)
+{
+}
+
+VideoSendStream::~VideoSendStream() {
+}
+
+void VideoSendStream::OnSendingRtpPacket(const RtpPacketView& packet) {
+    packet_history_.PutRtpPacket(packet.SequenceNumber(), packet.data(), packet.size());
+    rtp_rtcp_->OnSendingRtpPacket(packet.Timestamp(), packet.payload_size());
+}
+
+void VideoSendStream::DeliverRtcp(const uint8_t* data, size_t len) {
+    rtp_rtcp_->IncomingRtcpPacket(data, len);
+}
+
+void VideoSendStream::OnNackReceived(const std::vector<uint16_t>& nack_list) {
+    rtc::CopyOnWriteBuffer packet;
+    for (uint16_t seq_num : nack_list) {
+        if (packet_history_.GetPacketForRetransmission(seq_num, &packet)) {
+            SendRetransmission(packet);
+        }
+    }
+}
+
+void VideoSendStream::EnableUlpfec() {
+    if (!ulpfec_generator_) {
+        ulpfec_generator_ = std::make_unique<UlpfecGenerator>();
+    }
+}
+
+void VideoSendStream::SetFecProtectionFactor(uint8_t protection_factor) {
+    if (ulpfec_generator_) {
+        ulpfec_generator_->SetProtectionFactor(protection_factor);
+    }
+}
+
+void VideoSendStream::UpdateSequenceNumber(RtpPacketView* packet) {
+    if (fec_seq_offset_ != 0) {
+        packet->SetSequenceNumber(packet->SequenceNumber() + fec_seq_offset_);
+    }
+}
+
+rtc::CopyOnWriteBuffer VideoSendStream::ProtectRtpPacket(
+        const rtc::CopyOnWriteBuffer& packet,
+        const RtpPacketView& view,
+        std::vector<rtc::CopyOnWriteBuffer>* fec_packets)
+{
+    // padding包不封装也不保护
+    if (!ulpfec_generator_ || 0 == view.payload_size()) {
+        return packet;
+    }
+
+    // FEC保护的是RED封装之前的原始包，接收端解开RED之后再参与恢复
+    ulpfec_generator_->AddMediaPacket(packet, view.Marker());
+    rtc::CopyOnWriteBuffer red_packet = BuildRedPacket(view,
+            view.data() + view.headers_size(),
+            view.size() - view.headers_size(), view.PayloadType());
+
+    std::vector<rtc::CopyOnWriteBuffer> fec_data = ulpfec_generator_->GetFecPackets();
+    uint16_t seq_num = view.SequenceNumber();
+    for (const rtc::CopyOnWriteBuffer& fec : fec_data) {
+        rtc::CopyOnWriteBuffer fec_packet = BuildRedPacket(view, fec.data(), fec.size(),
+                config_.rtp.ulpfec_payload_type);
+        RtpPacketView fec_view;
+        fec_view.Parse(fec_packet.MutableData(), fec_packet.size());
+        fec_view.SetMarker(false);
+        fec_view.SetSequenceNumber(++seq_num);
+        fec_packets->push_back(std::move(fec_packet));
+    }
+
+    if (!fec_data.empty()) {
+        fec_seq_offset_ += fec_data.size();
+        Metrics::ThreadInstance()->Increment("fec_packets_sent", fec_data.size());
+    }
+
+    return red_packet;
+}
+
+rtc::CopyOnWriteBuffer VideoSendStream::BuildRedPacket(const RtpPacketView& view,
+        const uint8_t* payload, size_t payload_size, uint8_t block_payload_type)
+{
+    // 沿用媒体包的rtp头和扩展头，只改写负载类型
+    size_t headers_size = view.headers_size();
+    rtc::CopyOnWriteBuffer red_packet(headers_size + kRedHeaderSize + payload_size);
+    uint8_t* data = red_packet.MutableData();
+    memcpy(data, view.data(), headers_size);
+    data[headers_size] = block_payload_type & 0x7F;
+    memcpy(data + headers_size + kRedHeaderSize, payload, payload_size);
+    if (block_payload_type == config_.rtp.ulpfec_payload_type) {
+        // FEC包没有padding
+        data[0] &= ~0x20;
+    }
+
+    RtpPacketView red_view;
+    red_view.Parse(data, red_packet.size());
+    red_view.SetPayloadType(config_.rtp.red_payload_type);
+    return red_packet;
+}
+
+void VideoSendStream::SendRetransmission(const rtc::CopyOnWriteBuffer& packet) {
+    if (!config_.rtp_rtcp_module_observer) {
+        return;
+    }
+
+    if (0 == config_.rtp.rtx_ssrc) {
+        // 没有协商rtx，直接重发原始包
+        config_.rtp_rtcp_module_observer->OnLocalRtpPacket(webrtc::MediaType::VIDEO,
+                packet.data(), packet.size());
+        return;
+    }
+
+    webrtc::RtpPacket media_packet;
+    if (!media_packet.Parse(packet)) {
+        return;
+    }
+
+    // RFC4588: rtx包的payload前两个字节是原始包的序列号
+    webrtc::RtpPacket rtx_packet;
+    rtx_packet.CopyHeaderFrom(media_packet);
+    rtx_packet.SetSsrc(config_.rtp.rtx_ssrc);
+    rtx_packet.SetPayloadType(config_.rtp.rtx_payload_type);
+    rtx_packet.SetSequenceNumber(rtx_seq_num_++);
+
+    auto payload = media_packet.payload();
+    uint8_t* rtx_payload = rtx_packet.AllocatePayload(payload.size() + 2);
+    if (!rtx_payload) {
+        RTC_LOG(LS_WARNING) << "allocate rtx payload failed, seq_num: "
+            << media_packet.SequenceNumber();
+        return;
+    }
+
+    rtc::ByteWriter<uint16_t>::WriteBigEndian(rtx_payload,
+            media_packet.SequenceNumber());
+    memcpy(rtx_payload + 2, payload.data(), payload.size());
+
+    config_.rtp_rtcp_module_observer->OnLocalRtpPacket(webrtc::MediaType::VIDEO,
+            rtx_packet.data(), rtx_packet.size());
+}
+
+} // namespace xrtc
@@ -0,0 +1,56 @@
+#ifndef  XRTCSERVER_VIDEO_VIDEO_SEND_STREAM_H_
+#define  XRTCSERVER_VIDEO_VIDEO_SEND_STREAM_H_
+
+#include "video/video_send_stream_config.h"
+#include "modules/rtp_rtcp/rtp_rtcp_impl.h"
+#include "modules/rtp_rtcp/rtp_packet_history.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+#include "modules/fec/ulpfec_generator.h"
+
+namespace xrtc {
+
+// 拉流端的视频发送流，负责生成SR以及处理对端发来的NACK
+class VideoSendStream {
+public:
+    VideoSendStream(const VideoSendStreamConfig& config);
+    ~VideoSendStream();
+
+    uint32_t ssrc() const { return config_.rtp.ssrc; }
+    uint32_t rtx_ssrc() const { return config_.rtp.rtx_ssrc; }
+
+    void OnSendingRtpPacket(const RtpPacketView& packet);
+    void DeliverRtcp(const uint8_t* data, size_t len);
+    void OnNackReceived(const std::vector<uint16_t>& nack_list);
+    void SetRtt(int64_t rtt_ms) { packet_history_.SetRtt(rtt_ms); }
+
+    // 拉流端协商了red/ulpfec时开启，之后的媒体包都使用RED封装，
+    // FEC包和媒体包共用ssrc和序列号空间
+    void EnableUlpfec();
+    bool ulpfec_enabled() const { return ulpfec_generator_ != nullptr; }
+    void SetFecProtectionFactor(uint8_t protection_factor);
+    // 给已经发送的FEC包让出序列号，在打transport-cc序号之前调用
+    void UpdateSequenceNumber(RtpPacketView* packet);
+    // 最终发送的媒体包加入FEC编码，返回RED封装之后的包，
+    // 生成了FEC时追加到fec_packets，transport-cc序号由调用方改写
+    rtc::CopyOnWriteBuffer ProtectRtpPacket(const rtc::CopyOnWriteBuffer& packet,
+            const RtpPacketView& view,
+            std::vector<rtc::CopyOnWriteBuffer>* fec_packets);
+
+private:
+    void SendRetransmission(const rtc::CopyOnWriteBuffer& packet);
+    rtc::CopyOnWriteBuffer BuildRedPacket(const RtpPacketView& view,
+            const uint8_t* payload, size_t payload_size, uint8_t block_payload_type);
+
+private:
+    VideoSendStreamConfig config_;
+    std::unique_ptr<RtpRtcpImpl> rtp_rtcp_;
+    RtpPacketHistory packet_history_;
+    uint16_t rtx_seq_num_ = 0;
+    std::unique_ptr<UlpfecGenerator> ulpfec_generator_;
+    // 已经发送的FEC包个数，后续媒体包的序列号需要加上这个偏移
+    uint16_t fec_seq_offset_ = 0;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_VIDEO_VIDEO_SEND_STREAM_H_
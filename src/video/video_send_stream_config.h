@@ -0,0 +1,34 @@
+#ifndef  XRTCSERVER_VIDEO_VIDEO_SEND_STREAM_CONFIG_H_
+#define  XRTCSERVER_VIDEO_VIDEO_SEND_STREAM_CONFIG_H_
+
+#include <system_wrappers/include/clock.h>
+
+#include "base/event_loop.h"
+
+namespace xrtc {
+
+class RtpRtcpModuleObserver;
+class FeedbackScheduler;
+
+class VideoSendStreamConfig {
+public:
+    EventLoop* el = nullptr;
+    webrtc::Clock* clock = nullptr;
+    FeedbackScheduler* feedback_scheduler = nullptr;
+
+    struct Rtp {
+        uint32_t ssrc = 0;
+        uint32_t rtx_ssrc = 0;
+        uint32_t remote_ssrc = 0;
+        int payload_type = 107;
+        int rtx_payload_type = 99;
+        int red_payload_type = 116;
+        int ulpfec_payload_type = 117;
+    } rtp;
+
+    RtpRtcpModuleObserver* rtp_rtcp_module_observer = nullptr;
+};
+
+} // namespace xrtc
+
+#endif  //XRTCSERVER_VIDEO_VIDEO_SEND_STREAM_CONFIG_H_
@@ -7,10 +7,15 @@
 #define CMDNO_STOPPUSH 4
 #define CMDNO_STOPPULL 5
 
-#define MAX_RES_BUF 4096
+#include <memory>
+#include <string>
+
+#include "base/xhead.h"
 
 namespace xrtc {
 
+struct RemoteDescription;
+
 struct RtcMsg {
     int cmdno = -1;
     uint64_t uid = 0;
@@ -19,11 +24,16 @@ struct RtcMsg {
     int audio = 0;
     int video = 0;
     int is_dtls = 1;
+    int skip_silent_audio = 0;
     uint32_t log_id = 0;
     void* worker = nullptr;
     void* conn = nullptr;
     int fd = 0;
+    // 请求的xhead，响应时原样带回，长连接上用log_id/reserved关联请求和响应
+    xhead_t header;
     std::string sdp;
+    // answer在signaling线程中解析好，rtc worker直接应用
+    std::shared_ptr<RemoteDescription> remote_desc;
     int err_no = 0;
     void* certificate = nullptr;
 };
@@ -0,0 +1,610 @@
+#ifndef  __XRTCSERVER_TEST_LEGACY_SDP_H_
+#define  __XRTCSERVER_TEST_LEGACY_SDP_H_
+
+// 改成单次遍历的解析和SdpWriter之前的实现，逻辑保持原样，
+// 只用于和现在的实现对比输出(sdp测试)和性能(sdp性能测试)
+
+#include <sstream>
+
+#include <absl/algorithm/container.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/string_encode.h>
+
+#include "pc/remote_description.h"
+
+namespace xrtc {
+namespace legacy {
+
+const char kMediaProtocolDtlsSavpf[] = "UDP/TLS/RTP/SAVPF";
+const char kMediaProtocolSavpf[] = "RTP/SAVPF";
+const int kRedPayloadType = 116;
+const int kUlpfecPayloadType = 117;
+
+struct SsrcInfo {
+    uint32_t ssrc_id;
+    std::string cname;
+    std::string stream_id;
+    std::string track_id;
+};
+
+inline std::string GetAttribute(const std::string &line) {
+    std::vector<std::string> fields;
+    size_t size = rtc::tokenize(line, ':', &fields);
+    if (size != 2) {
+        RTC_LOG(LS_WARNING) << "get attribute error: " << line;
+        return "";
+    }
+
+    return fields[1];
+}
+
+inline int ParseTransportInfo(TransportDescription *td, const std::string &line) {
+    if (line.find("a=ice-ufrag") != std::string::npos) {
+        td->ice_ufrag = GetAttribute(line);
+        if (td->ice_ufrag.empty()) {
+            return -1;
+        }
+    } else if (line.find("a=ice-pwd") != std::string::npos) {
+        td->ice_pwd = GetAttribute(line);
+        if (td->ice_pwd.empty()) {
+            return -1;
+        }
+    } else if (line.find("a=fingerprint") != std::string::npos) {
+        std::vector<std::string> items;
+        rtc::tokenize(line, ' ', &items);
+        if (items.size() != 2) {
+            RTC_LOG(LS_WARNING) << "parse a=fingerprint error: " << line;
+            return -1;
+        }
+
+        // a=fingerprint: 14
+        std::string alg = items[0].substr(14);
+        absl::c_transform(alg, alg.begin(), ::tolower);
+        std::string content = items[1];
+
+        td->identity_fingerprint = rtc::SSLFingerprint::CreateUniqueFromRfc4572(
+                alg, content);
+        if (!(td->identity_fingerprint.get())) {
+            RTC_LOG(LS_WARNING) << "create fingerprint error: " << line;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+inline int ParseSsrcInfo(std::vector<SsrcInfo> &ssrc_info, const std::string &line) {
+    if (line.find("a=ssrc:") == std::string::npos) {
+        return 0;
+    }
+
+    std::string field1, field2;
+    if (!rtc::tokenize_first(line.substr(2), ' ', &field1, &field2)) {
+        RTC_LOG(LS_WARNING) << "parse a=ssrc failed, line: " << line;
+        return -1;
+    }
+
+    std::string ssrc_id_s = field1.substr(5);
+    uint32_t ssrc_id = 0;
+    if (!rtc::FromString(ssrc_id_s, &ssrc_id)) {
+        RTC_LOG(LS_WARNING) << "invalid ssrc_id, line: " << line;
+        return -1;
+    }
+
+    std::string attribute;
+    std::string value;
+    if (!rtc::tokenize_first(field2, ':', &attribute, &value)) {
+        RTC_LOG(LS_WARNING) << "get ssrc attribute failed, line: " << line;
+        return -1;
+    }
+
+    auto iter = ssrc_info.begin();
+    for (; iter != ssrc_info.end(); ++iter) {
+        if (iter->ssrc_id == ssrc_id) {
+            break;
+        }
+    }
+
+    if (iter == ssrc_info.end()) {
+        SsrcInfo info;
+        info.ssrc_id = ssrc_id;
+        ssrc_info.push_back(info);
+        iter = ssrc_info.end() - 1;
+    }
+
+    if ("cname" == attribute) {
+        iter->cname = value;
+    } else if ("msid" == attribute) {
+        std::vector<std::string> fields;
+        rtc::split(value, ' ', &fields);
+        if (fields.size() < 1 || fields.size() > 2) {
+            RTC_LOG(LS_WARNING) << "msid format error, line: " << line;
+            return -1;
+        }
+
+        iter->stream_id = fields[0];
+        if (fields.size() == 2) {
+            iter->track_id = fields[1];
+        }
+    }
+
+    return 0;
+}
+
+inline int ParseSsrcGroupInfo(std::vector<SsrcGroup> &ssrc_groups,
+                              const std::string &line) {
+    if (line.find("a=ssrc-group:") == std::string::npos) {
+        return 0;
+    }
+
+    std::vector<std::string> fields;
+    rtc::split(line.substr(2), ' ', &fields);
+    if (fields.size() < 2) {
+        RTC_LOG(LS_WARNING) << "ssrc-group field size < 2, line: " << line;
+        return -1;
+    }
+
+    std::string semantics = GetAttribute(fields[0]);
+    if (semantics.empty()) {
+        return -1;
+    }
+
+    std::vector<uint32_t> ssrcs;
+    for (size_t i = 1; i < fields.size(); ++i) {
+        uint32_t ssrc_id = 0;
+        if (!rtc::FromString(fields[i], &ssrc_id)) {
+            return -1;
+        }
+        ssrcs.push_back(ssrc_id);
+    }
+
+    ssrc_groups.push_back(SsrcGroup(semantics, ssrcs));
+
+    return 0;
+}
+
+inline int ParseExtmapInfo(MediaContentDescription *content, const std::string &line) {
+    if (line.find("a=extmap:") == std::string::npos) {
+        return 0;
+    }
+
+    std::vector<std::string> fields;
+    rtc::split(line.substr(2), ' ', &fields);
+    if (fields.size() < 2) {
+        RTC_LOG(LS_WARNING) << "extmap field size < 2, line: " << line;
+        return -1;
+    }
+
+    std::string value = GetAttribute(fields[0]);
+    std::string id_s = value.substr(0, value.find('/'));
+    int id = 0;
+    if (!rtc::FromString(id_s, &id)) {
+        RTC_LOG(LS_WARNING) << "invalid extmap id, line: " << line;
+        return -1;
+    }
+
+    content->AddRtpHeaderExtension(webrtc::RtpExtension(fields[1], id));
+    return 0;
+}
+
+inline int ParseRtxAptInfo(std::map<int, int> &rtx_apts, const std::string &line) {
+    if (line.find("a=fmtp:") == std::string::npos) {
+        return 0;
+    }
+
+    std::vector<std::string> fields;
+    rtc::split(line.substr(2), ' ', &fields);
+    if (fields.size() < 2) {
+        return 0;
+    }
+
+    std::vector<std::string> params;
+    rtc::split(fields[1], ';', &params);
+    for (auto param: params) {
+        if (param.find("apt=") != 0) {
+            continue;
+        }
+
+        int rtx_payload_type = 0;
+        int apt = 0;
+        if (!rtc::FromString(GetAttribute(fields[0]), &rtx_payload_type) ||
+            !rtc::FromString(param.substr(4), &apt))
+        {
+            RTC_LOG(LS_WARNING) << "invalid rtx apt, line: " << line;
+            return -1;
+        }
+
+        rtx_apts[rtx_payload_type] = apt;
+    }
+
+    return 0;
+}
+
+inline void CreateTrackFromSsrcInfo(const std::vector<SsrcInfo> &ssrc_infos,
+                                    std::vector<StreamParams> &tracks) {
+    for (auto ssrc_info: ssrc_infos) {
+        std::string track_id = ssrc_info.track_id;
+
+        auto iter = tracks.begin();
+        for (; iter != tracks.end(); ++iter) {
+            if (iter->id == track_id) {
+                break;
+            }
+        }
+
+        if (iter == tracks.end()) {
+            StreamParams track;
+            track.id = track_id;
+            tracks.push_back(track);
+            iter = tracks.end() - 1;
+        }
+
+        iter->cname = ssrc_info.cname;
+        iter->stream_id = ssrc_info.stream_id;
+        iter->ssrcs.push_back(ssrc_info.ssrc_id);
+    }
+}
+
+inline std::shared_ptr<RemoteDescription> ParseRemoteDescription(const std::string& sdp) {
+    std::vector<std::string> fields;
+    size_t size = rtc::tokenize(sdp, '\n', &fields);
+    if (size <= 0) {
+        RTC_LOG(LS_WARNING) << "sdp invalid";
+        return nullptr;
+    }
+
+    bool is_rn = false;
+    if (sdp.find("\r\n") != std::string::npos) {
+        is_rn = true;
+    }
+
+    auto remote = std::make_shared<RemoteDescription>();
+    remote->desc = std::make_shared<SessionDescription>(SdpType::kAnswer);
+
+    std::string media_type;
+
+    auto audio_content = std::make_shared<AudioContentDescription>();
+    auto video_content = std::make_shared<VideoContentDescription>();
+    audio_content->ClearRtpHeaderExtensions();
+    video_content->ClearRtpHeaderExtensions();
+    auto audio_td = std::make_shared<TransportDescription>();
+    auto video_td = std::make_shared<TransportDescription>();
+    std::vector<SsrcInfo> audio_ssrc_info;
+    std::vector<SsrcInfo> video_ssrc_info;
+    std::vector<SsrcGroup> video_ssrc_groups;
+    std::vector<StreamParams> audio_tracks;
+    std::vector<StreamParams> video_tracks;
+    std::map<int, int> video_rtx_apts;
+
+    for (auto field: fields) {
+        if (is_rn) {
+            field = field.substr(0, field.length() - 1);
+        }
+
+        if (field.find("m=group:BUNDLE") != std::string::npos) {
+            std::vector<std::string> items;
+            rtc::split(field, ' ', &items);
+            if (items.size() > 1) {
+                ContentGroup answer_bundle("BUNDLE");
+                for (size_t i = 1; i < items.size(); ++i) {
+                    answer_bundle.AddContentName(items[i]);
+                }
+                remote->desc->AddGroup(answer_bundle);
+            }
+        } else if (field.find("m=") != std::string::npos) {
+            std::vector<std::string> items;
+            rtc::split(field, ' ', &items);
+            if (items.size() <= 2) {
+                RTC_LOG(LS_WARNING) << "parse m= error: " << field;
+                return nullptr;
+            }
+
+            media_type = items[0].substr(2);
+            if ("audio" == media_type) {
+                remote->desc->AddContent(audio_content);
+                audio_td->mid = "audio";
+            } else if ("video" == media_type) {
+                remote->desc->AddContent(video_content);
+                video_td->mid = "video";
+
+                std::vector<std::string> payload_types(items.begin() + 3, items.end());
+                remote->ulpfec = absl::c_linear_search(payload_types,
+                        std::to_string(kRedPayloadType)) &&
+                    absl::c_linear_search(payload_types,
+                        std::to_string(kUlpfecPayloadType));
+            }
+        }
+
+        if ("audio" == media_type) {
+            if (ParseTransportInfo(audio_td.get(), field) != 0) {
+                return nullptr;
+            }
+
+            if (ParseExtmapInfo(audio_content.get(), field) != 0) {
+                return nullptr;
+            }
+
+            if (ParseSsrcInfo(audio_ssrc_info, field) != 0) {
+                return nullptr;
+            }
+
+        } else if ("video" == media_type) {
+            if (ParseTransportInfo(video_td.get(), field) != 0) {
+                return nullptr;
+            }
+
+            if (ParseExtmapInfo(video_content.get(), field) != 0) {
+                return nullptr;
+            }
+
+            if (ParseSsrcGroupInfo(video_ssrc_groups, field) != 0) {
+                return nullptr;
+            }
+
+            if (ParseSsrcInfo(video_ssrc_info, field) != 0) {
+                return nullptr;
+            }
+
+            if (ParseRtxAptInfo(video_rtx_apts, field) != 0) {
+                return nullptr;
+            }
+        }
+    }
+
+    if (!audio_ssrc_info.empty()) {
+        CreateTrackFromSsrcInfo(audio_ssrc_info, audio_tracks);
+
+        for (auto track: audio_tracks) {
+            audio_content->add_stream(track);
+        }
+    }
+
+    if (!video_ssrc_info.empty()) {
+        CreateTrackFromSsrcInfo(video_ssrc_info, video_tracks);
+
+        for (auto ssrc_group: video_ssrc_groups) {
+            if (ssrc_group.ssrcs.empty()) {
+                continue;
+            }
+
+            uint32_t ssrc = ssrc_group.ssrcs.front();
+            for (StreamParams &track: video_tracks) {
+                if (track.HasSsrc(ssrc)) {
+                    track.ssrc_groups.push_back(ssrc_group);
+                }
+            }
+        }
+
+        for (auto track: video_tracks) {
+            video_content->add_stream(track);
+        }
+    }
+
+    if (video_rtx_apts.empty()) {
+        for (auto &codec: video_content->codecs()) {
+            auto apt_iter = codec->codec_param.find("apt");
+            int apt = 0;
+            if (apt_iter != codec->codec_param.end() &&
+                rtc::FromString(apt_iter->second, &apt))
+            {
+                video_rtx_apts[codec->id] = apt;
+            }
+        }
+    }
+
+    remote->desc->AddTransportInfo(audio_td);
+    remote->desc->AddTransportInfo(video_td);
+    remote->audio_content = audio_content;
+    remote->video_content = video_content;
+    remote->video_rtx_apts = std::move(video_rtx_apts);
+
+    return remote;
+}
+
+inline const char* ConnectionRoleToString(ConnectionRole role) {
+    switch (role) {
+        case ConnectionRole::ACTIVE:
+            return "active";
+        case ConnectionRole::PASSIVE:
+            return "passive";
+        case ConnectionRole::ACTPASS:
+            return "actpass";
+        case ConnectionRole::HOLDCONN:
+            return "holdconn";
+        default:
+            return "none";
+    }
+}
+
+inline void AddRtcpFbLine(std::shared_ptr<CodecInfo> codec,
+        std::stringstream& ss)
+{
+    for (auto param : codec->feedback_param) {
+        ss << "a=rtcp-fb:" << codec->id << " " << param.id();
+        if (!param.param().empty()) {
+            ss << " " << param.param();
+        }
+        ss << "\r\n";
+    }
+}
+
+inline void AddFmtpLine(std::shared_ptr<CodecInfo> codec,
+        std::stringstream& ss)
+{
+    if (!codec->codec_param.empty()) {
+        ss << "a=fmtp:" << codec->id << " ";
+        std::string data;
+        for (auto param : codec->codec_param) {
+            data += (";" + param.first + "=" + param.second);
+        }
+        data = data.substr(1);
+        ss << data << "\r\n";
+    }
+}
+
+inline void BuildRtpMap(std::shared_ptr<MediaContentDescription> content,
+        std::stringstream& ss)
+{
+    for (auto codec : content->codecs()) {
+        ss << "a=rtpmap:" << codec->id << " " << codec->name << "/" << codec->clockrate;
+        if (MediaType::MEDIA_TYPE_AUDIO == content->type()) {
+            auto audio_codec = codec->as_audio();
+            ss << "/" << audio_codec->channels;
+        }
+        ss << "\r\n";
+
+        AddRtcpFbLine(codec, ss);
+        AddFmtpLine(codec, ss);
+    }
+}
+
+inline void BuildRtpHeaderExtensions(std::shared_ptr<MediaContentDescription> content,
+        std::stringstream& ss)
+{
+    for (auto ext : content->rtp_header_extensions()) {
+        ss << "a=extmap:" << ext.id << " " << ext.uri << "\r\n";
+    }
+}
+
+inline void BuildRtpDirection(std::shared_ptr<MediaContentDescription> content,
+        std::stringstream& ss)
+{
+    switch (content->direction()) {
+        case RtpDirection::kSendRecv:
+            ss << "a=sendrecv\r\n";
+            break;
+        case RtpDirection::kSendOnly:
+            ss << "a=sendonly\r\n";
+            break;
+        case RtpDirection::kRecvOnly:
+            ss << "a=recvonly\r\n";
+            break;
+        default:
+            ss << "a=inactive\r\n";
+            break;
+    }
+}
+
+inline void BuildCandidates(std::shared_ptr<MediaContentDescription> content,
+        std::stringstream& ss)
+{
+    for (auto c : content->candidates()) {
+        ss << "a=candidate:" << c.foundation
+           << " " << c.component
+           << " " << c.protocol
+           << " " << c.priority
+           << " " << c.address.HostAsURIString()
+           << " " << c.port
+           << " typ " << c.type
+           << "\r\n";
+    }
+}
+
+inline void AddSsrcLine(uint32_t ssrc,
+        const std::string& attribute,
+        const std::string& value,
+        std::stringstream& ss)
+{
+    ss << "a=ssrc:" << ssrc << " " << attribute << ":" << value << "\r\n";
+}
+
+inline void BuildSsrc(std::shared_ptr<MediaContentDescription> content,
+        std::stringstream& ss)
+{
+    for (auto track : content->streams()) {
+        for (auto ssrc_group : track.ssrc_groups) {
+            if (ssrc_group.ssrcs.empty()) {
+                continue;
+            }
+
+            ss << "a=ssrc-group:" << ssrc_group.semantics;
+            for (auto ssrc : ssrc_group.ssrcs) {
+                ss << " " << ssrc;
+            }
+            ss << "\r\n";
+        }
+
+        std::string msid = track.stream_id + " " + track.id;
+        for (auto ssrc : track.ssrcs) {
+            AddSsrcLine(ssrc, "cname", track.cname, ss);
+            AddSsrcLine(ssrc, "msid", msid, ss);
+            AddSsrcLine(ssrc, "mslabel", track.stream_id, ss);
+            AddSsrcLine(ssrc, "lable", track.id, ss);
+        }
+    }
+}
+
+// 原来的SessionDescription::ToString
+inline std::string ToString(SessionDescription* desc) {
+    std::stringstream ss;
+    ss << "v=0\r\n";
+    ss << "o=- 0 2 IN IP4 127.0.0.1\r\n";
+    ss << "s=-\r\n";
+    ss << "t=0 0\r\n";
+
+    std::vector<const ContentGroup*> content_group = desc->GetGroupByName("BUNDLE");
+    if (!content_group.empty()) {
+        ss << "a=group:BUNDLE";
+        for (auto group : content_group) {
+            for (auto content_name : group->content_names()) {
+                ss << " " << content_name;
+            }
+        }
+        ss << "\r\n";
+    }
+
+    ss << "a=msid-semantic: WMS\r\n";
+
+    for (auto content : desc->contents()) {
+        std::string fmt;
+        for (auto codec : content->codecs()) {
+            fmt.append(" ");
+            fmt.append(std::to_string(codec->id));
+        }
+
+        auto transport_info = desc->GetTransportInfo(content->mid());
+        if (transport_info && transport_info->identity_fingerprint.get()) {
+            ss << "m=" << content->mid() << " 9 " << kMediaProtocolDtlsSavpf
+                << fmt << "\r\n";
+        } else {
+            ss << "m=" << content->mid() << " 9 " << kMediaProtocolSavpf
+                << fmt << "\r\n";
+        }
+
+        ss << "c=IN IP4 0.0.0.0\r\n";
+        ss << "a=rtcp:9 IN IP4 0.0.0.0\r\n";
+
+        BuildCandidates(content, ss);
+
+        if (transport_info) {
+            ss << "a=ice-ufrag:" << transport_info->ice_ufrag << "\r\n";
+            ss << "a=ice-pwd:" << transport_info->ice_pwd << "\r\n";
+
+            auto fp = transport_info->identity_fingerprint.get();
+            if (fp) {
+                ss << "a=fingerprint:" << fp->algorithm << " " << fp->GetRfc4572Fingerprint()
+                    << "\r\n";
+                ss << "a=setup:" << ConnectionRoleToString(
+                        transport_info->connection_role) << "\r\n";
+            }
+        }
+
+        ss << "a=mid:" << content->mid() << "\r\n";
+        BuildRtpHeaderExtensions(content, ss);
+        BuildRtpDirection(content, ss);
+
+        if (content->rtcp_mux()) {
+            ss << "a=rtcp-mux\r\n";
+        }
+
+        BuildRtpMap(content, ss);
+        BuildSsrc(content, ss);
+    }
+
+    return ss.str();
+}
+
+} // namespace legacy
+} // namespace xrtc
+
+#endif  //__XRTCSERVER_TEST_LEGACY_SDP_H_
@@ -0,0 +1,243 @@
+// 发送端带宽估计在模拟链路上的行为：
+// 1. 链路带宽下降时，排队延迟增长，估计值降到新的带宽附近，带宽恢复后重新增长
+// 2. 没有拥塞只有随机丢包时，高丢包率下估计值下降，丢包消失后恢复
+// 发送端按照估计值发包，链路是固定带宽的FIFO队列加上固定的传播延迟，
+// 接收端每100ms回一个transport-cc反馈
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+#include "modules/congestion_controller/send_side_bandwidth_estimation.h"
+#include "test_util.h"
+
+namespace xrtc {
+namespace test {
+namespace {
+
+const int64_t kStartBitrateBps = 300000;
+const int64_t kMinBitrateBps = 50000;
+const int64_t kMaxBitrateBps = 5000000;
+const size_t kMaxPacketSize = 1200;
+// 发送端每5ms发送一批包，和pacer默认的处理间隔(pacer_process_interval)一致
+const int64_t kSendIntervalMs = 5;
+const int64_t kFeedbackIntervalMs = 100;
+const int64_t kPropagationDelayMs = 20;
+// 队列中最多排队这么长时间的数据，超出的包被丢弃
+const int64_t kMaxQueueDelayMs = 500;
+
+class SimulatedLink {
+public:
+    explicit SimulatedLink(uint32_t seed) : rng_(seed) {}
+
+    void set_capacity_bps(int64_t capacity_bps) { capacity_bps_ = capacity_bps; }
+    void set_loss_rate(double loss_rate) { loss_rate_ = loss_rate; }
+
+    // 队列满丢弃的包数和最大的排队延迟，基于延迟的估计应该在队列满之前降低码率
+    int dropped_packets() const { return dropped_packets_; }
+    int64_t max_queue_delay_ms() const { return max_queue_delay_us_ / 1000; }
+    void ResetStats() {
+        dropped_packets_ = 0;
+        max_queue_delay_us_ = 0;
+    }
+
+    // 返回到达接收端的时间，丢失时返回-1
+    int64_t Send(size_t size, int64_t send_time_us) {
+        if (dist_(rng_) < loss_rate_) {
+            return -1;
+        }
+
+        int64_t start_us = std::max(send_time_us, link_free_us_);
+        if (start_us - send_time_us > kMaxQueueDelayMs * 1000) {
+            ++dropped_packets_;
+            return -1;
+        }
+
+        max_queue_delay_us_ = std::max(max_queue_delay_us_, start_us - send_time_us);
+
+        link_free_us_ = start_us + static_cast<int64_t>(size) * 8 * 1000000 / capacity_bps_;
+        return link_free_us_ + kPropagationDelayMs * 1000;
+    }
+
+private:
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> dist_{0.0, 1.0};
+    int64_t capacity_bps_ = kMaxBitrateBps * 2;
+    double loss_rate_ = 0;
+    int64_t link_free_us_ = 0;
+    int dropped_packets_ = 0;
+    int64_t max_queue_delay_us_ = 0;
+};
+
+class LinkSimulation {
+public:
+    explicit LinkSimulation(uint32_t seed) :
+        link_(seed),
+        bwe_(kStartBitrateBps, kMinBitrateBps, kMaxBitrateBps) {}
+
+    SimulatedLink& link() { return link_; }
+    SendSideBandwidthEstimation& bwe() { return bwe_; }
+
+    // 运行duration_ms，返回这段时间内估计值的最小值和最大值
+    std::pair<int64_t, int64_t> Run(int64_t duration_ms) {
+        int64_t min_bps = bwe_.target_bitrate_bps();
+        int64_t max_bps = min_bps;
+        int64_t end_ms = now_ms_ + duration_ms;
+        for (; now_ms_ < end_ms; now_ms_ += kSendIntervalMs) {
+            SendPackets();
+            if (now_ms_ % kFeedbackIntervalMs == 0) {
+                SendFeedback();
+            }
+
+            min_bps = std::min(min_bps, bwe_.target_bitrate_bps());
+            max_bps = std::max(max_bps, bwe_.target_bitrate_bps());
+        }
+
+        return std::make_pair(min_bps, max_bps);
+    }
+
+private:
+    struct Packet {
+        uint16_t seq;
+        int64_t send_time_us;
+        // -1表示丢失
+        int64_t arrival_time_us;
+    };
+
+    void SendPackets() {
+        // 按照目标码率发送，不足一个包的部分累积到下一次
+        budget_bytes_ += bwe_.target_bitrate_bps() * kSendIntervalMs / 8000;
+        while (budget_bytes_ > 0) {
+            size_t size = std::min<int64_t>(budget_bytes_, kMaxPacketSize);
+            if (size < kMaxPacketSize / 4) {
+                break;
+            }
+
+            Packet packet;
+            packet.seq = next_seq_++;
+            packet.send_time_us = now_ms_ * 1000;
+            packet.arrival_time_us = link_.Send(size, packet.send_time_us);
+            bwe_.OnSentPacket(packet.seq, size, now_ms_);
+            in_flight_.push_back(packet);
+            budget_bytes_ -= size;
+        }
+    }
+
+    // 反馈包含已经确定状态的包：到达的包，以及之后有包到达的丢失的包
+    void SendFeedback() {
+        int64_t now_us = now_ms_ * 1000;
+        size_t end = 0;
+        for (size_t i = 0; i < in_flight_.size(); ++i) {
+            const Packet& packet = in_flight_[i];
+            if (packet.arrival_time_us < 0) {
+                continue;
+            }
+
+            if (packet.arrival_time_us > now_us) {
+                break;
+            }
+
+            end = i + 1;
+        }
+
+        if (0 == end) {
+            return;
+        }
+
+        webrtc::rtcp::TransportFeedback feedback;
+        feedback.SetBase(in_flight_[0].seq, in_flight_[0].send_time_us);
+        size_t reported = 0;
+        for (size_t i = 0; i < end; ++i) {
+            const Packet& packet = in_flight_[i];
+            if (packet.arrival_time_us < 0) {
+                continue;
+            }
+
+            if (!feedback.AddReceivedPacket(packet.seq, packet.arrival_time_us)) {
+                break;
+            }
+
+            reported = i + 1;
+        }
+
+        bwe_.OnTransportFeedback(feedback, now_ms_);
+        in_flight_.erase(in_flight_.begin(), in_flight_.begin() + reported);
+    }
+
+private:
+    SimulatedLink link_;
+    SendSideBandwidthEstimation bwe_;
+    int64_t now_ms_ = 0;
+    int64_t budget_bytes_ = 0;
+    uint16_t next_seq_ = 0;
+    std::deque<Packet> in_flight_;
+};
+
+void TestDelayBasedBackoff() {
+    LinkSimulation sim(1);
+    sim.link().set_capacity_bps(1500000);
+
+    // 从起始码率增长，稳定在链路带宽附近，排队延迟不会增长到丢包
+    sim.Run(30000);
+    sim.link().ResetStats();
+    auto range = sim.Run(20000);
+    XRTC_EXPECT_GE(range.first, 700000, "steady at 1.5Mbps");
+    XRTC_EXPECT_LE(range.second, 1800000, "steady at 1.5Mbps");
+    XRTC_EXPECT_EQ(sim.link().dropped_packets(), 0, "steady at 1.5Mbps");
+    XRTC_EXPECT_LE(sim.link().max_queue_delay_ms(), 300, "steady at 1.5Mbps");
+
+    // 带宽下降，排队延迟增长，估计值降到新的带宽附近
+    sim.link().set_capacity_bps(500000);
+    sim.Run(5000);
+    sim.link().ResetStats();
+    range = sim.Run(20000);
+    XRTC_EXPECT_LE(range.second, 700000, "capacity dropped to 500kbps");
+    XRTC_EXPECT_GE(range.first, 200000, "capacity dropped to 500kbps");
+    XRTC_EXPECT_EQ(sim.link().dropped_packets(), 0, "capacity dropped to 500kbps");
+    XRTC_EXPECT_LE(sim.link().max_queue_delay_ms(), 300, "capacity dropped to 500kbps");
+
+    // 带宽恢复后重新增长
+    sim.link().set_capacity_bps(1500000);
+    sim.Run(30000);
+    XRTC_EXPECT_GE(sim.bwe().target_bitrate_bps(), 1000000, "capacity restored");
+}
+
+void TestLossBasedBackoff() {
+    LinkSimulation sim(2);
+
+    // 链路带宽足够，没有丢包时增长到最大值
+    sim.Run(60000);
+    XRTC_EXPECT_EQ(sim.bwe().target_bitrate_bps(), kMaxBitrateBps, "no loss");
+
+    // 20%的随机丢包，基于丢包的估计值下降，基于延迟的估计值不受影响
+    sim.link().set_loss_rate(0.2);
+    sim.Run(10000);
+    int64_t lossy_bps = sim.bwe().target_bitrate_bps();
+    XRTC_EXPECT_LE(lossy_bps, kMaxBitrateBps / 4, "20% loss");
+    // 每20个包统计一次丢包率，低码率时单次的统计值波动较大
+    XRTC_EXPECT_GE(sim.bwe().loss_fraction(), 0.1, "20% loss");
+    XRTC_EXPECT_LE(sim.bwe().loss_fraction(), 0.5, "20% loss");
+    XRTC_EXPECT_EQ(sim.bwe().delay_based_bitrate_bps(), kMaxBitrateBps, "20% loss");
+
+    // 1%的丢包下重新增长
+    sim.link().set_loss_rate(0.01);
+    sim.Run(15000);
+    XRTC_EXPECT_GE(sim.bwe().target_bitrate_bps(), lossy_bps * 2, "1% loss");
+
+    sim.link().set_loss_rate(0);
+    sim.Run(60000);
+    XRTC_EXPECT_EQ(sim.bwe().target_bitrate_bps(), kMaxBitrateBps, "loss cleared");
+}
+
+} // namespace
+} // namespace test
+} // namespace xrtc
+
+int main() {
+    using namespace xrtc::test;
+
+    TestDelayBasedBackoff();
+    TestLossBasedBackoff();
+
+    return Finish("send_side_bandwidth_estimation_test");
+}
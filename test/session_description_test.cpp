@@ -0,0 +1,238 @@
+// sdp的解析和生成：
+// 1. 解析浏览器的answer(test/data)，检查解析出的字段
+// 2. SdpWriter生成的sdp和原来的std::stringstream实现逐字节一致，
+//    包括answer解析出的描述和服务器生成的推拉流offer
+// 3. offer模板生成的offer和ToString一致
+// 4. 生成的sdp再解析一次，重新生成的结果不变
+
+#include <fstream>
+#include <sstream>
+
+#include "pc/offer_template.h"
+#include "pc/remote_description.h"
+#include "legacy_sdp.h"
+#include "test_util.h"
+
+namespace xrtc {
+namespace test {
+namespace {
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+struct AnswerExpectation {
+    const char* file;
+    const char* ice_ufrag;
+    const char* ice_pwd;
+    const char* fingerprint;
+    bool ulpfec;
+    uint32_t audio_ssrc;
+    std::vector<uint32_t> video_ssrcs;
+    // 视频的FID group，空表示没有
+    std::vector<uint32_t> video_fid;
+    std::vector<int> audio_extension_ids;
+    std::vector<int> video_extension_ids;
+    // 原来的解析不支持会话级别的fingerprint
+    bool legacy_same;
+};
+
+template <typename T>
+std::string Join(const std::vector<T>& values) {
+    std::stringstream ss;
+    for (size_t i = 0; i < values.size(); ++i) {
+        ss << (i ? " " : "") << values[i];
+    }
+    return ss.str();
+}
+
+std::vector<int> ExtensionIds(std::shared_ptr<MediaContentDescription> content) {
+    std::vector<int> ids;
+    for (const auto& ext : content->rtp_header_extensions()) {
+        ids.push_back(ext.id);
+    }
+    return ids;
+}
+
+void TestAnswer(const AnswerExpectation& e) {
+    std::string sdp = ReadFile(std::string("data/") + e.file);
+    if (!XRTC_EXPECT_TRUE(!sdp.empty(), e.file)) {
+        return;
+    }
+
+    auto remote = ParseRemoteDescription(sdp);
+    if (!XRTC_EXPECT_TRUE(remote != nullptr, e.file)) {
+        return;
+    }
+
+    SessionDescription* desc = remote->desc.get();
+    XRTC_EXPECT_EQ(desc->contents().size(), (size_t)2, e.file);
+    for (const char* mid : {"audio", "video"}) {
+        auto td = desc->GetTransportInfo(mid);
+        if (!XRTC_EXPECT_TRUE(td != nullptr, e.file)) {
+            continue;
+        }
+
+        XRTC_EXPECT_EQ(td->ice_ufrag, std::string(e.ice_ufrag), e.file);
+        XRTC_EXPECT_EQ(td->ice_pwd, std::string(e.ice_pwd), e.file);
+        if (XRTC_EXPECT_TRUE(td->identity_fingerprint != nullptr, e.file)) {
+            XRTC_EXPECT_EQ(td->identity_fingerprint->algorithm, std::string("sha-256"),
+                    e.file);
+            XRTC_EXPECT_EQ(td->identity_fingerprint->GetRfc4572Fingerprint(),
+                    std::string(e.fingerprint), e.file);
+        }
+    }
+
+    XRTC_EXPECT_EQ(remote->ulpfec, e.ulpfec, e.file);
+    XRTC_EXPECT_EQ(remote->video_rtx_apts.size(), (size_t)1, e.file);
+    XRTC_EXPECT_EQ(remote->video_rtx_apts[99], 107, e.file);
+    XRTC_EXPECT_EQ(Join(ExtensionIds(remote->audio_content)),
+            Join(e.audio_extension_ids), e.file);
+    XRTC_EXPECT_EQ(Join(ExtensionIds(remote->video_content)),
+            Join(e.video_extension_ids), e.file);
+
+    const auto& audio_streams = remote->audio_content->streams();
+    if (XRTC_EXPECT_EQ(audio_streams.size(), (size_t)1, e.file)) {
+        XRTC_EXPECT_EQ(audio_streams[0].FirstSsrc(), e.audio_ssrc, e.file);
+    }
+
+    const auto& video_streams = remote->video_content->streams();
+    if (XRTC_EXPECT_EQ(video_streams.size(), (size_t)1, e.file)) {
+        XRTC_EXPECT_EQ(Join(video_streams[0].ssrcs), Join(e.video_ssrcs), e.file);
+        const SsrcGroup* fid = video_streams[0].GetSsrcGroup(kFidSsrcGroupSemantics);
+        XRTC_EXPECT_EQ(fid ? Join(fid->ssrcs) : std::string(), Join(e.video_fid),
+                e.file);
+    }
+
+    // 新旧两种生成方式的输出一致
+    std::string sdp_out = desc->ToString();
+    XRTC_EXPECT_EQ(sdp_out, legacy::ToString(desc), e.file);
+
+    // 新旧两种解析方式得到的描述一致
+    auto legacy_remote = legacy::ParseRemoteDescription(sdp);
+    if (XRTC_EXPECT_TRUE(legacy_remote != nullptr, e.file)) {
+        XRTC_EXPECT_EQ(legacy_remote->desc->ToString() == sdp_out, e.legacy_same, e.file);
+        XRTC_EXPECT_EQ(legacy_remote->ulpfec, remote->ulpfec, e.file);
+        XRTC_EXPECT_TRUE(legacy_remote->video_rtx_apts == remote->video_rtx_apts, e.file);
+    }
+
+    // 生成的sdp再解析，重新生成的结果不变
+    auto reparsed = ParseRemoteDescription(sdp_out);
+    if (XRTC_EXPECT_TRUE(reparsed != nullptr, e.file)) {
+        XRTC_EXPECT_EQ(reparsed->desc->ToString(), sdp_out, e.file);
+    }
+}
+
+Candidate MakeCandidate() {
+    Candidate c;
+    c.component = IceCandidateComponent::RTP;
+    c.protocol = "udp";
+    c.address = rtc::SocketAddress("192.168.1.10", 8000);
+    c.port = 8000;
+    c.priority = 2130706431;
+    c.type = "host";
+    c.foundation = "4208434592";
+    return c;
+}
+
+// 和PeerConnection::CreateOffer生成的结构一致
+std::unique_ptr<SessionDescription> MakeOffer(bool push, bool with_fingerprint) {
+    auto desc = std::make_unique<SessionDescription>(SdpType::kOffer);
+    std::vector<Candidate> candidates = {MakeCandidate()};
+
+    auto audio = std::make_shared<AudioContentDescription>();
+    auto video = std::make_shared<VideoContentDescription>();
+    audio->set_direction(push ? RtpDirection::kRecvOnly : RtpDirection::kSendOnly);
+    video->set_direction(push ? RtpDirection::kRecvOnly : RtpDirection::kSendOnly);
+
+    if (!push) {
+        StreamParams audio_stream;
+        audio_stream.id = "audio-track";
+        audio_stream.stream_id = "xrtc-stream";
+        audio_stream.cname = "xrtc";
+        audio_stream.ssrcs = {1001};
+        audio->add_stream(audio_stream);
+
+        StreamParams video_stream;
+        video_stream.id = "video-track";
+        video_stream.stream_id = "xrtc-stream";
+        video_stream.cname = "xrtc";
+        video_stream.ssrcs = {2001, 2002};
+        video_stream.ssrc_groups.push_back(SsrcGroup(kFidSsrcGroupSemantics, {2001, 2002}));
+        video->add_stream(video_stream);
+        video->AddFecCodecs();
+    }
+
+    ContentGroup bundle("BUNDLE");
+    for (std::shared_ptr<MediaContentDescription> content :
+            std::vector<std::shared_ptr<MediaContentDescription>>{audio, video})
+    {
+        content->add_candidates(candidates);
+        desc->AddContent(content);
+        bundle.AddContentName(content->mid());
+
+        auto td = std::make_shared<TransportDescription>();
+        td->mid = content->mid();
+        td->ice_ufrag = "aB3d";
+        td->ice_pwd = "q2W3e4R5t6Y7u8I9o0P1a2S3";
+        td->connection_role = ConnectionRole::ACTPASS;
+        if (with_fingerprint) {
+            td->identity_fingerprint = rtc::SSLFingerprint::CreateUniqueFromRfc4572(
+                    "sha-256", "22:B0:D3:38:A5:19:16:8D:4F:E8:17:70:92:BE:CC:0F:"
+                    "7F:46:31:D8:C0:A7:B7:89:CC:1A:D3:69:21:82:A3:45");
+        }
+        desc->AddTransportInfo(td);
+    }
+    desc->AddGroup(bundle);
+
+    return desc;
+}
+
+void TestOffer(bool push, bool with_fingerprint) {
+    const char* name = push ? (with_fingerprint ? "push offer" : "push offer without dtls")
+        : (with_fingerprint ? "pull offer" : "pull offer without dtls");
+    auto desc = MakeOffer(push, with_fingerprint);
+    std::string sdp = desc->ToString();
+    XRTC_EXPECT_EQ(sdp, legacy::ToString(desc.get()), name);
+
+    // 第一次生成模板，第二次使用缓存的模板
+    uint32_t key = (push ? 0x1000 : 0x2000) | (with_fingerprint ? 0x40 : 0);
+    XRTC_EXPECT_EQ(OfferTemplateCache::ThreadInstance()->Render(key, desc.get()), sdp, name);
+    XRTC_EXPECT_EQ(OfferTemplateCache::ThreadInstance()->Render(key, desc.get()), sdp, name);
+}
+
+} // namespace
+} // namespace test
+} // namespace xrtc
+
+int main() {
+    using namespace xrtc::test;
+
+    AnswerExpectation chrome = {
+        "chrome_answer.sdp", "Hq7N", "Zs0vTq3GJ1aK9cW6yR2mPxLb",
+        "22:B0:D3:38:A5:19:16:8D:4F:E8:17:70:92:BE:CC:0F:"
+            "7F:46:31:D8:C0:A7:B7:89:CC:1A:D3:69:21:82:A3:45",
+        false, 2283701342u, {1673019512u, 3902461857u}, {1673019512u, 3902461857u},
+        {1, 3}, {2, 3}, true,
+    };
+    AnswerExpectation firefox = {
+        "firefox_answer.sdp", "8e0d3f2a", "5c2be93a1f7d40e6b8a3c9d17e4f0a62",
+        "F9:71:A7:82:DF:FA:FF:C2:89:0B:4C:05:66:2B:9B:20:"
+            "1B:BF:1D:DF:A7:25:F3:62:DA:98:F6:51:85:E1:AE:35",
+        true, 3487225012u, {1029384756u}, {},
+        {1, 3}, {2, 3}, false,
+    };
+    TestAnswer(chrome);
+    TestAnswer(firefox);
+
+    for (bool push : {true, false}) {
+        for (bool with_fingerprint : {true, false}) {
+            TestOffer(push, with_fingerprint);
+        }
+    }
+
+    return Finish("session_description_test");
+}
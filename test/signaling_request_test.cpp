@@ -0,0 +1,289 @@
+// ParseSignalingRequest和原来基于jsoncpp的解析对比：
+// 同一个body，两边的成功/失败要一致，成功时每个字段的取值要一致
+
+#include <string.h>
+
+#include <memory>
+#include <string>
+
+#include <json/json.h>
+
+#include "server/signaling_request.h"
+#include "test_util.h"
+
+namespace xrtc {
+namespace test {
+namespace {
+
+// 原来的实现: CharReader解析出错，或者字段取值抛出异常时请求失败
+int ParseWithJsonCpp(const std::string& body, SignalingRequest* req) {
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    Json::Value root;
+    JSONCPP_STRING err;
+    reader->parse(body.data(), body.data() + body.size(), &root, &err);
+    if (!err.empty()) {
+        return -1;
+    }
+
+    try {
+        req->cmdno = root["cmdno"].asInt();
+        req->uid = root["uid"].asUInt64();
+        req->stream_name = root["stream_name"].asString();
+        req->audio = root["audio"].asInt();
+        req->video = root["video"].asInt();
+        req->is_dtls = root["is_dtls"].asInt();
+        req->skip_silent_audio = root.get("skip_silent_audio", 0).asInt();
+        req->answer = root["answer"].asString();
+        req->type = root["type"].asString();
+    } catch (const Json::Exception&) {
+        return -1;
+    }
+
+    return 0;
+}
+
+struct Case {
+    const char* name;
+    const char* body;
+};
+
+const Case kCases[] = {
+    // 正常的请求
+    {"push", R"({"cmdno":1,"uid":12345678901234,"stream_name":"abc","audio":1,)"
+        R"("video":1,"is_dtls":1})"},
+    {"pull", R"({"cmdno":2,"uid":7,"stream_name":"s","audio":1,"video":0,)"
+        R"("is_dtls":0,"skip_silent_audio":1})"},
+    {"answer", R"({"cmdno":3,"uid":7,"stream_name":"s","type":"push",)"
+        R"("answer":"v=0\r\no=- 1 2 IN IP4 127.0.0.1\r\ns=-\r\n"})"},
+    {"empty object", "{}"},
+    {"whitespace", " \t\r\n{ \"cmdno\" :\t1 ,\n\"uid\" : 2 }\r\n"},
+    {"unknown fields", R"({"extra":{"a":[1,2,{"b":null}],"c":true,"d":-1.5e3},)"
+        R"("cmdno":1,"list":[],"obj":{}})"},
+    {"duplicate key", R"({"cmdno":1,"cmdno":2})"},
+
+    // 转义字符
+    {"simple escapes", R"({"stream_name":"a\"b\\c\/d\be\ff\ng\rh\ti"})"},
+    {"unicode escape", R"({"stream_name":"caf\u00e9 \u4e2d\u6587 \u0041"})"},
+    {"utf-8 passthrough", "{\"stream_name\":\"caf\xc3\xa9\"}"},
+    {"escaped key", R"({"\u0063mdno":5,"stream\u005fname":"x"})"},
+    {"escaped unknown key", R"({"a\"b":1,"cmdno":1})"},
+    {"invalid escape", R"({"stream_name":"a\qb"})"},
+    {"short unicode escape", R"({"stream_name":"\u12"})"},
+    {"bad hex", R"({"stream_name":"\u12g4"})"},
+
+    // utf-16代理对
+    {"surrogate pair", R"({"stream_name":"\ud83d\ude00"})"},
+    {"surrogate pair upper", R"({"stream_name":"x\uD83D\uDE00y"})"},
+    {"lone low surrogate", R"({"stream_name":"\ude00"})"},
+    {"high surrogate then high", R"({"stream_name":"\ud83d\ud83d"})"},
+    {"lone high surrogate", R"({"stream_name":"\ud83d"})"},
+    {"high surrogate then char", R"({"stream_name":"\ud83dx"})"},
+    {"high surrogate then bmp", R"({"stream_name":"\ud83dA"})"},
+
+    // 数字
+    {"negative int", R"({"cmdno":-5})"},
+    {"float to int", R"({"cmdno":2.9,"audio":-1.5})"},
+    {"exponent to int", R"({"cmdno":1e2})"},
+    {"int max", R"({"cmdno":2147483647})"},
+    {"int min", R"({"cmdno":-2147483648})"},
+    {"int overflow", R"({"cmdno":2147483648})"},
+    {"int underflow", R"({"cmdno":-2147483649})"},
+    {"uint64 max", R"({"uid":18446744073709551615})"},
+    {"uint64 overflow", R"({"uid":18446744073709551616})"},
+    {"uint64 huge", R"({"uid":1e30})"},
+    {"uint64 negative", R"({"uid":-1})"},
+    {"uint64 negative zero", R"({"uid":-0})"},
+    {"uint64 float", R"({"uid":3.7})"},
+    {"int64 overflow in unknown field", R"({"x":123456789012345678901234567890,"cmdno":1})"},
+    {"leading zero", R"({"cmdno":007,"stream_name":00})"},
+    {"lone minus", R"({"cmdno":-,"stream_name":-})"},
+    {"lone plus", R"({"cmdno":+})"},
+    {"plus sign", R"({"cmdno":+1,"stream_name":+1})"},
+    {"trailing dot", R"({"cmdno":1.,"stream_name":1.})"},
+    {"dot exponent", R"({"cmdno":1.e5})"},
+    {"minus fraction", R"({"audio":-.5,"stream_name":-.5})"},
+    {"leading dot", R"({"cmdno":.5})"},
+    {"empty exponent", R"({"cmdno":1e})"},
+    {"empty exponent sign", R"({"cmdno":1e+})"},
+    {"double overflow", R"({"cmdno":1e400})"},
+    {"double overflow unknown", R"({"x":-1e400})"},
+    {"double underflow", R"({"cmdno":1e-400,"stream_name":1e-400})"},
+    {"double sign", R"({"cmdno":--1})"},
+    {"hex number", R"({"cmdno":0x10})"},
+    {"two dots", R"({"cmdno":1.5.5})"},
+    {"int64 min to string", R"({"stream_name":-9223372036854775808})"},
+    {"int64 underflow to string", R"({"stream_name":-9223372036854775809})"},
+    {"uint64 to int", R"({"cmdno":9223372036854775808})"},
+    {"float to uint64", R"({"uid":2147483647.5})"},
+    {"negative fraction to uint64", R"({"uid":-0.5})"},
+    {"negative zero float to uint64", R"({"uid":-0.0,"stream_name":-0.0})"},
+    {"long fraction to string", R"({"stream_name":0.)"
+        R"(000000000000000000000000000000000000000000000000000000000000000000001})"},
+    {"exponent to int", R"({"cmdno":-1E+2,"stream_name":1.2e-3})"},
+    {"big exponent to string", R"({"stream_name":1e300})"},
+    {"infinity", R"({"cmdno":Infinity})"},
+    {"nan", R"({"cmdno":NaN})"},
+
+    // bool和null的转换
+    {"bool to int", R"({"cmdno":true,"audio":false,"video":null})"},
+    {"bool to uint64", R"({"uid":true})"},
+    {"null to uint64", R"({"uid":null})"},
+    {"bool to string", R"({"stream_name":true,"type":false})"},
+    {"null to string", R"({"stream_name":null})"},
+    {"int to string", R"({"stream_name":12,"type":-3})"},
+    {"uint64 to string", R"({"stream_name":18446744073709551615})"},
+    {"float to string", R"({"stream_name":1.5})"},
+    {"exponent to string", R"({"stream_name":1e2})"},
+    {"fraction to string", R"({"stream_name":0.1})"},
+    {"negative zero to string", R"({"stream_name":-0})"},
+    {"string to int", R"({"cmdno":"1"})"},
+    {"string to uint64", R"({"uid":"1"})"},
+    {"object to int", R"({"cmdno":{}})"},
+    {"array to string", R"({"stream_name":[]})"},
+    {"object to string", R"({"answer":{"sdp":"v=0"}})"},
+    {"bad literal", R"({"cmdno":tru})"},
+    {"literal with suffix", R"({"cmdno":truex})"},
+    {"null literal to string", R"({"stream_name":nul})"},
+
+    // 同一个key重复出现，以最后一次为准
+    {"duplicate key fixes type", R"({"cmdno":"1","cmdno":2})"},
+    {"duplicate key breaks type", R"({"cmdno":1,"cmdno":"2"})"},
+    {"duplicate string key", R"({"stream_name":{},"stream_name":"a"})"},
+
+    // 注释
+    {"block comment", R"({"cmdno":1 /* c */})"},
+    {"comments around value", R"(/*a*/{/*b*/"cmdno":/*c*/1/*d*/,/*e*/"uid"://x)" "\n" R"(2})"},
+    {"line comment", "{\"cmdno\":1 // c\n}"},
+    {"line comment eats brace", R"({"cmdno":1 // c})"},
+    {"comment before colon", R"({"cmdno" /*c*/ :1})"},
+    {"comment without comma", R"({"cmdno":1 /*c*/ "uid":2})"},
+    {"unterminated comment", R"({"cmdno":1 /* c })"},
+    {"single slash", R"({"cmdno":1 / })"},
+    {"comment in unknown array", R"({"x":[/*c*/1 /*d*/, 2/*e*/],"cmdno":1})"},
+    {"comment after array comma", R"({"x":[1,/*c*/],"cmdno":1})"},
+    {"comment in empty array", R"({"x":[/*c*/],"cmdno":1})"},
+    {"comment after root", R"({"cmdno":1}/*)"},
+
+    // 末尾的逗号和多余的内容
+    {"trailing comma", R"({"cmdno":1,})"},
+    {"trailing comma with space", "{\"cmdno\":1 , }"},
+    {"trailing comma in unknown array", R"({"x":[1,2,],"cmdno":1})"},
+    {"trailing comma in unknown object", R"({"x":{"a":1,},"cmdno":1})"},
+    {"trailing comma with space in array", R"({"x":[1, ],"cmdno":1})"},
+    {"empty array with space", R"({"x":[ ],"cmdno":1})"},
+    {"only comma in array", R"({"x":[,],"cmdno":1})"},
+    {"double comma in array", R"({"x":[1,,],"cmdno":1})"},
+    {"missing comma in array", R"({"x":[1 2],"cmdno":1})"},
+    {"only comma in object", R"({,})"},
+    {"leading comma", R"({,"cmdno":1})"},
+    {"double comma", R"({"cmdno":1,,"uid":2})"},
+    {"trailing content", R"({"cmdno":1} trailing)"},
+    {"second object", R"({"cmdno":1}{"cmdno":2})"},
+
+    // 不是合法的json对象
+    {"empty body", ""},
+    {"array body", "[1]"},
+    {"string body", R"("cmdno")"},
+    {"number body", "1"},
+    {"null body", "null"},
+    {"null body with space", " null "},
+    {"bool body", "true"},
+    {"numeric key", R"({1:2})"},
+    {"unterminated object", R"({"cmdno":1)"},
+    {"unterminated string", R"({"stream_name":"abc)"},
+    {"missing colon", R"({"cmdno" 1})"},
+    {"missing value", R"({"cmdno":})"},
+    {"unquoted key", R"({cmdno:1})"},
+    {"single quotes", R"({'cmdno':1})"},
+};
+
+void RunCase(const Case& c) {
+    std::string body(c.body);
+    SignalingRequest expected;
+    int expected_ret = ParseWithJsonCpp(body, &expected);
+
+    SignalingRequest actual;
+    std::string err;
+    int ret = ParseSignalingRequest(body.data(), body.size(), &actual, &err);
+
+    if (!XRTC_EXPECT_EQ(ret, expected_ret, c.name)) {
+        fprintf(stderr, "  body: %s\n  err: %s\n", c.body, err.c_str());
+        return;
+    }
+
+    if (ret != 0) {
+        XRTC_EXPECT_TRUE(!err.empty(), c.name);
+        return;
+    }
+
+    XRTC_EXPECT_EQ(actual.cmdno, expected.cmdno, c.name);
+    XRTC_EXPECT_EQ(actual.uid, expected.uid, c.name);
+    XRTC_EXPECT_EQ(actual.stream_name, expected.stream_name, c.name);
+    XRTC_EXPECT_EQ(actual.audio, expected.audio, c.name);
+    XRTC_EXPECT_EQ(actual.video, expected.video, c.name);
+    XRTC_EXPECT_EQ(actual.is_dtls, expected.is_dtls, c.name);
+    XRTC_EXPECT_EQ(actual.skip_silent_audio, expected.skip_silent_audio, c.name);
+    XRTC_EXPECT_EQ(actual.answer, expected.answer, c.name);
+    XRTC_EXPECT_EQ(actual.type, expected.type, c.name);
+}
+
+// 未知字段中较深的嵌套
+void TestDeepNesting() {
+    std::string body = R"({"x":)";
+    for (int i = 0; i < 100; ++i) {
+        body += (i % 2) ? R"({"a":)" : "[";
+    }
+    body += "1";
+    for (int i = 99; i >= 0; --i) {
+        body += (i % 2) ? "}" : "]";
+    }
+    body += R"(,"cmdno":7})";
+
+    Case c = {"deep nesting", body.c_str()};
+    RunCase(c);
+}
+
+// 同一个对象复用时不能残留上一个请求的字段
+void TestReuse() {
+    SignalingRequest req;
+    std::string err;
+    std::string first = R"({"cmdno":3,"uid":9,"stream_name":"a","answer":"x","type":"pull"})";
+    std::string second = R"({"cmdno":4})";
+    XRTC_EXPECT_EQ(ParseSignalingRequest(first.data(), first.size(), &req, &err), 0,
+            "reuse");
+    XRTC_EXPECT_EQ(ParseSignalingRequest(second.data(), second.size(), &req, &err), 0,
+            "reuse");
+    XRTC_EXPECT_EQ(req.cmdno, 4, "reuse");
+    XRTC_EXPECT_EQ(req.uid, (uint64_t)0, "reuse");
+    XRTC_EXPECT_EQ(req.stream_name, std::string(), "reuse");
+    XRTC_EXPECT_EQ(req.answer, std::string(), "reuse");
+    XRTC_EXPECT_EQ(req.type, std::string(), "reuse");
+}
+
+// body不以\0结尾，解析不能越过长度
+void TestNotNulTerminated() {
+    std::string body = R"({"cmdno":12})";
+    std::string truncated = body.substr(0, body.size() - 2);
+    SignalingRequest req;
+    std::string err;
+    XRTC_EXPECT_EQ(ParseSignalingRequest(truncated.data(), truncated.size(), &req, &err),
+            -1, "not nul terminated");
+}
+
+} // namespace
+} // namespace test
+} // namespace xrtc
+
+int main() {
+    using namespace xrtc::test;
+
+    for (const Case& c : kCases) {
+        RunCase(c);
+    }
+
+    TestDeepNesting();
+    TestReuse();
+    TestNotNulTerminated();
+    return Finish("signaling_request_test");
+}
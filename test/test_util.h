@@ -0,0 +1,77 @@
+#ifndef  __XRTCSERVER_TEST_TEST_UTIL_H_
+#define  __XRTCSERVER_TEST_TEST_UTIL_H_
+
+#include <stdio.h>
+
+#include <sstream>
+
+namespace xrtc {
+namespace test {
+
+// 没有引入测试框架，每个测试是一个可执行文件，失败时返回非0
+inline int& FailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+inline int Finish(const char* name) {
+    if (FailureCount() > 0) {
+        fprintf(stderr, "%s: %d failure(s)\n", name, FailureCount());
+        return 1;
+    }
+
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+template <typename A, typename B>
+bool ExpectEq(const A& actual, const B& expected, const char* actual_expr,
+        const char* context, const char* file, int line)
+{
+    if (actual == expected) {
+        return true;
+    }
+
+    std::ostringstream ss;
+    ss << file << ":" << line << ": " << context << ": " << actual_expr
+        << " = " << actual << ", expected " << expected;
+    fprintf(stderr, "%s\n", ss.str().c_str());
+    ++FailureCount();
+    return false;
+}
+
+// 范围检查，不成立时输出实际值和边界
+template <typename A, typename B>
+bool ExpectCompare(bool ok, const A& actual, const B& bound, const char* actual_expr,
+        const char* op, const char* context, const char* file, int line)
+{
+    if (ok) {
+        return true;
+    }
+
+    std::ostringstream ss;
+    ss << file << ":" << line << ": " << context << ": " << actual_expr
+        << " = " << actual << ", expected " << op << " " << bound;
+    fprintf(stderr, "%s\n", ss.str().c_str());
+    ++FailureCount();
+    return false;
+}
+
+} // namespace test
+} // namespace xrtc
+
+#define XRTC_EXPECT_TRUE(cond, context) \
+    xrtc::test::ExpectEq((bool)(cond), true, #cond, context, __FILE__, __LINE__)
+
+#define XRTC_EXPECT_EQ(actual, expected, context) \
+    xrtc::test::ExpectEq(actual, expected, #actual, context, __FILE__, __LINE__)
+
+#define XRTC_EXPECT_LE(actual, bound, context) \
+    xrtc::test::ExpectCompare((actual) <= (bound), actual, bound, #actual, "<=", \
+            context, __FILE__, __LINE__)
+
+#define XRTC_EXPECT_GE(actual, bound, context) \
+    xrtc::test::ExpectCompare((actual) >= (bound), actual, bound, #actual, ">=", \
+            context, __FILE__, __LINE__)
+
+#endif  //__XRTCSERVER_TEST_TEST_UTIL_H_